@@ -0,0 +1,322 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HBHitTestEngine.h"
+#include "Async/ParallelFor.h"
+#include "Algo/Sort.h"
+
+void FHBHitTestEngine::SetCapsules(TArrayView<const FHBHitTestCapsule> _Capsules)
+{
+	bool canRefit = (_Capsules.Num() == Capsules.Num()) && (RefitsSinceBuild < RebuildInterval);
+
+	Capsules.Reset(_Capsules.Num());
+	Capsules.Append(_Capsules.GetData(), _Capsules.Num());
+
+	if (canRefit)
+	{
+		Refit();
+		RefitsSinceBuild++;
+	}
+	else
+	{
+		Build();
+		RefitsSinceBuild = 0;
+	}
+}
+
+void FHBHitTestEngine::Build()
+{
+	Order.Reset(Capsules.Num());
+	for (int32 i = 0; i < Capsules.Num(); i++) Order.Add(i);
+
+	Packets.Reset();
+	Leaves.Reset();
+	Nodes.Reset(Capsules.Num() * 2);
+
+	if (Capsules.Num() == 0) return;
+
+	Nodes.AddDefaulted(1);
+	BuildNode(0, 0, Capsules.Num());
+}
+
+void FHBHitTestEngine::BuildNode(int32 _NodeIndex, int32 _Begin, int32 _End)
+{
+	//< Small enough for a single packet. >
+	if (_End - _Begin <= PacketWidth)
+	{
+		FLeaf leaf;
+		leaf.Begin = _Begin;
+		leaf.End = _End;
+		leaf.Node = _NodeIndex;
+
+		Nodes[_NodeIndex].Packet = Leaves.Add(leaf);
+		Packets.AddUninitialized(1);
+		FillPacket(Nodes[_NodeIndex].Packet);
+		return;
+	}
+
+	//< Split at the median of the longest axis of the capsule centers, keeping the left side a multiple of the packet width. >
+	FBox centerBounds(ForceInit);
+	for (int32 i = _Begin; i < _End; i++)
+	{
+		const FHBHitTestCapsule& capsule = Capsules[Order[i]];
+		centerBounds += (capsule.A + capsule.B) * 0.5f;
+	}
+
+	FVector extent = centerBounds.GetExtent();
+	int32 axis = (extent.X >= extent.Y && extent.X >= extent.Z) ? 0 : (extent.Y >= extent.Z) ? 1 : 2;
+
+	Algo::Sort(MakeArrayView(Order.GetData() + _Begin, _End - _Begin), [this, axis](int32 _Left, int32 _Right)
+	{
+		return (Capsules[_Left].A[axis] + Capsules[_Left].B[axis]) < (Capsules[_Right].A[axis] + Capsules[_Right].B[axis]);
+	});
+
+	int32 count = _End - _Begin;
+	int32 middle = _Begin + FMath::Min(FMath::DivideAndRoundUp(count / 2, PacketWidth) * PacketWidth, count - 1);
+
+	int32 left = Nodes.AddDefaulted(2);
+	Nodes[_NodeIndex].Left = left;
+
+	BuildNode(left, _Begin, middle);
+	BuildNode(left + 1, middle, _End);
+
+	Nodes[_NodeIndex].Min = Nodes[left].Min.ComponentMin(Nodes[left + 1].Min);
+	Nodes[_NodeIndex].Max = Nodes[left].Max.ComponentMax(Nodes[left + 1].Max);
+}
+
+void FHBHitTestEngine::Refit()
+{
+	for (int32 i = 0; i < Leaves.Num(); i++)
+	{
+		FillPacket(i);
+	}
+
+	//< Children are stored after parents, so walking backwards visits them first. >
+	for (int32 i = Nodes.Num() - 1; i >= 0; i--)
+	{
+		FNode& node = Nodes[i];
+		if (node.Packet == INDEX_NONE)
+		{
+			node.Min = Nodes[node.Left].Min.ComponentMin(Nodes[node.Left + 1].Min);
+			node.Max = Nodes[node.Left].Max.ComponentMax(Nodes[node.Left + 1].Max);
+		}
+	}
+}
+
+void FHBHitTestEngine::FillPacket(int32 _LeafIndex)
+{
+	const FLeaf& leaf = Leaves[_LeafIndex];
+	FPacket& packet = Packets[_LeafIndex];
+	FNode& node = Nodes[leaf.Node];
+
+	node.Min = FVector(BIG_NUMBER);
+	node.Max = FVector(-BIG_NUMBER);
+
+	for (int32 lane = 0; lane < PacketWidth; lane++)
+	{
+		int32 orderIndex = leaf.Begin + lane;
+		if (orderIndex >= leaf.End)
+		{
+			//< Padding lanes have a negative radius & are masked out. >
+			packet.AX[lane] = packet.AY[lane] = packet.AZ[lane] = 0;
+			packet.AxisX[lane] = packet.AxisY[lane] = packet.AxisZ[lane] = 0;
+			packet.Radius[lane] = -1;
+			packet.CapsuleIndex[lane] = INDEX_NONE;
+			continue;
+		}
+
+		int32 capsuleIndex = Order[orderIndex];
+		const FHBHitTestCapsule& capsule = Capsules[capsuleIndex];
+		FVector axis = capsule.B - capsule.A;
+
+		packet.AX[lane] = capsule.A.X;
+		packet.AY[lane] = capsule.A.Y;
+		packet.AZ[lane] = capsule.A.Z;
+		packet.AxisX[lane] = axis.X;
+		packet.AxisY[lane] = axis.Y;
+		packet.AxisZ[lane] = axis.Z;
+		packet.Radius[lane] = capsule.Radius;
+		packet.CapsuleIndex[lane] = capsuleIndex;
+
+		node.Min = node.Min.ComponentMin(capsule.A.ComponentMin(capsule.B) - FVector(capsule.Radius));
+		node.Max = node.Max.ComponentMax(capsule.A.ComponentMax(capsule.B) + FVector(capsule.Radius));
+	}
+}
+
+static FORCEINLINE VectorRegister HBVectorDot3(const VectorRegister& _AX, const VectorRegister& _AY, const VectorRegister& _AZ, const VectorRegister& _BX, const VectorRegister& _BY, const VectorRegister& _BZ)
+{
+	return VectorMultiplyAdd(_AZ, _BZ, VectorMultiplyAdd(_AY, _BY, VectorMultiply(_AX, _BX)));
+}
+
+static FORCEINLINE VectorRegister HBVectorSqrt(const VectorRegister& _Value)
+{
+	//< Only used on lanes that are masked to non-negative values, the clamp just keeps the others finite. >
+	VectorRegister clamped = VectorMax(_Value, VectorSetFloat1(SMALL_NUMBER));
+	return VectorMultiply(clamped, VectorReciprocalSqrtAccurate(clamped));
+}
+
+int32 FHBHitTestEngine::IntersectPacket(const FPacket& _Packet, const FHBHitTestRay& _Ray, float& _BestDistance) const
+{
+	const VectorRegister zero = VectorZero();
+	const VectorRegister one = VectorOne();
+	const VectorRegister epsilon = VectorSetFloat1(KINDA_SMALL_NUMBER);
+	const VectorRegister miss = VectorSetFloat1(BIG_NUMBER);
+
+	const VectorRegister dirX = VectorSetFloat1(_Ray.Direction.X);
+	const VectorRegister dirY = VectorSetFloat1(_Ray.Direction.Y);
+	const VectorRegister dirZ = VectorSetFloat1(_Ray.Direction.Z);
+
+	//< Ray start relative to each capsule's A point. >
+	const VectorRegister oaX = VectorSubtract(VectorSetFloat1(_Ray.Start.X), VectorLoadAligned(_Packet.AX));
+	const VectorRegister oaY = VectorSubtract(VectorSetFloat1(_Ray.Start.Y), VectorLoadAligned(_Packet.AY));
+	const VectorRegister oaZ = VectorSubtract(VectorSetFloat1(_Ray.Start.Z), VectorLoadAligned(_Packet.AZ));
+
+	const VectorRegister baX = VectorLoadAligned(_Packet.AxisX);
+	const VectorRegister baY = VectorLoadAligned(_Packet.AxisY);
+	const VectorRegister baZ = VectorLoadAligned(_Packet.AxisZ);
+
+	//< A swept sphere is a ray against the capsule grown by the sphere radius. >
+	const VectorRegister capsuleRadius = VectorLoadAligned(_Packet.Radius);
+	const VectorRegister laneMask = VectorCompareGE(capsuleRadius, zero);
+	const VectorRegister radius = VectorAdd(capsuleRadius, VectorSetFloat1(_Ray.Radius));
+	const VectorRegister radiusSq = VectorMultiply(radius, radius);
+
+	const VectorRegister baba = HBVectorDot3(baX, baY, baZ, baX, baY, baZ);
+	const VectorRegister bard = HBVectorDot3(baX, baY, baZ, dirX, dirY, dirZ);
+	const VectorRegister baoa = HBVectorDot3(baX, baY, baZ, oaX, oaY, oaZ);
+	const VectorRegister rdoa = HBVectorDot3(dirX, dirY, dirZ, oaX, oaY, oaZ);
+	const VectorRegister oaoa = HBVectorDot3(oaX, oaY, oaZ, oaX, oaY, oaZ);
+
+	//< Cylinder body. >
+	VectorRegister a = VectorSubtract(baba, VectorMultiply(bard, bard));
+	VectorRegister b = VectorSubtract(VectorMultiply(baba, rdoa), VectorMultiply(baoa, bard));
+	VectorRegister c = VectorSubtract(VectorSubtract(VectorMultiply(baba, oaoa), VectorMultiply(baoa, baoa)), VectorMultiply(radiusSq, baba));
+	VectorRegister h = VectorSubtract(VectorMultiply(b, b), VectorMultiply(a, c));
+
+	VectorRegister t = VectorMultiply(VectorSubtract(VectorNegate(b), HBVectorSqrt(h)), VectorReciprocalAccurate(VectorMax(a, epsilon)));
+	VectorRegister y = VectorMultiplyAdd(t, bard, baoa);
+
+	VectorRegister hitMask = VectorBitwiseAnd(VectorCompareGE(h, zero), VectorCompareGT(a, epsilon));
+	hitMask = VectorBitwiseAnd(hitMask, VectorBitwiseAnd(VectorCompareGE(t, zero), VectorBitwiseAnd(VectorCompareGT(y, zero), VectorCompareLT(y, baba))));
+	VectorRegister best = VectorSelect(hitMask, t, miss);
+
+	//< Cap at A. >
+	h = VectorSubtract(VectorMultiply(rdoa, rdoa), VectorSubtract(oaoa, radiusSq));
+	t = VectorSubtract(VectorNegate(rdoa), HBVectorSqrt(h));
+	hitMask = VectorBitwiseAnd(VectorCompareGE(h, zero), VectorCompareGE(t, zero));
+	best = VectorMin(best, VectorSelect(hitMask, t, miss));
+
+	//< Cap at B. >
+	b = VectorSubtract(rdoa, bard);
+	c = VectorSubtract(VectorAdd(VectorSubtract(oaoa, VectorAdd(baoa, baoa)), baba), radiusSq);
+	h = VectorSubtract(VectorMultiply(b, b), c);
+	t = VectorSubtract(VectorNegate(b), HBVectorSqrt(h));
+	hitMask = VectorBitwiseAnd(VectorCompareGE(h, zero), VectorCompareGE(t, zero));
+	best = VectorMin(best, VectorSelect(hitMask, t, miss));
+
+	//< Starting inside counts as an immediate hit. >
+	VectorRegister along = VectorMin(VectorMax(VectorMultiply(baoa, VectorReciprocalAccurate(VectorMax(baba, epsilon))), zero), one);
+	VectorRegister offX = VectorSubtract(oaX, VectorMultiply(baX, along));
+	VectorRegister offY = VectorSubtract(oaY, VectorMultiply(baY, along));
+	VectorRegister offZ = VectorSubtract(oaZ, VectorMultiply(baZ, along));
+	VectorRegister inside = VectorCompareLE(HBVectorDot3(offX, offY, offZ, offX, offY, offZ), radiusSq);
+	best = VectorSelect(inside, zero, best);
+
+	best = VectorSelect(laneMask, best, miss);
+
+	//< Pick the closest lane that isn't ignored. >
+	alignas(16) float distances[PacketWidth];
+	VectorStoreAligned(best, distances);
+
+	int32 hitCapsule = INDEX_NONE;
+	for (int32 lane = 0; lane < PacketWidth; lane++)
+	{
+		if (distances[lane] < _BestDistance)
+		{
+			int32 capsuleIndex = _Packet.CapsuleIndex[lane];
+			if (capsuleIndex == INDEX_NONE) continue;
+			if (_Ray.IgnoreUserIndex != INDEX_NONE && Capsules[capsuleIndex].UserIndex == _Ray.IgnoreUserIndex) continue;
+
+			_BestDistance = distances[lane];
+			hitCapsule = capsuleIndex;
+		}
+	}
+
+	return hitCapsule;
+}
+
+bool FHBHitTestEngine::Raycast(const FHBHitTestRay& _Ray, FHBHitTestResult& _OutResult) const
+{
+	_OutResult = FHBHitTestResult();
+	if (Nodes.Num() == 0) return false;
+
+	FVector inverseDirection(
+		(_Ray.Direction.X != 0) ? 1.0f / _Ray.Direction.X : BIG_NUMBER,
+		(_Ray.Direction.Y != 0) ? 1.0f / _Ray.Direction.Y : BIG_NUMBER,
+		(_Ray.Direction.Z != 0) ? 1.0f / _Ray.Direction.Z : BIG_NUMBER);
+	FVector rayRadius(_Ray.Radius);
+
+	float bestDistance = _Ray.Length;
+	int32 hitCapsule = INDEX_NONE;
+
+	int32 stack[64];
+	int32 stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const FNode& node = Nodes[stack[--stackSize]];
+
+		//< Slab test against the node bounds grown by the ray radius. >
+		FVector t0 = (node.Min - rayRadius - _Ray.Start) * inverseDirection;
+		FVector t1 = (node.Max + rayRadius - _Ray.Start) * inverseDirection;
+		float tNear = t0.ComponentMin(t1).GetMax();
+		float tFar = t0.ComponentMax(t1).GetMin();
+		if (tNear > tFar || tFar < 0 || tNear > bestDistance) continue;
+
+		if (node.Packet != INDEX_NONE)
+		{
+			int32 capsuleIndex = IntersectPacket(Packets[node.Packet], _Ray, bestDistance);
+			if (capsuleIndex != INDEX_NONE) hitCapsule = capsuleIndex;
+		}
+		else if (stackSize + 2 <= UE_ARRAY_COUNT(stack))
+		{
+			stack[stackSize++] = node.Left + 1;
+			stack[stackSize++] = node.Left;
+		}
+	}
+
+	if (hitCapsule == INDEX_NONE) return false;
+
+	//< Normal points away from the closest point on the capsule segment. >
+	const FHBHitTestCapsule& capsule = Capsules[hitCapsule];
+	FVector center = _Ray.Start + _Ray.Direction * bestDistance;
+	FVector closest = FMath::ClosestPointOnSegment(center, capsule.A, capsule.B);
+	FVector normal = (bestDistance > 0) ? (center - closest).GetSafeNormal() : -_Ray.Direction;
+
+	_OutResult.UserIndex = capsule.UserIndex;
+	_OutResult.Distance = bestDistance;
+	_OutResult.ImpactNormal = normal;
+	_OutResult.ImpactPoint = center - normal * _Ray.Radius;
+	return true;
+}
+
+void FHBHitTestEngine::RaycastBatch(TArrayView<const FHBHitTestRay> _Rays, TArrayView<FHBHitTestResult> _OutResults, bool _AllowParallel) const
+{
+	check(_Rays.Num() == _OutResults.Num());
+
+	//< Below this a batch is cheaper to run inline than to hand out to workers. >
+	static constexpr int32 MinRaysPerTask = 256;
+
+	int32 taskCount = (_AllowParallel) ? FMath::DivideAndRoundUp(_Rays.Num(), MinRaysPerTask) : 1;
+	if (taskCount <= 1)
+	{
+		for (int32 i = 0; i < _Rays.Num(); i++) Raycast(_Rays[i], _OutResults[i]);
+		return;
+	}
+
+	ParallelFor(taskCount, [this, &_Rays, &_OutResults](int32 _Task)
+	{
+		int32 end = FMath::Min((_Task + 1) * MinRaysPerTask, _Rays.Num());
+		for (int32 i = _Task * MinRaysPerTask; i < end; i++) Raycast(_Rays[i], _OutResults[i]);
+	});
+}
@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+//< A character capsule as seen by the hit test engine. A & B are the end points of the inner segment. >
+struct FHBHitTestCapsule
+{
+	FVector A = FVector::ZeroVector;
+	FVector B = FVector::ZeroVector;
+	float Radius = 0;
+	int32 UserIndex = INDEX_NONE; //< Reported back in FHBHitTestResult, e.g. an index into the caller's character list. >
+};
+
+//< A ray, or a swept sphere when Radius > 0. Direction must be normalized. >
+struct FHBHitTestRay
+{
+	FVector Start = FVector::ZeroVector;
+	FVector Direction = FVector::ForwardVector;
+	float Length = 0;
+	float Radius = 0;
+	int32 IgnoreUserIndex = INDEX_NONE; //< Typically the shooter. INDEX_NONE ignores nothing, capsules without a UserIndex are never skipped. >
+};
+
+struct FHBHitTestResult
+{
+	int32 UserIndex = INDEX_NONE; //< INDEX_NONE if nothing was hit. >
+	float Distance = 0;
+	FVector ImpactPoint = FVector::ZeroVector;
+	FVector ImpactNormal = FVector::ZeroVector;
+
+	bool IsHit() const { return UserIndex != INDEX_NONE; }
+};
+
+//< Dedicated hit testing against character capsules, independent of the physics scene. >
+// Capsules are stored as SoA packets of four under a small BVH, & each packet is tested against a ray with one set of
+// 4-wide vector instructions. Built for batches of thousands of rays (pellets, high rate of fire) against ~64 characters.
+// Not thread safe to update while querying; queries themselves may run in parallel.
+class HITBOX_API FHBHitTestEngine
+{
+public:
+	//< Replaces all capsules. Refits the existing tree if the count is unchanged, otherwise rebuilds it. >
+	void SetCapsules(TArrayView<const FHBHitTestCapsule> _Capsules);
+
+	//< Forces a full rebuild on the next SetCapsules. >
+	void MarkDirty() { RefitsSinceBuild = RebuildInterval; }
+
+	bool Raycast(const FHBHitTestRay& _Ray, FHBHitTestResult& _OutResult) const;
+
+	//< _OutResults must be the same size as _Rays. Large batches are spread across worker threads. >
+	void RaycastBatch(TArrayView<const FHBHitTestRay> _Rays, TArrayView<FHBHitTestResult> _OutResults, bool _AllowParallel = true) const;
+
+	int32 NumCapsules() const { return Capsules.Num(); }
+
+	//< Refits before the tree is rebuilt from scratch. Capsules move continuously, so refitting stays tight for a while. >
+	int32 RebuildInterval = 30;
+
+private:
+	static constexpr int32 PacketWidth = 4;
+
+	struct alignas(16) FPacket
+	{
+		float AX[PacketWidth];
+		float AY[PacketWidth];
+		float AZ[PacketWidth];
+		float AxisX[PacketWidth];
+		float AxisY[PacketWidth];
+		float AxisZ[PacketWidth];
+		float Radius[PacketWidth];
+		int32 CapsuleIndex[PacketWidth]; //< Index into Capsules, INDEX_NONE for padding lanes. >
+	};
+
+	struct FNode
+	{
+		FVector Min;
+		FVector Max;
+		int32 Left = INDEX_NONE; //< Right child is always Left + 1. >
+		int32 Packet = INDEX_NONE; //< Set on leaves only. >
+	};
+
+	struct FLeaf
+	{
+		int32 Begin = 0; //< Range in Order. >
+		int32 End = 0;
+		int32 Node = INDEX_NONE;
+	};
+
+	void Build();
+	void BuildNode(int32 _NodeIndex, int32 _Begin, int32 _End);
+	void Refit();
+	void FillPacket(int32 _LeafIndex);
+
+	//< Tests one packet, updating _BestDistance & returning the winning capsule index or INDEX_NONE. >
+	int32 IntersectPacket(const FPacket& _Packet, const FHBHitTestRay& _Ray, float& _BestDistance) const;
+
+	TArray<FHBHitTestCapsule> Capsules;
+	TArray<int32> Order; //< Capsule indices in leaf order. >
+	TArray<FPacket> Packets;
+	TArray<FLeaf> Leaves; //< One per packet. >
+	TArray<FNode> Nodes; //< Children are always stored after their parent. >
+
+	int32 RefitsSinceBuild = 0;
+};
@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HBHitboxHistory.h"
+
+static_assert((FHBHitboxHistory::Capacity & (FHBHitboxHistory::Capacity - 1)) == 0, "FHBHitboxHistory::Capacity must be a power of two.");
+
+void FHBHitboxSample::GetSegment(FVector& _OutA, FVector& _OutB) const
+{
+	FVector halfSegment = Rotation.GetUpVector() * FMath::Max(HalfHeight - Radius, 0.0f);
+	_OutA = Location - halfSegment;
+	_OutB = Location + halfSegment;
+}
+
+void FHBHitboxHistory::Record(const FHBHitboxSample& _Sample)
+{
+	uint32 writeCount = WriteCount.Load(EMemoryOrder::Relaxed);
+	Samples[writeCount & (Capacity - 1)] = _Sample;
+	WriteCount.Store(writeCount + 1);
+}
+
+void FHBHitboxHistory::Reset()
+{
+	WriteCount.Store(0);
+}
+
+int32 FHBHitboxHistory::Num() const
+{
+	return (int32)FMath::Min<uint32>(WriteCount.Load(), Capacity);
+}
+
+float FHBHitboxHistory::GetOldestTime() const
+{
+	uint32 writeCount = WriteCount.Load();
+	if (writeCount == 0) return 0;
+	return GetSample(writeCount - FMath::Min<uint32>(writeCount, Capacity)).Time;
+}
+
+float FHBHitboxHistory::GetNewestTime() const
+{
+	uint32 writeCount = WriteCount.Load();
+	if (writeCount == 0) return 0;
+	return GetSample(writeCount - 1).Time;
+}
+
+bool FHBHitboxHistory::SampleAt(float _Time, FHBHitboxSample& _OutSample) const
+{
+	uint32 writeCount = WriteCount.Load();
+	if (writeCount == 0) return false;
+
+	uint32 first = writeCount - FMath::Min<uint32>(writeCount, Capacity);
+	uint32 last = writeCount - 1;
+
+	if (_Time < GetSample(first).Time) return false;
+	if (_Time >= GetSample(last).Time)
+	{
+		_OutSample = GetSample(last);
+		return true;
+	}
+
+	//< Binary search for the last sample at or before _Time. >
+	uint32 low = first;
+	uint32 high = last;
+	while (high - low > 1)
+	{
+		uint32 mid = low + (high - low) / 2;
+		if (GetSample(mid).Time <= _Time) low = mid;
+		else high = mid;
+	}
+
+	const FHBHitboxSample& from = GetSample(low);
+	const FHBHitboxSample& to = GetSample(high);
+
+	float span = to.Time - from.Time;
+	float alpha = (span > SMALL_NUMBER) ? (_Time - from.Time) / span : 0.0f;
+
+	_OutSample.Time			= _Time;
+	_OutSample.Location		= FMath::Lerp(from.Location, to.Location, alpha);
+	_OutSample.Rotation		= FQuat::Slerp(from.Rotation, to.Rotation, alpha);
+	_OutSample.HalfHeight	= FMath::Lerp(from.HalfHeight, to.HalfHeight, alpha);
+	_OutSample.Radius		= FMath::Lerp(from.Radius, to.Radius, alpha);
+	return true;
+}
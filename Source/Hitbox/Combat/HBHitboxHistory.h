@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/StaticArray.h"
+#include "Templates/Atomic.h"
+
+//< Capsule pose of a character at a point in time. >
+struct FHBHitboxSample
+{
+	float Time = 0;
+	FVector Location = FVector::ZeroVector;
+	FQuat Rotation = FQuat::Identity;
+	float HalfHeight = 0; //< Includes crouch. >
+	float Radius = 0;
+
+	//< End points of the capsule's inner segment. >
+	void GetSegment(FVector& _OutA, FVector& _OutB) const;
+};
+
+//< Fixed-size ring buffer of capsule poses, written once per physics sub step. >
+// Never allocates. Written from the physics callback & read from the game thread; reads only look at
+// published samples, but samples close to Capacity old may be overwritten while being read.
+class HITBOX_API FHBHitboxHistory
+{
+public:
+	static constexpr int32 Capacity = 128; //< ~1 second at the project's 8.3ms sub step. Must be a power of two. >
+
+	void Record(const FHBHitboxSample& _Sample);
+	void Reset();
+
+	//< Pose at _Time, interpolated between the two surrounding samples. >
+	// Times newer than the latest sample return the latest sample. Returns false if _Time is older than the history.
+	bool SampleAt(float _Time, FHBHitboxSample& _OutSample) const;
+
+	int32 Num() const;
+	float GetOldestTime() const;
+	float GetNewestTime() const;
+
+private:
+	const FHBHitboxSample& GetSample(uint32 _WriteIndex) const { return Samples[_WriteIndex & (Capacity - 1)]; }
+
+	TStaticArray<FHBHitboxSample, Capacity> Samples;
+	TAtomic<uint32> WriteCount { 0 }; //< Total samples ever recorded, published after each write. >
+};
@@ -0,0 +1,144 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HBHitboxRewindSubsystem.h"
+#include "HBHitboxHistory.h"
+#include "../HBMathLibrary.h"
+#include "../Pawns/HBPlayerCollisionComponent.h"
+#include "Components/CapsuleComponent.h"
+
+void UHBHitboxRewindSubsystem::RegisterComponent(UHBPlayerCollisionComponent* _Component)
+{
+	if (!_Component || Components.Contains(_Component)) return;
+
+	//< The engine's capsules no longer match the components. >
+	Components.Add(_Component);
+	LiveCapsuleFrame = MAX_uint64;
+	HitTestEngine.MarkDirty();
+}
+
+void UHBHitboxRewindSubsystem::UnregisterComponent(UHBPlayerCollisionComponent* _Component)
+{
+	Components.RemoveSwap(_Component);
+	LiveCapsuleFrame = MAX_uint64;
+	HitTestEngine.MarkDirty();
+}
+
+int32 UHBHitboxRewindSubsystem::FindComponentIndex(const AActor* _Owner) const
+{
+	return Components.IndexOfByPredicate([_Owner](const UHBPlayerCollisionComponent* _Component) { return _Component && _Component->GetOwner() == _Owner; });
+}
+
+bool UHBHitboxRewindSubsystem::RaycastAtTime(FVector _Start, FVector _End, float _Time, FHBRewindHit& _OutHit, const AActor* _IgnoreActor) const
+{
+	return SweepSphereAtTime(_Start, _End, 0, _Time, _OutHit, _IgnoreActor);
+}
+
+bool UHBHitboxRewindSubsystem::SweepSphereAtTime(FVector _Start, FVector _End, float _Radius, float _Time, FHBRewindHit& _OutHit, const AActor* _IgnoreActor) const
+{
+	FVector direction = _End - _Start;
+	float length = direction.Size();
+	if (length <= SMALL_NUMBER) return false;
+	direction /= length;
+
+	float bestDistance = length;
+	bool hit = false;
+
+	for (UHBPlayerCollisionComponent* component : Components)
+	{
+		if (!component || component->GetOwner() == _IgnoreActor) continue;
+
+		FHBHitboxSample sample;
+		if (!component->GetHitboxHistory().SampleAt(_Time, sample)) continue;
+
+		//< A swept sphere against a capsule is a ray against the capsule grown by the sphere radius. >
+		float radius = sample.Radius + _Radius;
+
+		//< Cheap bounding sphere rejection before the capsule test. >
+		FVector toCenter = sample.Location - _Start;
+		float along = FVector::DotProduct(toCenter, direction);
+		float boundRadius = sample.HalfHeight + _Radius;
+		if ((toCenter - direction * FMath::Clamp(along, 0.0f, bestDistance)).SizeSquared() > boundRadius * boundRadius) continue;
+
+		FVector capsuleA, capsuleB;
+		sample.GetSegment(capsuleA, capsuleB);
+
+		float distance;
+		FVector normal;
+		if (UHBMathLibrary::RayCapsuleIntersection(_Start, direction, bestDistance, capsuleA, capsuleB, radius, distance, normal))
+		{
+			bestDistance = distance;
+			hit = true;
+
+			_OutHit.Actor = component->GetOwner();
+			_OutHit.CollisionComponent = component;
+			_OutHit.Distance = distance;
+			_OutHit.ImpactNormal = normal;
+			_OutHit.ImpactPoint = _Start + direction * distance - normal * _Radius;
+		}
+	}
+
+	return hit;
+}
+
+void UHBHitboxRewindSubsystem::RaycastBatch(TArrayView<const FHBHitTestRay> _Rays, TArrayView<FHBHitTestResult> _OutResults)
+{
+	UpdateLiveCapsules();
+	HitTestEngine.RaycastBatch(_Rays, _OutResults);
+}
+
+void UHBHitboxRewindSubsystem::RaycastBatchAtTime(TArrayView<const FHBHitTestRay> _Rays, float _Time, TArrayView<FHBHitTestResult> _OutResults)
+{
+	UpdateRewoundCapsules(_Time);
+	HitTestEngine.RaycastBatch(_Rays, _OutResults);
+}
+
+void UHBHitboxRewindSubsystem::UpdateLiveCapsules()
+{
+	if (LiveCapsuleFrame == GFrameCounter) return;
+	LiveCapsuleFrame = GFrameCounter;
+
+	CapsuleScratch.Reset(Components.Num());
+	for (int32 i = 0; i < Components.Num(); i++)
+	{
+		FHBHitTestCapsule& capsule = CapsuleScratch.AddDefaulted_GetRef();
+		capsule.UserIndex = i;
+
+		UCapsuleComponent* cc = (Components[i]) ? Components[i]->CapsuleComponent : nullptr;
+		if (!cc)
+		{
+			capsule.Radius = -1; //< Never hit. >
+			continue;
+		}
+
+		FVector halfSegment = cc->GetUpVector() * FMath::Max(cc->GetScaledCapsuleHalfHeight() - cc->GetScaledCapsuleRadius(), 0.0f);
+		capsule.A = cc->GetComponentLocation() - halfSegment;
+		capsule.B = cc->GetComponentLocation() + halfSegment;
+		capsule.Radius = cc->GetScaledCapsuleRadius();
+	}
+
+	HitTestEngine.SetCapsules(CapsuleScratch);
+}
+
+void UHBHitboxRewindSubsystem::UpdateRewoundCapsules(float _Time)
+{
+	LiveCapsuleFrame = MAX_uint64;
+
+	CapsuleScratch.Reset(Components.Num());
+	for (int32 i = 0; i < Components.Num(); i++)
+	{
+		FHBHitTestCapsule& capsule = CapsuleScratch.AddDefaulted_GetRef();
+		capsule.UserIndex = i;
+
+		FHBHitboxSample sample;
+		if (!Components[i] || !Components[i]->GetHitboxHistory().SampleAt(_Time, sample))
+		{
+			capsule.Radius = -1; //< No history that far back, never hit. >
+			continue;
+		}
+
+		sample.GetSegment(capsule.A, capsule.B);
+		capsule.Radius = sample.Radius;
+	}
+
+	HitTestEngine.SetCapsules(CapsuleScratch);
+}
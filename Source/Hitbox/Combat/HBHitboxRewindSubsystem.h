@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HBHitTestEngine.h"
+#include "HBHitboxRewindSubsystem.generated.h"
+
+class UHBPlayerCollisionComponent;
+
+USTRUCT(BlueprintType)
+struct HITBOX_API FHBRewindHit
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Rewind")
+		AActor* Actor = nullptr;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Rewind")
+		UHBPlayerCollisionComponent* CollisionComponent = nullptr;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Rewind")
+		float Distance = 0;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Rewind")
+		FVector ImpactPoint = FVector::ZeroVector;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Rewind")
+		FVector ImpactNormal = FVector::ZeroVector;
+};
+
+//< Answers hit tests against character capsules as they were at an earlier time. >
+// Uses each UHBPlayerCollisionComponent's hitbox history & analytic capsule tests, so the live physics scene is never touched.
+UCLASS()
+class HITBOX_API UHBHitboxRewindSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	void RegisterComponent(UHBPlayerCollisionComponent* _Component);
+	void UnregisterComponent(UHBPlayerCollisionComponent* _Component);
+
+	//< Closest character hit by the ray from _Start to _End, with every capsule posed at _Time (world time seconds). >
+	UFUNCTION(BlueprintCallable, Category = "Rewind")
+		bool RaycastAtTime(FVector _Start, FVector _End, float _Time, FHBRewindHit& _OutHit, const AActor* _IgnoreActor = nullptr) const;
+
+	//< As RaycastAtTime but for a sphere of _Radius swept from _Start to _End. >
+	UFUNCTION(BlueprintCallable, Category = "Rewind")
+		bool SweepSphereAtTime(FVector _Start, FVector _End, float _Radius, float _Time, FHBRewindHit& _OutHit, const AActor* _IgnoreActor = nullptr) const;
+
+	//< Batched hit tests against every character's current capsule, including crouch height. >
+	// FHBHitTestResult::UserIndex is an index into GetComponents().
+	void RaycastBatch(TArrayView<const FHBHitTestRay> _Rays, TArrayView<FHBHitTestResult> _OutResults);
+
+	//< Batched hit tests with every capsule posed at _Time (world time seconds). >
+	void RaycastBatchAtTime(TArrayView<const FHBHitTestRay> _Rays, float _Time, TArrayView<FHBHitTestResult> _OutResults);
+
+	const TArray<UHBPlayerCollisionComponent*>& GetComponents() const { return Components; }
+	int32 FindComponentIndex(const AActor* _Owner) const;
+
+private:
+	//< Loads the hit test engine with the live capsules, at most once per frame. >
+	void UpdateLiveCapsules();
+	void UpdateRewoundCapsules(float _Time);
+
+	UPROPERTY()
+		TArray<UHBPlayerCollisionComponent*> Components;
+
+	FHBHitTestEngine HitTestEngine;
+	TArray<FHBHitTestCapsule> CapsuleScratch;
+
+	uint64 LiveCapsuleFrame = MAX_uint64; //< Frame the engine was last loaded with live capsules, MAX_uint64 if it holds rewound ones. >
+};
@@ -20,3 +20,85 @@ FVector UHBMathLibrary::FlattenOnAxis(FVector _InVector, FVector _Axis)
 	returnVector += (_Axis.Size() > 0) ? -axisDelta : axisDelta;
 	return returnVector;
 }
+
+bool UHBMathLibrary::RayCapsuleIntersection(FVector _Start, FVector _Direction, float _MaxDistance, FVector _CapsuleA, FVector _CapsuleB, float _Radius, float& _OutDistance, FVector& _OutNormal)
+{
+	FVector axis = _CapsuleB - _CapsuleA;
+	FVector toStart = _Start - _CapsuleA;
+
+	float axisSq = FVector::DotProduct(axis, axis);
+	float axisDir = FVector::DotProduct(axis, _Direction);
+	float axisStart = FVector::DotProduct(axis, toStart);
+	float radiusSq = _Radius * _Radius;
+
+	//< Starting inside counts as an immediate hit. >
+	float startAlong = (axisSq > SMALL_NUMBER) ? FMath::Clamp(axisStart / axisSq, 0.0f, 1.0f) : 0.0f;
+	FVector startOffset = toStart - axis * startAlong;
+	if (startOffset.SizeSquared() <= radiusSq)
+	{
+		_OutDistance = 0;
+		_OutNormal = -_Direction;
+		return true;
+	}
+
+	float bestDistance = MAX_FLT;
+
+	//< Cylinder body. >
+	float a = axisSq - axisDir * axisDir;
+	if (a > SMALL_NUMBER)
+	{
+		float b = axisSq * FVector::DotProduct(toStart, _Direction) - axisStart * axisDir;
+		float c = axisSq * FVector::DotProduct(toStart, toStart) - axisStart * axisStart - radiusSq * axisSq;
+		float h = b * b - a * c;
+		if (h >= 0)
+		{
+			float t = (-b - FMath::Sqrt(h)) / a;
+			float y = axisStart + t * axisDir;
+			if (t >= 0 && y > 0 && y < axisSq) bestDistance = t;
+		}
+	}
+
+	//< End caps. >
+	FVector caps[2] = { _CapsuleA, _CapsuleB };
+	for (const FVector& cap : caps)
+	{
+		FVector toCap = _Start - cap;
+		float b = FVector::DotProduct(_Direction, toCap);
+		float c = FVector::DotProduct(toCap, toCap) - radiusSq;
+		float h = b * b - c;
+		if (h >= 0)
+		{
+			float t = -b - FMath::Sqrt(h);
+			if (t >= 0 && t < bestDistance) bestDistance = t;
+		}
+	}
+
+	if (bestDistance > _MaxDistance) return false;
+
+	//< Normal points away from the closest point on the capsule segment. >
+	FVector impactPoint = _Start + _Direction * bestDistance;
+	float along = (axisSq > SMALL_NUMBER) ? FMath::Clamp(FVector::DotProduct(impactPoint - _CapsuleA, axis) / axisSq, 0.0f, 1.0f) : 0.0f;
+
+	_OutDistance = bestDistance;
+	_OutNormal = (impactPoint - (_CapsuleA + axis * along)).GetSafeNormal();
+	return true;
+}
+
+float UHBMathLibrary::CriticallyDampedSpring(float _Value, float& _Velocity, float _Target, float _SmoothTime, float _DeltaTime)
+{
+	if (_SmoothTime <= 0)
+	{
+		_Velocity = 0;
+		return _Target;
+	}
+
+	//< Closed form of the spring, with exp() replaced by its Pade approximation. Stable for any time step. >
+	float omega = 2.0f / _SmoothTime;
+	float x = omega * _DeltaTime;
+	float decay = 1.0f / (1.0f + x + 0.48f * x * x + 0.235f * x * x * x);
+
+	float offset = _Value - _Target;
+	float temp = (_Velocity + omega * offset) * _DeltaTime;
+	_Velocity = (_Velocity - omega * temp) * decay;
+	return _Target + (offset + temp) * decay;
+}
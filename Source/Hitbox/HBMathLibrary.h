@@ -17,4 +17,13 @@ public:
 
 
 	static FVector FlattenOnAxis(FVector _InVector, FVector _Axis);
+
+	//< Intersects a ray with the capsule whose segment runs from _CapsuleA to _CapsuleB. >
+	// Returns false if the ray misses within _MaxDistance. A ray starting inside the capsule hits at distance 0.
+	// _Direction must be normalized.
+	static bool RayCapsuleIntersection(FVector _Start, FVector _Direction, float _MaxDistance, FVector _CapsuleA, FVector _CapsuleB, float _Radius, float& _OutDistance, FVector& _OutNormal);
+
+	//< Moves _Value towards _Target as a critically damped spring, settling in about _SmoothTime without overshoot. >
+	// _Velocity carries the spring between calls. A _SmoothTime of 0 snaps to the target.
+	static float CriticallyDampedSpring(float _Value, float& _Velocity, float _Target, float _SmoothTime, float _DeltaTime);
 };
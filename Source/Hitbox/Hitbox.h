@@ -3,4 +3,9 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
 
+//< Trace channel used by the ground & wall queries of the movement. Set up in DefaultEngine.ini. >
+#define ECC_HBMovement ECC_GameTraceChannel1
+
+DECLARE_STATS_GROUP(TEXT("HBMovement"), STATGROUP_HBMovement, STATCAT_Advanced);
@@ -2,4 +2,54 @@
 
 
 #include "HitboxGameModeBase.h"
+#include "GameFramework/Controller.h"
+#include "Pawns/HBPhysicsCharacter.h"
+#include "Pawns/HBPawnPoolSubsystem.h"
 
+void AHitboxGameModeBase::StartPlay()
+{
+	Super::StartPlay();
+
+	//< Pay for the characters' subobjects & physics bodies now rather than on the first deaths. >
+	UClass* pawnClass = GetDefaultPawnClassForController(nullptr);
+	if (pawnClass && pawnClass->IsChildOf<AHBPhysicsCharacter>())
+	{
+		if (UHBPawnPoolSubsystem* pool = GetWorld()->GetSubsystem<UHBPawnPoolSubsystem>())
+		{
+			pool->Prewarm(pawnClass, PawnPoolSize);
+		}
+	}
+}
+
+APawn* AHitboxGameModeBase::SpawnDefaultPawnAtTransform_Implementation(AController* NewPlayer, const FTransform& SpawnTransform)
+{
+	UClass* pawnClass = GetDefaultPawnClassForController(NewPlayer);
+	UHBPawnPoolSubsystem* pool = GetWorld()->GetSubsystem<UHBPawnPoolSubsystem>();
+
+	if (pool && pawnClass && pawnClass->IsChildOf<AHBPhysicsCharacter>())
+	{
+		return pool->Acquire(pawnClass, SpawnTransform);
+	}
+	return Super::SpawnDefaultPawnAtTransform_Implementation(NewPlayer, SpawnTransform);
+}
+
+void AHitboxGameModeBase::RespawnPlayer(AController* _Controller)
+{
+	if (!_Controller) return;
+
+	APawn* pawn = _Controller->GetPawn();
+	AHBPhysicsCharacter* character = Cast<AHBPhysicsCharacter>(pawn);
+	UHBPawnPoolSubsystem* pool = GetWorld()->GetSubsystem<UHBPawnPoolSubsystem>();
+
+	if (character && pool)
+	{
+		pool->Release(character);
+	}
+	else if (pawn)
+	{
+		_Controller->UnPossess();
+		pawn->Destroy();
+	}
+
+	RestartPlayer(_Controller);
+}
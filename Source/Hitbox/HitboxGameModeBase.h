@@ -13,5 +13,16 @@ UCLASS()
 class HITBOX_API AHitboxGameModeBase : public AGameModeBase
 {
 	GENERATED_BODY()
-	
+
+public:
+	virtual void StartPlay() override;
+	virtual APawn* SpawnDefaultPawnAtTransform_Implementation(AController* NewPlayer, const FTransform& SpawnTransform) override;
+
+	//< Sends _Controller's pawn back to the pool & restarts it at a player start, e.g. on death. >
+	UFUNCTION(BlueprintCallable, Category = "Pawn Pool")
+		void RespawnPlayer(AController* _Controller);
+
+	//< Characters of the default pawn class spawned & parked at level start. See UHBPawnPoolSubsystem. >
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Pawn Pool", meta = (ClampMin = "0"))
+		int32 PawnPoolSize = 8;
 };
@@ -0,0 +1,158 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HBFixedMath.h"
+
+namespace
+{
+	constexpr int32 SineTableSize = 256; //< Segments per quarter turn. >
+	constexpr int64 QuarterTurn = 90 * FHBFixed::One;
+	constexpr int64 FullTurn = 360 * FHBFixed::One;
+
+	struct FQuarterSineTable
+	{
+		int64 Values[SineTableSize + 1];
+
+		FQuarterSineTable()
+		{
+			//< Taylor series to x^13 in 2.30 fixed point. Under 2^-20 off at 90 degrees, far below the 2^-16 the table keeps. >
+			constexpr int64 HalfPi = 1686629713; //< pi / 2 * 2^30. >
+
+			for (int32 i = 0; i <= SineTableSize; i++)
+			{
+				int64 x = HalfPi * i / SineTableSize;
+				int64 x2 = (x * x) >> 30;
+				int64 term = x;
+				int64 sum = x;
+
+				for (int32 n = 1; n <= 6; n++)
+				{
+					term = -((term * x2) >> 30) / ((2 * n) * (2 * n + 1));
+					sum += term;
+				}
+				Values[i] = (sum + (1 << 13)) >> 14; //< To 16 fraction bits, rounded. >
+			}
+		}
+	};
+
+	const int64* GetQuarterSine()
+	{
+		static const FQuarterSineTable table;
+		return table.Values;
+	}
+}
+
+FHBFixed FHBFixedVector::Size() const
+{
+	return HBFixedMath::Sqrt(SizeSquared());
+}
+
+FHBFixed FHBFixedVector::Size2D() const
+{
+	return HBFixedMath::Sqrt(X * X + Y * Y);
+}
+
+FHBFixedVector FHBFixedVector::GetSafeNormal() const
+{
+	FHBFixed size = Size();
+	if (size.Raw < 16) return FHBFixedVector(); //< Under 2^-12, the direction would be mostly rounding. >
+
+	return *this / size;
+}
+
+FHBFixedVector FHBFixedVector::GetClampedToMaxSize(FHBFixed _MaxSize) const
+{
+	if (_MaxSize.Raw <= 0) return FHBFixedVector();
+
+	FHBFixed size = Size();
+	if (size <= _MaxSize) return *this;
+
+	return (*this / size) * _MaxSize;
+}
+
+FHBFixed HBFixedMath::Sqrt(FHBFixed _Value)
+{
+	if (_Value.Raw <= 0) return FHBFixed();
+
+	//< sqrt(Raw / One) * One == sqrt(Raw * One), taken digit by digit. >
+	uint64 value = uint64(_Value.Raw) << FHBFixed::FractionBits;
+	uint64 result = 0;
+	uint64 bit = uint64(1) << 62;
+	while (bit > value) bit >>= 2;
+
+	while (bit != 0)
+	{
+		if (value >= result + bit)
+		{
+			value -= result + bit;
+			result = (result >> 1) + bit;
+		}
+		else
+		{
+			result >>= 1;
+		}
+		bit >>= 2;
+	}
+	return FHBFixed::FromRaw(int64(result));
+}
+
+FHBFixed HBFixedMath::SinDeg(FHBFixed _Degrees)
+{
+	int64 angle = _Degrees.Raw % FullTurn;
+	if (angle < 0) angle += FullTurn;
+
+	//< Mirror into the first quadrant. >
+	int64 quadrant = angle / QuarterTurn;
+	int64 inQuarter = angle - quadrant * QuarterTurn;
+	if (quadrant & 1) inQuarter = QuarterTurn - inQuarter;
+
+	//< Linear between table entries. >
+	const int64* table = GetQuarterSine();
+	int64 position = inQuarter * SineTableSize;
+	int64 index = position / QuarterTurn;
+	int64 value = table[index];
+	if (index < SineTableSize) value += (table[index + 1] - table[index]) * (position % QuarterTurn) / QuarterTurn;
+
+	return FHBFixed::FromRaw((quadrant >= 2) ? -value : value);
+}
+
+FHBFixed HBFixedMath::CosDeg(FHBFixed _Degrees)
+{
+	return SinDeg(_Degrees + FHBFixed::FromInt(90));
+}
+
+FHBFixed HBFixedMath::AsinDeg(FHBFixed _Value)
+{
+	int64 value = FMath::Min<int64>(Abs(_Value).Raw, int64(FHBFixed::One));
+	const int64* table = GetQuarterSine();
+
+	//< Last entry not above the value. The table rises monotonically over the quarter. >
+	int32 low = 0, high = SineTableSize;
+	while (low < high)
+	{
+		int32 middle = (low + high + 1) / 2;
+		if (table[middle] <= value)	low = middle;
+		else						high = middle - 1;
+	}
+
+	int64 position = int64(low) * QuarterTurn;
+	if (low < SineTableSize && table[low + 1] > table[low])
+	{
+		position += (value - table[low]) * QuarterTurn / (table[low + 1] - table[low]);
+	}
+	int64 degrees = position / SineTableSize;
+
+	return FHBFixed::FromRaw((_Value.Raw < 0) ? -degrees : degrees);
+}
+
+FHBFixed HBFixedMath::AcosDeg(FHBFixed _Value)
+{
+	return FHBFixed::FromInt(90) - AsinDeg(_Value);
+}
+
+FHBFixed HBFixedMath::NormalizeAxis(FHBFixed _Degrees)
+{
+	int64 angle = _Degrees.Raw % FullTurn;
+	if (angle <= -FullTurn / 2) angle += FullTurn;
+	if (angle > FullTurn / 2) angle -= FullTurn;
+	return FHBFixed::FromRaw(angle);
+}
@@ -0,0 +1,109 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+//< Signed fixed point number with 16 fraction bits in 64. Integer math only, so results are bit identical on every compiler & CPU. >
+// Products are formed in 64 bits before shifting back, so the raw values of two factors must not multiply past 2^63,
+// e.g. speeds times seconds or directions times distances, never positions times positions.
+struct HITBOX_API FHBFixed
+{
+	static constexpr int32 FractionBits = 16;
+	static constexpr int64 One = int64(1) << FractionBits;
+
+	int64 Raw = 0;
+
+	static FHBFixed FromRaw(int64 _Raw) { FHBFixed result; result.Raw = _Raw; return result; }
+	static FHBFixed FromInt(int32 _Value) { return FromRaw(int64(_Value) * One); }
+
+	//< Rounded to the nearest 1/65536, finer fractions are lost. >
+	// The same float converts the same on every build, so configuration does too. Never feed it the result of float math, which may already differ.
+	static FHBFixed FromFloat(float _Value) { return FromRaw((int64)FMath::RoundToDouble(double(_Value) * One)); }
+
+	float ToFloat() const { return float(double(Raw) / One); }
+
+	FHBFixed operator-() const							{ return FromRaw(-Raw);										}
+	FHBFixed operator+(FHBFixed _Other) const			{ return FromRaw(Raw + _Other.Raw);							}
+	FHBFixed operator-(FHBFixed _Other) const			{ return FromRaw(Raw - _Other.Raw);							}
+	FHBFixed operator*(FHBFixed _Other) const			{ return FromRaw((Raw * _Other.Raw) >> FractionBits);		}
+	FHBFixed operator/(FHBFixed _Other) const			{ return FromRaw((Raw * One) / _Other.Raw);					}
+	FHBFixed operator*(int32 _Value) const				{ return FromRaw(Raw * _Value);								}
+	FHBFixed operator/(int32 _Value) const				{ return FromRaw(Raw / _Value);								}
+
+	FHBFixed& operator+=(FHBFixed _Other)				{ Raw += _Other.Raw; return *this;							}
+	FHBFixed& operator-=(FHBFixed _Other)				{ Raw -= _Other.Raw; return *this;							}
+
+	bool operator==(FHBFixed _Other) const				{ return Raw == _Other.Raw;									}
+	bool operator!=(FHBFixed _Other) const				{ return Raw != _Other.Raw;									}
+	bool operator<(FHBFixed _Other) const				{ return Raw < _Other.Raw;									}
+	bool operator<=(FHBFixed _Other) const				{ return Raw <= _Other.Raw;									}
+	bool operator>(FHBFixed _Other) const				{ return Raw > _Other.Raw;									}
+	bool operator>=(FHBFixed _Other) const				{ return Raw >= _Other.Raw;									}
+};
+
+struct HITBOX_API FHBFixedVector
+{
+	FHBFixed X;
+	FHBFixed Y;
+	FHBFixed Z;
+
+	FHBFixedVector() = default;
+	FHBFixedVector(FHBFixed _X, FHBFixed _Y, FHBFixed _Z) : X(_X), Y(_Y), Z(_Z) {}
+
+	//< See FHBFixed::FromFloat. >
+	static FHBFixedVector FromVector(const FVector& _Vector) { return FHBFixedVector(FHBFixed::FromFloat(_Vector.X), FHBFixed::FromFloat(_Vector.Y), FHBFixed::FromFloat(_Vector.Z)); }
+	static FHBFixedVector Up() { return FHBFixedVector(FHBFixed(), FHBFixed(), FHBFixed::FromInt(1)); }
+
+	FVector ToVector() const { return FVector(X.ToFloat(), Y.ToFloat(), Z.ToFloat()); }
+
+	FHBFixedVector operator-() const							{ return FHBFixedVector(-X, -Y, -Z);										}
+	FHBFixedVector operator+(const FHBFixedVector& _Other) const	{ return FHBFixedVector(X + _Other.X, Y + _Other.Y, Z + _Other.Z);	}
+	FHBFixedVector operator-(const FHBFixedVector& _Other) const	{ return FHBFixedVector(X - _Other.X, Y - _Other.Y, Z - _Other.Z);	}
+	FHBFixedVector operator*(FHBFixed _Scale) const				{ return FHBFixedVector(X * _Scale, Y * _Scale, Z * _Scale);				}
+	FHBFixedVector operator/(FHBFixed _Scale) const				{ return FHBFixedVector(X / _Scale, Y / _Scale, Z / _Scale);				}
+
+	FHBFixedVector& operator+=(const FHBFixedVector& _Other)	{ X += _Other.X; Y += _Other.Y; Z += _Other.Z; return *this;				}
+	FHBFixedVector& operator-=(const FHBFixedVector& _Other)	{ X -= _Other.X; Y -= _Other.Y; Z -= _Other.Z; return *this;				}
+
+	bool IsZero() const { return X.Raw == 0 && Y.Raw == 0 && Z.Raw == 0; }
+
+	static FHBFixed Dot(const FHBFixedVector& _A, const FHBFixedVector& _B) { return _A.X * _B.X + _A.Y * _B.Y + _A.Z * _B.Z; }
+
+	FHBFixed SizeSquared() const { return Dot(*this, *this); }
+	FHBFixed Size() const;
+	FHBFixed Size2D() const;
+
+	FHBFixedVector Flat() const { return FHBFixedVector(X, Y, FHBFixed()); }
+
+	//< Unit length, or zero if too short to have a direction. >
+	FHBFixedVector GetSafeNormal() const;
+
+	//< Scaled down to _MaxSize if longer. >
+	FHBFixedVector GetClampedToMaxSize(FHBFixed _MaxSize) const;
+
+	//< Removes the part along the unit _Normal. >
+	FHBFixedVector ProjectOnPlane(const FHBFixedVector& _Normal) const { return *this - _Normal * Dot(*this, _Normal); }
+};
+
+//< Square root & trigonometry without floating point. Angles are in degrees. >
+// Trigonometry reads a quarter wave sine table that is computed with integer math on first use, so it is the same on every build.
+namespace HBFixedMath
+{
+	HITBOX_API FHBFixed Sqrt(FHBFixed _Value);
+
+	HITBOX_API FHBFixed SinDeg(FHBFixed _Degrees);
+	HITBOX_API FHBFixed CosDeg(FHBFixed _Degrees);
+
+	//< Inverse of the table, _Value is clamped to [-1, 1]. >
+	HITBOX_API FHBFixed AsinDeg(FHBFixed _Value);
+	HITBOX_API FHBFixed AcosDeg(FHBFixed _Value);
+
+	//< Into (-180, 180]. >
+	HITBOX_API FHBFixed NormalizeAxis(FHBFixed _Degrees);
+
+	inline FHBFixed Abs(FHBFixed _Value) { return FHBFixed::FromRaw((_Value.Raw < 0) ? -_Value.Raw : _Value.Raw); }
+	inline FHBFixed Min(FHBFixed _A, FHBFixed _B) { return (_A < _B) ? _A : _B; }
+	inline FHBFixed Max(FHBFixed _A, FHBFixed _B) { return (_A > _B) ? _A : _B; }
+	inline FHBFixed Clamp(FHBFixed _Value, FHBFixed _Min, FHBFixed _Max) { return Max(_Min, Min(_Value, _Max)); }
+}
@@ -0,0 +1,732 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HBLockstepMovement.h"
+#include "Components/CapsuleComponent.h"
+#include "Curves/CurveFloat.h"
+#include "Misc/Crc.h"
+#include "../Pawns/HBMovementComponent.h"
+#include "../Pawns/HBPlayerCollisionComponent.h"
+#include "../Tools/HBStaticCollisionWorld.h"
+
+namespace
+{
+	bool ContactWithGround(const FHBLockstepContact& _Contact, const FHBLockstepSettings& _Settings)	{ return _Contact.GroundDistance < _Settings.GroundContactDistance;	}
+	bool IsNearGround(const FHBLockstepContact& _Contact, const FHBLockstepSettings& _Settings)		{ return _Contact.GroundDistance < _Settings.GroundNearDistance;		}
+	bool ContactWithWall(const FHBLockstepContact& _Contact, const FHBLockstepSettings& _Settings)	{ return _Contact.WallDistance < _Settings.WallContactDistance;		}
+
+	bool IsHeld(const FHBLockstepInput& _Input, uint8 _Button) { return (_Input.Buttons & _Button) != 0; }
+}
+
+FHBLockstepSettings FHBLockstepSettings::FromComponent(const UHBMovementComponent& _Movement, const UHBPlayerCollisionComponent* _Collision, float _DeltaTime)
+{
+	if (!_Collision) _Collision = GetDefault<UHBPlayerCollisionComponent>();
+
+	auto fixed = [](float _Value) { return FHBFixed::FromFloat(_Value); };
+	FHBLockstepSettings settings;
+
+	settings.DeltaTime				= fixed(_DeltaTime);
+
+	float mass = (_Collision->CapsuleComponent) ? _Collision->CapsuleComponent->BodyInstance.GetMassOverride() : 1.0f;
+	settings.Gravity				= fixed(_Movement.Gravity) * fixed(mass);
+	settings.GroundAcceleration		= fixed(_Movement.GroundAcceleration);
+	settings.GroundDeceleration		= fixed(_Movement.GroundDeceleration);
+	settings.StickToGroundForce		= fixed(_Movement.StickToGroundForce);
+	settings.CosMaxSlopeAngle		= HBFixedMath::CosDeg(fixed(_Movement.MaxSlopeAngle));
+
+	settings.WalkSpeed				= fixed(_Movement.WalkSpeed);
+	settings.RunSpeed				= fixed(_Movement.RunSpeed);
+	settings.CrouchSpeed			= fixed(_Movement.CrouchSpeed);
+	settings.SlideForce				= fixed(_Movement.SlideForce);
+	settings.SlideDeceleration		= fixed(_Movement.SlideDeceleration);
+
+	settings.AirSpeed				= fixed(_Movement.AirSpeed);
+	settings.AirAcceleration		= fixed(_Movement.AirAcceleration);
+	settings.AirDeceleration		= fixed(_Movement.AirDeceleration);
+	settings.JumpForce				= fixed(_Movement.JumpForce);
+	settings.SlideHopWindow			= fixed(_Movement.SlideHopWindow);
+
+	settings.WallRunSpeed			= fixed(_Movement.WallRunSpeed);
+	settings.WallRunAcceleration	= fixed(_Movement.WallRunAcceleration);
+	settings.WallJumpForce			= fixed(_Movement.WallJumpForce);
+	settings.WallRunDelay			= fixed(_Movement.WallRunDelay);
+	settings.StickToWallForce		= fixed(_Movement.StickToWallForce);
+	settings.CosMaxApproachVertical		= HBFixedMath::CosDeg(fixed(_Movement.MaxApproachAngleVertical));
+	settings.CosMaxApproachHorizontal	= HBFixedMath::CosDeg(fixed(_Movement.MaxApproachAngleHorizontal));
+
+	//< Curves are only read at their ends, which evaluate to the stored key values exactly. >
+	settings.WallRunDuration = FHBFixed::FromInt(2);
+	if (_Movement.WallrunFalloffCurve)
+	{
+		float minTime, maxTime;
+		_Movement.WallrunFalloffCurve->GetTimeRange(minTime, maxTime);
+		settings.WallRunDuration = fixed(maxTime);
+	}
+
+	settings.StandingHalfHeight = fixed(_Movement.PlayerHeight) / 2;
+	settings.CrouchedHalfHeight = settings.StandingHalfHeight;
+	if (_Movement.CrouchCurve)
+	{
+		float minTime, maxTime;
+		_Movement.CrouchCurve->GetTimeRange(minTime, maxTime);
+		settings.StandingHalfHeight = fixed(_Movement.PlayerHeight) * fixed(_Movement.CrouchCurve->GetFloatValue(minTime)) / 2;
+		settings.CrouchedHalfHeight = fixed(_Movement.PlayerHeight) * fixed(_Movement.CrouchCurve->GetFloatValue(maxTime)) / 2;
+		settings.CrouchTime = fixed(maxTime) - fixed(minTime);
+	}
+
+	settings.Radius					= fixed(_Movement.PlayerRadius);
+	settings.GroundNearDistance		= fixed(_Collision->GroundNearDistance);
+	settings.GroundContactDistance	= fixed(_Collision->GroundContactDistance);
+	settings.WallNearDistance		= fixed(_Collision->WallNearDistance);
+	settings.WallContactDistance	= fixed(_Collision->WallContactDistance);
+
+	return settings;
+}
+
+uint32 FHBLockstepSettings::Hash() const
+{
+	static_assert(sizeof(FHBLockstepSettings) % sizeof(FHBFixed) == 0, "FHBLockstepSettings must only hold FHBFixed fields, so its bytes have no padding.");
+	return FCrc::MemCrc32(this, sizeof(*this));
+}
+
+FHBLockstepInput FHBLockstepInput::FromStepInput(const FHBMovementStepInput& _StepInput, const FHBMovementStepInput& _PreviousInput)
+{
+	FHBLockstepInput input;
+	input.MoveX = (int8)FMath::Clamp(FMath::RoundToInt(_StepInput.Input.MovementInput.X * 127), -127, 127);
+	input.MoveY = (int8)FMath::Clamp(FMath::RoundToInt(_StepInput.Input.MovementInput.Y * 127), -127, 127);
+
+	if (_StepInput.Input.SprintPressed)							input.Buttons |= HBLockstepButton::Sprint;
+	if (_StepInput.Input.CrouchPressed)							input.Buttons |= HBLockstepButton::Crouch;
+	if (_StepInput.JumpPresses != _PreviousInput.JumpPresses)		input.Buttons |= HBLockstepButton::JumpPressed;
+	if (_StepInput.SprintPresses != _PreviousInput.SprintPresses)	input.Buttons |= HBLockstepButton::SprintPressed;
+	if (_StepInput.CrouchPresses != _PreviousInput.CrouchPresses)	input.Buttons |= HBLockstepButton::CrouchPressed;
+	if (_StepInput.CrouchReleases != _PreviousInput.CrouchReleases)	input.Buttons |= HBLockstepButton::CrouchReleased;
+
+	input.YawDelta = (int32)FMath::RoundToDouble((_StepInput.YawInput - _PreviousInput.YawInput) * FHBFixed::One);
+	return input;
+}
+
+FHBLockstepState FHBLockstepState::FromMovementState(const FHBMovementState& _State)
+{
+	FHBLockstepState state;
+	state.Location				= FHBFixedVector::FromVector(_State.Location);
+	state.Velocity				= FHBFixedVector::FromVector(_State.Velocity);
+	state.Yaw					= FHBFixed::FromFloat(_State.Yaw);
+	state.CapsuleHalfHeight		= FHBFixed::FromFloat(_State.CapsuleHalfHeight);
+
+	state.JumpDelayTimer		= FHBFixed::FromFloat(_State.JumpDelayTimer);
+	state.CrouchTimeline		= FHBFixed::FromFloat(_State.CrouchCurveTimeline);
+	state.WallRunTimeline		= FHBFixed::FromFloat(_State.WallrunFalloffTimeline);
+	state.WallRunDelayTimer		= FHBFixed::FromFloat(_State.WallRunDelayTimer);
+	state.PreviousWallNormal	= FHBFixedVector::FromVector(_State.PreviousWallNormal);
+
+	state.Grounded				= _State.Grounded;
+	state.SprintActive			= _State.SprintActive;
+	state.AttemptJump			= _State.AttemptJump;
+	state.PerformBoost			= _State.PerformBoost;
+	state.WallRunActive			= _State.WallRunActive;
+	state.WallRunSide			= _State.WallRunSide;
+	return state;
+}
+
+void FHBLockstepState::ToMovementState(FHBMovementState& _OutState) const
+{
+	_OutState.Location					= Location.ToVector();
+	_OutState.Velocity					= Velocity.ToVector();
+	_OutState.Yaw						= Yaw.ToFloat();
+	_OutState.CapsuleHalfHeight			= CapsuleHalfHeight.ToFloat();
+
+	_OutState.JumpDelayTimer			= JumpDelayTimer.ToFloat();
+	_OutState.CrouchCurveTimeline		= CrouchTimeline.ToFloat();
+	_OutState.WallrunFalloffTimeline	= WallRunTimeline.ToFloat();
+	_OutState.WallRunDelayTimer			= WallRunDelayTimer.ToFloat();
+	_OutState.PreviousWallNormal		= PreviousWallNormal.ToVector();
+
+	_OutState.Grounded					= Grounded;
+	_OutState.SprintActive				= SprintActive;
+	_OutState.AttemptJump				= AttemptJump;
+	_OutState.PerformBoost				= PerformBoost;
+	_OutState.WallRunActive				= WallRunActive;
+	_OutState.WallRunSide				= WallRunSide;
+}
+
+uint32 FHBLockstepState::Hash(uint32 _Seed) const
+{
+	//< Field by field, so padding never reaches the hash. >
+	const int64 values[] =
+	{
+		Location.X.Raw, Location.Y.Raw, Location.Z.Raw,
+		Velocity.X.Raw, Velocity.Y.Raw, Velocity.Z.Raw,
+		Yaw.Raw, CapsuleHalfHeight.Raw,
+		JumpDelayTimer.Raw, CrouchTimeline.Raw, WallRunTimeline.Raw, WallRunDelayTimer.Raw,
+		PreviousWallNormal.X.Raw, PreviousWallNormal.Y.Raw, PreviousWallNormal.Z.Raw,
+		int64(Grounded) | int64(SprintActive) << 1 | int64(AttemptJump) << 2 | int64(PerformBoost) << 3 | int64(WallRunActive) << 4 | int64(WallRunSide) << 5,
+	};
+	return FCrc::MemCrc32(values, sizeof(values), _Seed);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//< WORLD >
+
+void FHBLockstepWorld::AddBox(const FIntVector& _Min, const FIntVector& _Max)
+{
+	FFixedBox box;
+	box.Min = FHBFixedVector(FHBFixed::FromInt(_Min.X), FHBFixed::FromInt(_Min.Y), FHBFixed::FromInt(_Min.Z));
+	box.Max = FHBFixedVector(FHBFixed::FromInt(_Max.X), FHBFixed::FromInt(_Max.Y), FHBFixed::FromInt(_Max.Z));
+	Boxes.Add(box);
+}
+
+void FHBLockstepWorld::AddTestCourse()
+{
+	//< Floor. >
+	AddBox(FIntVector(-2000, -2000, -100), FIntVector(20000, 2000, 0));
+
+	//< A long wall to the right of the +X run, then a gap & a second wall on the left to chain wall runs. >
+	AddBox(FIntVector(1500, 300, 0), FIntVector(4500, 400, 600));
+	AddBox(FIntVector(5500, -400, 0), FIntVector(8500, -300, 600));
+
+	//< Steps of rising height. >
+	for (int32 i = 0; i < 4; i++)
+	{
+		int32 start = 10000 + i * 800;
+		AddBox(FIntVector(start, -500, 0), FIntVector(start + 400, 500, 40 + i * 40));
+	}
+}
+
+void FHBLockstepWorld::BakeFrom(const FHBStaticCollisionWorld& _World)
+{
+	for (const FBox& box : _World.GetBoxes())
+	{
+		AddBox(FIntVector(FMath::FloorToInt(box.Min.X), FMath::FloorToInt(box.Min.Y), FMath::FloorToInt(box.Min.Z)),
+			FIntVector(FMath::CeilToInt(box.Max.X), FMath::CeilToInt(box.Max.Y), FMath::CeilToInt(box.Max.Z)));
+	}
+}
+
+void FHBLockstepWorld::Serialize(FArchive& _Ar)
+{
+	int32 version = BoxListVersion;
+	int32 count = Boxes.Num();
+	_Ar << version << count;
+
+	if (_Ar.IsLoading())
+	{
+		Boxes.Reset();
+		Cells.Reset();
+		if (version != BoxListVersion || count < 0)
+		{
+			_Ar.SetError();
+			return;
+		}
+	}
+
+	//< Boxes only ever hold whole centimetres, so shifting back is exact. >
+	for (int32 i = 0; i < count && !_Ar.IsError(); i++)
+	{
+		FIntVector min, max;
+		if (_Ar.IsSaving())
+		{
+			const FFixedBox& box = Boxes[i];
+			min = FIntVector(int32(box.Min.X.Raw >> FHBFixed::FractionBits), int32(box.Min.Y.Raw >> FHBFixed::FractionBits), int32(box.Min.Z.Raw >> FHBFixed::FractionBits));
+			max = FIntVector(int32(box.Max.X.Raw >> FHBFixed::FractionBits), int32(box.Max.Y.Raw >> FHBFixed::FractionBits), int32(box.Max.Z.Raw >> FHBFixed::FractionBits));
+		}
+
+		_Ar << min << max;
+		if (_Ar.IsLoading() && !_Ar.IsError()) AddBox(min, max);
+	}
+}
+
+void FHBLockstepWorld::Build()
+{
+	//< Ordered by position rather than by how the level listed its actors, so ties between boxes resolve the same on every peer. >
+	Boxes.Sort([](const FFixedBox& _A, const FFixedBox& _B)
+	{
+		const int64 a[] = { _A.Min.X.Raw, _A.Min.Y.Raw, _A.Min.Z.Raw, _A.Max.X.Raw, _A.Max.Y.Raw, _A.Max.Z.Raw };
+		const int64 b[] = { _B.Min.X.Raw, _B.Min.Y.Raw, _B.Min.Z.Raw, _B.Max.X.Raw, _B.Max.Y.Raw, _B.Max.Z.Raw };
+		for (int32 i = 0; i < 6; i++)
+		{
+			if (a[i] != b[i]) return a[i] < b[i];
+		}
+		return false;
+	});
+
+	Cells.Reset();
+	FHBFixed margin = FHBFixed::FromInt(CellMargin);
+
+	for (int32 index = 0; index < Boxes.Num(); index++)
+	{
+		const FFixedBox& box = Boxes[index];
+		FIntPoint minCell = GetCell(box.Min.X - margin, box.Min.Y - margin);
+		FIntPoint maxCell = GetCell(box.Max.X + margin, box.Max.Y + margin);
+
+		for (int32 x = minCell.X; x <= maxCell.X; x++)
+		{
+			for (int32 y = minCell.Y; y <= maxCell.Y; y++)
+			{
+				Cells.FindOrAdd(FIntPoint(x, y)).Add(index);
+			}
+		}
+	}
+}
+
+void FHBLockstepWorld::QueryContact(const FHBFixedVector& _Location, FHBFixed _HalfHeight, const FHBLockstepSettings& _Settings, FHBLockstepContact& _OutContact) const
+{
+	_OutContact = FHBLockstepContact();
+
+	const TArray<int32>* candidates = Cells.Find(GetCell(_Location.X, _Location.Y));
+	if (!candidates) return;
+
+	FHBFixed groundRadius = _Settings.Radius * FHBFixed::FromFloat(0.95f);
+	const FFixedBox* wallBox = nullptr;
+	FHBFixedVector wallPoint;
+	FHBFixed wallDistance = _Settings.Radius + _Settings.WallNearDistance;
+
+	for (int32 index : *candidates)
+	{
+		const FFixedBox& box = Boxes[index];
+		FHBFixedVector closest(HBFixedMath::Clamp(_Location.X, box.Min.X, box.Max.X), HBFixedMath::Clamp(_Location.Y, box.Min.Y, box.Max.Y), _Location.Z);
+		FHBFixed flatDistance = (_Location - closest).Size2D();
+
+		//< Ground: the highest top below the centre. Tops are flat. >
+		if (box.Max.Z <= _Location.Z)
+		{
+			FHBFixed distance = _Location.Z - box.Max.Z - _HalfHeight;
+			if (flatDistance < groundRadius && distance < _OutContact.GroundDistance) _OutContact.GroundDistance = distance;
+			continue;
+		}
+
+		//< Wall: the nearest side at the height of the centre. >
+		if (box.Min.Z <= _Location.Z && flatDistance < wallDistance)
+		{
+			wallBox = &box;
+			wallPoint = closest;
+			wallDistance = flatDistance;
+		}
+	}
+
+	if (!wallBox) return;
+
+	FHBFixedVector normal = (_Location - wallPoint).Flat();
+	if (wallDistance.Raw < 16)
+	{
+		//< Centre inside the box, push out through the nearest side. >
+		FHBFixed toMinX = _Location.X - wallBox->Min.X, toMaxX = wallBox->Max.X - _Location.X;
+		FHBFixed toMinY = _Location.Y - wallBox->Min.Y, toMaxY = wallBox->Max.Y - _Location.Y;
+		FHBFixed nearest = HBFixedMath::Min(HBFixedMath::Min(toMinX, toMaxX), HBFixedMath::Min(toMinY, toMaxY));
+
+		FHBFixed one = FHBFixed::FromInt(1), zero;
+		normal = (nearest == toMinX) ? FHBFixedVector(-one, zero, zero) : (nearest == toMaxX) ? FHBFixedVector(one, zero, zero) : (nearest == toMinY) ? FHBFixedVector(zero, -one, zero) : FHBFixedVector(zero, one, zero);
+		wallDistance = -nearest;
+	}
+	else
+	{
+		normal = normal / wallDistance;
+	}
+
+	_OutContact.WallDistance	= wallDistance - _Settings.Radius;
+	_OutContact.WallNormal		= normal;
+	_OutContact.WallImpactPoint = wallPoint;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//< RULES >
+
+void FHBLockstepMovement::Step(FHBLockstepState& _State, const FHBLockstepInput& _Input, const FHBLockstepWorld& _World, const FHBLockstepSettings& _Settings)
+{
+	FHBLockstepContact contact;
+	_World.QueryContact(_State.Location, _State.CapsuleHalfHeight, _Settings, contact);
+
+	_State.CameraYaw = FHBFixed();
+	_State.CameraRoll = FHBFixed();
+
+	ApplyInput(_State, _Input, _Settings);
+	StepRules(_State, _Input, contact, _Settings);
+	Integrate(_State, _World, _Settings);
+}
+
+void FHBLockstepMovement::ApplyInput(FHBLockstepState& _State, const FHBLockstepInput& _Input, const FHBLockstepSettings& _Settings)
+{
+	if (IsHeld(_Input, HBLockstepButton::JumpPressed))
+	{
+		_State.AttemptJump = true;
+		_State.JumpDelayTimer = _Settings.SlideHopWindow;
+	}
+
+	if (IsHeld(_Input, HBLockstepButton::SprintPressed))
+	{
+		_State.SprintActive = true;
+	}
+
+	if (IsHeld(_Input, HBLockstepButton::CrouchPressed))
+	{
+		_State.SprintActive = false;
+		if (IsSliding(_State, true, _Settings)) _State.PerformBoost = true;
+	}
+
+	if (IsHeld(_Input, HBLockstepButton::CrouchReleased))
+	{
+		_State.PerformBoost = false;
+		if (IsHeld(_Input, HBLockstepButton::Sprint)) _State.SprintActive = true;
+	}
+
+	_State.Yaw = HBFixedMath::NormalizeAxis(_State.Yaw + FHBFixed::FromRaw(_Input.YawDelta));
+}
+
+void FHBLockstepMovement::StepRules(FHBLockstepState& _State, const FHBLockstepInput& _Input, const FHBLockstepContact& _Contact, const FHBLockstepSettings& _Settings)
+{
+	//< Check for disable sprint. >
+	if (!IsHeld(_Input, HBLockstepButton::Sprint) && _State.SprintActive)
+	{
+		if (_State.Velocity.Size2D() < (_Settings.WalkSpeed + _Settings.RunSpeed) / 2) _State.SprintActive = false;
+	}
+
+	TickCapsuleHeight(_State, IsHeld(_Input, HBLockstepButton::Crouch), _Settings);
+
+	if (_State.WallRunDelayTimer > FHBFixed()) _State.WallRunDelayTimer -= _Settings.DeltaTime;
+
+	if (_State.WallRunActive)
+	{
+		WallRun(_State, _Contact, _Settings);
+		return;
+	}
+
+	if (ContactWithGround(_Contact, _Settings))
+	{
+		//< Steeper than MaxSlopeAngle means a ground normal Z below its cosine, no Acos needed. >
+		_State.Grounded = _Contact.GroundNormal.Z >= _Settings.CosMaxSlopeAngle;
+	}
+	else if (!IsNearGround(_Contact, _Settings))
+	{
+		_State.Grounded = false;
+	}
+
+	if (_State.Grounded)
+	{
+		if (_State.AttemptJump)
+		{
+			Jump(_State, _Contact, _Settings);
+			return;
+		}
+
+		GroundMove(_State, _Input, _Contact, _Settings);
+
+		//< Stick to ground. >
+		if (!ContactWithGround(_Contact, _Settings))
+		{
+			_State.Velocity -= _Contact.GroundNormal * ((_Settings.StickToGroundForce + _State.Velocity.Size2D() / 10) * 100 * _Settings.DeltaTime);
+		}
+	}
+	else if (ShouldStartWallRun(_State, _Input, _Contact, _Settings))
+	{
+		StartWallRun(_State, _Contact);
+	}
+	else
+	{
+		_State.Velocity.Z -= _Settings.Gravity * _Settings.DeltaTime;
+		AirMove(_State, _Input, _Settings);
+	}
+}
+
+void FHBLockstepMovement::GroundMove(FHBLockstepState& _State, const FHBLockstepInput& _Input, const FHBLockstepContact& _Contact, const FHBLockstepSettings& _Settings)
+{
+	bool crouching = IsHeld(_Input, HBLockstepButton::Crouch);
+	bool sliding = IsSliding(_State, crouching, _Settings);
+	FHBFixedVector targetVel = GetMoveDirection(_State, _Input);
+	FHBFixedVector deltaVel;
+
+	//< Check for slide boost. >
+	bool boost = false;
+	if (sliding && _State.PerformBoost)
+	{
+		FHBFixed horizontalSpeed = _State.Velocity.Size2D();
+		boost = horizontalSpeed > (_Settings.WalkSpeed + _Settings.RunSpeed) / 2 && horizontalSpeed < _Settings.SlideForce;
+		if (!boost) _State.PerformBoost = false;
+	}
+
+	if (boost)
+	{
+		_State.PerformBoost = false;
+		deltaVel = (targetVel * _Settings.SlideForce - _State.Velocity).Flat();
+	}
+	else
+	{
+		//< When sliding ignore directional input. >
+		if (sliding)									targetVel = FHBFixedVector();
+		else if (crouching)								targetVel = targetVel * _Settings.CrouchSpeed;
+		else if (_State.SprintActive && _Input.MoveX > 0)	targetVel = targetVel * _Settings.RunSpeed;
+		else											targetVel = targetVel * _Settings.WalkSpeed;
+
+		bool accelerating = FHBFixedVector::Dot(targetVel, _State.Velocity) > FHBFixed();
+		FHBFixed accelValue = (accelerating) ? _Settings.GroundAcceleration : (sliding) ? _Settings.SlideDeceleration : _Settings.GroundDeceleration;
+
+		deltaVel = (targetVel - _State.Velocity).GetClampedToMaxSize(accelValue * _Settings.DeltaTime).Flat();
+	}
+
+	//< Adjust target velocity via ground normal. >
+	_State.Velocity += deltaVel.ProjectOnPlane(_Contact.GroundNormal);
+}
+
+void FHBLockstepMovement::AirMove(FHBLockstepState& _State, const FHBLockstepInput& _Input, const FHBLockstepSettings& _Settings)
+{
+	if (_State.AttemptJump)
+	{
+		if (_State.JumpDelayTimer > FHBFixed()) _State.JumpDelayTimer -= _Settings.DeltaTime;
+		if (_State.JumpDelayTimer <= FHBFixed()) _State.AttemptJump = false;
+	}
+
+	FHBFixedVector targetVel = GetMoveDirection(_State, _Input);
+
+	//< While accelerating, try to maintain current speed if it's higher than our air speed. >
+	bool accelerating = FHBFixedVector::Dot(targetVel, _State.Velocity) > FHBFixed();
+	FHBFixed accelValue = (accelerating) ? _Settings.AirAcceleration : _Settings.AirDeceleration;
+	targetVel = targetVel * ((accelerating) ? HBFixedMath::Max(_Settings.AirSpeed, _State.Velocity.Size2D()) : _Settings.AirSpeed);
+
+	_State.Velocity += (targetVel - _State.Velocity).GetClampedToMaxSize(accelValue * _Settings.DeltaTime).Flat();
+}
+
+void FHBLockstepMovement::WallRun(FHBLockstepState& _State, const FHBLockstepContact& _Contact, const FHBLockstepSettings& _Settings)
+{
+	//< Check for drop off. >
+	if (_State.WallRunTimeline > _Settings.WallRunDuration)
+	{
+		StopWallRun(_State, _Settings, _Contact.WallNormal * FHBFixed::FromInt(35), false);
+		_State.WallRunDelayTimer = _Settings.WallRunDelay * 3;
+		return;
+	}
+
+	//< Check for wall jump. >
+	if (_State.AttemptJump)
+	{
+		FHBFixedVector exitVelocity = GetForward(_State.Yaw) * _Settings.WallJumpForce;
+		exitVelocity.Z += _Settings.WallJumpForce / 2;
+		StopWallRun(_State, _Settings, exitVelocity, true);
+		return;
+	}
+
+	//< Turn with the wall. The only angle taken from the table, every threshold elsewhere compares cosines. >
+	FHBFixed wallAngleDelta = HBFixedMath::AcosDeg(FHBFixedVector::Dot(_State.PreviousWallNormal.GetSafeNormal(), _Contact.WallNormal.GetSafeNormal()));
+	if (wallAngleDelta < FHBFixed::FromFloat(0.03f)) wallAngleDelta = FHBFixed();
+
+	bool redirectVelocity = false;
+	if (wallAngleDelta != FHBFixed())
+	{
+		//< Exit wallrun if hit a normal too different than our current surface. >
+		if (wallAngleDelta > FHBFixed::FromInt(45))
+		{
+			StopWallRun(_State, _Settings, FHBFixedVector(), false);
+			return;
+		}
+
+		//< The old normal turned 90 degrees about up. >
+		FHBFixedVector oldWallNormalRight(-_State.PreviousWallNormal.Y, _State.PreviousWallNormal.X, FHBFixed());
+		if (FHBFixedVector::Dot(_Contact.WallNormal, oldWallNormalRight) < FHBFixed()) wallAngleDelta = -wallAngleDelta;
+		redirectVelocity = true;
+	}
+	_State.CameraYaw += wallAngleDelta;
+
+	//< Accelerate along wall, 90 degrees either side of its normal. >
+	FHBFixedVector wallNormal = _Contact.WallNormal.Flat();
+	FHBFixedVector wallRunDirection = ((_State.WallRunSide)
+		? FHBFixedVector(-wallNormal.Y, wallNormal.X, FHBFixed())
+		: FHBFixedVector(wallNormal.Y, -wallNormal.X, FHBFixed())).GetSafeNormal();
+
+	if (redirectVelocity)
+	{
+		_State.Velocity = wallRunDirection * _State.Velocity.Size2D();
+	}
+	else
+	{
+		_State.Velocity += (wallRunDirection * _Settings.WallRunSpeed - _State.Velocity).GetClampedToMaxSize(_Settings.WallRunAcceleration * _Settings.DeltaTime);
+	}
+
+	//< Stick to wall. >
+	_State.Velocity -= _Contact.WallNormal * ((_Settings.StickToWallForce + _State.Velocity.Size2D() / 10) * 100 * _Settings.DeltaTime);
+
+	_State.WallRunTimeline += _Settings.DeltaTime;
+	_State.PreviousWallNormal = _Contact.WallNormal;
+}
+
+void FHBLockstepMovement::Jump(FHBLockstepState& _State, const FHBLockstepContact& _Contact, const FHBLockstepSettings& _Settings)
+{
+	//< Move outside range of the ground check to prevent "landing" on the next step. >
+	FHBFixed preJumpDistance = _Settings.GroundContactDistance;
+	if (_Contact.GroundDistance < FHBFixed()) preJumpDistance += HBFixedMath::Abs(_Contact.GroundDistance);
+
+	_State.Location.Z += preJumpDistance;
+	_State.Velocity.Z = _Settings.JumpForce;
+	_State.AttemptJump = false;
+	_State.Grounded = false;
+}
+
+bool FHBLockstepMovement::IsSliding(const FHBLockstepState& _State, bool _Crouching, const FHBLockstepSettings& _Settings)
+{
+	return _State.Grounded && _Crouching && _State.Velocity.Size() > _Settings.WalkSpeed;
+}
+
+bool FHBLockstepMovement::ShouldStartWallRun(const FHBLockstepState& _State, const FHBLockstepInput& _Input, const FHBLockstepContact& _Contact, const FHBLockstepSettings& _Settings)
+{
+	if (_State.Velocity.Z <= FHBFixed::FromInt(-500)) return false;
+	if (IsHeld(_Input, HBLockstepButton::Crouch) || _State.Velocity.Size2D() <= (_Settings.CrouchSpeed + _Settings.WalkSpeed) / 2) return false;
+	if (_State.WallRunDelayTimer > FHBFixed() || !ContactWithWall(_Contact, _Settings)) return false;
+
+	//< Angle of approach between the limits. A wider angle has a smaller cosine. >
+	FHBFixed approach = FHBFixedVector::Dot(-_Contact.WallNormal.GetSafeNormal(), GetForward(_State.Yaw));
+	return approach < _Settings.CosMaxApproachVertical && approach > _Settings.CosMaxApproachHorizontal;
+}
+
+void FHBLockstepMovement::StartWallRun(FHBLockstepState& _State, const FHBLockstepContact& _Contact)
+{
+	//< Calculate wall side. >
+	FHBFixedVector directionVector = (_State.Location - _Contact.WallImpactPoint).GetSafeNormal();
+	FHBFixedVector rightVector(-HBFixedMath::SinDeg(_State.Yaw), HBFixedMath::CosDeg(_State.Yaw), FHBFixed());
+	_State.WallRunSide = FHBFixedVector::Dot(directionVector, rightVector) < FHBFixed();
+
+	_State.CameraRoll += FHBFixed::FromInt((_State.WallRunSide) ? -10 : 10);
+
+	_State.WallRunActive = true;
+	_State.WallRunTimeline = FHBFixed();
+	_State.PreviousWallNormal = _Contact.WallNormal;
+	_State.WallRunDelayTimer = FHBFixed();
+}
+
+void FHBLockstepMovement::StopWallRun(FHBLockstepState& _State, const FHBLockstepSettings& _Settings, FHBFixedVector _ExitVelocity, bool _VelocityChange)
+{
+	if (!_ExitVelocity.IsZero())
+	{
+		if (_VelocityChange)
+		{
+			_State.Velocity = _ExitVelocity;
+		}
+		else
+		{
+			_State.Velocity += _ExitVelocity;
+			_State.Velocity.Z = _ExitVelocity.Z;
+		}
+	}
+
+	//< Reset camera roll. Cancelling the remaining camera yaw is left to the presentation, see FHBLockstepState::CameraYaw. >
+	_State.CameraRoll += FHBFixed::FromInt((_State.WallRunSide) ? 10 : -10);
+
+	_State.WallRunDelayTimer = _Settings.WallRunDelay;
+	_State.WallRunActive = false;
+	_State.AttemptJump = false;
+	_State.Grounded = false;
+}
+
+void FHBLockstepMovement::TickCapsuleHeight(FHBLockstepState& _State, bool _Crouching, const FHBLockstepSettings& _Settings)
+{
+	if (_Settings.CrouchTime <= FHBFixed()) return;
+
+	//< Abort if target reached. >
+	FHBFixed targetTime = (_Crouching) ? _Settings.CrouchTime : FHBFixed();
+	if (_State.CrouchTimeline == targetTime) return;
+
+	_State.CrouchTimeline = HBFixedMath::Clamp(_State.CrouchTimeline + ((_Crouching) ? _Settings.DeltaTime : -_Settings.DeltaTime), FHBFixed(), _Settings.CrouchTime);
+
+	FHBFixed newHalfHeight = _Settings.StandingHalfHeight + (_Settings.CrouchedHalfHeight - _Settings.StandingHalfHeight) * (_State.CrouchTimeline / _Settings.CrouchTime);
+	_State.Location.Z += newHalfHeight - _State.CapsuleHalfHeight;
+	_State.CapsuleHalfHeight = newHalfHeight;
+}
+
+void FHBLockstepMovement::Integrate(FHBLockstepState& _State, const FHBLockstepWorld& _World, const FHBLockstepSettings& _Settings)
+{
+	_State.Location += _State.Velocity * _Settings.DeltaTime;
+
+	FHBLockstepContact contact;
+	_World.QueryContact(_State.Location, _State.CapsuleHalfHeight, _Settings, contact);
+
+	if (contact.HasGround() && contact.GroundDistance < FHBFixed())
+	{
+		_State.Location.Z -= contact.GroundDistance;
+
+		FHBFixed intoGround = FHBFixedVector::Dot(_State.Velocity, contact.GroundNormal);
+		if (intoGround < FHBFixed()) _State.Velocity -= contact.GroundNormal * intoGround;
+	}
+
+	if (contact.HasWall() && contact.WallDistance < FHBFixed())
+	{
+		FHBFixedVector flatNormal = contact.WallNormal.Flat().GetSafeNormal();
+		_State.Location -= flatNormal * contact.WallDistance;
+
+		FHBFixed intoWall = FHBFixedVector::Dot(_State.Velocity, flatNormal);
+		if (intoWall < FHBFixed()) _State.Velocity -= flatNormal * intoWall;
+	}
+}
+
+FHBFixedVector FHBLockstepMovement::GetMoveDirection(const FHBLockstepState& _State, const FHBLockstepInput& _Input)
+{
+	if (_Input.MoveX == 0 && _Input.MoveY == 0) return FHBFixedVector();
+
+	FHBFixed x = FHBFixed::FromInt(_Input.MoveX);
+	FHBFixed y = FHBFixed::FromInt(_Input.MoveY);
+	FHBFixed cosYaw = HBFixedMath::CosDeg(_State.Yaw);
+	FHBFixed sinYaw = HBFixedMath::SinDeg(_State.Yaw);
+	return FHBFixedVector(x * cosYaw - y * sinYaw, x * sinYaw + y * cosYaw, FHBFixed()).GetSafeNormal();
+}
+
+FHBFixedVector FHBLockstepMovement::GetForward(FHBFixed _Yaw)
+{
+	return FHBFixedVector(HBFixedMath::CosDeg(_Yaw), HBFixedMath::SinDeg(_Yaw), FHBFixed());
+}
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//< DETERMINISM >
+
+void FHBLockstepMovement::RunDeterminismScript(const FHBLockstepSettings& _Settings, int32 _Steps, TArray<uint32>& _OutHashes)
+{
+	FHBLockstepWorld world;
+	world.AddTestCourse();
+	world.Build();
+
+	FHBLockstepState state;
+	state.CapsuleHalfHeight = _Settings.StandingHalfHeight;
+	state.Location = FHBFixedVector(FHBFixed(), FHBFixed(), _Settings.StandingHalfHeight);
+
+	//< Integer generator, so the script is the same on every build too. >
+	uint32 random = 1;
+	auto next = [&random](uint32 _Range) { random = random * 1664525u + 1013904223u; return (random >> 8) % _Range; };
+
+	FHBLockstepInput input;
+	uint32 hash = _Settings.Hash();
+	_OutHashes.Reset(_Steps);
+
+	for (int32 step = 0; step < _Steps; step++)
+	{
+		//< Held buttons carry over, presses & turns last one step. >
+		input.Buttons &= HBLockstepButton::Sprint | HBLockstepButton::Crouch;
+		input.YawDelta = 0;
+
+		//< New stick & buttons every 30 steps. Mostly forward, so runs reach the walls & steps of the course. >
+		if (step % 30 == 0)
+		{
+			input.MoveX = (int8)next(128);
+			input.MoveY = (int8)(int32(next(255)) - 127);
+			input.YawDelta = int32((int64(next(61)) - 30) * FHBFixed::One / 2);
+
+			switch (next(6))
+			{
+			case 0:
+			case 1:
+				input.Buttons |= HBLockstepButton::JumpPressed;
+				break;
+			case 2:
+				if (!IsHeld(input, HBLockstepButton::Sprint)) input.Buttons |= HBLockstepButton::Sprint | HBLockstepButton::SprintPressed;
+				break;
+			case 3:
+				if (!IsHeld(input, HBLockstepButton::Crouch)) input.Buttons |= HBLockstepButton::Crouch | HBLockstepButton::CrouchPressed;
+				break;
+			case 4:
+				if (IsHeld(input, HBLockstepButton::Crouch)) input.Buttons = (uint8)((input.Buttons & ~HBLockstepButton::Crouch) | HBLockstepButton::CrouchReleased);
+				break;
+			default:
+				input.Buttons &= (uint8)~HBLockstepButton::Sprint;
+				break;
+			}
+		}
+
+		Step(state, input, world, _Settings);
+		hash = state.Hash(hash);
+		_OutHashes.Add(hash);
+	}
+}
@@ -0,0 +1,214 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HBFixedMath.h"
+#include "../Pawns/HBMovementTypes.h"
+
+class UHBMovementComponent;
+class UHBPlayerCollisionComponent;
+class FHBStaticCollisionWorld;
+
+//< UHBMovementComponent's configuration in fixed point, see FHBLockstepMovement. >
+// Converted once from the configured floats, which every build reads the same, so every peer steps with identical numbers.
+struct HITBOX_API FHBLockstepSettings
+{
+	FHBFixed DeltaTime;
+
+	FHBFixed Gravity; //< Already scaled by the body mass, as ApplyGravity does. >
+	FHBFixed GroundAcceleration;
+	FHBFixed GroundDeceleration;
+	FHBFixed StickToGroundForce;
+	FHBFixed CosMaxSlopeAngle; //< Ground normals are compared against this instead of taking an Acos. >
+
+	FHBFixed WalkSpeed;
+	FHBFixed RunSpeed;
+	FHBFixed CrouchSpeed;
+	FHBFixed SlideForce;
+	FHBFixed SlideDeceleration;
+
+	FHBFixed AirSpeed;
+	FHBFixed AirAcceleration;
+	FHBFixed AirDeceleration;
+	FHBFixed JumpForce;
+	FHBFixed SlideHopWindow;
+
+	FHBFixed WallRunSpeed;
+	FHBFixed WallRunAcceleration;
+	FHBFixed WallJumpForce;
+	FHBFixed WallRunDelay;
+	FHBFixed StickToWallForce;
+	FHBFixed CosMaxApproachVertical;
+	FHBFixed CosMaxApproachHorizontal;
+	FHBFixed WallRunDuration; //< End of the WallrunFalloffCurve. >
+
+	//< The CrouchCurve reduced to a linear blend between its two ends. >
+	FHBFixed StandingHalfHeight;
+	FHBFixed CrouchedHalfHeight;
+	FHBFixed CrouchTime;
+
+	//< Query sizes & thresholds, as on the HBPlayerCollisionComponent. >
+	FHBFixed Radius;
+	FHBFixed GroundNearDistance;
+	FHBFixed GroundContactDistance;
+	FHBFixed WallNearDistance;
+	FHBFixed WallContactDistance;
+
+	//< _Collision may be null, its class defaults are used then. >
+	static FHBLockstepSettings FromComponent(const UHBMovementComponent& _Movement, const UHBPlayerCollisionComponent* _Collision, float _DeltaTime);
+
+	//< Of every field, so peers can check they run the same configuration before starting. >
+	uint32 Hash() const;
+};
+
+namespace HBLockstepButton
+{
+	//< Held. >
+	constexpr uint8 Sprint			= 1 << 0;
+	constexpr uint8 Crouch			= 1 << 1;
+
+	//< Pressed or released since the previous step. >
+	constexpr uint8 JumpPressed		= 1 << 2;
+	constexpr uint8 SprintPressed	= 1 << 3;
+	constexpr uint8 CrouchPressed	= 1 << 4;
+	constexpr uint8 CrouchReleased	= 1 << 5;
+}
+
+//< One step of one player's input, all a lockstep peer has to send. >
+struct HITBOX_API FHBLockstepInput
+{
+	int8 MoveX = 0; //< Forward, -127 to 127. >
+	int8 MoveY = 0; //< Right. >
+	uint8 Buttons = 0; //< HBLockstepButton flags. >
+	int32 YawDelta = 0; //< Raw FHBFixed degrees turned since the previous step. >
+
+	//< Quantizes what the game thread handed to the step. Only the owning peer does this, the others receive the result. >
+	static FHBLockstepInput FromStepInput(const FHBMovementStepInput& _StepInput, const FHBMovementStepInput& _PreviousInput);
+};
+
+//< The part of FHBMovementState the ground, air, slide & wall run rules use, in fixed point. >
+struct HITBOX_API FHBLockstepState
+{
+	FHBFixedVector Location;
+	FHBFixedVector Velocity;
+	FHBFixed Yaw;
+	FHBFixed CapsuleHalfHeight;
+
+	FHBFixed JumpDelayTimer;
+	FHBFixed CrouchTimeline;
+	FHBFixed WallRunTimeline;
+	FHBFixed WallRunDelayTimer;
+	FHBFixedVector PreviousWallNormal;
+
+	bool Grounded = true;
+	bool SprintActive = false;
+	bool AttemptJump = false;
+	bool PerformBoost = false;
+	bool WallRunActive = false;
+	bool WallRunSide = false;
+
+	//< Camera rotation the last step asked for (wall run roll & turns). Only for presentation, so not hashed. >
+	FHBFixed CameraYaw;
+	FHBFixed CameraRoll;
+
+	//< For starting from a placed or respawned character. Floats round to the fixed point grid, see FHBFixed::FromFloat. >
+	static FHBLockstepState FromMovementState(const FHBMovementState& _State);
+
+	//< Writes the fields above into _OutState, leaving its camera rotation & abilities alone. >
+	void ToMovementState(FHBMovementState& _OutState) const;
+
+	//< Of every simulated field, for comparing peers & builds. >
+	uint32 Hash(uint32 _Seed) const;
+};
+
+//< Ground & wall found by FHBLockstepWorld::QueryContact. >
+struct HITBOX_API FHBLockstepContact
+{
+	FHBFixed GroundDistance = FHBFixed::FromInt(9999);
+	FHBFixedVector GroundNormal = FHBFixedVector::Up();
+
+	FHBFixed WallDistance = FHBFixed::FromInt(9999);
+	FHBFixedVector WallNormal;
+	FHBFixedVector WallImpactPoint;
+
+	bool HasGround() const { return GroundDistance < FHBFixed::FromInt(9999); }
+	bool HasWall() const { return WallDistance < FHBFixed::FromInt(9999); }
+};
+
+//< Static level collision as boxes in whole centimetres, queried with integer math only. >
+// Only ever filled from integers: authored boxes, the test course, or a box list baked from a level once & loaded by every peer,
+// so level bounds that float math computed differently on another build never reach the simulation. See hb.Lockstep.BakeCollision.
+// Immutable once built. Answers the same ground & wall questions as FHBStaticCollisionWorld, without ledges.
+class HITBOX_API FHBLockstepWorld
+{
+public:
+	void AddBox(const FIntVector& _Min, const FIntVector& _Max);
+
+	//< FHBStaticCollisionWorld::AddTestCourse in whole centimetres. >
+	void AddTestCourse();
+
+	//< _World's boxes snapped outwards to whole centimetres. Float bounds, so only for baking a box list on one machine. >
+	void BakeFrom(const FHBStaticCollisionWorld& _World);
+
+	//< The box list, for baking to a file & loading on every peer. Loading replaces the boxes & sets an error on bad data, Build after. >
+	void Serialize(FArchive& _Ar);
+
+	//< Must be called after the last box is added & before querying. >
+	void Build();
+
+	int32 NumBoxes() const { return Boxes.Num(); }
+
+	void QueryContact(const FHBFixedVector& _Location, FHBFixed _HalfHeight, const FHBLockstepSettings& _Settings, FHBLockstepContact& _OutContact) const;
+
+private:
+	struct FFixedBox
+	{
+		FHBFixedVector Min;
+		FHBFixedVector Max;
+	};
+
+	static constexpr int32 BoxListVersion = 1;
+	static constexpr int32 CellShift = FHBFixed::FractionBits + 10; //< 1024 cm cells. >
+	static constexpr int32 CellMargin = 256; //< Widest horizontal reach of a query, cm. >
+
+	static FIntPoint GetCell(FHBFixed _X, FHBFixed _Y) { return FIntPoint(int32(_X.Raw >> CellShift), int32(_Y.Raw >> CellShift)); }
+
+	TArray<FFixedBox> Boxes;
+	TMap<FIntPoint, TArray<int32>> Cells; //< Boxes within CellMargin of each cell. >
+};
+
+//< The ground, air, slide & wall run rules of UHBMovementComponent in fixed point, against a FHBLockstepWorld. >
+// Peers stepping the same inputs from the same state end up with bit identical states on any compiler & CPU, so lockstep
+// only has to exchange FHBLockstepInputs. Abilities, surface profiles & the crouch curve's shape are not part of it.
+struct HITBOX_API FHBLockstepMovement
+{
+	//< Queries the world, applies _Input, runs the rules & moves _State by one _Settings.DeltaTime. >
+	static void Step(FHBLockstepState& _State, const FHBLockstepInput& _Input, const FHBLockstepWorld& _World, const FHBLockstepSettings& _Settings);
+
+	//< Scripted inputs on the test course, hashing the state after every step. The same settings must give the same hashes on every build. >
+	static void RunDeterminismScript(const FHBLockstepSettings& _Settings, int32 _Steps, TArray<uint32>& _OutHashes);
+
+private:
+	static void ApplyInput(FHBLockstepState& _State, const FHBLockstepInput& _Input, const FHBLockstepSettings& _Settings);
+	static void StepRules(FHBLockstepState& _State, const FHBLockstepInput& _Input, const FHBLockstepContact& _Contact, const FHBLockstepSettings& _Settings);
+
+	static void GroundMove(FHBLockstepState& _State, const FHBLockstepInput& _Input, const FHBLockstepContact& _Contact, const FHBLockstepSettings& _Settings);
+	static void AirMove(FHBLockstepState& _State, const FHBLockstepInput& _Input, const FHBLockstepSettings& _Settings);
+	static void WallRun(FHBLockstepState& _State, const FHBLockstepContact& _Contact, const FHBLockstepSettings& _Settings);
+	static void Jump(FHBLockstepState& _State, const FHBLockstepContact& _Contact, const FHBLockstepSettings& _Settings);
+
+	static bool IsSliding(const FHBLockstepState& _State, bool _Crouching, const FHBLockstepSettings& _Settings);
+	static bool ShouldStartWallRun(const FHBLockstepState& _State, const FHBLockstepInput& _Input, const FHBLockstepContact& _Contact, const FHBLockstepSettings& _Settings);
+	static void StartWallRun(FHBLockstepState& _State, const FHBLockstepContact& _Contact);
+	static void StopWallRun(FHBLockstepState& _State, const FHBLockstepSettings& _Settings, FHBFixedVector _ExitVelocity, bool _VelocityChange);
+
+	static void TickCapsuleHeight(FHBLockstepState& _State, bool _Crouching, const FHBLockstepSettings& _Settings);
+
+	//< Moves by the velocity & pushes out of the ground & wall, as UHBMovementComponent::IntegratePrediction does with planes. >
+	static void Integrate(FHBLockstepState& _State, const FHBLockstepWorld& _World, const FHBLockstepSettings& _Settings);
+
+	//< Input direction turned by the yaw, unit length or zero. >
+	static FHBFixedVector GetMoveDirection(const FHBLockstepState& _State, const FHBLockstepInput& _Input);
+	static FHBFixedVector GetForward(FHBFixed _Yaw);
+};
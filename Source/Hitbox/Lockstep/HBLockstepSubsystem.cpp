@@ -0,0 +1,138 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HBLockstepSubsystem.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "../Pawns/HBMovementComponent.h"
+#include "../Tools/HBStaticCollisionWorld.h"
+
+static FAutoConsoleCommandWithWorldAndArgs LockstepDeterminismCommand(
+	TEXT("hb.Lockstep.DeterminismCheck"),
+	TEXT("hb.Lockstep.DeterminismCheck [Steps] [OtherBuild.txt]: Runs scripted inputs through the fixed point movement on the test course with the player's movement settings, or the class defaults, ")
+	TEXT("& writes the state hash after every step to Saved/Lockstep/<Platform>_<Configuration>.txt. Given the file another build wrote, reports the first step where the two differ."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& _Args, UWorld* _World)
+	{
+		int32 steps = (_Args.Num() > 0) ? FMath::Max(FCString::Atoi(*_Args[0]), 1) : 3600;
+
+		const UHBMovementComponent* movement = GetDefault<UHBMovementComponent>();
+		const UHBPlayerCollisionComponent* collision = nullptr;
+		APlayerController* controller = (_World) ? _World->GetFirstPlayerController() : nullptr;
+		if (APawn* pawn = (controller) ? controller->GetPawn() : nullptr)
+		{
+			if (UHBMovementComponent* playerMovement = pawn->FindComponentByClass<UHBMovementComponent>())
+			{
+				movement = playerMovement;
+				collision = playerMovement->GetCollisionComponent();
+			}
+		}
+
+		FHBLockstepSettings settings = FHBLockstepSettings::FromComponent(*movement, collision, movement->LockstepStepTime);
+		TArray<uint32> hashes;
+		FHBLockstepMovement::RunDeterminismScript(settings, steps, hashes);
+
+		FString settingsLine = FString::Printf(TEXT("settings %08x"), settings.Hash());
+		FString text = settingsLine + TEXT("\n");
+		for (uint32 hash : hashes) text += FString::Printf(TEXT("%08x\n"), hash);
+
+		FString filename = FPaths::ProjectSavedDir() / TEXT("Lockstep") / FString::Printf(TEXT("%s_%s.txt"), ANSI_TO_TCHAR(FPlatformProperties::PlatformName()), LexToString(FApp::GetBuildConfiguration()));
+		FFileHelper::SaveStringToFile(text, *filename);
+		UE_LOG(LogTemp, Display, TEXT("Lockstep determinism: %d steps, %s, final hash %08x. Wrote %s."), steps, *settingsLine, hashes.Last(), *filename);
+
+		if (_Args.Num() < 2) return;
+
+		//< The other build's file, as given or next to this one's. >
+		TArray<FString> otherLines;
+		if (!FFileHelper::LoadFileToStringArray(otherLines, *_Args[1]) && !FFileHelper::LoadFileToStringArray(otherLines, *(FPaths::ProjectSavedDir() / TEXT("Lockstep") / _Args[1])))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Lockstep determinism: could not read %s."), *_Args[1]);
+			return;
+		}
+
+		if (otherLines.Num() == 0 || otherLines[0] != settingsLine)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Lockstep determinism: %s was made with other settings, nothing to compare."), *_Args[1]);
+			return;
+		}
+
+		int32 compared = FMath::Min(hashes.Num(), otherLines.Num() - 1);
+		for (int32 i = 0; i < compared; i++)
+		{
+			if (FParse::HexNumber(*otherLines[i + 1]) != hashes[i])
+			{
+				UE_LOG(LogTemp, Error, TEXT("Lockstep determinism: differs from %s from step %d on."), *_Args[1], i);
+				return;
+			}
+		}
+		UE_LOG(LogTemp, Display, TEXT("Lockstep determinism: matches %s over %d steps."), *_Args[1], compared);
+	}));
+
+static FAutoConsoleCommandWithWorld LockstepBakeCollisionCommand(
+	TEXT("hb.Lockstep.BakeCollision"),
+	TEXT("Snaps the current map's static collision to whole centimetre boxes & writes them to Content/Lockstep/<Map>.hbboxes. ")
+	TEXT("Lockstep movement loads that list on every peer instead of converting the level's float bounds itself."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* _World)
+	{
+		if (!_World) return;
+
+		FHBStaticCollisionWorld staticWorld;
+		staticWorld.AddFromWorld(_World);
+
+		FHBLockstepWorld lockstepWorld;
+		lockstepWorld.BakeFrom(staticWorld);
+		lockstepWorld.Build();
+
+		TArray<uint8> data;
+		FMemoryWriter writer(data);
+		lockstepWorld.Serialize(writer);
+
+		FString filename = UHBLockstepSubsystem::GetBakedCollisionFilename(_World);
+		if (FFileHelper::SaveArrayToFile(data, *filename))	UE_LOG(LogTemp, Display, TEXT("Lockstep collision: baked %d boxes to %s."), lockstepWorld.NumBoxes(), *filename);
+		else												UE_LOG(LogTemp, Warning, TEXT("Lockstep collision: could not write %s."), *filename);
+	}));
+
+FString UHBLockstepSubsystem::GetBakedCollisionFilename(const UWorld* _World)
+{
+	//< Staged with the game, see DirectoriesToAlwaysStageAsUFS in DefaultGame.ini. >
+	return FPaths::ProjectContentDir() / TEXT("Lockstep") / UWorld::RemovePIEPrefix(_World->GetMapName()) + TEXT(".hbboxes");
+}
+
+const FHBLockstepWorld& UHBLockstepSubsystem::GetCollisionWorld()
+{
+	if (!CollisionWorldBuilt)
+	{
+		FString filename = GetBakedCollisionFilename(GetWorld());
+		TArray<uint8> data;
+		if (FFileHelper::LoadFileToArray(data, *filename, FILEREAD_Silent))
+		{
+			FMemoryReader reader(data);
+			CollisionWorld.Serialize(reader);
+			if (reader.IsError())
+			{
+				UE_LOG(LogTemp, Warning, TEXT("Lockstep collision: %s is not a box list this build reads."), *filename);
+				CollisionWorld = FHBLockstepWorld();
+			}
+		}
+
+		//< Another build may snap the float bounds differently, so peers only agree for certain on a baked list. >
+		if (CollisionWorld.NumBoxes() == 0)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Lockstep collision: no box list at %s, snapping the level's bounds. Run hb.Lockstep.BakeCollision so every peer loads the same boxes."), *filename);
+
+			FHBStaticCollisionWorld staticWorld;
+			staticWorld.AddFromWorld(GetWorld());
+			CollisionWorld.BakeFrom(staticWorld);
+		}
+
+		CollisionWorld.Build();
+		CollisionWorldBuilt = true;
+		UE_LOG(LogTemp, Display, TEXT("Lockstep collision: %d boxes."), CollisionWorld.NumBoxes());
+	}
+	return CollisionWorld;
+}
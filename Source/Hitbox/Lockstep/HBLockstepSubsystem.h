@@ -0,0 +1,27 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HBLockstepMovement.h"
+#include "HBLockstepSubsystem.generated.h"
+
+//< The level's static collision as a FHBLockstepWorld, shared by every character in EHBBodyMode::Lockstep. >
+// See hb.Lockstep.DeterminismCheck for comparing the fixed point movement between builds.
+UCLASS()
+class HITBOX_API UHBLockstepSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	//< Loaded from the map's baked box list on first use, or snapped from the level's static primitives if it has none. Game thread. >
+	const FHBLockstepWorld& GetCollisionWorld();
+
+	//< Where hb.Lockstep.BakeCollision writes the box list of the map _World shows, & GetCollisionWorld reads it. >
+	static FString GetBakedCollisionFilename(const UWorld* _World);
+
+private:
+	FHBLockstepWorld CollisionWorld;
+	bool CollisionWorldBuilt = false;
+};
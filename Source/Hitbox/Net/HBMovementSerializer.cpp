@@ -0,0 +1,390 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HBMovementSerializer.h"
+#include "Serialization/BitWriter.h"
+#include "Serialization/BitReader.h"
+
+namespace HBMovementSerializer
+{
+	//< Zig-zag so small negative deltas stay small. >
+	static uint32 ZigZag(int32 _Value)		{ return ((uint32)_Value << 1) ^ (uint32)(_Value >> 31);	}
+	static int32 UnZigZag(uint32 _Value)	{ return (int32)(_Value >> 1) ^ -(int32)(_Value & 1);		}
+
+	static float SignNotZero(float _Value)	{ return (_Value >= 0) ? 1.0f : -1.0f; }
+
+	//< Deltas are a 2 bit size class followed by 4, 8, 16 or 32 bits. >
+	static const int32 DeltaClassBits[4] = { 4, 8, 16, 32 };
+
+	//< The active ability is sent as its index + 1, so None wraps to 0. >
+	static constexpr int32 AbilityBits = 3;
+	static_assert((1 << AbilityBits) > HBAbility::MaxAbilities, "AbilityBits can not hold every ability index.");
+
+	static void WriteBits(FBitWriter& _Writer, uint32 _Value, int32 _Bits)
+	{
+		uint32 value = INTEL_ORDER32(_Value);
+		_Writer.SerializeBits(&value, _Bits);
+	}
+
+	static uint32 ReadBits(FBitReader& _Reader, int32 _Bits)
+	{
+		uint32 value = 0;
+		_Reader.SerializeBits(&value, _Bits);
+		return INTEL_ORDER32(value);
+	}
+
+	static void WriteField(FBitWriter& _Writer, int32 _Value, int32 _Baseline)
+	{
+		bool changed = (_Value != _Baseline);
+		_Writer.WriteBit(changed);
+		if (!changed) return;
+
+		uint32 delta = ZigZag((int32)((uint32)_Value - (uint32)_Baseline));
+		uint32 sizeClass = (delta < (1u << 4)) ? 0 : (delta < (1u << 8)) ? 1 : (delta < (1u << 16)) ? 2 : 3;
+
+		WriteBits(_Writer, sizeClass, 2);
+		WriteBits(_Writer, delta, DeltaClassBits[sizeClass]);
+	}
+
+	static int32 ReadField(FBitReader& _Reader, int32 _Baseline)
+	{
+		if (!_Reader.ReadBit()) return _Baseline;
+
+		uint32 sizeClass = ReadBits(_Reader, 2);
+		int32 delta = UnZigZag(ReadBits(_Reader, DeltaClassBits[sizeClass]));
+		return (int32)((uint32)_Baseline + (uint32)delta);
+	}
+
+	//< Vectors get one bit for "unchanged" before spending a bit per component. >
+	static void WriteVector(FBitWriter& _Writer, const int32 (&_Value)[3], const int32 (&_Baseline)[3])
+	{
+		bool changed = (_Value[0] != _Baseline[0]) || (_Value[1] != _Baseline[1]) || (_Value[2] != _Baseline[2]);
+		_Writer.WriteBit(changed);
+		if (!changed) return;
+
+		for (int32 i = 0; i < 3; i++) WriteField(_Writer, _Value[i], _Baseline[i]);
+	}
+
+	static void ReadVector(FBitReader& _Reader, int32 (&_OutValue)[3], const int32 (&_Baseline)[3])
+	{
+		bool changed = _Reader.ReadBit() != 0;
+		for (int32 i = 0; i < 3; i++) _OutValue[i] = (changed) ? ReadField(_Reader, _Baseline[i]) : _Baseline[i];
+	}
+}
+
+bool FHBQuantizedMovementState::operator==(const FHBQuantizedMovementState& _Other) const
+{
+	return FMemory::Memcmp(Location, _Other.Location, sizeof(Location)) == 0
+		&& FMemory::Memcmp(Velocity, _Other.Velocity, sizeof(Velocity)) == 0
+		&& Yaw == _Other.Yaw
+		&& CapsuleHalfHeight == _Other.CapsuleHalfHeight
+		&& FMemory::Memcmp(Timers, _Other.Timers, sizeof(Timers)) == 0
+		&& CurrentWallRunSpeed == _Other.CurrentWallRunSpeed
+		&& PreviousWallNormal == _Other.PreviousWallNormal
+		&& FMemory::Memcmp(TargetRotationDelta, _Other.TargetRotationDelta, sizeof(TargetRotationDelta)) == 0
+		&& Flags == _Other.Flags
+		&& AbilityEquals(_Other);
+}
+
+bool FHBQuantizedMovementState::AbilityEquals(const FHBQuantizedMovementState& _Other) const
+{
+	return AbilityActive == _Other.AbilityActive
+		&& AbilityTime == _Other.AbilityTime
+		&& FMemory::Memcmp(AbilityTarget, _Other.AbilityTarget, sizeof(AbilityTarget)) == 0
+		&& FMemory::Memcmp(AbilityCooldowns, _Other.AbilityCooldowns, sizeof(AbilityCooldowns)) == 0;
+}
+
+namespace
+{
+	//< FNV-1a, one 32 bit word at a time. >
+	FORCEINLINE uint32 HashWord(uint32 _Hash, uint32 _Word)
+	{
+		return (_Hash ^ _Word) * 16777619u;
+	}
+}
+
+uint32 FHBQuantizedMovementState::Hash(uint32 _PreviousHash) const
+{
+	uint32 hash = HashWord(2166136261u, _PreviousHash);
+	for (int32 value : Location)	hash = HashWord(hash, (uint32)value);
+	for (int32 value : Velocity)	hash = HashWord(hash, (uint32)value);
+	for (int32 value : Timers)		hash = HashWord(hash, (uint32)value);
+	hash = HashWord(hash, (uint32)CapsuleHalfHeight);
+	hash = HashWord(hash, (uint32)CurrentWallRunSpeed);
+	hash = HashWord(hash, PreviousWallNormal);
+	hash = HashWord(hash, Flags);
+
+	for (int32 value : AbilityTarget)		hash = HashWord(hash, (uint32)value);
+	for (int32 value : AbilityCooldowns)	hash = HashWord(hash, (uint32)value);
+	hash = HashWord(hash, (uint32)AbilityTime);
+	return HashWord(hash, AbilityActive);
+}
+
+FString FHBQuantizedMovementState::DescribeDifferences(const FHBQuantizedMovementState& _Other, const FHBQuantizationSettings& _Settings) const
+{
+	static const TCHAR* const axisNames[3] = { TEXT("X"), TEXT("Y"), TEXT("Z") };
+	static const TCHAR* const rotationNames[3] = { TEXT("Pitch"), TEXT("Yaw"), TEXT("Roll") };
+	static const TCHAR* const timerNames[Timer_Count] = { TEXT("JumpDelayTimer"), TEXT("CrouchCurveTimeline"), TEXT("WallrunFalloffTimeline"), TEXT("WallRunDelayTimer") };
+	static const TCHAR* const flagNames[Flag_Count] = { TEXT("Grounded"), TEXT("SprintActive"), TEXT("AttemptJump"), TEXT("PerformBoost"), TEXT("WallRunActive"), TEXT("WallRunSide") };
+
+	FString result;
+	auto compare = [&result](const FString& _Name, int32 _A, int32 _B, float _Precision)
+	{
+		if (_A != _B) result += FString::Printf(TEXT("  %s: %.4f vs %.4f\n"), *_Name, _A * _Precision, _B * _Precision);
+	};
+
+	for (int32 i = 0; i < 3; i++) compare(FString(TEXT("Location.")) + axisNames[i], Location[i], _Other.Location[i], _Settings.PositionPrecision);
+	for (int32 i = 0; i < 3; i++) compare(FString(TEXT("Velocity.")) + axisNames[i], Velocity[i], _Other.Velocity[i], _Settings.VelocityPrecision);
+	compare(TEXT("Yaw"), Yaw, _Other.Yaw, _Settings.AnglePrecision);
+	compare(TEXT("CapsuleHalfHeight"), CapsuleHalfHeight, _Other.CapsuleHalfHeight, _Settings.PositionPrecision);
+	for (int32 i = 0; i < Timer_Count; i++) compare(timerNames[i], Timers[i], _Other.Timers[i], _Settings.TimePrecision);
+	compare(TEXT("CurrentWallRunSpeed"), CurrentWallRunSpeed, _Other.CurrentWallRunSpeed, _Settings.VelocityPrecision);
+	for (int32 i = 0; i < 3; i++) compare(FString(TEXT("TargetRotationDelta.")) + rotationNames[i], TargetRotationDelta[i], _Other.TargetRotationDelta[i], _Settings.AnglePrecision);
+	for (int32 i = 0; i < 3; i++) compare(FString(TEXT("Ability.Target.")) + axisNames[i], AbilityTarget[i], _Other.AbilityTarget[i], _Settings.PositionPrecision);
+	compare(TEXT("Ability.Time"), AbilityTime, _Other.AbilityTime, _Settings.TimePrecision);
+	for (int32 i = 0; i < HBAbility::MaxAbilities; i++) compare(FString::Printf(TEXT("Ability.Cooldowns[%d]"), i), AbilityCooldowns[i], _Other.AbilityCooldowns[i], _Settings.TimePrecision);
+
+	if (AbilityActive != _Other.AbilityActive)
+	{
+		result += FString::Printf(TEXT("  Ability.Active: %d vs %d\n"), AbilityActive, _Other.AbilityActive);
+	}
+
+	if (PreviousWallNormal != _Other.PreviousWallNormal)
+	{
+		result += FString::Printf(TEXT("  PreviousWallNormal: %08x vs %08x (packed)\n"), PreviousWallNormal, _Other.PreviousWallNormal);
+	}
+
+	for (int32 i = 0; i < Flag_Count; i++)
+	{
+		bool a = (Flags & (1 << i)) != 0;
+		bool b = (_Other.Flags & (1 << i)) != 0;
+		if (a != b) result += FString::Printf(TEXT("  %s: %d vs %d\n"), flagNames[i], a, b);
+	}
+	return result;
+}
+
+int32 FHBMovementSerializer::QuantizeValue(float _Value, float _Precision)
+{
+	float steps = _Value / _Precision;
+	if (FMath::IsNaN(steps)) return 0;
+
+	//< Largest float below 2^31. >
+	return FMath::RoundToInt(FMath::Clamp(steps, (float)MIN_int32, 2147483520.0f));
+}
+
+FHBQuantizedMovementState FHBMovementSerializer::Quantize(const FHBMovementState& _State) const
+{
+	FHBQuantizedMovementState result;
+
+	for (int32 i = 0; i < 3; i++)
+	{
+		result.Location[i] = QuantizeValue(_State.Location[i], Settings.PositionPrecision);
+		result.Velocity[i] = QuantizeValue(_State.Velocity[i], Settings.VelocityPrecision);
+	}
+
+	result.Yaw = QuantizeValue(FRotator::NormalizeAxis(_State.Yaw), Settings.AnglePrecision);
+	result.CapsuleHalfHeight = QuantizeValue(_State.CapsuleHalfHeight, Settings.PositionPrecision);
+
+	result.Timers[FHBQuantizedMovementState::Timer_JumpDelay]		= QuantizeValue(_State.JumpDelayTimer, Settings.TimePrecision);
+	result.Timers[FHBQuantizedMovementState::Timer_CrouchCurve]		= QuantizeValue(_State.CrouchCurveTimeline, Settings.TimePrecision);
+	result.Timers[FHBQuantizedMovementState::Timer_WallrunFalloff]	= QuantizeValue(_State.WallrunFalloffTimeline, Settings.TimePrecision);
+	result.Timers[FHBQuantizedMovementState::Timer_WallRunDelay]	= QuantizeValue(_State.WallRunDelayTimer, Settings.TimePrecision);
+
+	result.CurrentWallRunSpeed = QuantizeValue(_State.CurrentWallRunSpeed, Settings.VelocityPrecision);
+	result.PreviousWallNormal = EncodeNormal(_State.PreviousWallNormal);
+
+	result.TargetRotationDelta[0] = QuantizeValue(_State.TargetRotationDelta.Pitch, Settings.AnglePrecision);
+	result.TargetRotationDelta[1] = QuantizeValue(_State.TargetRotationDelta.Yaw, Settings.AnglePrecision);
+	result.TargetRotationDelta[2] = QuantizeValue(_State.TargetRotationDelta.Roll, Settings.AnglePrecision);
+
+	result.Flags =
+		((_State.Grounded)		? FHBQuantizedMovementState::Flag_Grounded		: 0) |
+		((_State.SprintActive)	? FHBQuantizedMovementState::Flag_SprintActive	: 0) |
+		((_State.AttemptJump)	? FHBQuantizedMovementState::Flag_AttemptJump	: 0) |
+		((_State.PerformBoost)	? FHBQuantizedMovementState::Flag_PerformBoost	: 0) |
+		((_State.WallRunActive)	? FHBQuantizedMovementState::Flag_WallRunActive	: 0) |
+		((_State.WallRunSide)	? FHBQuantizedMovementState::Flag_WallRunSide	: 0);
+
+	const FHBAbilityState& ability = _State.Ability;
+	result.AbilityActive = (ability.Active < HBAbility::MaxAbilities) ? ability.Active : HBAbility::None;
+	result.AbilityTime = QuantizeValue(ability.Time, Settings.TimePrecision);
+	for (int32 i = 0; i < 3; i++) result.AbilityTarget[i] = QuantizeValue(ability.Target[i], Settings.PositionPrecision);
+	for (int32 i = 0; i < HBAbility::MaxAbilities; i++) result.AbilityCooldowns[i] = QuantizeValue(ability.Cooldowns[i], Settings.TimePrecision);
+
+	return result;
+}
+
+FHBMovementState FHBMovementSerializer::Dequantize(const FHBQuantizedMovementState& _State) const
+{
+	FHBMovementState result;
+
+	for (int32 i = 0; i < 3; i++)
+	{
+		result.Location[i] = DequantizeValue(_State.Location[i], Settings.PositionPrecision);
+		result.Velocity[i] = DequantizeValue(_State.Velocity[i], Settings.VelocityPrecision);
+	}
+
+	result.Yaw = DequantizeValue(_State.Yaw, Settings.AnglePrecision);
+	result.CapsuleHalfHeight = DequantizeValue(_State.CapsuleHalfHeight, Settings.PositionPrecision);
+
+	result.JumpDelayTimer			= DequantizeValue(_State.Timers[FHBQuantizedMovementState::Timer_JumpDelay], Settings.TimePrecision);
+	result.CrouchCurveTimeline		= DequantizeValue(_State.Timers[FHBQuantizedMovementState::Timer_CrouchCurve], Settings.TimePrecision);
+	result.WallrunFalloffTimeline	= DequantizeValue(_State.Timers[FHBQuantizedMovementState::Timer_WallrunFalloff], Settings.TimePrecision);
+	result.WallRunDelayTimer		= DequantizeValue(_State.Timers[FHBQuantizedMovementState::Timer_WallRunDelay], Settings.TimePrecision);
+
+	result.CurrentWallRunSpeed = DequantizeValue(_State.CurrentWallRunSpeed, Settings.VelocityPrecision);
+	result.PreviousWallNormal = DecodeNormal(_State.PreviousWallNormal);
+
+	result.TargetRotationDelta.Pitch	= DequantizeValue(_State.TargetRotationDelta[0], Settings.AnglePrecision);
+	result.TargetRotationDelta.Yaw		= DequantizeValue(_State.TargetRotationDelta[1], Settings.AnglePrecision);
+	result.TargetRotationDelta.Roll		= DequantizeValue(_State.TargetRotationDelta[2], Settings.AnglePrecision);
+
+	result.Grounded			= (_State.Flags & FHBQuantizedMovementState::Flag_Grounded) != 0;
+	result.SprintActive		= (_State.Flags & FHBQuantizedMovementState::Flag_SprintActive) != 0;
+	result.AttemptJump		= (_State.Flags & FHBQuantizedMovementState::Flag_AttemptJump) != 0;
+	result.PerformBoost		= (_State.Flags & FHBQuantizedMovementState::Flag_PerformBoost) != 0;
+	result.WallRunActive	= (_State.Flags & FHBQuantizedMovementState::Flag_WallRunActive) != 0;
+	result.WallRunSide		= (_State.Flags & FHBQuantizedMovementState::Flag_WallRunSide) != 0;
+
+	result.Ability.Active = _State.AbilityActive;
+	result.Ability.Time = DequantizeValue(_State.AbilityTime, Settings.TimePrecision);
+	for (int32 i = 0; i < 3; i++) result.Ability.Target[i] = DequantizeValue(_State.AbilityTarget[i], Settings.PositionPrecision);
+	for (int32 i = 0; i < HBAbility::MaxAbilities; i++) result.Ability.Cooldowns[i] = DequantizeValue(_State.AbilityCooldowns[i], Settings.TimePrecision);
+
+	return result;
+}
+
+void FHBMovementSerializer::Write(FBitWriter& _Writer, const FHBQuantizedMovementState& _State, const FHBQuantizedMovementState* _Baseline) const
+{
+	using namespace HBMovementSerializer;
+
+	static const FHBQuantizedMovementState ZeroState;
+	const FHBQuantizedMovementState& baseline = (_Baseline) ? *_Baseline : ZeroState;
+
+	//< Mode flags are always sent raw, they are only a few bits. >
+	WriteBits(_Writer, _State.Flags, FHBQuantizedMovementState::Flag_Count);
+
+	WriteVector(_Writer, _State.Location, baseline.Location);
+	WriteVector(_Writer, _State.Velocity, baseline.Velocity);
+
+	WriteField(_Writer, _State.Yaw, baseline.Yaw);
+	WriteField(_Writer, _State.CapsuleHalfHeight, baseline.CapsuleHalfHeight);
+
+	for (int32 i = 0; i < FHBQuantizedMovementState::Timer_Count; i++)
+	{
+		WriteField(_Writer, _State.Timers[i], baseline.Timers[i]);
+	}
+
+	WriteField(_Writer, _State.CurrentWallRunSpeed, baseline.CurrentWallRunSpeed);
+
+	//< Normals rarely change, so send them whole when they do. >
+	bool normalChanged = (_State.PreviousWallNormal != baseline.PreviousWallNormal);
+	_Writer.WriteBit(normalChanged);
+	if (normalChanged) WriteBits(_Writer, _State.PreviousWallNormal, Settings.NormalBits * 2 + 1);
+
+	WriteVector(_Writer, _State.TargetRotationDelta, baseline.TargetRotationDelta);
+
+	//< Abilities are idle most of the time, so the whole block costs one bit when nothing changed. >
+	bool abilityChanged = !_State.AbilityEquals(baseline);
+	_Writer.WriteBit(abilityChanged);
+	if (!abilityChanged) return;
+
+	WriteBits(_Writer, (uint8)(_State.AbilityActive + 1), AbilityBits);
+	WriteField(_Writer, _State.AbilityTime, baseline.AbilityTime);
+	WriteVector(_Writer, _State.AbilityTarget, baseline.AbilityTarget);
+	for (int32 i = 0; i < HBAbility::MaxAbilities; i++)
+	{
+		WriteField(_Writer, _State.AbilityCooldowns[i], baseline.AbilityCooldowns[i]);
+	}
+}
+
+bool FHBMovementSerializer::Read(FBitReader& _Reader, FHBQuantizedMovementState& _OutState, const FHBQuantizedMovementState* _Baseline) const
+{
+	using namespace HBMovementSerializer;
+
+	static const FHBQuantizedMovementState ZeroState;
+	const FHBQuantizedMovementState baseline = (_Baseline) ? *_Baseline : ZeroState; //< Copy, _OutState may alias the baseline. >
+
+	_OutState.Flags = (uint8)ReadBits(_Reader, FHBQuantizedMovementState::Flag_Count);
+
+	ReadVector(_Reader, _OutState.Location, baseline.Location);
+	ReadVector(_Reader, _OutState.Velocity, baseline.Velocity);
+
+	_OutState.Yaw = ReadField(_Reader, baseline.Yaw);
+	_OutState.CapsuleHalfHeight = ReadField(_Reader, baseline.CapsuleHalfHeight);
+
+	for (int32 i = 0; i < FHBQuantizedMovementState::Timer_Count; i++)
+	{
+		_OutState.Timers[i] = ReadField(_Reader, baseline.Timers[i]);
+	}
+
+	_OutState.CurrentWallRunSpeed = ReadField(_Reader, baseline.CurrentWallRunSpeed);
+
+	_OutState.PreviousWallNormal = (_Reader.ReadBit()) ? ReadBits(_Reader, Settings.NormalBits * 2 + 1) : baseline.PreviousWallNormal;
+
+	ReadVector(_Reader, _OutState.TargetRotationDelta, baseline.TargetRotationDelta);
+
+	if (_Reader.ReadBit())
+	{
+		_OutState.AbilityActive = (uint8)(ReadBits(_Reader, AbilityBits) - 1);
+		_OutState.AbilityTime = ReadField(_Reader, baseline.AbilityTime);
+		ReadVector(_Reader, _OutState.AbilityTarget, baseline.AbilityTarget);
+		for (int32 i = 0; i < HBAbility::MaxAbilities; i++)
+		{
+			_OutState.AbilityCooldowns[i] = ReadField(_Reader, baseline.AbilityCooldowns[i]);
+		}
+	}
+	else
+	{
+		_OutState.AbilityActive = baseline.AbilityActive;
+		_OutState.AbilityTime = baseline.AbilityTime;
+		FMemory::Memcpy(_OutState.AbilityTarget, baseline.AbilityTarget, sizeof(baseline.AbilityTarget));
+		FMemory::Memcpy(_OutState.AbilityCooldowns, baseline.AbilityCooldowns, sizeof(baseline.AbilityCooldowns));
+	}
+
+	return !_Reader.IsError();
+}
+
+uint32 FHBMovementSerializer::EncodeNormal(FVector _Normal) const
+{
+	//< 0 is reserved for the zero vector, which the wall normal uses when there is no wall. Non finite normals pack as none too. >
+	float l1 = FMath::Abs(_Normal.X) + FMath::Abs(_Normal.Y) + FMath::Abs(_Normal.Z);
+	if (l1 < KINDA_SMALL_NUMBER || !FMath::IsFinite(l1)) return 0;
+
+	//< Octahedral mapping onto the unit square. >
+	float x = _Normal.X / l1;
+	float y = _Normal.Y / l1;
+	if (_Normal.Z < 0)
+	{
+		float foldedX = (1.0f - FMath::Abs(y)) * HBMovementSerializer::SignNotZero(x);
+		float foldedY = (1.0f - FMath::Abs(x)) * HBMovementSerializer::SignNotZero(y);
+		x = foldedX;
+		y = foldedY;
+	}
+
+	uint32 maxValue = (1u << Settings.NormalBits) - 1;
+	uint32 packedX = (uint32)FMath::RoundToInt((x * 0.5f + 0.5f) * maxValue);
+	uint32 packedY = (uint32)FMath::RoundToInt((y * 0.5f + 0.5f) * maxValue);
+
+	return ((packedX << Settings.NormalBits) | packedY) + 1;
+}
+
+FVector FHBMovementSerializer::DecodeNormal(uint32 _Packed) const
+{
+	if (_Packed == 0) return FVector::ZeroVector;
+	_Packed -= 1;
+
+	uint32 maxValue = (1u << Settings.NormalBits) - 1;
+	float x = ((float)(_Packed >> Settings.NormalBits) / maxValue) * 2.0f - 1.0f;
+	float y = ((float)(_Packed & maxValue) / maxValue) * 2.0f - 1.0f;
+	float z = 1.0f - FMath::Abs(x) - FMath::Abs(y);
+
+	if (z < 0)
+	{
+		float unfoldedX = (1.0f - FMath::Abs(y)) * HBMovementSerializer::SignNotZero(x);
+		float unfoldedY = (1.0f - FMath::Abs(x)) * HBMovementSerializer::SignNotZero(y);
+		x = unfoldedX;
+		y = unfoldedY;
+	}
+
+	return FVector(x, y, z).GetSafeNormal();
+}
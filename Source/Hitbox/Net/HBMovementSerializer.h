@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "../Pawns/HBMovementTypes.h"
+#include "HBMovementSerializer.generated.h"
+
+class FBitWriter;
+class FBitReader;
+
+//< Precision used when packing FHBMovementState. Both ends must agree. >
+USTRUCT(BlueprintType)
+struct HITBOX_API FHBQuantizationSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Quantization")
+		float PositionPrecision = 0.01f; //< World units per step. >
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Quantization")
+		float VelocityPrecision = 0.1f; //< Units/s per step. >
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Quantization")
+		float AnglePrecision = 0.01f; //< Degrees per step, yaw & target rotation delta. >
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Quantization")
+		float TimePrecision = 0.001f; //< Seconds per step for timers & timelines. >
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Quantization", meta = (ClampMin = "4", ClampMax = "15"))
+		int32 NormalBits = 12; //< Bits per octahedral component. >
+};
+
+//< FHBMovementState snapped to the quantization grid. Comparing two of these is exact. >
+// The ability's pending requests & requested target are left out, they only live within the step that reads the input.
+struct HITBOX_API FHBQuantizedMovementState
+{
+	enum EFlags : uint8
+	{
+		Flag_Grounded		= 1 << 0,
+		Flag_SprintActive	= 1 << 1,
+		Flag_AttemptJump	= 1 << 2,
+		Flag_PerformBoost	= 1 << 3,
+		Flag_WallRunActive	= 1 << 4,
+		Flag_WallRunSide	= 1 << 5,
+
+		Flag_Count			= 6
+	};
+
+	enum ETimer : uint8
+	{
+		Timer_JumpDelay,
+		Timer_CrouchCurve,
+		Timer_WallrunFalloff,
+		Timer_WallRunDelay,
+
+		Timer_Count
+	};
+
+	int32 Location[3] = { 0, 0, 0 };
+	int32 Velocity[3] = { 0, 0, 0 };
+	int32 Yaw = 0;
+	int32 CapsuleHalfHeight = 0;
+	int32 Timers[Timer_Count] = { 0, 0, 0, 0 };
+	int32 CurrentWallRunSpeed = 0;
+	uint32 PreviousWallNormal = 0; //< Octahedral, two NormalBits wide components. >
+	int32 TargetRotationDelta[3] = { 0, 0, 0 };
+	uint8 Flags = 0;
+
+	//< FHBAbilityState. The target is a point for the grapple & ledge climb & a direction for the dash, both at PositionPrecision. >
+	int32 AbilityTarget[3] = { 0, 0, 0 };
+	int32 AbilityTime = 0;
+	int32 AbilityCooldowns[HBAbility::MaxAbilities] = {};
+	uint8 AbilityActive = HBAbility::None;
+
+	bool operator==(const FHBQuantizedMovementState& _Other) const;
+	bool operator!=(const FHBQuantizedMovementState& _Other) const { return !(*this == _Other); }
+
+	bool AbilityEquals(const FHBQuantizedMovementState& _Other) const;
+
+	//< Rolling hash of the simulated part of the state, chained from the previous sub step's hash. >
+	// Leaves out yaw & TargetRotationDelta, which follow the view rather than the simulation.
+	uint32 Hash(uint32 _PreviousHash) const;
+
+	//< One line per field that differs from _Other, dequantized with _Settings. Empty if the states match. >
+	FString DescribeDifferences(const FHBQuantizedMovementState& _Other, const FHBQuantizationSettings& _Settings) const;
+};
+
+//< Bit packs movement state, delta encoded against a baseline both ends already have. >
+// Unchanged fields cost one bit & changed ones only send the difference, so a steady run costs a handful of bytes.
+class HITBOX_API FHBMovementSerializer
+{
+public:
+	FHBMovementSerializer(const FHBQuantizationSettings& _Settings = FHBQuantizationSettings()) : Settings(_Settings) {}
+
+	FHBQuantizedMovementState Quantize(const FHBMovementState& _State) const;
+	FHBMovementState Dequantize(const FHBQuantizedMovementState& _State) const;
+
+	//< _Baseline may be null, which sends a full state (delta against zero). >
+	void Write(FBitWriter& _Writer, const FHBQuantizedMovementState& _State, const FHBQuantizedMovementState* _Baseline) const;
+	bool Read(FBitReader& _Reader, FHBQuantizedMovementState& _OutState, const FHBQuantizedMovementState* _Baseline) const;
+
+	const FHBQuantizationSettings& GetSettings() const { return Settings; }
+
+private:
+	//< Saturates at the int32 range rather than overflowing, NaN becomes 0. >
+	static int32 QuantizeValue(float _Value, float _Precision);
+	static float DequantizeValue(int32 _Value, float _Precision) { return _Value * _Precision; }
+
+	uint32 EncodeNormal(FVector _Normal) const;
+	FVector DecodeNormal(uint32 _Packed) const;
+
+	FHBQuantizationSettings Settings;
+};
@@ -0,0 +1,357 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HBMovementValidator.h"
+#include "Components/CapsuleComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+#include "../Pawns/HBMovementComponent.h"
+#include "../Pawns/HBPlayerCollisionComponent.h"
+#include "../Hitbox.h"
+
+DECLARE_CYCLE_STAT(TEXT("Movement Validation"), STAT_HBMovementValidation, STATGROUP_HBMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Players Validated"), STAT_HBPlayersValidated, STATGROUP_HBMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Players Escalated"), STAT_HBPlayersEscalated, STATGROUP_HBMovement);
+
+static FAutoConsoleCommandWithWorldAndArgs ValidationBenchmarkCommand(
+	TEXT("hb.Net.ValidationBench"),
+	TEXT("hb.Net.ValidationBench [Players=64] [Ticks=1000]: Validates Ticks network ticks of plausible random reports for Players players ")
+	TEXT("against the default movement rules & logs the cost of one tick."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& _Args, UWorld* _World)
+	{
+		int32 numPlayers = (_Args.Num() > 0) ? FMath::Max(FCString::Atoi(*_Args[0]), 1) : 64;
+		int32 ticks = (_Args.Num() > 1) ? FMath::Max(FCString::Atoi(*_Args[1]), 1) : 1000;
+		const float tickTime = 1.0f / 30.0f;
+
+		FHBMovementValidator validator(FHBMovementLimits::FromComponent(*GetDefault<UHBMovementComponent>(), nullptr));
+		FRandomStream random(numPlayers);
+
+		TArray<FHBMovementReport> reports;
+		TArray<FHBMovementContact> contacts;
+		reports.SetNum(numPlayers);
+		contacts.SetNum(numPlayers);
+		for (int32 i = 0; i < numPlayers; i++)
+		{
+			FHBMovementState state;
+			state.Location = random.GetUnitVector() * 5000;
+			validator.AddPlayer(state);
+			reports[i] = FHBMovementReport::FromState(state);
+			contacts[i].GroundDistance = 0;
+		}
+
+		TArray<int32> suspicious;
+		int32 escalations = 0;
+		double seconds = 0;
+		for (int32 tick = 0; tick < ticks; tick++)
+		{
+			//< Running about on the ground, well within the rules. >
+			for (FHBMovementReport& report : reports)
+			{
+				FVector direction = FVector(random.FRandRange(-1, 1), random.FRandRange(-1, 1), 0).GetSafeNormal();
+				report.Velocity = direction * random.FRandRange(0, 575);
+				report.Location += report.Velocity * tickTime;
+			}
+
+			suspicious.Reset();
+			double startTime = FPlatformTime::Seconds();
+			validator.Validate(reports, contacts, tickTime, suspicious);
+			seconds += FPlatformTime::Seconds() - startTime;
+			escalations += suspicious.Num();
+		}
+
+		UE_LOG(LogTemp, Display, TEXT("Validated %d players for %d ticks: %.2f us per tick, %.3f us per player, %d escalations."),
+			numPlayers, ticks, seconds * 1000000 / ticks, seconds * 1000000 / ticks / numPlayers, escalations);
+	}));
+
+uint8 HBMovementMode::FromState(const FHBMovementState& _State)
+{
+	if (_State.Ability.IsActive())	return Ability;
+	if (_State.WallRunActive)		return WallRun;
+	return (_State.Grounded) ? Ground : Air;
+}
+
+FHBMovementLimits FHBMovementLimits::FromComponent(const UHBMovementComponent& _Movement, const UHBPlayerCollisionComponent* _Collision)
+{
+	if (!_Collision) _Collision = GetDefault<UHBPlayerCollisionComponent>();
+
+	FHBMovementLimits limits;
+	const FHBAbilitySettings& abilities = _Movement.Abilities;
+
+	//< Surfaces may raise the ground speeds. >
+	float surfaceScale = _Movement.DefaultSurfaceProfile.MaxSpeedScale;
+	for (const TPair<UPhysicalMaterial*, FHBSurfaceProfile>& profile : _Movement.SurfaceProfiles)
+	{
+		surfaceScale = FMath::Max(surfaceScale, profile.Value.MaxSpeedScale);
+	}
+	float groundSpeed = FMath::Max(FMath::Max(_Movement.WalkSpeed, _Movement.RunSpeed) * surfaceScale, _Movement.SlideForce);
+
+	//< Abilities hand over their exit speeds to whatever mode comes next. >
+	float exitSpeed = FMath::Max((abilities.Dash.Enabled) ? abilities.Dash.ExitSpeed : 0, (abilities.LedgeClimb.Enabled) ? abilities.LedgeClimb.ExitSpeed : 0);
+	float abilitySpeed = FMath::Max((abilities.Dash.Enabled) ? abilities.Dash.Speed : 0, (abilities.Grapple.Enabled) ? abilities.Grapple.MaxSpeed : 0);
+	float climbSpeed = (abilities.LedgeClimb.Enabled) ? abilities.LedgeClimb.MaxHeight / FMath::Max(abilities.LedgeClimb.Duration * 0.6f, 0.01f) : 0;
+
+	limits.HorizontalSpeed[HBMovementMode::Ground]	= FMath::Max(groundSpeed, exitSpeed);
+	limits.HorizontalSpeed[HBMovementMode::Air]		= FMath::Max3(_Movement.AirSpeed, _Movement.WallJumpForce, exitSpeed);
+	limits.HorizontalSpeed[HBMovementMode::WallRun]	= _Movement.WallRunSpeed;
+	limits.HorizontalSpeed[HBMovementMode::Ability]	= FMath::Max(abilitySpeed, exitSpeed);
+
+	//< Ground speed turns upwards on the steepest walkable slope. >
+	float slopeSpeed = groundSpeed * FMath::Sin(FMath::DegreesToRadians(_Movement.MaxSlopeAngle));
+	limits.UpSpeed[HBMovementMode::Ground]	= FMath::Max(_Movement.JumpForce, slopeSpeed);
+	limits.UpSpeed[HBMovementMode::Air]		= _Movement.JumpForce; //< A buffered jump lands & fires within the tick. >
+	limits.UpSpeed[HBMovementMode::WallRun]	= FMath::Max(_Movement.JumpForce, _Movement.WallJumpForce / 2);
+	limits.UpSpeed[HBMovementMode::Ability]	= FMath::Max3((abilities.Dash.Enabled) ? abilities.Dash.Speed : 0, (abilities.Grapple.Enabled) ? abilities.Grapple.MaxSpeed : 0, climbSpeed);
+
+	//< As ApplyGravity & StickToGround at the fastest ground speed. >
+	float mass = (_Collision->CapsuleComponent) ? _Collision->CapsuleComponent->BodyInstance.GetMassOverride() : 1.0f;
+	limits.FallAcceleration = _Movement.Gravity * mass + (_Movement.StickToGroundForce + groundSpeed / 10) * 100.0f;
+
+	//< On the ground the slowest surface's braking or sliding, or the pull back to the target speed while pushing on. >
+	float groundDeceleration = _Movement.GroundDeceleration * _Movement.DefaultSurfaceProfile.DecelerationScale;
+	float slideDeceleration = _Movement.SlideDeceleration * _Movement.DefaultSurfaceProfile.SlideDecelerationScale;
+	for (const TPair<UPhysicalMaterial*, FHBSurfaceProfile>& profile : _Movement.SurfaceProfiles)
+	{
+		groundDeceleration = FMath::Min(groundDeceleration, _Movement.GroundDeceleration * profile.Value.DecelerationScale);
+		slideDeceleration = FMath::Min(slideDeceleration, _Movement.SlideDeceleration * profile.Value.SlideDecelerationScale);
+	}
+	limits.CarryDeceleration[HBMovementMode::Ground] = FMath::Max(FMath::Min3(groundDeceleration, slideDeceleration, _Movement.GroundAcceleration), 0.0f);
+
+	//< Everywhere else air drag. Pushing along the velocity in the air holds it, so long flights above the air limit slowly build
+	// suspicion & are left to the resimulation to confirm.
+	limits.CarryDeceleration[HBMovementMode::Air] = _Movement.AirDeceleration;
+	limits.CarryDeceleration[HBMovementMode::WallRun] = _Movement.AirDeceleration;
+	limits.CarryDeceleration[HBMovementMode::Ability] = _Movement.AirDeceleration;
+
+	FHBMovementAbilities::GetLimits(abilities, limits.AbilityDurations, limits.AbilityCooldowns);
+	return limits;
+}
+
+FHBMovementReport FHBMovementReport::FromState(const FHBMovementState& _State)
+{
+	FHBMovementReport report;
+	report.Location = _State.Location;
+	report.Velocity = _State.Velocity;
+	report.Mode = HBMovementMode::FromState(_State);
+	report.Ability = _State.Ability.Active;
+	return report;
+}
+
+int32 FHBMovementValidator::AddPlayer(const FHBMovementState& _State)
+{
+	int32 index = Players.AddDefaulted();
+	ResetPlayer(index, _State);
+	return index;
+}
+
+void FHBMovementValidator::ResetPlayer(int32 _Player, const FHBMovementState& _State)
+{
+	FPlayer& player = Players[_Player];
+	player.Location = _State.Location;
+	player.Velocity = _State.Velocity;
+	player.Mode = HBMovementMode::FromState(_State);
+	player.Suspicion = 0;
+
+	player.Ability = _State.Ability.Active;
+	player.AbilityTime = _State.Ability.Time;
+	FMemory::Memcpy(player.AbilityCooldowns, _State.Ability.Cooldowns, sizeof(player.AbilityCooldowns));
+}
+
+uint8 FHBMovementValidator::BoundMode(const FPlayer& _Player, const FHBMovementReport& _Report, const FHBMovementContact& _Contact, float _DeltaTime, float& _OutFalseClaim) const
+{
+	_OutFalseClaim = 0;
+	uint8 fallback = (_Contact.IsNearGround()) ? HBMovementMode::Ground : HBMovementMode::Air;
+
+	switch (_Report.Mode)
+	{
+	case HBMovementMode::Ground:
+		return fallback;
+
+	case HBMovementMode::WallRun:
+		if (_Contact.IsNearWall()) return HBMovementMode::WallRun;
+
+		//< At least one full violation, more the further the nearest wall. >
+		_OutFalseClaim = FMath::Max(1.0f, (_Contact.WallDistance - _Contact.WallNearDistance) / FMath::Max(Settings.PositionTolerance, KINDA_SMALL_NUMBER));
+		return fallback;
+
+	case HBMovementMode::Ability:
+		if (_Report.Ability < HBAbility::MaxAbilities && Limits.AbilityDurations[_Report.Ability] > 0)
+		{
+			//< Still within its duration, which sub steps may overrun by a little, or started once its cooldown ran out during the tick. >
+			bool running = _Player.Ability == _Report.Ability && _Player.AbilityTime <= Limits.AbilityDurations[_Report.Ability] + _DeltaTime;
+			bool started = _Player.Ability != _Report.Ability && _Player.AbilityCooldowns[_Report.Ability] <= _DeltaTime;
+			if (running || started) return HBMovementMode::Ability;
+		}
+		_OutFalseClaim = 1;
+		return fallback;
+
+	default:
+		return HBMovementMode::Air;
+	}
+}
+
+uint8 FHBMovementValidator::FillLane(FPacket& _Packet, int32 _Lane, const FPlayer& _Player, const FHBMovementReport& _Report, const FHBMovementContact& _Contact, float _DeltaTime) const
+{
+	//< Reports come from the client, so anything malformed is a violation of its own rather than garbage in the vector pass. >
+	if (_Report.Mode >= HBMovementMode::Count || _Report.Location.ContainsNaN() || _Report.Velocity.ContainsNaN())
+	{
+		for (float* lanes : { _Packet.DeltaX, _Packet.DeltaY, _Packet.DeltaZ, _Packet.VelocityX, _Packet.VelocityY, _Packet.VelocityZ,
+			_Packet.PreviousHorizontalSpeed, _Packet.PreviousVerticalSpeed, _Packet.CarryDeceleration, _Packet.SpeedLimit, _Packet.UpLimit }) lanes[_Lane] = 0;
+		_Packet.FalseClaim[_Lane] = BIG_NUMBER;
+		return _Player.Mode;
+	}
+
+	uint8 mode = BoundMode(_Player, _Report, _Contact, _DeltaTime, _Packet.FalseClaim[_Lane]);
+
+	FVector delta = _Report.Location - _Player.Location;
+	_Packet.DeltaX[_Lane] = delta.X;
+	_Packet.DeltaY[_Lane] = delta.Y;
+	_Packet.DeltaZ[_Lane] = delta.Z;
+
+	_Packet.VelocityX[_Lane] = _Report.Velocity.X;
+	_Packet.VelocityY[_Lane] = _Report.Velocity.Y;
+	_Packet.VelocityZ[_Lane] = _Report.Velocity.Z;
+
+	_Packet.PreviousHorizontalSpeed[_Lane] = _Player.Velocity.Size2D();
+	_Packet.PreviousVerticalSpeed[_Lane] = _Player.Velocity.Z;
+	_Packet.CarryDeceleration[_Lane] = Limits.CarryDeceleration[_Player.Mode];
+
+	//< The character may have been in either mode for any part of the tick. >
+	_Packet.SpeedLimit[_Lane] = FMath::Max(Limits.HorizontalSpeed[_Player.Mode], Limits.HorizontalSpeed[mode]);
+
+	//< Only ground, walls & abilities push upwards. Falling clear of them, the climb can only slow down. >
+	bool falling = _Player.Mode == HBMovementMode::Air && mode == HBMovementMode::Air && !_Contact.IsNearGround() && !_Contact.IsNearWall();
+	_Packet.UpLimit[_Lane] = (falling) ? _Player.Velocity.Z : FMath::Max3(Limits.UpSpeed[_Player.Mode], Limits.UpSpeed[mode], _Player.Velocity.Z);
+	return mode;
+}
+
+void FHBMovementValidator::Accept(FPlayer& _Player, const FHBMovementReport& _Report, uint8 _Mode, float _DeltaTime) const
+{
+	_Player.Location = _Report.Location;
+	_Player.Velocity = _Report.Velocity;
+	_Player.Mode = _Mode;
+
+	for (float& cooldown : _Player.AbilityCooldowns) cooldown = FMath::Max(cooldown - _DeltaTime, 0.0f);
+
+	//< An ability that ended may have done so right at the start of the tick, so its cooldown is counted from there. >
+	uint8 ability = (_Mode == HBMovementMode::Ability) ? _Report.Ability : HBAbility::None;
+	if (_Player.Ability < HBAbility::MaxAbilities && _Player.Ability != ability)
+	{
+		_Player.AbilityCooldowns[_Player.Ability] = FMath::Max(Limits.AbilityCooldowns[_Player.Ability] - _DeltaTime, 0.0f);
+	}
+
+	//< A started ability may have run for as little as no time at all. >
+	_Player.AbilityTime = (ability != HBAbility::None && ability == _Player.Ability) ? _Player.AbilityTime + _DeltaTime : 0;
+	_Player.Ability = ability;
+}
+
+static FORCEINLINE VectorRegister HBVectorLength2D(const VectorRegister& _X, const VectorRegister& _Y)
+{
+	//< The clamp keeps zero lanes finite. >
+	VectorRegister squared = VectorMax(VectorMultiplyAdd(_Y, _Y, VectorMultiply(_X, _X)), VectorSetFloat1(SMALL_NUMBER));
+	return VectorMultiply(squared, VectorReciprocalSqrtAccurate(squared));
+}
+
+void FHBMovementValidator::ScorePacket(const FPacket& _Packet, float _DeltaTime, float* _OutScores) const
+{
+	const VectorRegister zero = VectorZero();
+	const VectorRegister deltaTime = VectorSetFloat1(_DeltaTime);
+	const VectorRegister inverseSpeedTolerance = VectorSetFloat1(1.0f / FMath::Max(Settings.SpeedTolerance, KINDA_SMALL_NUMBER));
+	const VectorRegister inversePositionTolerance = VectorSetFloat1(1.0f / FMath::Max(Settings.PositionTolerance, KINDA_SMALL_NUMBER));
+
+	const VectorRegister velocityX = VectorLoadAligned(_Packet.VelocityX);
+	const VectorRegister velocityY = VectorLoadAligned(_Packet.VelocityY);
+	const VectorRegister velocityZ = VectorLoadAligned(_Packet.VelocityZ);
+	const VectorRegister deltaX = VectorLoadAligned(_Packet.DeltaX);
+	const VectorRegister deltaY = VectorLoadAligned(_Packet.DeltaY);
+	const VectorRegister deltaZ = VectorLoadAligned(_Packet.DeltaZ);
+	const VectorRegister previousVertical = VectorLoadAligned(_Packet.PreviousVerticalSpeed);
+	const VectorRegister upLimit = VectorLoadAligned(_Packet.UpLimit);
+
+	//< Horizontal speed: the mode's limit, or what is left of the speed carried in after the tick's least deceleration. >
+	VectorRegister carriedSpeed = VectorSubtract(VectorLoadAligned(_Packet.PreviousHorizontalSpeed), VectorMultiply(VectorLoadAligned(_Packet.CarryDeceleration), deltaTime));
+	VectorRegister allowedSpeed = VectorMax(VectorLoadAligned(_Packet.SpeedLimit), carriedSpeed);
+	VectorRegister speed = HBVectorLength2D(velocityX, velocityY);
+	VectorRegister score = VectorMultiply(VectorMax(VectorSubtract(speed, allowedSpeed), zero), inverseSpeedTolerance);
+
+	//< Horizontal distance: whatever the speed within the tick, it was never above the allowed one. Catches teleports. >
+	VectorRegister distance = HBVectorLength2D(deltaX, deltaY);
+	VectorRegister overshoot = VectorMax(VectorSubtract(distance, VectorMultiply(allowedSpeed, deltaTime)), zero);
+	score = VectorMax(score, VectorMultiply(overshoot, inversePositionTolerance));
+
+	//< Upward speed. >
+	overshoot = VectorMax(VectorSubtract(velocityZ, upLimit), zero);
+	score = VectorMax(score, VectorMultiply(overshoot, inverseSpeedTolerance));
+
+	//< Height: no higher than the upward limit allows, no lower than falling from a standstill or the speed carried in. >
+	VectorRegister highest = VectorMultiply(VectorMax(upLimit, zero), deltaTime);
+	VectorRegister lowest = VectorMultiply(VectorSubtract(VectorMin(previousVertical, zero), VectorMultiply(VectorSetFloat1(Limits.FallAcceleration), deltaTime)), deltaTime);
+	overshoot = VectorAdd(VectorMax(VectorSubtract(deltaZ, highest), zero), VectorMax(VectorSubtract(lowest, deltaZ), zero));
+	score = VectorMax(score, VectorMultiply(overshoot, inversePositionTolerance));
+
+	//< Wall runs & abilities the server's state doesn't back, already in violations. >
+	score = VectorMax(score, VectorLoadAligned(_Packet.FalseClaim));
+
+	VectorStoreAligned(score, _OutScores);
+}
+
+void FHBMovementValidator::Validate(TArrayView<const FHBMovementReport> _Reports, TArrayView<const FHBMovementContact> _Contacts, float _DeltaTime, TArray<int32>& _OutSuspicious)
+{
+	check(_Reports.Num() == Players.Num() && _Contacts.Num() == Players.Num());
+	SCOPE_CYCLE_COUNTER(STAT_HBMovementValidation);
+	INC_DWORD_STAT_BY(STAT_HBPlayersValidated, Players.Num());
+
+	const float forgiven = Settings.SuspicionDecay * _DeltaTime;
+	int32 escalated = 0;
+
+	for (int32 first = 0; first < Players.Num(); first += PacketWidth)
+	{
+		const int32 lanes = FMath::Min(PacketWidth, Players.Num() - first);
+
+		//< Zeroed padding lanes score zero. >
+		FPacket packet;
+		if (lanes < PacketWidth) FMemory::Memzero(packet);
+		uint8 modes[PacketWidth];
+		for (int32 lane = 0; lane < lanes; lane++)
+		{
+			modes[lane] = FillLane(packet, lane, Players[first + lane], _Reports[first + lane], _Contacts[first + lane], _DeltaTime);
+		}
+
+		alignas(16) float scores[PacketWidth];
+		ScorePacket(packet, _DeltaTime, scores);
+
+		for (int32 lane = 0; lane < lanes; lane++)
+		{
+			FPlayer& player = Players[first + lane];
+			player.Suspicion = FMath::Max(player.Suspicion - forgiven, 0.0f) + scores[lane];
+
+			if (player.Suspicion >= 1)
+			{
+				_OutSuspicious.Add(first + lane);
+				escalated++;
+				continue;
+			}
+
+			Accept(player, _Reports[first + lane], modes[lane], _DeltaTime);
+		}
+	}
+	INC_DWORD_STAT_BY(STAT_HBPlayersEscalated, escalated);
+}
+
+bool FHBMovementValidator::ConfirmByResimulation(int32 _Player, UHBMovementComponent& _Movement, const FHBMovementSnapshot& _From, TArrayView<const FHBMovementStepInput> _Inputs,
+	float _StepTime, const FHBMovementReport& _Report, FHBMovementState& _OutState)
+{
+	_Movement.RestoreState(_From);
+	_Movement.Resimulate(_Inputs, _StepTime);
+	_OutState = _Movement.GetMovementState();
+
+	bool confirmed = FVector::DistSquared(_OutState.Location, _Report.Location) <= FMath::Square(Settings.ResimulationTolerance)
+		&& FVector::DistSquared(_OutState.Velocity, _Report.Velocity) <= FMath::Square(Settings.SpeedTolerance);
+
+	if (confirmed)
+	{
+		//< Keep the client's own numbers, they passed. >
+		_OutState.Location = _Report.Location;
+		_OutState.Velocity = _Report.Velocity;
+	}
+	ResetPlayer(_Player, _OutState);
+	return confirmed;
+}
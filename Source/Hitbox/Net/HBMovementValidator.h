@@ -0,0 +1,157 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "../Pawns/HBMovementTypes.h"
+#include "HBMovementValidator.generated.h"
+
+class UHBMovementComponent;
+class UHBPlayerCollisionComponent;
+struct FHBMovementSnapshot;
+
+namespace HBMovementMode
+{
+	//< What a report claims the character was doing, each mode allows different speeds. >
+	constexpr uint8 Ground	= 0;
+	constexpr uint8 Air		= 1;
+	constexpr uint8 WallRun	= 2;
+	constexpr uint8 Ability	= 3;
+
+	constexpr int32 Count	= 4;
+
+	HITBOX_API uint8 FromState(const FHBMovementState& _State);
+}
+
+//< Fastest the movement rules can move a character, per mode. See FHBMovementValidator. >
+struct HITBOX_API FHBMovementLimits
+{
+	float HorizontalSpeed[HBMovementMode::Count] = {}; //< Most any rule of the mode accelerates to. Faster speeds may only be carried in. >
+	float UpSpeed[HBMovementMode::Count] = {}; //< Most upward speed any rule of the mode sets, e.g. jumps, slopes & grapples. >
+	float FallAcceleration = 0; //< Gravity plus the pull towards the ground, units/s/s. >
+
+	//< Least the mode's rules slow down horizontal speed above its limit by, units/s/s. Carried in speed decays at this. >
+	float CarryDeceleration[HBMovementMode::Count] = {};
+
+	//< By ability id, see FHBMovementAbilities. A duration of 0 means the ability never runs. >
+	float AbilityDurations[HBAbility::MaxAbilities] = {};
+	float AbilityCooldowns[HBAbility::MaxAbilities] = {};
+
+	//< _Collision may be null, its class defaults are used then. >
+	static FHBMovementLimits FromComponent(const UHBMovementComponent& _Movement, const UHBPlayerCollisionComponent* _Collision);
+};
+
+//< What a client reports of its character each network tick. >
+struct HITBOX_API FHBMovementReport
+{
+	FVector Location = FVector::ZeroVector;
+	FVector Velocity = FVector::ZeroVector;
+	uint8 Mode = HBMovementMode::Ground;
+	uint8 Ability = HBAbility::None; //< Id of the active ability, for reports in HBMovementMode::Ability. >
+
+	static FHBMovementReport FromState(const FHBMovementState& _State);
+};
+
+USTRUCT(BlueprintType)
+struct HITBOX_API FHBValidationSettings
+{
+	GENERATED_BODY()
+
+	//< Overshoot of a speed limit that counts as one full violation, units/s. Covers quantization & frame timing. >
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Validation")
+		float SpeedTolerance = 60;
+
+	//< Overshoot of the distance a tick could cover that counts as one full violation. >
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Validation")
+		float PositionTolerance = 15;
+
+	//< Violations forgiven per second. A player is escalated once its unforgiven violations reach one. >
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Validation")
+		float SuspicionDecay = 0.5f;
+
+	//< Most a resimulated location may differ from the report & still confirm it, see ConfirmByResimulation. >
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Validation")
+		float ResimulationTolerance = 5;
+};
+
+//< Server side plausibility check of client reported movement, for client authoritative setups. >
+// Each network tick every report is checked against what the movement rules allow from the player's last accepted report:
+// horizontal speed for the mode or what is left of the speed carried in, upward speed (none gained while falling clear of
+// ground & walls) & the distance covered. The claimed mode is only believed as far as the server's own state backs it: wall
+// runs need a wall in the cached contact, abilities one whose cooldown is over or that is still within its duration.
+// Players are scored as SoA packets of four with one set of vector instructions, hb.Net.ValidationBench measures the cost.
+// Only players that keep overshooting are escalated to a full resimulation, see ConfirmByResimulation.
+class HITBOX_API FHBMovementValidator
+{
+public:
+	FHBMovementValidator(const FHBMovementLimits& _Limits, const FHBValidationSettings& _Settings = FHBValidationSettings()) : Limits(_Limits), Settings(_Settings) {}
+
+	//< Players are indexed densely from zero. Returns the new player's index. >
+	int32 AddPlayer(const FHBMovementState& _State);
+
+	//< Accepts _State without checking it, e.g. after a respawn, a correction or a confirmed resimulation. Clears the suspicion. >
+	void ResetPlayer(int32 _Player, const FHBMovementState& _State);
+
+	int32 NumPlayers() const { return Players.Num(); }
+	float GetSuspicion(int32 _Player) const { return Players[_Player].Suspicion; }
+
+	//< One network tick. _Reports & _Contacts are indexed by player, _Contacts are the server's cached queries for each. >
+	// Plausible reports become the players' new baselines. _OutSuspicious gets the players to escalate, whose baselines stay put
+	// until ResetPlayer is called for them.
+	void Validate(TArrayView<const FHBMovementReport> _Reports, TArrayView<const FHBMovementContact> _Contacts, float _DeltaTime, TArray<int32>& _OutSuspicious);
+
+	//< The escalation: restores _Movement to _From, resimulates the client's _Inputs & compares the result with _Report. >
+	// Returns whether the report held up. Either way the player is reset, to the report or to _OutState, the correction to send.
+	bool ConfirmByResimulation(int32 _Player, UHBMovementComponent& _Movement, const FHBMovementSnapshot& _From, TArrayView<const FHBMovementStepInput> _Inputs,
+		float _StepTime, const FHBMovementReport& _Report, FHBMovementState& _OutState);
+
+private:
+	static constexpr int32 PacketWidth = 4;
+
+	//< Checked reports of one packet, filled in by Validate before the vector pass. >
+	struct alignas(16) FPacket
+	{
+		float DeltaX[PacketWidth]; //< Reported minus accepted location. >
+		float DeltaY[PacketWidth];
+		float DeltaZ[PacketWidth];
+		float VelocityX[PacketWidth]; //< Reported. >
+		float VelocityY[PacketWidth];
+		float VelocityZ[PacketWidth];
+		float PreviousHorizontalSpeed[PacketWidth]; //< Of the accepted report. >
+		float PreviousVerticalSpeed[PacketWidth];
+		float CarryDeceleration[PacketWidth]; //< Of the accepted report's mode. >
+		float SpeedLimit[PacketWidth]; //< Fastest mode of the two reports. >
+		float UpLimit[PacketWidth]; //< Most upward speed that can have been reached. >
+		float FalseClaim[PacketWidth]; //< Violations for a claimed mode the server's state doesn't back, 0 otherwise. >
+	};
+
+	struct FPlayer
+	{
+		FVector Location = FVector::ZeroVector;
+		FVector Velocity = FVector::ZeroVector;
+		uint8 Mode = HBMovementMode::Ground; //< As far as the server backed the claim. >
+		float Suspicion = 0;
+
+		//< The ability state as the accepted reports show it. >
+		uint8 Ability = HBAbility::None;
+		float AbilityTime = 0;
+		float AbilityCooldowns[HBAbility::MaxAbilities] = {};
+	};
+
+	//< The mode of _Report the server's state backs. Unbacked wall runs & abilities fall back to ground or air & set _OutFalseClaim. >
+	uint8 BoundMode(const FPlayer& _Player, const FHBMovementReport& _Report, const FHBMovementContact& _Contact, float _DeltaTime, float& _OutFalseClaim) const;
+
+	//< Returns the bounded mode, for Accept. >
+	uint8 FillLane(FPacket& _Packet, int32 _Lane, const FPlayer& _Player, const FHBMovementReport& _Report, const FHBMovementContact& _Contact, float _DeltaTime) const;
+
+	//< Makes _Report the player's baseline & advances its ability state by one tick. >
+	void Accept(FPlayer& _Player, const FHBMovementReport& _Report, uint8 _Mode, float _DeltaTime) const;
+
+	//< Violations of each lane, in multiples of the tolerances. 0 for plausible reports & padding lanes. >
+	void ScorePacket(const FPacket& _Packet, float _DeltaTime, float* _OutScores) const;
+
+	FHBMovementLimits Limits;
+	FHBValidationSettings Settings;
+
+	TArray<FPlayer> Players;
+};
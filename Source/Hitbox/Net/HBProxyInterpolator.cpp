@@ -0,0 +1,125 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HBProxyInterpolator.h"
+#include "../Pawns/HBMovementTypes.h"
+
+FHBProxySnapshot FHBProxySnapshot::FromMovementState(const FHBMovementState& _State, float _CameraRoll, double _Time)
+{
+	FHBProxySnapshot snapshot;
+	snapshot.Time = _Time;
+	snapshot.Location = _State.Location;
+	snapshot.Velocity = _State.Velocity;
+	snapshot.Yaw = _State.Yaw;
+	snapshot.CapsuleHalfHeight = _State.CapsuleHalfHeight;
+	snapshot.CameraRoll = _CameraRoll;
+	return snapshot;
+}
+
+void FHBProxyInterpolator::AddSnapshot(const FHBProxySnapshot& _Snapshot, double _ArrivalTime)
+{
+	//< Already played past it, or a duplicate. >
+	if (_Snapshot.Time <= PlaybackTime || Snapshots.ContainsByPredicate([&](const FHBProxySnapshot& _Other) { return _Other.Time == _Snapshot.Time; }))
+	{
+		LateSnapshots++;
+		return;
+	}
+
+	double transit = _ArrivalTime - _Snapshot.Time;
+	if (NewestTime == -DBL_MAX)
+	{
+		ClockOffset = transit;
+	}
+	else
+	{
+		//< Follow the fastest transit, but let it creep up so a lasting rise in latency is picked up too. >
+		ClockOffset = FMath::Min(transit, ClockOffset + (_ArrivalTime - LastArrival) * 0.01);
+
+		//< RFC 3550 jitter: smoothed difference in transit time between consecutive arrivals. >
+		Jitter += (FMath::Abs(float(transit - LastTransit)) - Jitter) / 16;
+
+		if (_Snapshot.Time > NewestTime)
+		{
+			float interval = float(_Snapshot.Time - NewestTime);
+			Interval = (Interval > 0) ? Interval + (interval - Interval) / 16 : interval;
+		}
+	}
+	LastTransit = transit;
+	LastArrival = _ArrivalTime;
+	NewestTime = FMath::Max(NewestTime, _Snapshot.Time);
+
+	//< Usually lands at the end, reordered ones go in place. >
+	int32 index = Snapshots.Num();
+	while (index > 0 && Snapshots[index - 1].Time > _Snapshot.Time) index--;
+	Snapshots.Insert(_Snapshot, index);
+
+	if (Snapshots.Num() > MaxSnapshots) Snapshots.RemoveAt(0, Snapshots.Num() - MaxSnapshots, false);
+}
+
+float FHBProxyInterpolator::GetTargetDelay() const
+{
+	return FMath::Clamp(Interval + Jitter * Settings.JitterMultiplier, Settings.MinDelay, FMath::Max(Settings.MinDelay, Settings.MaxDelay));
+}
+
+bool FHBProxyInterpolator::Sample(double _Time, float _DeltaTime, FHBProxySnapshot& _OutPose)
+{
+	if (Snapshots.Num() == 0) return false;
+
+	//< Change the delay by stretching or squeezing playback a little, so the proxy never visibly jumps. >
+	float targetDelay = GetTargetDelay();
+	float maxChange = Settings.DelayAdjustRate * _DeltaTime;
+	Delay = (Delay < 0) ? targetDelay : Delay + FMath::Clamp(targetDelay - Delay, -maxChange, maxChange);
+
+	//< Playback never runs backwards, even when the clock offset is corrected. >
+	PlaybackTime = FMath::Max(PlaybackTime, _Time - ClockOffset - Delay);
+
+	//< Keep one snapshot at or before the playback time to blend from. >
+	int32 expired = 0;
+	while (expired + 1 < Snapshots.Num() && Snapshots[expired + 1].Time <= PlaybackTime) expired++;
+	if (expired > 0) Snapshots.RemoveAt(0, expired, false);
+
+	const FHBProxySnapshot& from = Snapshots[0];
+	Extrapolating = false;
+
+	if (PlaybackTime <= from.Time)
+	{
+		_OutPose = from;
+	}
+	else if (Snapshots.Num() > 1)
+	{
+		const FHBProxySnapshot& to = Snapshots[1];
+		float span = float(to.Time - from.Time);
+		float alpha = float(PlaybackTime - from.Time) / span;
+
+		//< Hermite tangents are velocities scaled to the span. >
+		_OutPose.Location			= FMath::CubicInterp(from.Location, from.Velocity * span, to.Location, to.Velocity * span, alpha);
+		_OutPose.Velocity			= FMath::Lerp(from.Velocity, to.Velocity, alpha);
+		_OutPose.Yaw				= from.Yaw + FRotator::NormalizeAxis(to.Yaw - from.Yaw) * alpha;
+		_OutPose.CapsuleHalfHeight	= FMath::Lerp(from.CapsuleHalfHeight, to.CapsuleHalfHeight, alpha);
+		_OutPose.CameraRoll			= FMath::Lerp(from.CameraRoll, to.CameraRoll, alpha);
+	}
+	else
+	{
+		//< Ran dry: carry on in a straight line for a short while, then hold. Interpolation takes over again with the next snapshot. >
+		float ahead = FMath::Min(float(PlaybackTime - from.Time), Settings.MaxExtrapolationTime);
+		_OutPose = from;
+		_OutPose.Location += from.Velocity * ahead;
+		Extrapolating = true;
+	}
+	_OutPose.Time = PlaybackTime;
+	return true;
+}
+
+void FHBProxyInterpolator::Reset()
+{
+	Snapshots.Reset();
+	ClockOffset = 0;
+	LastTransit = 0;
+	LastArrival = 0;
+	NewestTime = -DBL_MAX;
+	PlaybackTime = -DBL_MAX;
+	Interval = 0;
+	Jitter = 0;
+	Delay = -1;
+	Extrapolating = false;
+	LateSnapshots = 0;
+}
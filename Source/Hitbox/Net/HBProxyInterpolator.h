@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HBProxyInterpolator.generated.h"
+
+struct FHBMovementState;
+
+//< What a remote character is drawn from, taken by its owning peer. See AHBPhysicsCharacter::MakeProxySnapshot. >
+struct HITBOX_API FHBProxySnapshot
+{
+	double Time = 0; //< Sender's world time the snapshot was taken at. >
+	FVector Location = FVector::ZeroVector;
+	FVector Velocity = FVector::ZeroVector;
+	float Yaw = 0;
+	float CapsuleHalfHeight = 86;
+	float CameraRoll = 0; //< Of the view, e.g. leaning into a wall run. >
+
+	static FHBProxySnapshot FromMovementState(const FHBMovementState& _State, float _CameraRoll, double _Time);
+};
+
+//< Tuning of the jitter buffer, see FHBProxyInterpolator. >
+USTRUCT(BlueprintType)
+struct HITBOX_API FHBProxyInterpolationSettings
+{
+	GENERATED_BODY()
+
+	//< The buffer delay stays between these, in seconds. >
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Interpolation")
+		float MinDelay = 0.02f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Interpolation")
+		float MaxDelay = 0.25f;
+
+	//< Measured arrival jitter times this is kept buffered on top of the send interval. Higher survives worse networks & adds latency. >
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Interpolation")
+		float JitterMultiplier = 3;
+
+	//< Fraction of a second the delay may grow or shrink by per second, i.e. how far playback may speed up or slow down. >
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Interpolation", meta = (ClampMin = "0.0", ClampMax = "0.5"))
+		float DelayAdjustRate = 0.1f;
+
+	//< Seconds the last snapshot is carried forward by its velocity once the buffer runs dry, before the proxy holds still. >
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Interpolation")
+		float MaxExtrapolationTime = 0.15f;
+};
+
+//< Adaptive jitter buffer for one remote character. >
+// Snapshots are played back a little behind the sender, far enough that the next one has usually arrived by the time it is needed.
+// How far is worked out from the send interval & the variation in transit time (as RTP does it), & changes by gently speeding
+// up or slowing down playback rather than jumping. Reordered snapshots are put in place, ones that arrive too late are dropped.
+class HITBOX_API FHBProxyInterpolator
+{
+public:
+	FHBProxyInterpolator(const FHBProxyInterpolationSettings& _Settings = FHBProxyInterpolationSettings()) : Settings(_Settings) {}
+
+	void SetSettings(const FHBProxyInterpolationSettings& _Settings) { Settings = _Settings; }
+
+	//< _ArrivalTime is the local world time the snapshot was received at. >
+	void AddSnapshot(const FHBProxySnapshot& _Snapshot, double _ArrivalTime);
+
+	//< Pose to draw at local world time _Time. False until the first snapshot has arrived. >
+	// Positions follow a cubic through the snapshots' locations & velocities, yaw, crouch height & roll are blended linearly.
+	bool Sample(double _Time, float _DeltaTime, FHBProxySnapshot& _OutPose);
+
+	//< Forgets every snapshot & measurement, e.g. when the character respawns or changes owner. >
+	void Reset();
+
+	int32 NumSnapshots() const { return Snapshots.Num(); }
+	float GetDelay() const { return Delay; }
+	float GetTargetDelay() const;
+	float GetJitter() const { return Jitter; }
+	bool IsExtrapolating() const { return Extrapolating; }
+	uint32 GetLateSnapshots() const { return LateSnapshots; }
+
+private:
+	static constexpr int32 MaxSnapshots = 32;
+
+	FHBProxyInterpolationSettings Settings;
+
+	TArray<FHBProxySnapshot, TInlineAllocator<MaxSnapshots>> Snapshots; //< Oldest first, only the one before the playback time is kept. >
+
+	double ClockOffset = 0; //< Local minus sender time of the fastest recent snapshot. >
+	double LastTransit = 0;
+	double LastArrival = 0;
+	double NewestTime = -DBL_MAX;
+	double PlaybackTime = -DBL_MAX; //< Sender time last sampled at. >
+
+	float Interval = 0; //< Smoothed time between snapshots at the sender. >
+	float Jitter = 0; //< Smoothed variation in transit time. >
+	float Delay = -1; //< Current buffer delay, < 0 until the first sample. >
+
+	bool Extrapolating = false;
+	uint32 LateSnapshots = 0;
+};
@@ -1,15 +1,19 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "HBCameraController.h"
+#include "HBMovementComponent.h"
 #include "Camera/CameraComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "../HBMathLibrary.h"
 
 // Sets default values for this component's properties
 UHBCameraController::UHBCameraController()
 {
 	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.TickGroup = TG_PrePhysics; //< The movement waits on this tick & has to hand its input to the sub steps before physics starts. >
 
 	ViewMountComponent = CreateDefaultSubobject<USceneComponent>(TEXT("ViewMount"));
-	
+
 	CameraComponent = CreateDefaultSubobject<UCameraComponent>(TEXT("Camera"));
 	CameraComponent->SetupAttachment(ViewMountComponent);
 }
@@ -27,35 +31,136 @@ void UHBCameraController::SetupAttachment(USceneComponent* InParent, FName InSoc
 void UHBCameraController::BeginPlay()
 {
 	Super::BeginPlay();
+
+	MovementComponent = GetOwner()->FindComponentByClass<UHBMovementComponent>();
+	if (MovementComponent)
+	{
+		//< Both tick in TG_PrePhysics, so this frame's yaw reaches this frame's movement step. >
+		MovementComponent->AddTickPrerequisiteComponent(this);
+	}
+	SpawnPitch = ViewMountComponent->GetRelativeRotation().Pitch;
+	Pitch = SpawnPitch;
+	SnapToTargets();
 }
 
 // Called every frame
 void UHBCameraController::TickComponent(float _DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
-	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	Super::TickComponent(_DeltaTime, TickType, ThisTickFunction);
 
-	//< Tick delta rotation. >
-	FRotator deltaRot = DeltaRot * FMath::Clamp((float)(_DeltaTime * CameraRotationSpeed), 0.0f, 1.0f);
-	DeltaRot -= deltaRot;
+	//< Mouse look. Pitch stays on the view mount, yaw turns the whole character inside its movement step. >
+	FVector2D look = LookInput * 25 * MouseSensitivity * _DeltaTime;
+	LookInput = FVector2D::ZeroVector;
+	Pitch = FMath::Clamp(Pitch + look.Y, -MaxPitch, MaxPitch);
+
+	//< Take over whatever rotation the movement asked for since last frame. >
+	if (MovementComponent)
+	{
+		//< A wall run that ends cancels the yaw it asked for, but that was already taken over, so drop what is left of it here. >
+		bool wallRunActive = MovementComponent->GetMovementState().WallRunActive;
+		if (WallRunActive && !wallRunActive)
+		{
+			TargetOffset.Yaw = 0;
+			OffsetVelocity.Yaw = 0;
+		}
+		WallRunActive = wallRunActive;
+
+		FRotator requested = MovementComponent->GetTargetRotationDelta();
+		if (!requested.IsNearlyZero())
+		{
+			TargetOffset += requested;
+			MovementComponent->SetTargetRotationDelta(FRotator::ZeroRotator);
+		}
+	}
 
+	//< Tick the springs. >
+	Offset.Pitch	= UHBMathLibrary::CriticallyDampedSpring(Offset.Pitch, OffsetVelocity.Pitch, TargetOffset.Pitch, RotationSmoothTime.Pitch, _DeltaTime);
+	Offset.Roll		= UHBMathLibrary::CriticallyDampedSpring(Offset.Roll, OffsetVelocity.Roll, TargetOffset.Roll, RotationSmoothTime.Roll, _DeltaTime);
+	Height			= UHBMathLibrary::CriticallyDampedSpring(Height, HeightVelocity, GetTargetHeight(), HeightSmoothTime, _DeltaTime);
 
-	MovementComponent->SetTargetRotationDelta(deltaRot);
+	//< The yaw offset is handed to the character as it goes, so its spring always starts from zero. >
+	float yawOffset = UHBMathLibrary::CriticallyDampedSpring(0, OffsetVelocity.Yaw, TargetOffset.Yaw, RotationSmoothTime.Yaw, _DeltaTime);
+	TargetOffset.Yaw -= yawOffset;
 
-	return FRotator(pitch, yaw, roll);
+	float yaw = look.X + yawOffset;
+	if (yaw != 0)
+	{
+		if (MovementComponent) MovementComponent->AddYawInput(yaw);
+		else GetOwner()->AddActorWorldRotation(FRotator(0, yaw, 0), false);
+	}
 
+	CommitViewTransform();
+}
 
-	//< Tick target rotation. >
+void UHBCameraController::RotateAxisBy(FRotator _Axis, float _Rotation, bool _Additive /*= true*/)
+{
+	FRotator rotation = _Axis * _Rotation;
+	TargetOffset = (_Additive) ? TargetOffset + rotation : rotation;
 }
 
-void UHBCameraController::RotateAxisBy(FRotator _Axis, float _Rotation, bool _Additive /*= true*/, UCurveFloat* _Curve /*= nullptr*/)
+void UHBCameraController::RotateAxisTo(FRotator _Axis, float _Rotation)
 {
-	//< Set remaining rotation. >
-	FRotator newRot = _Axis * _Rotation;
-	DeltaRot += (_Additive) ? (DeltaRot + newRot) : newRot;
+	if (_Axis.Pitch != 0)	TargetOffset.Pitch	= _Rotation;
+	if (_Axis.Yaw != 0)		TargetOffset.Yaw	= _Rotation;
+	if (_Axis.Roll != 0)	TargetOffset.Roll	= _Rotation;
 }
 
-void UHBCameraController::RotateAxisTo(FRotator _Axis, float _Rotation, UCurveFloat* _Curve /*= nullptr*/)
+void UHBCameraController::SnapToTargets()
 {
+	Offset.Pitch = TargetOffset.Pitch;
+	Offset.Roll = TargetOffset.Roll;
+	OffsetVelocity = FRotator::ZeroRotator;
 
+	Height = GetTargetHeight();
+	HeightVelocity = 0;
+
+	//< Force the commit. >
+	CommittedLocation = FVector(TNumericLimits<float>::Max());
+	CommitViewTransform();
 }
 
+void UHBCameraController::ResetForRespawn()
+{
+	LookInput = FVector2D::ZeroVector;
+	Pitch = SpawnPitch;
+	WallRunActive = false;
+	TargetOffset = FRotator::ZeroRotator;
+	Offset = FRotator::ZeroRotator;
+	SnapToTargets();
+}
+
+void UHBCameraController::SetProxyView(float _HalfHeight, float _Roll)
+{
+	Height = _HalfHeight - CameraDepth;
+	HeightVelocity = 0;
+	Offset.Roll = _Roll;
+	OffsetVelocity.Roll = 0;
+	CommitViewTransform();
+}
+
+float UHBCameraController::GetTargetHeight() const
+{
+	//< Follow the published movement state while playing, the capsule otherwise (e.g. in the editor). >
+	float halfHeight = (MovementComponent) ? MovementComponent->GetMovementState().CapsuleHalfHeight : 0;
+	if (halfHeight <= 0)
+	{
+		if (UCapsuleComponent* cc = Cast<UCapsuleComponent>(GetOwner()->GetRootComponent()))
+		{
+			halfHeight = cc->GetScaledCapsuleHalfHeight();
+		}
+	}
+	return halfHeight - CameraDepth;
+}
+
+void UHBCameraController::CommitViewTransform()
+{
+	FVector location(0, 0, Height);
+	FRotator rotation(Pitch + Offset.Pitch, 0, Offset.Roll);
+
+	//< Skip the update, & with it the transform propagation to the camera, while nothing visibly moves. >
+	if (location.Equals(CommittedLocation, 0.01f) && rotation.Equals(CommittedRotation, 0.001f)) return;
+
+	ViewMountComponent->SetRelativeLocationAndRotation(location, rotation);
+	CommittedLocation = location;
+	CommittedRotation = rotation;
+}
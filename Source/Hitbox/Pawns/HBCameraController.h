@@ -6,12 +6,12 @@
 #include "Components/ActorComponent.h"
 #include "HBCameraController.generated.h"
 
-class AHBPhysicsCharacter;
+class UHBMovementComponent;
 class UCameraComponent;
 class USceneComponent;
 
-//< I'm going to be refactoring the code structure a bit, moving much of the camera functionality into here. >
-
+//< Owns the first person view: mouse look, the rotation the movement asks for (wall run roll etc.) & the crouch height. >
+// Everything is smoothed with critically damped springs & written to the view mount in at most one transform update per frame.
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class HITBOX_API UHBCameraController : public UActorComponent
 {
@@ -31,15 +31,65 @@ protected:
 
 public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Camera")
-		FRotator CameraRotationSpeed = FRotator(5.0f, 5.0f, 5.0f);
+		float CameraDepth = 15; //< Distance of the eyes below the top of the capsule. >
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Camera", meta = (ClampMin = "1.0", ClampMax = "10.0", UIMin = "1.0", UIMax = "10.0"))
+		int MouseSensitivity = 5;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Camera")
+		float MaxPitch = 85;
+
+	//< Seconds the springs take to settle. Pitch & yaw are for the offsets requested by the movement, mouse look is never smoothed. >
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Camera|Smoothing")
+		FRotator RotationSmoothTime = FRotator(0.2f, 0.2f, 0.2f);
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Camera|Smoothing")
+		float HeightSmoothTime = 0.08f;
+
+
+	//< Mouse look, applied on the next tick. >
+	void AddLookInput(FVector2D _Delta) { LookInput += _Delta; }
+
+	//< Adds _Rotation degrees on each axis selected by _Axis (e.g. FRotator(0, 0, 1) for roll) to the target offset. >
+	void RotateAxisBy(FRotator _Axis, float _Rotation, bool _Additive = true);
 
+	//< Sets the target offset on each axis selected by _Axis to _Rotation degrees. >
+	void RotateAxisTo(FRotator _Axis, float _Rotation);
 
-	void RotateAxisBy(FRotator _Axis, float _Rotation, bool _Additive = true, UCurveFloat* _Curve = nullptr);
-	void RotateAxisTo(FRotator _Axis, float _Rotation, UCurveFloat* _Curve = nullptr);
+	//< Puts every spring at its target & commits the view mount, e.g. after construction or a teleport. >
+	void SnapToTargets();
+
+	//< Level view with no pending offsets, snapped. Call after the movement has been reset, see AHBPhysicsCharacter::RespawnAt. >
+	void ResetForRespawn();
+
+	//< Roll the view currently shows, e.g. for the snapshots a remote proxy is drawn from. >
+	float GetViewRoll() const { return Offset.Roll; }
+
+	//< Remote proxies, see AHBPhysicsCharacter::SetRemoteProxy. Eye height & roll are set as given, their snapshots are already smooth. >
+	void SetProxyView(float _HalfHeight, float _Roll);
 
 private:
-	FRotator DeltaRot = FRotator::ZeroRotator;
-	FRotator TargetRot	= FRotator::ZeroRotator;
+	float GetTargetHeight() const;
+
+	//< Writes the view mount transform if it changed enough to be visible. >
+	void CommitViewTransform();
+
+	UHBMovementComponent* MovementComponent = nullptr;
+
+	FVector2D LookInput = FVector2D::ZeroVector;
+	float Pitch = 0;
+	float SpawnPitch = 0; //< View mount pitch the character was placed with. >
+
+	FRotator TargetOffset = FRotator::ZeroRotator;
+	FRotator Offset = FRotator::ZeroRotator;
+	FRotator OffsetVelocity = FRotator::ZeroRotator;
+	bool WallRunActive = false; //< As the movement last published it. >
+
+	float Height = 0;
+	float HeightVelocity = 0;
+
+	FVector CommittedLocation = FVector::ZeroVector;
+	FRotator CommittedRotation = FRotator::ZeroRotator;
 
 
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,347 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HBMovementTypes.h"
+#include "HBMovementAbilities.generated.h"
+
+USTRUCT(BlueprintType)
+struct HITBOX_API FHBDashSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dash")
+		bool Enabled = true;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dash")
+		float Speed = 2200;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dash")
+		float Duration = 0.15f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dash")
+		float ExitSpeed = 900; //< Horizontal speed left once the dash is over. >
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dash")
+		float Cooldown = 0.8f;
+};
+
+USTRUCT(BlueprintType)
+struct HITBOX_API FHBGrappleSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grapple")
+		bool Enabled = true;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grapple")
+		float Range = 2500;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grapple")
+		float Acceleration = 5000;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grapple")
+		float MaxSpeed = 2200;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grapple")
+		float ReleaseDistance = 150; //< Lets go this close to the grapple point. >
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grapple")
+		float MaxDuration = 3;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grapple")
+		float Cooldown = 0.5f;
+};
+
+USTRUCT(BlueprintType)
+struct HITBOX_API FHBLedgeClimbSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LedgeClimb")
+		bool Enabled = true;
+
+	//< Ledge heights above the bottom of the capsule that can be climbed. >
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LedgeClimb")
+		float MinHeight = 60;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LedgeClimb")
+		float MaxHeight = 220;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LedgeClimb")
+		float Duration = 0.35f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LedgeClimb")
+		float ExitSpeed = 300;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "LedgeClimb")
+		float Cooldown = 0.3f;
+};
+
+USTRUCT(BlueprintType)
+struct HITBOX_API FHBAbilitySettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Abilities")
+		FHBDashSettings Dash;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Abilities")
+		FHBGrappleSettings Grapple;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Abilities")
+		FHBLedgeClimbSettings LedgeClimb;
+};
+
+//< Everything an ability sees during a movement step. >
+struct FHBAbilityContext
+{
+	FHBMovementState& State;
+	const FHBMovementInput& Input;
+	const FHBMovementContact& Contact;
+	const FHBAbilitySettings& Settings;
+	float DeltaTime;
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//< ABILITIES >
+// Each ability is a policy type with static functions, composed into a THBAbilitySet:
+//	bool CanEnter(const FHBAbilityContext&)	//< Checked while no ability is active. >
+//	void Enter(FHBAbilityContext&)
+//	bool Tick(FHBAbilityContext&)			//< Owns the step's velocity. Returns false once done. >
+//	float Exit(FHBAbilityContext&)			//< Returns the cooldown in seconds. >
+//	float MaxDuration(const FHBAbilitySettings&)	//< Longest it stays active, 0 while disabled. For server side validation. >
+//	float Cooldown(const FHBAbilitySettings&)
+// Abilities only start from the regular movement modes, never during a wall run.
+
+//< Short burst along the movement input, or forward without input. Ignores gravity while it lasts. >
+struct FHBDashAbility
+{
+	static bool CanEnter(const FHBAbilityContext& _Context)
+	{
+		return _Context.Settings.Dash.Enabled
+			&& (_Context.State.Ability.Requests & HBAbility::Request_Dash)
+			&& !_Context.State.WallRunActive;
+	}
+
+	static void Enter(FHBAbilityContext& _Context)
+	{
+		FHBMovementState& state = _Context.State;
+		FVector direction = FVector(_Context.Input.MovementInput.X, _Context.Input.MovementInput.Y, 0);
+		if (direction.IsNearlyZero()) direction = FVector::ForwardVector;
+
+		state.Ability.Target = state.GetRotation().RotateVector(direction).GetSafeNormal();
+	}
+
+	static bool Tick(FHBAbilityContext& _Context)
+	{
+		FHBMovementState& state = _Context.State;
+		state.Velocity = state.Ability.Target * _Context.Settings.Dash.Speed;
+		return state.Ability.Time < _Context.Settings.Dash.Duration;
+	}
+
+	static float Exit(FHBAbilityContext& _Context)
+	{
+		FHBMovementState& state = _Context.State;
+		state.Velocity = state.Ability.Target * _Context.Settings.Dash.ExitSpeed;
+		return Cooldown(_Context.Settings);
+	}
+
+	static float MaxDuration(const FHBAbilitySettings& _Settings) { return (_Settings.Dash.Enabled) ? _Settings.Dash.Duration : 0; }
+	static float Cooldown(const FHBAbilitySettings& _Settings) { return _Settings.Dash.Cooldown; }
+};
+
+//< Pulls towards the point passed to UHBMovementComponent::Input_Grapple until released, close or out of time. >
+struct FHBGrappleAbility
+{
+	static bool CanEnter(const FHBAbilityContext& _Context)
+	{
+		const FHBMovementState& state = _Context.State;
+		return _Context.Settings.Grapple.Enabled
+			&& (state.Ability.Requests & HBAbility::Request_Grapple)
+			&& !state.WallRunActive
+			&& FVector::DistSquared(state.Location, state.Ability.RequestedTarget) <= FMath::Square(_Context.Settings.Grapple.Range);
+	}
+
+	static void Enter(FHBAbilityContext& _Context)
+	{
+		_Context.State.Ability.Target = _Context.State.Ability.RequestedTarget;
+		_Context.State.Grounded = false;
+	}
+
+	static bool Tick(FHBAbilityContext& _Context)
+	{
+		FHBMovementState& state = _Context.State;
+		const FHBGrappleSettings& settings = _Context.Settings.Grapple;
+		if (state.Ability.Requests & HBAbility::Request_GrappleRelease) return false;
+		if (state.Ability.Time > settings.MaxDuration) return false;
+
+		FVector toTarget = state.Ability.Target - state.Location;
+		if (toTarget.SizeSquared() < FMath::Square(settings.ReleaseDistance)) return false;
+
+		state.Velocity += toTarget.GetSafeNormal() * (settings.Acceleration * _Context.DeltaTime);
+		state.Velocity = state.Velocity.GetClampedToMaxSize(settings.MaxSpeed);
+		return true;
+	}
+
+	static float Exit(FHBAbilityContext& _Context)
+	{
+		//< Keep the momentum. >
+		return Cooldown(_Context.Settings);
+	}
+
+	static float MaxDuration(const FHBAbilitySettings& _Settings) { return (_Settings.Grapple.Enabled) ? _Settings.Grapple.MaxDuration : 0; }
+	static float Cooldown(const FHBAbilitySettings& _Settings) { return _Settings.Grapple.Cooldown; }
+};
+
+//< Climbs onto a ledge found by the collision component's ledge probe while pushing forward into the wall under it. >
+// Rises straight up until clear of the edge, then steps over it.
+struct FHBLedgeClimbAbility
+{
+	static bool CanEnter(const FHBAbilityContext& _Context)
+	{
+		const FHBMovementState& state = _Context.State;
+		const FHBMovementContact& contact = _Context.Contact;
+		const FHBLedgeClimbSettings& settings = _Context.Settings.LedgeClimb;
+		if (!settings.Enabled || !contact.HasLedge() || state.WallRunActive) return false;
+		if (contact.LedgeHeight < settings.MinHeight || contact.LedgeHeight > settings.MaxHeight) return false;
+		if (!contact.IsNearWall() || _Context.Input.MovementInput.X <= 0) return false;
+
+		FVector intoWall = -FVector(contact.WallNormal.X, contact.WallNormal.Y, 0).GetSafeNormal();
+		return FVector::DotProduct(state.GetRotation().GetForwardVector(), intoWall) > 0.7f;
+	}
+
+	static void Enter(FHBAbilityContext& _Context)
+	{
+		FHBMovementState& state = _Context.State;
+		state.Ability.Target = _Context.Contact.LedgePoint + FVector::UpVector * (state.CapsuleHalfHeight + 2);
+		state.Grounded = false;
+	}
+
+	static bool Tick(FHBAbilityContext& _Context)
+	{
+		FHBMovementState& state = _Context.State;
+		const FHBLedgeClimbSettings& settings = _Context.Settings.LedgeClimb;
+		float dt = FMath::Max(_Context.DeltaTime, KINDA_SMALL_NUMBER);
+
+		FVector toTarget = state.Ability.Target - state.Location;
+		if (state.Ability.Time > settings.Duration || toTarget.SizeSquared() < 4) return false;
+
+		//< The first 60% of the climb is for rising, the rest for stepping over. >
+		if (toTarget.Z > 1)
+		{
+			float riseTime = FMath::Max(settings.Duration * 0.6f - state.Ability.Time, dt);
+			state.Velocity = FVector(0, 0, toTarget.Z / riseTime);
+		}
+		else
+		{
+			float stepTime = FMath::Max(settings.Duration - state.Ability.Time, dt);
+			state.Velocity = FVector(toTarget.X, toTarget.Y, 0) / stepTime;
+		}
+		return true;
+	}
+
+	static float Exit(FHBAbilityContext& _Context)
+	{
+		FHBMovementState& state = _Context.State;
+		state.Velocity = state.GetRotation().GetForwardVector() * _Context.Settings.LedgeClimb.ExitSpeed;
+		return Cooldown(_Context.Settings);
+	}
+
+	static float MaxDuration(const FHBAbilitySettings& _Settings) { return (_Settings.LedgeClimb.Enabled) ? _Settings.LedgeClimb.Duration : 0; }
+	static float Cooldown(const FHBAbilitySettings& _Settings) { return _Settings.LedgeClimb.Cooldown; }
+};
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//< COMPOSITION >
+
+//< Recursion over the abilities of a set. TIndex is the ability's id in FHBAbilityState. >
+template<uint8 TIndex, typename... TAbilities>
+struct THBAbilityChain
+{
+	static bool TryEnter(FHBAbilityContext& _Context) { return false; }
+	static void Tick(FHBAbilityContext& _Context) {}
+	static void GetLimits(const FHBAbilitySettings& _Settings, float* _OutDurations, float* _OutCooldowns) {}
+};
+
+template<uint8 TIndex, typename TAbility, typename... TRest>
+struct THBAbilityChain<TIndex, TAbility, TRest...>
+{
+	using FNext = THBAbilityChain<TIndex + 1, TRest...>;
+
+	static bool TryEnter(FHBAbilityContext& _Context)
+	{
+		FHBAbilityState& ability = _Context.State.Ability;
+		if (ability.Cooldowns[TIndex] <= 0 && TAbility::CanEnter(_Context))
+		{
+			ability.Active = TIndex;
+			ability.Time = 0;
+			TAbility::Enter(_Context);
+			return true;
+		}
+		return FNext::TryEnter(_Context);
+	}
+
+	static void Tick(FHBAbilityContext& _Context)
+	{
+		FHBAbilityState& ability = _Context.State.Ability;
+		if (ability.Active != TIndex)
+		{
+			FNext::Tick(_Context);
+			return;
+		}
+
+		if (!TAbility::Tick(_Context))
+		{
+			ability.Cooldowns[TIndex] = TAbility::Exit(_Context);
+			ability.Active = HBAbility::None;
+		}
+		ability.Time += _Context.DeltaTime;
+	}
+
+	static void GetLimits(const FHBAbilitySettings& _Settings, float* _OutDurations, float* _OutCooldowns)
+	{
+		_OutDurations[TIndex] = TAbility::MaxDuration(_Settings);
+		_OutCooldowns[TIndex] = TAbility::Cooldown(_Settings);
+		FNext::GetLimits(_Settings, _OutDurations, _OutCooldowns);
+	}
+};
+
+//< Abilities composed at compile time. Earlier abilities win when several could start on the same step. >
+// Dispatch is a chain of inlined index compares, abilities left out of the set cost nothing.
+template<typename... TAbilities>
+struct THBAbilitySet
+{
+	static_assert(sizeof...(TAbilities) <= HBAbility::MaxAbilities, "Raise HBAbility::MaxAbilities.");
+
+	using FChain = THBAbilityChain<0, TAbilities...>;
+
+	//< Runs the active ability, or starts one. Returns true if an ability owned the step & the regular rules should not run. >
+	static bool Step(FHBAbilityContext& _Context)
+	{
+		FHBAbilityState& ability = _Context.State.Ability;
+		for (int32 i = 0; i < (int32)sizeof...(TAbilities); i++)
+		{
+			ability.Cooldowns[i] = FMath::Max(ability.Cooldowns[i] - _Context.DeltaTime, 0.0f);
+		}
+
+		bool owned = ability.IsActive() || FChain::TryEnter(_Context);
+		if (owned) FChain::Tick(_Context);
+
+		//< A press only counts on the step it arrives. >
+		ability.Requests = 0;
+		return owned;
+	}
+
+	//< MaxDuration & Cooldown of every ability by its id, ids the set doesn't use are left alone. >
+	static void GetLimits(const FHBAbilitySettings& _Settings, float (&_OutDurations)[HBAbility::MaxAbilities], float (&_OutCooldowns)[HBAbility::MaxAbilities])
+	{
+		FChain::GetLimits(_Settings, _OutDurations, _OutCooldowns);
+	}
+};
+
+//< Every ability the movement steps can run, in order of priority. >
+using FHBMovementAbilities = THBAbilitySet<FHBLedgeClimbAbility, FHBGrappleAbility, FHBDashAbility>;
@@ -5,6 +5,106 @@
 #include "HBPlayerCollisionComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Kismet/KismetMathLibrary.h"
+#include "PhysicsEngine/PhysicsSettings.h"
+#include "Async/ParallelFor.h"
+#include "Serialization/BitWriter.h"
+#include "Serialization/BitReader.h"
+#include "UObject/UObjectIterator.h"
+#include "../Lockstep/HBLockstepSubsystem.h"
+#include "../Hitbox.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Movement Steps"), STAT_HBMovementSteps, STATGROUP_HBMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Movement Steps Saved"), STAT_HBMovementStepsSaved, STATGROUP_HBMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Movement Steps Coasted"), STAT_HBMovementStepsCoasted, STATGROUP_HBMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ballistic Sweeps"), STAT_HBBallisticSweeps, STATGROUP_HBMovement);
+
+static TAutoConsoleVariable<int32> CVarShowStateBandwidth(
+	TEXT("hb.Net.ShowStateBandwidth"),
+	0,
+	TEXT("Shows the size of a delta compressed movement state update each frame & checks that it round trips."));
+
+//< How many physics sub steps the engine runs for a frame of _DeltaTime, following FPhysScene & FPhysSubstepTask: >
+// the frame is first capped at MaxPhysicsDeltaTime, then split by a plain ceil, so a MaxSubstepDeltaTime rounded below 1/120 makes 3 at 60 Hz.
+static int32 GetFrameSubsteps(float _DeltaTime)
+{
+	const UPhysicsSettings* physicsSettings = UPhysicsSettings::Get();
+	if (!physicsSettings->bSubstepping) return 1;
+
+	int32 maxSubsteps = FMath::Clamp(physicsSettings->MaxSubsteps, 1, 16);
+	float frameTime = FMath::Min(FMath::Min(_DeltaTime, physicsSettings->MaxPhysicsDeltaTime), maxSubsteps * physicsSettings->MaxSubstepDeltaTime);
+	return FMath::Clamp(FMath::CeilToInt(frameTime / physicsSettings->MaxSubstepDeltaTime), 1, maxSubsteps);
+}
+
+static FAutoConsoleCommandWithWorldAndArgs RollbackBenchmarkCommand(
+	TEXT("hb.Movement.RollbackBench"),
+	TEXT("hb.Movement.RollbackBench [Frames=8] [Iterations=20]: Saves every character's movement, resimulates Frames 60 Hz frames of sub steps ")
+	TEXT("with its current input & restores it, then logs the cost of a rollback of all characters against the frame."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& _Args, UWorld* _World)
+	{
+		int32 frames = (_Args.Num() > 0) ? FMath::Max(FCString::Atoi(*_Args[0]), 1) : 8;
+		int32 iterations = (_Args.Num() > 1) ? FMath::Max(FCString::Atoi(*_Args[1]), 1) : 20;
+
+		TArray<UHBMovementComponent*> components;
+		for (TObjectIterator<UHBMovementComponent> it; it; ++it)
+		{
+			if (it->GetWorld() == _World && it->HasBegunPlay() && it->IsComponentTickEnabled()) components.Add(*it);
+		}
+
+		//< The frame split into equal sub steps, as many as the engine would run. >
+		const float frameTime = 1.0f / 60.0f;
+		int32 frameSubsteps = GetFrameSubsteps(frameTime);
+		float deltaTime = frameTime / frameSubsteps;
+
+		int32 simulated = 0;
+		for (UHBMovementComponent* component : components)
+		{
+			if (component->BodyMode == EHBBodyMode::Simulated) simulated++;
+		}
+
+		TArray<FHBMovementSnapshot> snapshots;
+		snapshots.SetNum(components.Num());
+		TArray<FHBMovementStepInput> inputs;
+		double saveSeconds = 0, resimulateSeconds = 0, restoreSeconds = 0;
+
+		for (int32 iteration = 0; iteration < iterations; iteration++)
+		{
+			double startTime = FPlatformTime::Seconds();
+			for (int32 i = 0; i < components.Num(); i++) components[i]->SaveState(snapshots[i]);
+			saveSeconds += FPlatformTime::Seconds() - startTime;
+
+			for (int32 i = 0; i < components.Num(); i++)
+			{
+				//< Continue from the applied input, so only held input repeats & no press is counted twice. >
+				inputs.Reset();
+				for (int32 step = 0; step < frames * frameSubsteps; step++)
+				{
+					FHBMovementStepInput& input = inputs.Add_GetRef(snapshots[i].AppliedStepInput);
+					input.Input = components[i]->GetMovementInput();
+					input.FrameNumber += 1 + step / frameSubsteps;
+					input.FrameSubsteps = frameSubsteps;
+				}
+
+				startTime = FPlatformTime::Seconds();
+				components[i]->Resimulate(inputs, deltaTime);
+				resimulateSeconds += FPlatformTime::Seconds() - startTime;
+			}
+
+			startTime = FPlatformTime::Seconds();
+			for (int32 i = 0; i < components.Num(); i++) components[i]->RestoreState(snapshots[i]);
+			restoreSeconds += FPlatformTime::Seconds() - startTime;
+		}
+
+		double rollbackMs = (saveSeconds + resimulateSeconds + restoreSeconds) * 1000 / iterations;
+		UE_LOG(LogTemp, Display, TEXT("Rollback of %d characters by %d frames (%d steps each): save %.2f us, resimulate %.3f ms, restore %.2f us. %.3f ms total, %.1f%% of a %.1f ms frame."),
+			components.Num(), frames, frames * frameSubsteps,
+			saveSeconds * 1000000 / iterations, resimulateSeconds * 1000 / iterations, restoreSeconds * 1000000 / iterations,
+			rollbackMs, rollbackMs * 100 / (frameTime * 1000), frameTime * 1000);
+
+		if (simulated > 0)
+		{
+			UE_LOG(LogTemp, Display, TEXT("%d of them are in simulated mode, which resimulates with sweeps rather than the solver: the cost is representative, the motion only approximate."), simulated);
+		}
+	}));
 
 UHBMovementComponent::UHBMovementComponent(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
@@ -23,34 +123,148 @@ void UHBMovementComponent::BeginPlay()
 {
 	Super::BeginPlay();
 	CalculateCustomPhysics.BindUObject(this, &UHBMovementComponent::SubstepTick);
+	CostMap = GetWorld()->GetSubsystem<UHBMovementCostMapSubsystem>();
 
 	//< Apply the player physics material. >
 	if (PhysicsMaterial) CollisionComponent->CapsuleComponent->SetPhysMaterialOverride(PhysicsMaterial);
+
+	//< The wall query only looks for ledges when something can climb them. >
+	if (Abilities.LedgeClimb.Enabled)
+	{
+		CollisionComponent->LedgeProbeHeight = FMath::Max(CollisionComponent->LedgeProbeHeight, Abilities.LedgeClimb.MaxHeight);
+	}
+
+	//< Start the movement state from where the capsule was placed. >
+	if (UCapsuleComponent* cc = CollisionComponent->CapsuleComponent)
+	{
+		State.Location = cc->GetComponentLocation();
+		State.Yaw = cc->GetComponentRotation().Yaw;
+		State.CapsuleHalfHeight = cc->GetScaledCapsuleHalfHeight();
+
+		if (BodyMode != EHBBodyMode::Simulated)
+		{
+			//< The component moves the capsule itself, the body only has to collide. >
+			cc->SetSimulatePhysics(false);
+			SetUpdatedComponent(cc);
+
+			//< Sub steps now run in this tick, which has to come after the collision component's for the hitbox clock. >
+			AddTickPrerequisiteComponent(CollisionComponent);
+		}
+	}
+
+	if (BodyMode == EHBBodyMode::Lockstep)
+	{
+		LockstepWorld = &GetWorld()->GetSubsystem<UHBLockstepSubsystem>()->GetCollisionWorld();
+		LockstepSettings = FHBLockstepSettings::FromComponent(*this, CollisionComponent, LockstepStepTime);
+		LockstepState = FHBLockstepState::FromMovementState(State);
+	}
+	StepOutput.State = State;
+}
+
+void UHBMovementComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	StopRecording();
+	Super::EndPlay(EndPlayReason);
+}
+
+bool UHBMovementComponent::StartRecording(const FString& _Filename, int32 _KeyframeInterval)
+{
+	StopRecording();
+
+	TUniquePtr<FHBReplayWriter> recorder = MakeUnique<FHBReplayWriter>(HBReplay::ResolveFilename(_Filename), FHBQuantizationSettings(), _KeyframeInterval);
+	if (!recorder->IsOpen()) return false;
+
+	FScopeLock lock(&RecorderLock);
+	Recorder = MoveTemp(recorder);
+	return true;
+}
+
+void UHBMovementComponent::StopRecording()
+{
+	TUniquePtr<FHBReplayWriter> recorder;
+	{
+		FScopeLock lock(&RecorderLock);
+		recorder = MoveTemp(Recorder);
+	}
+
+	//< Closing waits for the writer thread, so do it outside the lock. >
+	if (recorder) recorder->Close();
 }
 
 void UHBMovementComponent::TickComponent(float _DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
 	Super::TickComponent(_DeltaTime, TickType, ThisTickFunction);
-	if (UCapsuleComponent* cc = CollisionComponent->CapsuleComponent) {
-		//UE_LOG(LogTemp, Display, TEXT("Current Speed %f"), cc->GetPhysicsLinearVelocity().Size());
-	}
-
-	//< Required to sign up for custom physics every frame. >
-	// It is only possible to add custom physics to a simulating primitive component.
-	// The reason for GetAttachSocketName(), is that we might be attached to a skeletal mesh socket,
-	// in which case we would get a different BodyInstance than if we were attached to the root socket.
-	if (UCapsuleComponent* cc = CollisionComponent->CapsuleComponent) {
-		if (cc->IsSimulatingPhysics(NAME_None)) {
-			if (FBodyInstance* bodyInstance = cc->GetBodyInstance(NAME_None)) {
-				bodyInstance->AddCustomPhysics(CalculateCustomPhysics);
+
+	//< Hand this frame's input to the next step, along with how many sub steps the engine will run for it. >
+	PendingStepInput.FrameNumber = GFrameCounter;
+	PendingStepInput.FrameSubsteps = GetFrameSubsteps(_DeltaTime);
+	PublishStepInput();
+
+	if (BodyMode == EHBBodyMode::Kinematic)
+	{
+		KinematicTick(_DeltaTime);
+	}
+	else if (BodyMode == EHBBodyMode::Lockstep)
+	{
+		LockstepTick(_DeltaTime);
+	}
+	else
+	{
+		//< Required to sign up for custom physics every frame. The sub steps run within this frame's physics tick. >
+		// It is only possible to add custom physics to a simulating primitive component.
+		// The reason for GetAttachSocketName(), is that we might be attached to a skeletal mesh socket,
+		// in which case we would get a different BodyInstance than if we were attached to the root socket.
+		if (UCapsuleComponent* cc = CollisionComponent->CapsuleComponent) {
+			if (cc->IsSimulatingPhysics(NAME_None)) {
+				if (FBodyInstance* bodyInstance = cc->GetBodyInstance(NAME_None)) {
+					bodyInstance->AddCustomPhysics(CalculateCustomPhysics);
+				}
 			}
 		}
 	}
 
+	//< Read back the latest step. >
+	if (StepOutputBuffer.IsDirty())
+	{
+		StepOutput = StepOutputBuffer.SwapAndRead();
+	}
+
 	if (GEngine)
 	{
-		GEngine->AddOnScreenDebugMessage(-1, _DeltaTime, FColor::Green, FString::Printf(TEXT("Horizontal Speed %f"), GetCurrentHorizontalSpeed()));
-		GEngine->AddOnScreenDebugMessage(-1, _DeltaTime, FColor::Yellow, FString::Printf(TEXT("Total Speed %f"), NewVelocity.Size()));
+		GEngine->AddOnScreenDebugMessage(-1, _DeltaTime, FColor::Green, FString::Printf(TEXT("Horizontal Speed %f"), GetCurrentHorizontalSpeed(StepOutput.State.Velocity)));
+		GEngine->AddOnScreenDebugMessage(-1, _DeltaTime, FColor::Yellow, FString::Printf(TEXT("Total Speed %f"), StepOutput.State.Velocity.Size()));
+	}
+
+	if (CVarShowStateBandwidth.GetValueOnGameThread() > 0)
+	{
+		MeasureStateBandwidth(_DeltaTime);
+	}
+}
+
+void UHBMovementComponent::MeasureStateBandwidth(float _DeltaTime)
+{
+	FHBQuantizedMovementState quantized = StateSerializer.Quantize(StepOutput.State);
+	const FHBQuantizedMovementState* baseline = (BandwidthBaseline.IsSet()) ? &BandwidthBaseline.GetValue() : nullptr;
+
+	FBitWriter writer(0, true);
+	StateSerializer.Write(writer, quantized, baseline);
+
+	//< Round trip check. >
+	FBitReader reader(writer.GetData(), writer.GetNumBits());
+	FHBQuantizedMovementState decoded;
+	if (!StateSerializer.Read(reader, decoded, baseline) || decoded != quantized)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Movement state failed to round trip through FHBMovementSerializer."));
+	}
+
+	float bytes = writer.GetNumBits() / 8.0f;
+	AverageStateBytes = (AverageStateBytes > 0) ? FMath::Lerp(AverageStateBytes, bytes, 0.05f) : bytes;
+	BandwidthBaseline = quantized;
+
+	if (GEngine)
+	{
+		float updatesPerSecond = (_DeltaTime > 0) ? 1.0f / _DeltaTime : 0;
+		GEngine->AddOnScreenDebugMessage(-1, _DeltaTime, FColor::Cyan, FString::Printf(TEXT("State Update %.1f bytes (avg %.1f, %.2f KB/s at frame rate)"), bytes, AverageStateBytes, AverageStateBytes * updatesPerSecond / 1024.0f));
 	}
 }
 
@@ -63,228 +277,1060 @@ void UHBMovementComponent::SubstepTick(float _DeltaTime, FBodyInstance* _BodyIns
 	if (!_BodyInstance || !CollisionComponent) return;
 	if (UCapsuleComponent* cc = CollisionComponent->CapsuleComponent)
 	{
-		//< Update local copy of the velocity. >
-		NewVelocity = _BodyInstance->GetUnrealWorldVelocity();
+		//< Pick up the latest input from the game thread. >
+		const FHBMovementStepInput& stepInput = StepInputBuffer.SwapAndRead();
+
+		//< The only read of the body this sub step. Everything below works from the snapshot. >
+		Body.Transform = _BodyInstance->GetUnrealWorldTransform();
 
-		//< Check for disable sprint. >
-		if (!SprintPressed & SprintActive)
+		//< Skipped sub steps leave the body coasting on its last velocity & only record the hitbox. >
+		float stepTime = 0;
+		if (!ShouldRunSubstep(stepInput, _DeltaTime, stepTime))
 		{
-			if (GetCurrentHorizontalSpeed() < (WalkSpeed + RunSpeed) / 2)
-				SprintActive = false;
+			//< The body's own gravity is off, so keep it falling where the rules would. >
+			if (UseGravity && !State.Grounded && !State.WallRunActive && !State.Ability.IsActive())
+			{
+				float fallSpeed = Gravity * Body.Mass * _DeltaTime;
+				_BodyInstance->SetLinearVelocity(FVector::DownVector * fallSpeed, true);
+				SkippedGravity += fallSpeed;
+			}
+			CollisionComponent->SkipSubstep(_DeltaTime, Body);
+			return;
 		}
 
+		Body.Velocity = _BodyInstance->GetUnrealWorldVelocity();
+		Body.Mass = _BodyInstance->GetMassOverride();
+
+		//< Update local copy of the body. >
+		State.Location = Body.Transform.GetTranslation();
+		State.Yaw = Body.Transform.Rotator().Yaw;
+		State.Velocity = Body.Velocity;
+
+		//< The rules apply gravity over the whole step time, skipped sub steps included, so take out what those already gave. >
+		State.Velocity.Z += SkippedGravity;
+		SkippedGravity = 0;
+
+		FHBMovementCostSample costSample(CostMap, State.Location);
+
 		//< Update IsGrounded & ground normal. >
-		CollisionComponent->SubstepTick(_DeltaTime, _BodyInstance);
+		if (ShouldCoast(stepInput, stepTime))	CollisionComponent->CoastSubstep(_DeltaTime, Body);
+		else									CollisionComponent->SubstepTick(_DeltaTime, Body);
+		costSample.QueriesDone();
 
-		//< Used for transitioning between height changes. >
-		TickCapsuleHeight(_DeltaTime, _BodyInstance);
+		FVector previousLocation = State.Location;
+		float previousHalfHeight = State.CapsuleHalfHeight;
+		float previousYaw = State.Yaw;
 
-		if (WallRunDelayTimer > 0) WallRunDelayTimer -= _DeltaTime;
+		AdvanceState(stepInput, stepTime);
 
-		//< Tick Wallrun. >
-		if (WallRunActive)
+		if (State.CapsuleHalfHeight != previousHalfHeight)
 		{
-			WallRun(_DeltaTime, _BodyInstance);
+			cc->SetCapsuleSize(PlayerRadius, State.CapsuleHalfHeight);
 		}
-		else
+
+		//< The rules' translation, the view yaw & the final velocity go back to the body together. >
+		CommitBody(_BodyInstance, State.Location != previousLocation || State.Yaw != previousYaw);
+
+		PublishStepOutput(stepTime);
+	}
+}
+
+bool UHBMovementComponent::ShouldCoast(const FHBMovementStepInput& _StepInput, float _StepTime)
+{
+	//< Ground, walls & abilities need the queries every step. >
+	bool flying = BallisticFlight && UseGravity && !State.Grounded && !State.WallRunActive && !State.Ability.IsActive();
+
+	//< Any press may start a jump, dash or grapple, crouching changes the capsule the flight was swept with. >
+	bool sameFlight = flying && State.CapsuleHalfHeight == BallisticHalfHeight
+		&& _StepInput.JumpPresses == BallisticInput.JumpPresses
+		&& _StepInput.CrouchPresses == BallisticInput.CrouchPresses && _StepInput.CrouchReleases == BallisticInput.CrouchReleases
+		&& _StepInput.SprintPresses == BallisticInput.SprintPresses && _StepInput.DashPresses == BallisticInput.DashPresses
+		&& _StepInput.GrapplePresses == BallisticInput.GrapplePresses && _StepInput.GrappleReleases == BallisticInput.GrappleReleases;
+
+	if (!sameFlight)
+	{
+		BallisticTimeLeft = 0;
+		BallisticRetryTime = 0;
+	}
+	if (!flying) return false;
+
+	BallisticRetryTime -= _StepTime;
+	if (BallisticTimeLeft < _StepTime && BallisticRetryTime <= 0)
+	{
+		SweepBallisticFlight(_StepInput);
+	}
+	if (BallisticTimeLeft < _StepTime) return false;
+
+	BallisticTimeLeft -= _StepTime;
+	INC_DWORD_STAT(STAT_HBMovementStepsCoasted);
+	return true;
+}
+
+void UHBMovementComponent::SweepBallisticFlight(const FHBMovementStepInput& _StepInput)
+{
+	BallisticInput = _StepInput;
+	BallisticHalfHeight = State.CapsuleHalfHeight;
+
+	const int32 segments = FMath::Clamp(BallisticSegments, 1, 8);
+	const float segmentTime = FMath::Max(BallisticHorizon, 0.05f) / segments;
+	const float gravity = Gravity * Body.Mass; //< As ApplyGravity. >
+	const float airControl = FMath::Max(AirAcceleration, AirDeceleration);
+
+	//< The arc without air control, which is the only thing that can pull the character off it. >
+	TArray<FVector, TInlineAllocator<9>> path;
+	TArray<float, TInlineAllocator<8>> inflations;
+	for (int32 i = 0; i <= segments; i++)
+	{
+		float time = segmentTime * i;
+		path.Add(State.Location + State.Velocity * time + FVector::DownVector * (gravity * time * time / 2));
+		if (i == 0) continue;
+
+		//< Furthest air control can have pulled away by the segment's end, plus the arc's sag below the chord & the drift of discrete steps. >
+		inflations.Add(airControl * time * time / 2 + gravity * segmentTime * segmentTime / 8 + gravity * MaxAdaptiveStepTime * time / 2);
+	}
+
+	BallisticTimeLeft = CollisionComponent->SweepPath(path, inflations) * segmentTime;
+	INC_DWORD_STAT(STAT_HBBallisticSweeps);
+
+	//< Something is in the way, run regular steps up to it & a while past before sweeping again. >
+	BallisticRetryTime = (BallisticTimeLeft < segmentTime * segments) ? BallisticTimeLeft + segmentTime : 0;
+}
+
+bool UHBMovementComponent::ShouldRunSubstep(const FHBMovementStepInput& _StepInput, float _DeltaTime, float& _OutStepTime)
+{
+	//< Plan the frame on its first sub step. >
+	if (_StepInput.FrameNumber != BudgetFrameNumber)
+	{
+		BudgetFrameNumber = _StepInput.FrameNumber;
+		BudgetSubstepIndex = 0;
+
+		int32 frameSubsteps = FMath::Max(_StepInput.FrameSubsteps, 1);
+		BudgetSteps = frameSubsteps;
+		if (AdaptiveSubsteps)
 		{
-			//< Update "ContactWithGround". >
-			if (CollisionComponent->ContactWithGround())
-			{
-				Grounded = true;
-				float floorAngle = FMath::RadiansToDegrees(FMath::Acos(FVector::DotProduct(CollisionComponent->GetGroundNormal(), FVector::UpVector)));
-				if (floorAngle > MaxSlopeAngle)
-				{
-					Grounded = false;
-				}
-			}
-			else
-			{
-				if (!CollisionComponent->IsNearGround())
-				{
-					Grounded = false;
-				}
-			}
+			float frameTime = _DeltaTime * frameSubsteps;
+			BudgetSteps = FMath::Clamp(FMath::CeilToInt(frameTime / GetAdaptiveStepTime(State, CollisionComponent->GetContact())), 1, frameSubsteps);
+		}
+		BudgetSteps = FMath::Min(BudgetSteps, FMath::Max(MaxMovementStepsPerFrame, 1));
+		INC_DWORD_STAT_BY(STAT_HBMovementStepsSaved, frameSubsteps - BudgetSteps);
+	}
 
-			if (Grounded)
-			{
-				if (AttemptJump)
-				{
-					Jump(_BodyInstance);
-				}
-				else
-				{
-					GroundMove(_DeltaTime, _BodyInstance);
+	//< Spread the budget evenly over the frame. The last planned sub step always runs. >
+	int32 index = BudgetSubstepIndex++;
+	int32 frameSubsteps = FMath::Max(_StepInput.FrameSubsteps, 1);
+	bool run = (index >= frameSubsteps - 1) || ((index + 1) * BudgetSteps / frameSubsteps) > (index * BudgetSteps / frameSubsteps);
 
-					if (!CollisionComponent->ContactWithGround())
-					{
-						StickToGround(_DeltaTime);
-					}
-				}
-			}
-			else
+	PendingStepTime += _DeltaTime;
+	if (!run) return false;
+
+	_OutStepTime = PendingStepTime;
+	PendingStepTime = 0;
+	INC_DWORD_STAT(STAT_HBMovementSteps);
+	return true;
+}
+
+float UHBMovementComponent::GetAdaptiveStepTime(const FHBMovementState& _State, const FHBMovementContact& _Contact) const
+{
+	//< Wall runs & moving between surfaces (landing, leaving a ledge, slopes, approaching walls) need every step. >
+	bool onSlope = _State.Grounded && FVector::DotProduct(_Contact.GroundNormal, FVector::UpVector) < 0.995f;
+	bool approachingGround = _Contact.IsNearGround() && !_Contact.ContactWithGround();
+	bool approachingWall = !_State.Grounded && _Contact.IsNearWall();
+
+	float minStepTime = GetMinAdaptiveStepTime();
+	if (_State.WallRunActive || onSlope || approachingGround || approachingWall)
+	{
+		return minStepTime;
+	}
+
+	//< Otherwise move at most AdaptiveStepDistance per step. >
+	float speed = _State.Velocity.Size();
+	float stepTime = (speed > KINDA_SMALL_NUMBER) ? AdaptiveStepDistance / speed : MaxAdaptiveStepTime;
+	return FMath::Clamp(stepTime, minStepTime, FMath::Max(MaxAdaptiveStepTime, minStepTime));
+}
+
+float UHBMovementComponent::GetMinAdaptiveStepTime() const
+{
+	float engineStepTime = UPhysicsSettings::Get()->MaxSubstepDeltaTime;
+	float minStepTime = (MinAdaptiveStepTime > 0) ? MinAdaptiveStepTime : engineStepTime;
+
+	//< Simulated mode runs on the physics sub steps, so can not step more often anyway. >
+	if (BodyMode == EHBBodyMode::Simulated) minStepTime = FMath::Max(minStepTime, engineStepTime);
+	return FMath::Max(minStepTime, KINDA_SMALL_NUMBER);
+}
+
+void UHBMovementComponent::KinematicTick(float _DeltaTime)
+{
+	if (!CollisionComponent || !CollisionComponent->CapsuleComponent || !UpdatedComponent) return;
+
+	//< Split the frame into equal steps no longer than MaxKinematicStepTime, or the adaptive step time if that is shorter. >
+	float maxStepTime = FMath::Max(MaxKinematicStepTime, KINDA_SMALL_NUMBER);
+	float targetStepTime = (AdaptiveSubsteps) ? FMath::Min(maxStepTime, GetAdaptiveStepTime(State, CollisionComponent->GetContact())) : maxStepTime;
+
+	int32 maxSteps = FMath::Max(FMath::Min(MaxKinematicSteps, MaxMovementStepsPerFrame), 1);
+	int32 steps = FMath::Clamp(FMath::CeilToInt(_DeltaTime / FMath::Max(targetStepTime, KINDA_SMALL_NUMBER)), 1, maxSteps);
+	float stepTime = _DeltaTime / steps;
+
+	int32 fullSteps = FMath::Clamp(FMath::CeilToInt(_DeltaTime / FMath::Min(maxStepTime, GetMinAdaptiveStepTime())), 1, maxSteps);
+	INC_DWORD_STAT_BY(STAT_HBMovementSteps, steps);
+	INC_DWORD_STAT_BY(STAT_HBMovementStepsSaved, fullSteps - steps);
+
+	//< Attached components (view mount, camera) follow once at the end instead of after every step. >
+	FScopedMovementUpdate scopedMovement(UpdatedComponent, EScopedUpdate::DeferredUpdates);
+
+	for (int32 i = 0; i < steps; i++)
+	{
+		KinematicStep(stepTime);
+	}
+}
+
+void UHBMovementComponent::KinematicStep(float _DeltaTime)
+{
+	const FHBMovementStepInput& stepInput = StepInputBuffer.SwapAndRead();
+	SweptStep(stepInput, _DeltaTime, false);
+	PublishStepOutput(_DeltaTime);
+}
+
+void UHBMovementComponent::SweptStep(const FHBMovementStepInput& _StepInput, float _DeltaTime, bool _Resimulating)
+{
+	UCapsuleComponent* cc = CollisionComponent->CapsuleComponent;
+
+	//< The capsule is the state, velocity lives only in State. >
+	Body.Transform = cc->GetComponentTransform();
+	Body.Velocity = State.Velocity;
+	Body.Mass = cc->BodyInstance.GetMassOverride();
+	State.Location = Body.Transform.GetTranslation();
+	State.Yaw = Body.Transform.Rotator().Yaw;
+
+	FHBMovementCostSample costSample((_Resimulating) ? nullptr : CostMap, State.Location);
+
+	//< Resimulated steps happened before the hitbox history's latest pose, so only query. They never coast, corrections must see the level. >
+	if (_Resimulating)								CollisionComponent->QueryContact(Body);
+	else if (ShouldCoast(_StepInput, _DeltaTime))	CollisionComponent->CoastSubstep(_DeltaTime, Body);
+	else											CollisionComponent->SubstepTick(_DeltaTime, Body);
+	costSample.QueriesDone();
+
+	FVector previousLocation = State.Location;
+	float previousHalfHeight = State.CapsuleHalfHeight;
+
+	AdvanceState(_StepInput, _DeltaTime, _Resimulating);
+
+	if (State.CapsuleHalfHeight != previousHalfHeight)
+	{
+		cc->SetCapsuleSize(PlayerRadius, State.CapsuleHalfHeight);
+	}
+
+	//< The rules' own translation (crouch keeping the feet planted, etc.) & the velocity are swept as one move. >
+	SlideMove((State.Location - previousLocation) + State.Velocity * _DeltaTime, _Resimulating);
+	State.Location = UpdatedComponent->GetComponentLocation();
+}
+
+void UHBMovementComponent::SlideMove(FVector _Delta, bool _Resimulating)
+{
+	//< The move, along the first surface hit, then along the crease if a second one is hit, as SlideAlongSurface & TwoWallAdjust do. >
+	const int32 maxMoves = 3;
+
+	FVector delta = _Delta;
+	FVector previousNormal = FVector::ZeroVector;
+	for (int32 move = 0; move < maxMoves && !delta.IsNearlyZero(); move++)
+	{
+		FHitResult hit;
+		MoveCapsule(delta, hit, _Resimulating);
+		if (!hit.IsValidBlockingHit()) return;
+
+		//< Lose the velocity going into the surface, as the simulated body would. >
+		float intoSurface = FVector::DotProduct(State.Velocity, hit.Normal);
+		if (intoSurface < 0) State.Velocity -= hit.Normal * intoSurface;
+
+		delta *= 1.0f - hit.Time;
+		if (previousNormal.IsZero())
+		{
+			delta = ComputeSlideVector(delta, 1.0f, hit.Normal, hit);
+		}
+		else
+		{
+			TwoWallAdjust(delta, hit, previousNormal);
+
+			//< Wedged between two surfaces facing each other, only movement along the crease is left. >
+			if (FVector::DotProduct(hit.Normal, previousNormal) <= 0)
 			{
-				if (ShouldStartWallRun(_BodyInstance))
-				{
-					StartWallRun(_BodyInstance);
-				}
-				else
-				{
-					//< LMAO things go down. >
-					ApplyGravity(_DeltaTime, _BodyInstance);
-					AirMove(_DeltaTime, _BodyInstance);
-				}
+				FVector crease = FVector::CrossProduct(hit.Normal, previousNormal).GetSafeNormal();
+				State.Velocity = crease * FVector::DotProduct(State.Velocity, crease);
 			}
 		}
+		previousNormal = hit.Normal;
+	}
+}
+
+void UHBMovementComponent::MoveCapsule(const FVector& _Delta, FHitResult& _OutHit, bool _Resimulating)
+{
+	FQuat rotation = State.GetRotation();
+	if (!_Resimulating)
+	{
+		SafeMoveUpdatedComponent(_Delta, rotation, true, _OutHit);
+		return;
+	}
+
+	//< Blocked by what the capsule itself blocks, as the real move is. >
+	UCapsuleComponent* cc = CollisionComponent->CapsuleComponent;
+	FCollisionQueryParams params(SCENE_QUERY_STAT(HBResimulateSweep), false, GetOwner());
+	FCollisionResponseParams response;
+	cc->InitSweepCollisionParams(params, response);
+
+	FVector start = cc->GetComponentLocation();
+	GetWorld()->SweepSingleByChannel(_OutHit, start, start + _Delta, rotation, cc->GetCollisionObjectType(), cc->GetCollisionShape(), params, response);
+
+	//< Pushed out of a start penetration & swept again once, as SafeMoveUpdatedComponent does. >
+	if (_OutHit.bStartPenetrating)
+	{
+		start += GetPenetrationAdjustment(_OutHit);
+		GetWorld()->SweepSingleByChannel(_OutHit, start, start + _Delta, rotation, cc->GetCollisionObjectType(), cc->GetCollisionShape(), params, response);
 	}
 
-	ApplyFinalVelocity(_BodyInstance);
+	//< Stop a little short of the surface, as MoveComponent does. >
+	float length = _Delta.Size();
+	float time = (_OutHit.bBlockingHit && length > KINDA_SMALL_NUMBER) ? FMath::Max(_OutHit.Time - 0.1f / length, 0.0f) : 1.0f;
+	if (_OutHit.bStartPenetrating) time = 0;
+
+	//< Teleports within the caller's deferred movement scope, so the overlaps update once for the final pose. >
+	cc->SetWorldLocationAndRotation(start + _Delta * time, rotation, false, nullptr, ETeleportType::TeleportPhysics);
 }
 
-void UHBMovementComponent::Input_Jump()
+void UHBMovementComponent::LockstepTick(float _DeltaTime)
 {
-	//< Ready jump & reset delay timer for perfect hopping. >
-	AttemptJump = true;
-	JumpDelayTimer = SlideHopWindow;
+	if (!LockstepWorld || !CollisionComponent || !CollisionComponent->CapsuleComponent || !UpdatedComponent) return;
+
+	//< Whole steps only, the rest of the frame carries over. Long frames run slow motion rather than spiral. >
+	float stepTime = LockstepSettings.DeltaTime.ToFloat();
+	LockstepTime += _DeltaTime;
+	int32 steps = FMath::Min(FMath::FloorToInt(LockstepTime / stepTime), FMath::Max(MaxMovementStepsPerFrame, 1));
+	LockstepTime = FMath::Min(LockstepTime - steps * stepTime, stepTime);
+	if (steps <= 0) return;
+
+	INC_DWORD_STAT_BY(STAT_HBMovementSteps, steps);
+
+	for (int32 i = 0; i < steps; i++)
+	{
+		LockstepStep(StepInputBuffer.SwapAndRead(), stepTime, false);
+	}
+	ShowLockstepState();
 }
 
-void UHBMovementComponent::Input_CrouchDown()
+void UHBMovementComponent::ShowLockstepState()
 {
-	CrouchPressed = true;
-	SprintActive = false;
+	//< The capsule only shows the result, the simulation never reads it back. >
+	UCapsuleComponent* cc = CollisionComponent->CapsuleComponent;
+	if (cc->GetUnscaledCapsuleHalfHeight() != State.CapsuleHalfHeight)
+	{
+		cc->SetCapsuleSize(PlayerRadius, State.CapsuleHalfHeight);
+	}
+	UpdatedComponent->SetWorldLocationAndRotation(State.Location, State.GetRotation(), false, nullptr, ETeleportType::TeleportPhysics);
+}
 
-	//< If crouch while grounded & meeting the speed threshold, perform a slide boost. >
-	if (IsSliding())
+void UHBMovementComponent::LockstepStep(const FHBMovementStepInput& _StepInput, float _DeltaTime, bool _Resimulating)
+{
+	//< Hitbox pose at the start of the step, as the other modes record it. A resimulated step is older than the history's latest. >
+	if (!_Resimulating)
 	{
-		PerformBoost = true;
+		Body.Transform = FTransform(State.GetRotation(), State.Location);
+		Body.Velocity = State.Velocity;
+		CollisionComponent->SkipSubstep(_DeltaTime, Body);
 	}
+
+	bool previousWallRunActive = LockstepState.WallRunActive;
+	FHBLockstepMovement::Step(LockstepState, FHBLockstepInput::FromStepInput(_StepInput, AppliedStepInput), *LockstepWorld, LockstepSettings);
+	LockstepState.ToMovementState(State);
+
+	//< Camera rotation is presentation, so it stays in floats next to the simulation. >
+	State.TargetRotationDelta -= _StepInput.ConsumedRotationDelta - AppliedStepInput.ConsumedRotationDelta;
+	State.TargetRotationDelta.Yaw += LockstepState.CameraYaw.ToFloat();
+	State.TargetRotationDelta.Roll += LockstepState.CameraRoll.ToFloat();
+	if (previousWallRunActive && !LockstepState.WallRunActive) State.TargetRotationDelta.Yaw = 0;
+	AppliedStepInput = _StepInput;
+
+	//< The replay already holds the original run of a resimulated step. >
+	if (_Resimulating) return;
+
+	{
+		FScopeLock lock(&RecorderLock);
+		if (Recorder) Recorder->RecordSubstep(_DeltaTime, _StepInput, State);
+	}
+	PublishStepOutput(_DeltaTime);
 }
 
-void UHBMovementComponent::Input_CrouchUp()
+void UHBMovementComponent::AdvanceState(const FHBMovementStepInput& _StepInput, float _DeltaTime, bool _Resimulating)
 {
-	//< If there is space above the player, stand up. >
-	CrouchPressed = false;
-	PerformBoost = false;
+	bool previousWallRunActive = State.WallRunActive;
+
+	ApplyStepInput(State, _StepInput, AppliedStepInput);
+	AppliedStepInput = _StepInput;
+
+	const FHBMovementInput& input = _StepInput.Input;
+	StepMovement(State, input, CollisionComponent->GetContact(), Body.Mass, _DeltaTime);
+
+	if (State.WallRunActive != previousWallRunActive)
+	{
+		UseGravity = !State.WallRunActive;
+		if (!_Resimulating) UE_LOG(LogTemp, Display, TEXT("%s"), (State.WallRunActive) ? TEXT("Started Wallrun") : TEXT("Wallrun over"));
+	}
+
+	//< The replay already holds the original run of a resimulated step. >
+	if (_Resimulating) return;
+
+	{
+		FScopeLock lock(&RecorderLock);
+		if (Recorder) Recorder->RecordSubstep(_DeltaTime, _StepInput, State);
+	}
 
-	if (SprintPressed) SprintActive = true;
+#if HB_WITH_MOVEMENT_DEBUG_DRAW
+	DrawStepDebug();
+#endif
 }
 
-void UHBMovementComponent::GroundMove(float _DeltaTime, FBodyInstance* _BodyInstance)
+#if HB_WITH_MOVEMENT_DEBUG_DRAW
+void UHBMovementComponent::DrawStepDebug()
 {
-	if (_BodyInstance)
+	FHBMovementDebugDraw& draw = CollisionComponent->GetDebugDraw();
+
+	if (State.WallRunActive && draw.IsEnabled(HBMovementDebugDraw::WallRun))
 	{
-		//< Calculate our target velocity. >
-		FVector direction = FVector(MovementInput.X, MovementInput.Y, 0);
+		FVector direction = GetWallRunDirection(CollisionComponent->GetContact(), State.WallRunSide).GetSafeNormal();
+		draw.Arrow(State.Location, State.Location + direction * 100, FColor::Orange);
+	}
 
-		FVector targetVel = UKismetMathLibrary::TransformDirection(_BodyInstance->GetUnrealWorldTransform(), direction);
-		targetVel.Normalize(0.0001f);
+	//< Facing in white, where the camera is still heading (yaw & roll) in magenta. >
+	if (draw.IsEnabled(HBMovementDebugDraw::Rotation))
+	{
+		FVector eyes = State.Location + FVector::UpVector * State.CapsuleHalfHeight;
+		FQuat target = FRotator(0, State.Yaw + State.TargetRotationDelta.Yaw, State.TargetRotationDelta.Roll).Quaternion();
+		draw.Arrow(eyes, eyes + State.GetRotation().GetForwardVector() * 75, FColor::White);
+		draw.Arrow(eyes, eyes + target.GetForwardVector() * 75, FColor::Magenta);
+		draw.Line(eyes, eyes + target.GetUpVector() * 30, FColor::Magenta);
+	}
+}
+#endif
 
-		FVector deltaVel;
+void UHBMovementComponent::PublishStepOutput(float _DeltaTime)
+{
+	//< The game thread picks this up on its next tick. >
+	FHBMovementStepOutput& output = StepOutputBuffer.GetWriteBuffer();
+	CountStep();
+	output.State = State;
+	output.ConsumedRotationDelta = AppliedStepInput.ConsumedRotationDelta;
+	output.StepCount = StepCount;
+	output.DeltaTime = _DeltaTime;
+	output.FrameNumber = AppliedStepInput.FrameNumber;
+	output.StateHash = StateHash;
+	StepOutputBuffer.SwapWriteBuffers();
+}
 
-		//< Check for slide boost. >
-		if (CanSlideBoost())
+void UHBMovementComponent::CountStep()
+{
+	StepCount++;
+	if (HashStates)
+	{
+		StateHash = StateSerializer.Quantize(State).Hash(StateHash);
+	}
+}
+
+void UHBMovementComponent::SyncStepOutput()
+{
+	if (StepOutputBuffer.IsDirty()) StepOutputBuffer.SwapAndRead();
+
+	StepOutput.State = State;
+	StepOutput.ConsumedRotationDelta = AppliedStepInput.ConsumedRotationDelta;
+	StepOutput.StepCount = StepCount;
+	StepOutput.DeltaTime = 0;
+	StepOutput.FrameNumber = AppliedStepInput.FrameNumber;
+	StepOutput.StateHash = StateHash;
+}
+
+void UHBMovementComponent::StepMovement(FHBMovementState& _State, const FHBMovementInput& _Input, const FHBMovementContact& _Contact, float _BodyMass, float _DeltaTime) const
+{
+	//< Check for disable sprint. >
+	if (!_Input.SprintPressed & _State.SprintActive)
+	{
+		if (GetCurrentHorizontalSpeed(_State.Velocity) < (WalkSpeed + RunSpeed) / 2)
+			_State.SprintActive = false;
+	}
+
+	//< Used for transitioning between height changes. >
+	TickCapsuleHeight(_State, _Input, _DeltaTime);
+
+	if (_State.WallRunDelayTimer > 0) _State.WallRunDelayTimer -= _DeltaTime;
+
+	//< An active ability owns the whole step. >
+	FHBAbilityContext abilityContext { _State, _Input, _Contact, Abilities, _DeltaTime };
+	if (FHBMovementAbilities::Step(abilityContext)) return;
+
+	//< Tick Wallrun. >
+	if (_State.WallRunActive)
+	{
+		WallRun(_State, _Contact, _DeltaTime);
+		return;
+	}
+
+	//< Update "ContactWithGround". >
+	if (_Contact.ContactWithGround())
+	{
+		_State.Grounded = true;
+		float floorAngle = FMath::RadiansToDegrees(FMath::Acos(FVector::DotProduct(_Contact.GroundNormal, FVector::UpVector)));
+		if (floorAngle > MaxSlopeAngle)
+		{
+			_State.Grounded = false;
+		}
+	}
+	else
+	{
+		if (!_Contact.IsNearGround())
 		{
-			targetVel *= SlideForce;
-			PerformBoost = false;
+			_State.Grounded = false;
+		}
+	}
 
-			deltaVel = (targetVel - NewVelocity);
-			deltaVel.Z = 0;
+	if (_State.Grounded)
+	{
+		if (_State.AttemptJump)
+		{
+			Jump(_State, _Contact);
 		}
 		else
 		{
-			//< When sliding ignore directional input. >
-			if (IsSliding())
-			{
-				targetVel = FVector::ZeroVector;
-			}
-			else
+			GroundMove(_State, _Input, _Contact, _DeltaTime);
+
+			if (!_Contact.ContactWithGround())
 			{
-				targetVel *= GetTargetSpeed(direction);
+				StickToGround(_State, _Contact, _DeltaTime);
 			}
+		}
+	}
+	else
+	{
+		if (ShouldStartWallRun(_State, _Input, _Contact))
+		{
+			StartWallRun(_State, _Contact);
+		}
+		else
+		{
+			//< LMAO things go down. >
+			ApplyGravity(_State, _BodyMass, _DeltaTime);
+			AirMove(_State, _Input, _DeltaTime);
+		}
+	}
+}
+
+FHBMovementInput UHBMovementComponent::GetMovementInput() const
+{
+	FHBMovementInput input;
+	input.MovementInput = MovementInput;
+	input.SprintPressed = SprintPressed;
+	input.CrouchPressed = CrouchPressed;
+	return input;
+}
+
+FHBPredictionRequest UHBMovementComponent::MakePredictionRequest(const FHBMovementState& _State, const FHBMovementInput& _Input, float _Horizon) const
+{
+	FHBPredictionRequest request;
+	request.MovementComponent = this;
+	request.State = _State;
+	request.Input = _Input;
+	request.Horizon = _Horizon;
+	request.BodyMass = Body.Mass;
+	if (CollisionComponent) request.Contact = CollisionComponent->GetContact();
+	return request;
+}
+
+void UHBMovementComponent::PredictTrajectory(const FHBMovementState& _State, const FHBMovementInput& _Input, float _Horizon, FHBPredictedTrajectory& _OutTrajectory, const FHBPredictionSettings& _Settings) const
+{
+	PredictTrajectory(MakePredictionRequest(_State, _Input, _Horizon), _OutTrajectory, _Settings);
+}
+
+void UHBMovementComponent::PredictTrajectory(const FHBPredictionRequest& _Request, FHBPredictedTrajectory& _OutTrajectory, const FHBPredictionSettings& _Settings) const
+{
+	float deltaTime = (_Settings.SubstepDeltaTime > 0) ? _Settings.SubstepDeltaTime : UPhysicsSettings::Get()->MaxSubstepDeltaTime;
+	int32 outputInterval = FMath::Max(_Settings.OutputInterval, 1);
+	int32 stepCount = (deltaTime > 0) ? FMath::CeilToInt(_Request.Horizon / deltaTime) : 0;
+
+	_OutTrajectory.Positions.Reset(stepCount / outputInterval);
+	_OutTrajectory.SampleInterval = deltaTime * outputInterval;
+	_OutTrajectory.FinalState = _Request.State;
+
+	if (!CollisionComponent) return;
 
-			//< Calculate if we're Accelerating or Decelerating >
-			float AccelValue = (FVector::DotProduct(targetVel, NewVelocity) > 0) ? GroundAcceleration : GetDeceleration();
+	FHBMovementState& state = _OutTrajectory.FinalState;
+	FHBMovementContact contact = _Request.Contact.ExtrapolatedTo(state.Location, state.CapsuleHalfHeight);
 
-			deltaVel = (targetVel - NewVelocity);
-			deltaVel = deltaVel.GetClampedToSize(-AccelValue * _DeltaTime, AccelValue * _DeltaTime);
-			deltaVel.Z = 0;
+	for (int32 step = 1; step <= stepCount; step++)
+	{
+		//< Optionally refresh the ground plane from the scene. >
+		if (_Settings.GroundProbeInterval > 0 && (step % _Settings.GroundProbeInterval) == 0)
+		{
+			CollisionComponent->ProbeGround(state.Location, state.CapsuleHalfHeight, contact);
 		}
 
-		//< Adjust target velocity via ground normal. >
-		deltaVel = FVector::VectorPlaneProject(deltaVel, CollisionComponent->GetGroundNormal());
+		StepMovement(state, _Request.Input, contact, _Request.BodyMass, deltaTime);
+		IntegratePrediction(state, contact, deltaTime);
 
-		NewVelocity += deltaVel;
+		if ((step % outputInterval) == 0)
+		{
+			_OutTrajectory.Positions.Add(state.Location);
+		}
 	}
 }
 
-void UHBMovementComponent::AirMove(float _DeltaTime, FBodyInstance* _BodyInstance)
+void UHBMovementComponent::PredictTrajectories(TArrayView<const FHBPredictionRequest> _Requests, TArray<FHBPredictedTrajectory>& _OutTrajectories, const FHBPredictionSettings& _Settings)
 {
-	if (AttemptJump)
+	_OutTrajectories.SetNum(_Requests.Num());
+
+	ParallelFor(_Requests.Num(), [&_Requests, &_OutTrajectories, &_Settings](int32 _Index)
 	{
-		//< Tick down jump delay timer. >
-		if (JumpDelayTimer > 0) JumpDelayTimer -= _DeltaTime;
+		const FHBPredictionRequest& request = _Requests[_Index];
+		if (request.MovementComponent)
+		{
+			request.MovementComponent->PredictTrajectory(request, _OutTrajectories[_Index], _Settings);
+		}
+		else
+		{
+			_OutTrajectories[_Index] = FHBPredictedTrajectory();
+		}
+	});
+}
+
+void UHBMovementComponent::SimulateStep(FHBMovementState& _State, const FHBMovementStepInput& _StepInput, const FHBMovementStepInput& _PreviousInput, FHBMovementContact& _Contact, float _DeltaTime) const
+{
+	ApplyStepInput(_State, _StepInput, _PreviousInput);
+	StepMovement(_State, _StepInput.Input, _Contact, Body.Mass, _DeltaTime);
+	IntegratePrediction(_State, _Contact, _DeltaTime);
+}
+
+void UHBMovementComponent::InitBodyFromSettings()
+{
+	if (CollisionComponent && CollisionComponent->CapsuleComponent)
+	{
+		Body.Mass = CollisionComponent->CapsuleComponent->BodyInstance.GetMassOverride();
+	}
+}
+
+void UHBMovementComponent::ResetForRespawn(const FTransform& _Transform)
+{
+	State = FHBMovementState();
+	State.Location = _Transform.GetLocation();
+	State.Yaw = _Transform.Rotator().Yaw;
+	State.CapsuleHalfHeight = PlayerHeight / 2;
+	LockstepState = FHBLockstepState::FromMovementState(State);
+	LockstepTime = 0;
+
+	//< Let go of held input. Press counters keep counting, the applied input catches up so no press from the last life fires. >
+	MovementInput = FVector2D::ZeroVector;
+	SprintPressed = false;
+	CrouchPressed = false;
+	PendingStepInput.Input = FHBMovementInput();
+	AppliedStepInput = PendingStepInput;
+	PublishStepInput();
+
+	StepCount = 0;
+	StateHash = 0;
+	BudgetFrameNumber = 0;
+	PendingStepTime = 0;
+	SkippedGravity = 0;
+	BallisticTimeLeft = 0;
+	BallisticRetryTime = 0;
+	BandwidthBaseline.Reset();
+
+	//< Drop any output of the last life still waiting to be read. >
+	SyncStepOutput();
+
+	if (UCapsuleComponent* cc = CollisionComponent->CapsuleComponent)
+	{
+		cc->SetCapsuleSize(PlayerRadius, State.CapsuleHalfHeight);
+		cc->SetWorldLocationAndRotation(State.Location, State.GetRotation(), false, nullptr, ETeleportType::TeleportPhysics);
+
+		if (BodyMode == EHBBodyMode::Simulated)
+		{
+			cc->SetSimulatePhysics(true);
+			cc->SetPhysicsLinearVelocity(FVector::ZeroVector);
+			cc->SetPhysicsAngularVelocityInDegrees(FVector::ZeroVector);
+		}
+	}
+	CollisionComponent->ResetForRespawn();
+}
+
+void UHBMovementComponent::SaveState(FHBMovementSnapshot& _OutSnapshot) const
+{
+	_OutSnapshot.State = State;
+	_OutSnapshot.AppliedStepInput = AppliedStepInput;
+	_OutSnapshot.Contact = CollisionComponent->GetContact();
+	_OutSnapshot.SubstepClock = CollisionComponent->GetSubstepClock();
+
+	//< Kinematic bodies keep their velocity in State. >
+	UCapsuleComponent* cc = CollisionComponent->CapsuleComponent;
+	bool simulating = cc->IsSimulatingPhysics();
+	_OutSnapshot.BodyLocation = cc->GetComponentLocation();
+	_OutSnapshot.BodyRotation = cc->GetComponentQuat();
+	_OutSnapshot.BodyVelocity = (simulating) ? cc->GetPhysicsLinearVelocity() : State.Velocity;
+	_OutSnapshot.BodyAngularVelocity = (simulating) ? cc->GetPhysicsAngularVelocityInDegrees() : FVector::ZeroVector;
+	_OutSnapshot.BodyMass = Body.Mass;
+
+	_OutSnapshot.PendingStepTime = PendingStepTime;
+	_OutSnapshot.SkippedGravity = SkippedGravity;
+	_OutSnapshot.BudgetFrameNumber = BudgetFrameNumber;
+	_OutSnapshot.BudgetSubstepIndex = BudgetSubstepIndex;
+	_OutSnapshot.BudgetSteps = BudgetSteps;
+	_OutSnapshot.StepCount = StepCount;
+	_OutSnapshot.StateHash = StateHash;
+	_OutSnapshot.UseGravity = UseGravity;
+	_OutSnapshot.LockstepState = LockstepState;
+	_OutSnapshot.LockstepTime = LockstepTime;
+}
+
+void UHBMovementComponent::RestoreState(const FHBMovementSnapshot& _Snapshot)
+{
+	State = _Snapshot.State;
+	AppliedStepInput = _Snapshot.AppliedStepInput;
+	CollisionComponent->RestoreQueries(_Snapshot.Contact, _Snapshot.SubstepClock);
+	Body.Mass = _Snapshot.BodyMass;
+
+	PendingStepTime = _Snapshot.PendingStepTime;
+	SkippedGravity = _Snapshot.SkippedGravity;
+	BudgetFrameNumber = _Snapshot.BudgetFrameNumber;
+	BudgetSubstepIndex = _Snapshot.BudgetSubstepIndex;
+	BudgetSteps = _Snapshot.BudgetSteps;
+	StepCount = _Snapshot.StepCount;
+	StateHash = _Snapshot.StateHash;
+	UseGravity = _Snapshot.UseGravity;
+	LockstepState = _Snapshot.LockstepState;
+	LockstepTime = _Snapshot.LockstepTime;
+
+	//< The flight was swept from another state. >
+	BallisticTimeLeft = 0;
+	BallisticRetryTime = 0;
+
+	UCapsuleComponent* cc = CollisionComponent->CapsuleComponent;
+	if (cc->GetUnscaledCapsuleHalfHeight() != State.CapsuleHalfHeight)
+	{
+		cc->SetCapsuleSize(PlayerRadius, State.CapsuleHalfHeight);
+	}
+	cc->SetWorldLocationAndRotation(_Snapshot.BodyLocation, _Snapshot.BodyRotation, false, nullptr, ETeleportType::TeleportPhysics);
+
+	if (cc->IsSimulatingPhysics())
+	{
+		cc->SetPhysicsLinearVelocity(_Snapshot.BodyVelocity);
+		cc->SetPhysicsAngularVelocityInDegrees(_Snapshot.BodyAngularVelocity);
+	}
+
+	SyncStepOutput();
+}
+
+void UHBMovementComponent::Resimulate(TArrayView<const FHBMovementStepInput> _Inputs, float _DeltaTime)
+{
+	if (!CollisionComponent || !CollisionComponent->CapsuleComponent || !UpdatedComponent || _Inputs.Num() == 0) return;
+
+	//< Lockstep steps never read the scene, so replaying its fixed steps is exact & the capsule only moves once at the end. >
+	if (BodyMode == EHBBodyMode::Lockstep)
+	{
+		if (!LockstepWorld) return;
+
+		for (const FHBMovementStepInput& stepInput : _Inputs)
+		{
+			LockstepStep(stepInput, LockstepSettings.DeltaTime.ToFloat(), true);
+			CountStep();
+		}
+		ShowLockstepState();
+		SyncStepOutput();
+		return;
+	}
 
-		if (JumpDelayTimer <= 0)
+	{
+		//< As in KinematicTick, attached components follow once at the end. >
+		FScopedMovementUpdate scopedMovement(UpdatedComponent, EScopedUpdate::DeferredUpdates);
+
+		for (const FHBMovementStepInput& stepInput : _Inputs)
 		{
-			AttemptJump = false;
+			SweptStep(stepInput, _DeltaTime, true);
+			CountStep();
 		}
 	}
 
-	if (_BodyInstance)
+	//< A simulating body carries on from the resimulated velocity. >
+	UCapsuleComponent* cc = CollisionComponent->CapsuleComponent;
+	if (cc->IsSimulatingPhysics())
 	{
-		//< Calculate our target velocity. >
-		FVector direction = FVector(MovementInput.X, MovementInput.Y, 0);
+		cc->SetPhysicsLinearVelocity(State.Velocity);
+	}
 
-		FVector targetVel = UKismetMathLibrary::TransformDirection(_BodyInstance->GetUnrealWorldTransform(), direction);
-		targetVel.Normalize(0.0001f);
+	SyncStepOutput();
+}
 
-		//< Calculate if we're Accelerating or Decelerating >
-		bool Accelerating = (FVector::DotProduct(targetVel, NewVelocity) > 0);
-		float AccelValue = (Accelerating) ? AirAcceleration : AirDeceleration;
+void UHBMovementComponent::IntegratePrediction(FHBMovementState& _State, FHBMovementContact& _Contact, float _DeltaTime) const
+{
+	_State.Location += _State.Velocity * _DeltaTime;
+	_Contact = _Contact.ExtrapolatedTo(_State.Location, _State.CapsuleHalfHeight);
+
+	//< Resolve against the ground plane, the body would be stopped by the solver here. >
+	if (_Contact.HasGround() && _Contact.GroundDistance < 0)
+	{
+		_State.Location.Z -= _Contact.GroundDistance;
+
+		float intoGround = FVector::DotProduct(_State.Velocity, _Contact.GroundNormal);
+		if (intoGround < 0) _State.Velocity -= _Contact.GroundNormal * intoGround;
+	}
 
-		//< While accelerating, try to maintain current speed if it's higher than our air speed. >
-		TArray<float> AirSpeedValues = { AirSpeed, GetCurrentHorizontalSpeed() };
-		targetVel *= (Accelerating) ? FMath::Max(AirSpeedValues) : AirSpeed;
+	//< Resolve against the wall plane. >
+	if (_Contact.HasWall() && _Contact.WallDistance < 0)
+	{
+		FVector flatNormal = FVector(_Contact.WallNormal.X, _Contact.WallNormal.Y, 0).GetSafeNormal();
+		_State.Location -= flatNormal * _Contact.WallDistance;
+
+		float intoWall = FVector::DotProduct(_State.Velocity, flatNormal);
+		if (intoWall < 0) _State.Velocity -= flatNormal * intoWall;
+	}
+
+	_Contact = _Contact.ExtrapolatedTo(_State.Location, _State.CapsuleHalfHeight);
+}
+
+void UHBMovementComponent::Input_Jump()
+{
+	PendingStepInput.JumpPresses++;
+	PublishStepInput();
+}
+
+void UHBMovementComponent::Input_CrouchDown()
+{
+	CrouchPressed = true;
+	PendingStepInput.CrouchPresses++;
+	PublishStepInput();
+}
+
+void UHBMovementComponent::Input_CrouchUp()
+{
+	CrouchPressed = false;
+	PendingStepInput.CrouchReleases++;
+	PublishStepInput();
+}
+
+void UHBMovementComponent::Input_SprintDown()
+{
+	SprintPressed = true;
+	PendingStepInput.SprintPresses++;
+	PublishStepInput();
+}
+
+void UHBMovementComponent::Input_SprintUp()
+{
+	SprintPressed = false;
+	PublishStepInput();
+}
+
+void UHBMovementComponent::Input_Dash()
+{
+	PendingStepInput.DashPresses++;
+	PublishStepInput();
+}
+
+void UHBMovementComponent::Input_Grapple(FVector _Target)
+{
+	PendingStepInput.GrapplePresses++;
+	PendingStepInput.GrappleTarget = _Target;
+	PublishStepInput();
+}
 
-		FVector deltaVel = (targetVel - NewVelocity);
+void UHBMovementComponent::Input_GrappleRelease()
+{
+	PendingStepInput.GrappleReleases++;
+	PublishStepInput();
+}
+
+void UHBMovementComponent::AddYawInput(float _Degrees)
+{
+	PendingStepInput.YawInput += _Degrees;
+	PublishStepInput();
+}
+
+void UHBMovementComponent::PublishStepInput()
+{
+	PendingStepInput.Input = GetMovementInput();
+	StepInputBuffer.Write(PendingStepInput);
+}
+
+void UHBMovementComponent::ApplyStepInput(FHBMovementState& _State, const FHBMovementStepInput& _StepInput, const FHBMovementStepInput& _PreviousInput) const
+{
+	//< Ready jump & reset delay timer for perfect hopping. >
+	if (_StepInput.JumpPresses != _PreviousInput.JumpPresses)
+	{
+		_State.AttemptJump = true;
+		_State.JumpDelayTimer = SlideHopWindow;
+	}
+
+	if (_StepInput.SprintPresses != _PreviousInput.SprintPresses)
+	{
+		_State.SprintActive = true;
+	}
+
+	if (_StepInput.CrouchPresses != _PreviousInput.CrouchPresses)
+	{
+		_State.SprintActive = false;
+
+		//< If crouch while grounded & meeting the speed threshold, perform a slide boost. >
+		// Crouch may already have been released again by the time this step runs, the press still counts.
+		FHBMovementInput crouchInput = _StepInput.Input;
+		crouchInput.CrouchPressed = true;
+		if (IsSliding(_State, crouchInput))
+		{
+			_State.PerformBoost = true;
+		}
+	}
+
+	if (_StepInput.CrouchReleases != _PreviousInput.CrouchReleases)
+	{
+		//< If there is space above the player, stand up. >
+		_State.PerformBoost = false;
+		if (_StepInput.Input.SprintPressed) _State.SprintActive = true;
+	}
+
+	//< Ability presses, picked up by FHBMovementAbilities this step. >
+	if (_StepInput.DashPresses != _PreviousInput.DashPresses)
+	{
+		_State.Ability.Requests |= HBAbility::Request_Dash;
+	}
+
+	if (_StepInput.GrapplePresses != _PreviousInput.GrapplePresses)
+	{
+		_State.Ability.Requests |= HBAbility::Request_Grapple;
+		_State.Ability.RequestedTarget = _StepInput.GrappleTarget;
+	}
+
+	if (_StepInput.GrappleReleases != _PreviousInput.GrappleReleases)
+	{
+		_State.Ability.Requests |= HBAbility::Request_GrappleRelease;
+	}
+
+	//< Turn by the view yaw since the last step. The body is rotated to match once the step is done. >
+	_State.Yaw = FRotator::NormalizeAxis(_State.Yaw + (float)(_StepInput.YawInput - _PreviousInput.YawInput));
+
+	//< Take out the camera rotation the game thread has used since the last step. >
+	_State.TargetRotationDelta -= _StepInput.ConsumedRotationDelta - _PreviousInput.ConsumedRotationDelta;
+}
+
+FRotator UHBMovementComponent::GetTargetRotationDelta() const
+{
+	//< Anything consumed since the last published step has not been taken out of its state yet. >
+	return StepOutput.State.TargetRotationDelta - (PendingStepInput.ConsumedRotationDelta - StepOutput.ConsumedRotationDelta);
+}
+
+void UHBMovementComponent::SetTargetRotationDelta(FRotator _NewDelta)
+{
+	PendingStepInput.ConsumedRotationDelta += GetTargetRotationDelta() - _NewDelta;
+	PublishStepInput();
+}
+
+void UHBMovementComponent::GroundMove(FHBMovementState& _State, const FHBMovementInput& _Input, const FHBMovementContact& _Contact, float _DeltaTime) const
+{
+	//< Calculate our target velocity. >
+	FVector direction = FVector(_Input.MovementInput.X, _Input.MovementInput.Y, 0);
+
+	FVector targetVel = _State.GetRotation().RotateVector(direction);
+	targetVel.Normalize(0.0001f);
+
+	FVector deltaVel;
+	const FHBSurfaceProfile& surface = GetSurfaceProfile(_Contact.GroundMaterial);
+
+	//< Check for slide boost. >
+	if (CanSlideBoost(_State, _Input))
+	{
+		targetVel *= SlideForce;
+		_State.PerformBoost = false;
+
+		deltaVel = (targetVel - _State.Velocity);
+		deltaVel.Z = 0;
+	}
+	else
+	{
+		//< When sliding ignore directional input. >
+		if (IsSliding(_State, _Input))
+		{
+			targetVel = FVector::ZeroVector;
+		}
+		else
+		{
+			targetVel *= GetTargetSpeed(_State, _Input, direction, surface);
+		}
+
+		//< Calculate if we're Accelerating or Decelerating >
+		float AccelValue = (FVector::DotProduct(targetVel, _State.Velocity) > 0) ? GroundAcceleration : GetDeceleration(_State, _Input, surface);
+
+		deltaVel = (targetVel - _State.Velocity);
 		deltaVel = deltaVel.GetClampedToSize(-AccelValue * _DeltaTime, AccelValue * _DeltaTime);
 		deltaVel.Z = 0;
+	}
 
-		NewVelocity += deltaVel;
+	//< Adjust target velocity via ground normal. >
+	deltaVel = FVector::VectorPlaneProject(deltaVel, _Contact.GroundNormal);
+
+	_State.Velocity += deltaVel;
+}
+
+void UHBMovementComponent::AirMove(FHBMovementState& _State, const FHBMovementInput& _Input, float _DeltaTime) const
+{
+	if (_State.AttemptJump)
+	{
+		//< Tick down jump delay timer. >
+		if (_State.JumpDelayTimer > 0) _State.JumpDelayTimer -= _DeltaTime;
+
+		if (_State.JumpDelayTimer <= 0)
+		{
+			_State.AttemptJump = false;
+		}
 	}
+
+	//< Calculate our target velocity. >
+	FVector direction = FVector(_Input.MovementInput.X, _Input.MovementInput.Y, 0);
+
+	FVector targetVel = _State.GetRotation().RotateVector(direction);
+	targetVel.Normalize(0.0001f);
+
+	//< Calculate if we're Accelerating or Decelerating >
+	bool Accelerating = (FVector::DotProduct(targetVel, _State.Velocity) > 0);
+	float AccelValue = (Accelerating) ? AirAcceleration : AirDeceleration;
+
+	//< While accelerating, try to maintain current speed if it's higher than our air speed. >
+	targetVel *= (Accelerating) ? FMath::Max(AirSpeed, GetCurrentHorizontalSpeed(_State.Velocity)) : AirSpeed;
+
+	FVector deltaVel = (targetVel - _State.Velocity);
+	deltaVel = deltaVel.GetClampedToSize(-AccelValue * _DeltaTime, AccelValue * _DeltaTime);
+	deltaVel.Z = 0;
+
+	_State.Velocity += deltaVel;
 }
 
-void UHBMovementComponent::WallRun(float _DeltaTime, FBodyInstance* _BodyInstance)
+void UHBMovementComponent::WallRun(FHBMovementState& _State, const FHBMovementContact& _Contact, float _DeltaTime) const
 {
 	//< Check for drop off. >
 	float wallrunCurveTimeMin, wallrunCurveTimeMax;
 	WallrunFalloffCurve->GetTimeRange(wallrunCurveTimeMin, wallrunCurveTimeMax);
-	if (WallrunFalloffTimeline > wallrunCurveTimeMax)
+	if (_State.WallrunFalloffTimeline > wallrunCurveTimeMax)
 	{
-		UE_LOG(LogTemp, Display, TEXT("Wallrun over"));
-		StopWallRun(_BodyInstance, CollisionComponent->GetWallNormal() * 35.0f, false);
-		WallRunDelayTimer = WallRunDelay * 3;
+		StopWallRun(_State, _Contact.WallNormal * 35.0f, false);
+		_State.WallRunDelayTimer = WallRunDelay * 3;
 		return;
 	}
 
 
 	//< Check for wall jump. >
-	if (AttemptJump)
+	if (_State.AttemptJump)
 	{
 		//< Setup exit velocity. >
-		FVector exitVelocity = CollisionComponent->CapsuleComponent->GetForwardVector();
+		FVector exitVelocity = _State.GetRotation().GetForwardVector();
 		exitVelocity *= WallJumpForce;
 		exitVelocity.Z += WallJumpForce / 2;
 
-		StopWallRun(_BodyInstance, exitVelocity, true);
+		StopWallRun(_State, exitVelocity, true);
 		return;
 	}
 
 
 	//< Calculate rotation. >
-	FVector oldWallNormalRight = UKismetMathLibrary::RotateAngleAxis(PreviousWallNormal, 90.0f, FVector::UpVector);
+	FVector oldWallNormalRight = UKismetMathLibrary::RotateAngleAxis(_State.PreviousWallNormal, 90.0f, FVector::UpVector);
 
-	float wallAngleDelta = AngleBetweenTwoVectors(PreviousWallNormal, CollisionComponent->GetWallNormal());
+	float wallAngleDelta = AngleBetweenTwoVectors(_State.PreviousWallNormal, _Contact.WallNormal);
 	bool RedirectVelocity = false;
 	if (FMath::Abs(wallAngleDelta) < 0.03f) wallAngleDelta = 0; //< Round down to account for small precision error in the formula. >
 
@@ -294,21 +1340,19 @@ void UHBMovementComponent::WallRun(float _DeltaTime, FBodyInstance* _BodyInstanc
 		//< Exit wallrun if hit a normal too different than our current surface. >
 		if (wallAngleDelta > 45.0f)
 		{
-			StopWallRun(_BodyInstance, FVector::ZeroVector, false);
+			StopWallRun(_State, FVector::ZeroVector, false);
 			return;
 		}
 
-		wallAngleDelta *= (FVector::DotProduct(CollisionComponent->GetWallNormal(), oldWallNormalRight) < 0) ? -1 : 1;
+		wallAngleDelta *= (FVector::DotProduct(_Contact.WallNormal, oldWallNormalRight) < 0) ? -1 : 1;
 		RedirectVelocity = true;
 	}
 
 	//< Set our target rotation change. >
-	TargetRotationDelta.Yaw += wallAngleDelta;
+	_State.TargetRotationDelta.Yaw += wallAngleDelta;
 
 	//< Accelerate along wall. >
-	FVector wallrunDirection = CollisionComponent->GetWallNormal();
-	wallrunDirection.Z = 0;
-	wallrunDirection = wallrunDirection.RotateAngleAxis((WallRunSide) ? 90 : -90, FVector::UpVector);
+	FVector wallrunDirection = GetWallRunDirection(_Contact, _State.WallRunSide);
 
 
 	FVector targetVelocity;
@@ -316,43 +1360,43 @@ void UHBMovementComponent::WallRun(float _DeltaTime, FBodyInstance* _BodyInstanc
 
 	if (RedirectVelocity)
 	{
-		targetVelocity = wallrunDirection.GetSafeNormal() * GetCurrentHorizontalSpeed();
-		deltaVel = (targetVelocity - NewVelocity);
+		targetVelocity = wallrunDirection.GetSafeNormal() * GetCurrentHorizontalSpeed(_State.Velocity);
+		deltaVel = (targetVelocity - _State.Velocity);
 	}
 	else
 	{
 		targetVelocity = wallrunDirection.GetSafeNormal() * WallRunSpeed;
-		deltaVel = (targetVelocity - NewVelocity);
+		deltaVel = (targetVelocity - _State.Velocity);
 
 		deltaVel = deltaVel.GetClampedToSize(-WallRunAcceleration * _DeltaTime, WallRunAcceleration * _DeltaTime);
 	}
 
-	NewVelocity += deltaVel;
+	_State.Velocity += deltaVel;
 
-	StickToWall(_DeltaTime);
+	StickToWall(_State, _Contact, _DeltaTime);
 
 	//< Tick wall run time line. >
-	WallrunFalloffTimeline += _DeltaTime;
-	PreviousWallNormal = CollisionComponent->GetWallNormal();
+	_State.WallrunFalloffTimeline += _DeltaTime;
+	_State.PreviousWallNormal = _Contact.WallNormal;
 }
 
-void UHBMovementComponent::Jump(FBodyInstance* _BodyInstance)
+void UHBMovementComponent::Jump(FHBMovementState& _State, const FHBMovementContact& _Contact) const
 {
 	//< Move outside range of IsGrounded check to prevent "landing" on the next frame. >
-	float PreJumpDistance = CollisionComponent->GroundContactDistance;
-	if (CollisionComponent->GetDistanceToGround() < 0) PreJumpDistance += FMath::Abs(CollisionComponent->GetDistanceToGround()); //Account for the curvature of our capsule bottom. 
+	float PreJumpDistance = _Contact.GroundContactDistance;
+	if (_Contact.GroundDistance < 0) PreJumpDistance += FMath::Abs(_Contact.GroundDistance); //Account for the curvature of our capsule bottom. 
 
-	AddTranslation(_BodyInstance, FVector(0, 0, PreJumpDistance));
+	_State.Location.Z += PreJumpDistance;
 
 	//< Perform jump & reset. >
-	NewVelocity.Z = JumpForce;
-	AttemptJump = false;
-	Grounded = false;
+	_State.Velocity.Z = JumpForce;
+	_State.AttemptJump = false;
+	_State.Grounded = false;
 }
 
-void UHBMovementComponent::ApplyGravity(float _DeltaTime, FBodyInstance* _BodyInstance)
+void UHBMovementComponent::ApplyGravity(FHBMovementState& _State, float _BodyMass, float _DeltaTime) const
 {
-	NewVelocity += FVector::DownVector * (Gravity * _BodyInstance->GetMassOverride() * _DeltaTime);
+	_State.Velocity += FVector::DownVector * (Gravity * _BodyMass * _DeltaTime);
 }
 
 FVector2D UHBMovementComponent::FindVelRelativeToLook()
@@ -374,34 +1418,38 @@ FVector2D UHBMovementComponent::FindVelRelativeToLook()
 	return FVector2D(xMag, yMag);
 }
 
-void UHBMovementComponent::ApplyFinalVelocity(FBodyInstance* _BodyInstance)
+void UHBMovementComponent::CommitBody(FBodyInstance* _BodyInstance, bool _TransformChanged)
 {
-	_BodyInstance->SetLinearVelocity(NewVelocity, false);
+	if (_TransformChanged)
+	{
+		_BodyInstance->SetBodyTransform(FTransform(State.GetRotation(), State.Location), ETeleportType::TeleportPhysics);
+	}
+	_BodyInstance->SetLinearVelocity(State.Velocity, false);
 }
 
-float UHBMovementComponent::GetTargetSpeed(FVector _Direction)
+float UHBMovementComponent::GetTargetSpeed(const FHBMovementState& _State, const FHBMovementInput& _Input, FVector _Direction, const FHBSurfaceProfile& _Surface) const
 {
-	if (CrouchPressed)
+	if (_Input.CrouchPressed)
 	{
-		return CrouchSpeed;
+		return CrouchSpeed * _Surface.MaxSpeedScale;
 	}
-	if (SprintActive && _Direction.X > 0) return RunSpeed;
+	if (_State.SprintActive && _Direction.X > 0) return RunSpeed * _Surface.MaxSpeedScale;
 
-	return WalkSpeed;
+	return WalkSpeed * _Surface.MaxSpeedScale;
 }
 
-float UHBMovementComponent::GetCurrentHorizontalSpeed()
+float UHBMovementComponent::GetCurrentHorizontalSpeed(const FVector& _Velocity)
 {
-	FVector currentVelocity = NewVelocity;
+	FVector currentVelocity = _Velocity;
 	currentVelocity.Z = 0;
 	return currentVelocity.Size();
 }
 
-float UHBMovementComponent::GetDeceleration()
+float UHBMovementComponent::GetDeceleration(const FHBMovementState& _State, const FHBMovementInput& _Input, const FHBSurfaceProfile& _Surface) const
 {
-	if (Grounded)
+	if (_State.Grounded)
 	{
-		return (IsSliding()) ? SlideDeceleration : GroundDeceleration;
+		return (IsSliding(_State, _Input)) ? SlideDeceleration * _Surface.SlideDecelerationScale : GroundDeceleration * _Surface.DecelerationScale;
 	}
 	else
 	{
@@ -409,27 +1457,34 @@ float UHBMovementComponent::GetDeceleration()
 	}
 }
 
-bool UHBMovementComponent::IsSliding()
+const FHBSurfaceProfile& UHBMovementComponent::GetSurfaceProfile(UPhysicalMaterial* _Material) const
 {
-	if (Grounded && CrouchPressed)
+	const FHBSurfaceProfile* profile = (_Material) ? SurfaceProfiles.Find(_Material) : nullptr;
+	return (profile) ? *profile : DefaultSurfaceProfile;
+}
+
+bool UHBMovementComponent::IsSliding(const FHBMovementState& _State, const FHBMovementInput& _Input) const
+{
+	if (_State.Grounded && _Input.CrouchPressed)
 	{
-		if (NewVelocity.Size() > WalkSpeed) return true;
+		if (_State.Velocity.Size() > WalkSpeed) return true;
 	}
 
 	return false;
 }
 
-bool UHBMovementComponent::CanSlideBoost()
+bool UHBMovementComponent::CanSlideBoost(FHBMovementState& _State, const FHBMovementInput& _Input) const
 {
-	if (IsSliding() & PerformBoost)
+	if (IsSliding(_State, _Input) & _State.PerformBoost)
 	{
-		if (GetCurrentHorizontalSpeed() > ((WalkSpeed + RunSpeed) / 2) && GetCurrentHorizontalSpeed() < SlideForce)
+		float horizontalSpeed = GetCurrentHorizontalSpeed(_State.Velocity);
+		if (horizontalSpeed > ((WalkSpeed + RunSpeed) / 2) && horizontalSpeed < SlideForce)
 		{
 			return true;
 		}
 		else
 		{
-			PerformBoost = false;
+			_State.PerformBoost = false;
 		}
 
 	}
@@ -437,30 +1492,30 @@ bool UHBMovementComponent::CanSlideBoost()
 	return false;
 }
 
-void UHBMovementComponent::StickToGround(float _DeltaTime)
+void UHBMovementComponent::StickToGround(FHBMovementState& _State, const FHBMovementContact& _Contact, float _DeltaTime) const
 {
-	FVector forceToApply = (CollisionComponent->GetGroundNormal() * -1.0f) * (StickToGroundForce + (GetCurrentHorizontalSpeed() / 10)) * 100.0f * _DeltaTime;
-	NewVelocity += forceToApply;
+	FVector forceToApply = (_Contact.GroundNormal * -1.0f) * (StickToGroundForce + (GetCurrentHorizontalSpeed(_State.Velocity) / 10)) * 100.0f * _DeltaTime;
+	_State.Velocity += forceToApply;
 }
 
-void UHBMovementComponent::StickToWall(float _DeltaTime)
+void UHBMovementComponent::StickToWall(FHBMovementState& _State, const FHBMovementContact& _Contact, float _DeltaTime) const
 {
-	FVector forceToApply = (CollisionComponent->GetWallNormal() * -1.0f) * (StickToWallForce + (GetCurrentHorizontalSpeed() / 10)) * 100.0f * _DeltaTime;
-	NewVelocity += forceToApply;
+	FVector forceToApply = (_Contact.WallNormal * -1.0f) * (StickToWallForce + (GetCurrentHorizontalSpeed(_State.Velocity) / 10)) * 100.0f * _DeltaTime;
+	_State.Velocity += forceToApply;
 }
 
-bool UHBMovementComponent::ShouldStartWallRun(FBodyInstance* _BodyInstance)
+bool UHBMovementComponent::ShouldStartWallRun(const FHBMovementState& _State, const FHBMovementInput& _Input, const FHBMovementContact& _Contact) const
 {
-	if (_BodyInstance->GetUnrealWorldVelocity().Z > -500.0f)
+	if (_State.Velocity.Z > -500.0f)
 	{
-		if (!CrouchPressed && GetCurrentHorizontalSpeed() > (CrouchSpeed + WalkSpeed) / 2)
+		if (!_Input.CrouchPressed && GetCurrentHorizontalSpeed(_State.Velocity) > (CrouchSpeed + WalkSpeed) / 2)
 		{
-			if (WallRunDelayTimer <= 0)
+			if (_State.WallRunDelayTimer <= 0)
 			{
 				//< Check angle of approach. >
-				if (CollisionComponent->ContactWithWall())
+				if (_Contact.ContactWithWall() && GetSurfaceProfile(_Contact.WallMaterial).WallRunnable)
 				{
-					float approachAngle = AngleBetweenTwoVectors(CollisionComponent->GetWallNormal() * -1, _BodyInstance->GetUnrealWorldTransform().GetUnitAxis(EAxis::X));
+					float approachAngle = AngleBetweenTwoVectors(_Contact.WallNormal * -1, _State.GetRotation().GetAxisX());
 					if (approachAngle > MaxApproachAngleVertical && approachAngle < MaxApproachAngleHorizontal)
 					{
 						return true;
@@ -473,27 +1528,24 @@ bool UHBMovementComponent::ShouldStartWallRun(FBodyInstance* _BodyInstance)
 	return false;
 }
 
-void UHBMovementComponent::StartWallRun(FBodyInstance* _BodyInstance)
+void UHBMovementComponent::StartWallRun(FHBMovementState& _State, const FHBMovementContact& _Contact) const
 {
 	//< Calculate wall side. >
-	FVector directionVector = (GetTranslation(_BodyInstance) - CollisionComponent->GetWallImpactPoint()).GetSafeNormal().GetSafeNormal();
-	FVector rightVector = _BodyInstance->GetUnrealWorldTransform().GetUnitAxis(EAxis::Y).GetSafeNormal();
-	WallRunSide = FVector::DotProduct(directionVector, rightVector) < 0;
-
-	TargetRotationDelta.Roll += (WallRunSide) ? -10 : 10;
+	FVector directionVector = (_State.Location - _Contact.WallImpactPoint).GetSafeNormal();
+	FVector rightVector = _State.GetRotation().GetAxisY();
+	_State.WallRunSide = FVector::DotProduct(directionVector, rightVector) < 0;
 
-	WallRunActive = true;
-	WallrunFalloffTimeline = 0;
-	PreviousWallNormal = CollisionComponent->GetWallNormal();
-	CurrentWallRunSpeed = GetCurrentHorizontalSpeed();
+	_State.TargetRotationDelta.Roll += (_State.WallRunSide) ? -10 : 10;
 
-	UseGravity = false;
-	WallRunDelayTimer = 0;
+	_State.WallRunActive = true;
+	_State.WallrunFalloffTimeline = 0;
+	_State.PreviousWallNormal = _Contact.WallNormal;
+	_State.CurrentWallRunSpeed = GetCurrentHorizontalSpeed(_State.Velocity);
 
-	UE_LOG(LogTemp, Display, TEXT("Started Wallrun"));
+	_State.WallRunDelayTimer = 0;
 }
 
-void UHBMovementComponent::StopWallRun(FBodyInstance* _BodyInstance, FVector _ExitVelocity, bool _VelocityChange)
+void UHBMovementComponent::StopWallRun(FHBMovementState& _State, FVector _ExitVelocity, bool _VelocityChange) const
 {
 	//< Apply exit velocity. >
 	if (_ExitVelocity != FVector::ZeroVector)
@@ -501,67 +1553,60 @@ void UHBMovementComponent::StopWallRun(FBodyInstance* _BodyInstance, FVector _Ex
 		if (!_VelocityChange)
 		{
 			//< Add exit velocity. >
-			NewVelocity += _ExitVelocity;
+			_State.Velocity += _ExitVelocity;
 
 			//< Perform jump & reset. >
-			NewVelocity.Z = _ExitVelocity.Z;
+			_State.Velocity.Z = _ExitVelocity.Z;
 		}
 		else
 		{
 			//< Apply exit velocity. >
-			NewVelocity = _ExitVelocity;
+			_State.Velocity = _ExitVelocity;
 		}
 	}
 
 	//< Reset camera roll. >
-	TargetRotationDelta.Roll += (WallRunSide) ? 10 : -10;
+	_State.TargetRotationDelta.Roll += (_State.WallRunSide) ? 10 : -10;
 
 	//< Cancel remaining camera yaw. >
-	TargetRotationDelta.Yaw = 0;
+	_State.TargetRotationDelta.Yaw = 0;
 
-	WallRunDelayTimer = WallRunDelay;
+	_State.WallRunDelayTimer = WallRunDelay;
 
-	WallRunActive = false;
-	UseGravity = true;
-	AttemptJump = false;
-	Grounded = false;
+	_State.WallRunActive = false;
+	_State.AttemptJump = false;
+	_State.Grounded = false;
 }
 
-void UHBMovementComponent::TickCapsuleHeight(float _DeltaTime, FBodyInstance* _BodyInstance)
+void UHBMovementComponent::TickCapsuleHeight(FHBMovementState& _State, const FHBMovementInput& _Input, float _DeltaTime) const
 {
 	float minTime, maxTime;
 	CrouchCurve->GetTimeRange(minTime, maxTime);
 
 	//< Abort if target reached. >
-	float targetTime = (!CrouchPressed) ? minTime : maxTime;
-	if (CrouchCurveTimeline == targetTime) return;
+	float targetTime = (!_Input.CrouchPressed) ? minTime : maxTime;
+	if (_State.CrouchCurveTimeline == targetTime) return;
 
-	CrouchCurveTimeline += (CrouchPressed) ? _DeltaTime : -_DeltaTime;
-	CrouchCurveTimeline = FMath::Clamp(CrouchCurveTimeline, minTime, maxTime);
+	_State.CrouchCurveTimeline += (_Input.CrouchPressed) ? _DeltaTime : -_DeltaTime;
+	_State.CrouchCurveTimeline = FMath::Clamp(_State.CrouchCurveTimeline, minTime, maxTime);
 
 	//< Update height with new value from loaded curve. >
-	float curveValue = CrouchCurve->GetFloatValue(CrouchCurveTimeline);
+	float curveValue = CrouchCurve->GetFloatValue(_State.CrouchCurveTimeline);
 	float newHalfHeight = (PlayerHeight * curveValue) / 2;
-	float heightDelta = newHalfHeight - CollisionComponent->CapsuleComponent->GetScaledCapsuleHalfHeight();
+	float heightDelta = newHalfHeight - _State.CapsuleHalfHeight;
 
-	CollisionComponent->CapsuleComponent->SetCapsuleSize(PlayerRadius, newHalfHeight);
-
-	AddTranslation(_BodyInstance, FVector::UpVector * heightDelta);
+	_State.CapsuleHalfHeight = newHalfHeight;
+	_State.Location += FVector::UpVector * heightDelta;
 }
 
-void UHBMovementComponent::AddTranslation(FBodyInstance* _BodyInstance, FVector _NewWorldTranslation)
+FVector UHBMovementComponent::GetWallRunDirection(const FHBMovementContact& _Contact, bool _WallRunSide)
 {
-	FTransform transform = _BodyInstance->GetUnrealWorldTransform();
-	transform.SetTranslation(transform.GetTranslation() + _NewWorldTranslation);
-	_BodyInstance->SetBodyTransform(transform, ETeleportType::TeleportPhysics);
-}
-
-FVector UHBMovementComponent::GetTranslation(FBodyInstance* _BodyInstance)
-{
-	return _BodyInstance->GetUnrealWorldTransform().GetTranslation();
+	FVector direction = _Contact.WallNormal;
+	direction.Z = 0;
+	return direction.RotateAngleAxis((_WallRunSide) ? 90 : -90, FVector::UpVector);
 }
 
 float UHBMovementComponent::AngleBetweenTwoVectors(FVector _A, FVector _B)
 {
 	return UKismetMathLibrary::DegAcos(FVector::DotProduct(_A.GetSafeNormal(0.0001f), _B.GetSafeNormal(0.0001f)));
-}
\ No newline at end of file
+}
@@ -5,11 +5,55 @@
 #include "CoreMinimal.h"
 #include "GameFramework/PawnMovementComponent.h"
 #include "PhysicsEngine/BodyInstance.h"
+#include "Containers/TripleBuffer.h"
+#include "Templates/IsTriviallyCopyAssignable.h"
+#include "Templates/IsTriviallyCopyConstructible.h"
+#include "HBMovementTypes.h"
+#include "HBMovementDebugDraw.h"
+#include "HBMovementAbilities.h"
+#include "../Net/HBMovementSerializer.h"
+#include "../Replay/HBReplayFile.h"
+#include "../Tools/HBMovementCostMap.h"
+#include "../Lockstep/HBLockstepMovement.h"
 #include "HBMovementComponent.generated.h"
 
 class UHBPlayerCollisionComponent;
 class UCurveFloat;
 
+//< Everything a movement step reads that earlier steps wrote, for rollback & replay scrubbing. See UHBMovementComponent::SaveState. >
+// Next to the component rather than in HBMovementTypes.h, as it holds the lockstep state. Plain data, so saving is a copy & snapshots can live in flat arrays.
+struct HITBOX_API FHBMovementSnapshot
+{
+	FHBMovementState State;
+	FHBMovementStepInput AppliedStepInput; //< Presses are counted against this. >
+	FHBMovementContact Contact; //< The collision component's last queries. >
+
+	//< The body. >
+	FVector BodyLocation = FVector::ZeroVector;
+	FQuat BodyRotation = FQuat::Identity;
+	FVector BodyVelocity = FVector::ZeroVector;
+	FVector BodyAngularVelocity = FVector::ZeroVector;
+	float BodyMass = 1.0f;
+
+	//< Sub step bookkeeping. >
+	float SubstepClock = 0;
+	float PendingStepTime = 0;
+	float SkippedGravity = 0;
+	uint64 BudgetFrameNumber = 0;
+	int32 BudgetSubstepIndex = 0;
+	int32 BudgetSteps = 1;
+	uint32 StepCount = 0;
+	uint32 StateHash = 0;
+
+	bool UseGravity = true; //< Switched by wall runs. >
+
+	//< Lockstep mode, State is only its float copy. >
+	FHBLockstepState LockstepState;
+	float LockstepTime = 0;
+};
+
+static_assert(TIsTriviallyCopyConstructible<FHBMovementSnapshot>::Value && TIsTriviallyCopyAssignable<FHBMovementSnapshot>::Value, "FHBMovementSnapshot must stay plain data.");
+
 UCLASS()
 class HITBOX_API UHBMovementComponent : public UPawnMovementComponent
 {
@@ -19,15 +63,81 @@ public:
 	UHBMovementComponent(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
 
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void TickComponent(float _DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 	virtual void SubstepTick(float _DeltaTime, FBodyInstance* _BodyInstance);
 
 	void Input_Jump();
 	void Input_CrouchDown();
 	void Input_CrouchUp();
+	void Input_SprintDown();
+	void Input_SprintUp();
+	void Input_Dash();
+
+	//< Starts a grapple towards _Target (world space), if within FHBGrappleSettings::Range. >
+	void Input_Grapple(FVector _Target);
+	void Input_GrappleRelease();
+
+	//< Turns the character. Applied to the body inside the next movement step rather than by moving the actor. >
+	void AddYawInput(float _Degrees);
+
+	//< Camera rotation requested by the movement rules that the game thread has not used yet. >
+	FRotator GetTargetRotationDelta() const;
+	void SetTargetRotationDelta(FRotator _NewDelta);
+
+	//< Latest state published by the movement step. Game thread only. >
+	const FHBMovementState& GetMovementState() const { return StepOutput.State; }
+	const FHBMovementStepOutput& GetStepOutput() const { return StepOutput; }
+	FHBMovementInput GetMovementInput() const;
+
+	//< Copies what a prediction reads of the live character, the last sub step's contact & the body mass, into a request. Game thread. >
+	FHBPredictionRequest MakePredictionRequest(const FHBMovementState& _State, const FHBMovementInput& _Input, float _Horizon) const;
+
+	//< Runs the ground, air & wall run rules forward from the request's state for its horizon without touching the physics body. >
+	// Contacts come from the request's copy of the last queries, extrapolated as planes, plus optional floor probes.
+	// Only reads the request & the configuration, never what the sub steps write, so safe to call off the game thread.
+	void PredictTrajectory(const FHBPredictionRequest& _Request, FHBPredictedTrajectory& _OutTrajectory, const FHBPredictionSettings& _Settings = FHBPredictionSettings()) const;
+
+	//< Game thread shorthand for MakePredictionRequest & PredictTrajectory. >
+	void PredictTrajectory(const FHBMovementState& _State, const FHBMovementInput& _Input, float _Horizon, FHBPredictedTrajectory& _OutTrajectory, const FHBPredictionSettings& _Settings = FHBPredictionSettings()) const;
+
+	//< Runs many predictions in parallel. _Requests must come from MakePredictionRequest, _OutTrajectories is resized to match. >
+	static void PredictTrajectories(TArrayView<const FHBPredictionRequest> _Requests, TArray<FHBPredictedTrajectory>& _OutTrajectories, const FHBPredictionSettings& _Settings = FHBPredictionSettings());
+
+	//< One step of input, rules & plane based integration against _Contact, without a physics body or scene queries. >
+	// _Contact is extrapolated to the new location. Gravity reads the body mass the component's own sub steps write, so only call
+	// this off the game thread on components that run none, e.g. the sweep commandlet's after InitBodyFromSettings.
+	void SimulateStep(FHBMovementState& _State, const FHBMovementStepInput& _StepInput, const FHBMovementStepInput& _PreviousInput, FHBMovementContact& _Contact, float _DeltaTime) const;
+
+	//< Picks up the body mass from the capsule's settings, for components that never run a physics sub step. >
+	void InitBodyFromSettings();
+
+	//< Fresh state at _Transform: velocity, timers, crouch, wall run, abilities & pending camera rotation cleared, the body teleported. >
+	// Game thread, only while no sub steps run, i.e. with the component's tick disabled. See AHBPhysicsCharacter::RespawnAt.
+	void ResetForRespawn(const FTransform& _Transform);
+
+	//< Copies out everything needed to resimulate from this point: state, applied input, contact, body & sub step bookkeeping. >
+	// Game thread, outside of the physics scene's sub steps (e.g. not between TG_StartPhysics & TG_EndPhysics).
+	void SaveState(FHBMovementSnapshot& _OutSnapshot) const;
+
+	//< Puts the component, its collision queries & the body back to _Snapshot. Same threading as SaveState. >
+	void RestoreState(const FHBMovementSnapshot& _Snapshot);
 
-	FRotator GetTargetRotationDelta() { return TargetRotationDelta; }
-	void SetTargetRotationDelta(FRotator _NewDelta) { TargetRotationDelta = _NewDelta; }
+	//< Runs one movement step per entry of _Inputs from the current state, sweeping the capsule instead of stepping the physics scene. >
+	// For rollback: restore a snapshot, then resimulate the corrected inputs. Nothing is recorded to replays or the hitbox history &
+	// no hit or overlap events fire, the overlaps are updated once for where the capsule ends up.
+	// Kinematic & lockstep modes resimulate exactly what they ran. Simulated mode can only approximate the solver's motion with sweeps.
+	void Resimulate(TArrayView<const FHBMovementStepInput> _Inputs, float _DeltaTime);
+
+	//< Streams every sub step to a replay file. See HBReplay::ResolveFilename & FHBReplayWriter. >
+	UFUNCTION(BlueprintCallable, Category = "Replay")
+		bool StartRecording(const FString& _Filename, int32 _KeyframeInterval = 120);
+
+	UFUNCTION(BlueprintCallable, Category = "Replay")
+		void StopRecording();
+
+	UFUNCTION(BlueprintPure, Category = "Replay")
+		bool IsRecording() const { return Recorder.IsValid(); }
 
 public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Configuration")
@@ -39,6 +149,71 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Configuration")
 		UPhysicalMaterial* PhysicsMaterial;
 
+	//< Per physical material changes to the ground & wall run rules. Surfaces without an entry use DefaultSurfaceProfile. >
+	// The materials come back with the ground & wall queries, so this costs no extra scene queries.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Configuration|Surfaces")
+		TMap<UPhysicalMaterial*, FHBSurfaceProfile> SurfaceProfiles;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Configuration|Surfaces")
+		FHBSurfaceProfile DefaultSurfaceProfile;
+
+	//< Profile of the surface with _Material, see SurfaceProfiles. >
+	const FHBSurfaceProfile& GetSurfaceProfile(UPhysicalMaterial* _Material) const;
+
+	//< Read on BeginPlay. >
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Configuration")
+		EHBBodyMode BodyMode = EHBBodyMode::Simulated;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Configuration|Kinematic", meta = (ClampMin = "0.001"))
+		float MaxKinematicStepTime = 1.0f / 60.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Configuration|Kinematic", meta = (ClampMin = "1"))
+		int32 MaxKinematicSteps = 4; //< Per frame, long frames run slow motion rather than spiral. >
+
+	//< Every lockstep peer must use the same. Read on BeginPlay. >
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Configuration|Lockstep", meta = (ClampMin = "0.001"))
+		float LockstepStepTime = 1.0f / 60.0f;
+
+
+	//< Run fewer movement steps when slow & away from geometry. See stat HBMovement for the steps saved. >
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Configuration|Substeps")
+		bool AdaptiveSubsteps = true;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Configuration|Substeps")
+		float AdaptiveStepDistance = 10; //< Most a step may move outside of wall runs & surface transitions. >
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Configuration|Substeps")
+		float MinAdaptiveStepTime = 0; //< Full precision. 0 uses the engine's MaxSubstepDeltaTime, simulated mode never goes below it. >
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Configuration|Substeps")
+		float MaxAdaptiveStepTime = 1.0f / 30.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Configuration|Substeps", meta = (ClampMin = "1"))
+		int32 MaxMovementStepsPerFrame = 12; //< Hard cap, whatever the speed. >
+
+	//< Skip the ground & wall queries while airborne & clear of geometry. Gravity is the only vertical force in the air, so one sweep
+	// along the flight arc finds the first time anything could come within reach & the steps before it only carry the contact along.
+	// Presses & crouching end the flight early. See stat HBMovement for the steps coasted. >
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Configuration|Substeps")
+		bool BallisticFlight = true;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Configuration|Substeps", meta = (ClampMin = "0.05"))
+		float BallisticHorizon = 0.3f; //< Seconds of flight one sweep covers. Air control widens the sweep with the square of this. >
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Configuration|Substeps", meta = (ClampMin = "1", ClampMax = "8"))
+		int32 BallisticSegments = 3; //< Straight sweeps the arc is split into. >
+
+
+	//< Dash, grapple & ledge climb. The set of abilities is fixed at compile time, see FHBMovementAbilities. >
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Configuration|Abilities")
+		FHBAbilitySettings Abilities;
+
+
+	//< Chain a hash of the quantized state through every step, published with the step output. For hunting desyncs. >
+	// Replays always carry their own hash stream, see hb.Replay.Compare.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Configuration|Debug")
+		bool HashStates = false;
+
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Configuration|Gravity")
 		float Gravity = 15;
@@ -79,10 +254,6 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Configuration|GroundMovement|Crouch&Slide")
 		float SlideDeceleration = 500;
 
-private:
-	bool PerformBoost = false;
-	float CrouchCurveTimeline = 0;
-
 public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Configuration|AirMovement")
 		float AirSpeed = 250;
@@ -127,57 +298,145 @@ public:
 		UCurveFloat* WallrunFalloffCurve;
 
 private:
-	float WallrunFalloffTimeline = 0; // Tracks how far through the WallrunFalloffCurve we are. Will be necessary once we used that curve for wall height.
-	bool WallRunActive = false; // If currently performing a wall run.
-	bool WallRunSide = false; // false = left : true = right.
-	float CurrentWallRunSpeed = 0;
-	float WallRunDelayTimer = 0; // Min time before starting another wall run.
+	//< The movement rules. These only read configuration & write to the state passed in, so they are shared by the live sub step & prediction. >
+	void StepMovement(FHBMovementState& _State, const FHBMovementInput& _Input, const FHBMovementContact& _Contact, float _BodyMass, float _DeltaTime) const;
 
-private:
-	void GroundMove(float _DeltaTime, FBodyInstance* _BodyInstance);
-	void AirMove(float _DeltaTime, FBodyInstance* _BodyInstance);
-	void WallRun(float _DeltaTime, FBodyInstance* _BodyInstance);
-	void Jump(FBodyInstance* _BodyInstance);
+	void GroundMove(FHBMovementState& _State, const FHBMovementInput& _Input, const FHBMovementContact& _Contact, float _DeltaTime) const;
+	void AirMove(FHBMovementState& _State, const FHBMovementInput& _Input, float _DeltaTime) const;
+	void WallRun(FHBMovementState& _State, const FHBMovementContact& _Contact, float _DeltaTime) const;
+	void Jump(FHBMovementState& _State, const FHBMovementContact& _Contact) const;
+
+	void ApplyGravity(FHBMovementState& _State, float _BodyMass, float _DeltaTime) const;
+	void StickToGround(FHBMovementState& _State, const FHBMovementContact& _Contact, float _DeltaTime) const;
+	void StickToWall(FHBMovementState& _State, const FHBMovementContact& _Contact, float _DeltaTime) const;
+
+	bool IsSliding(const FHBMovementState& _State, const FHBMovementInput& _Input) const;
+	bool CanSlideBoost(FHBMovementState& _State, const FHBMovementInput& _Input) const;
+
+	float GetTargetSpeed(const FHBMovementState& _State, const FHBMovementInput& _Input, FVector _Direction, const FHBSurfaceProfile& _Surface) const;
+	float GetDeceleration(const FHBMovementState& _State, const FHBMovementInput& _Input, const FHBSurfaceProfile& _Surface) const;
+
+	bool ShouldStartWallRun(const FHBMovementState& _State, const FHBMovementInput& _Input, const FHBMovementContact& _Contact) const;
+
+	void StartWallRun(FHBMovementState& _State, const FHBMovementContact& _Contact) const;
+	void StopWallRun(FHBMovementState& _State, FVector _ExitVelocity, bool _VelocityChange) const;
+
+	void TickCapsuleHeight(FHBMovementState& _State, const FHBMovementInput& _Input, float _DeltaTime) const;
+
+	//< Moves a predicted state by its velocity & resolves it against the extrapolated contact planes. >
+	void IntegratePrediction(FHBMovementState& _State, FHBMovementContact& _Contact, float _DeltaTime) const;
+
+	//< The single write back to the body at the end of a sub step. >
+	void CommitBody(FBodyInstance* _BodyInstance, bool _TransformChanged);
 
-	void ApplyGravity(float _DeltaTime, FBodyInstance* _BodyInstance);
-	void StickToGround(float _DeltaTime);
-	void StickToWall(float _DeltaTime);
+	//< Input, rules, recording & wall run bookkeeping shared by the simulated & kinematic sub steps. >
+	void AdvanceState(const FHBMovementStepInput& _StepInput, float _DeltaTime, bool _Resimulating = false);
 
-	bool IsSliding();
-	bool CanSlideBoost();
+#if HB_WITH_MOVEMENT_DEBUG_DRAW
+	//< Records the wall run direction & pending camera rotation of the step just taken. See hb.Movement.DebugDraw. >
+	void DrawStepDebug();
+#endif
+	void PublishStepOutput(float _DeltaTime);
 
-	float GetTargetSpeed(FVector _Direction);
-	float GetDeceleration();
+	//< Step count & optional state hash, advanced once per step run. >
+	void CountStep();
 
-	bool ShouldStartWallRun(FBodyInstance* _BodyInstance);
+	//< Game thread, replaces the output read back with the current state & drops any the sub steps left unread. >
+	void SyncStepOutput();
 
-	void StartWallRun(FBodyInstance* _BodyInstance);
-	void StopWallRun(FBodyInstance* _BodyInstance, FVector _ExitVelocity, bool _VelocityChange);
+	//< Kinematic mode, see EHBBodyMode. >
+	void KinematicTick(float _DeltaTime);
+	void KinematicStep(float _DeltaTime);
 
-	void TickCapsuleHeight(float _DeltaTime, FBodyInstance* _BodyInstance);
+	//< A step that queries & sweeps from the capsule's current transform. Kinematic steps & resimulation. >
+	void SweptStep(const FHBMovementStepInput& _StepInput, float _DeltaTime, bool _Resimulating);
+	void SlideMove(FVector _Delta, bool _Resimulating);
 
-	void ApplyFinalVelocity(FBodyInstance* _BodyInstance);
+	//< SafeMoveUpdatedComponent, or for resimulated steps a plain sweep & teleport that fire no hit or overlap events for moves already made. >
+	void MoveCapsule(const FVector& _Delta, FHitResult& _OutHit, bool _Resimulating);
 
+	//< Lockstep mode, see EHBBodyMode. Whole fixed steps of LockstepStepTime, the capsule follows the result. >
+	void LockstepTick(float _DeltaTime);
+	void LockstepStep(const FHBMovementStepInput& _StepInput, float _DeltaTime, bool _Resimulating);
+	void ShowLockstepState(); //< Moves & sizes the capsule to State. >
 
-	FVector NewVelocity; //< Velocity to apply at the end of each sub step. >
-	FVector PreviousWallNormal = FVector::ZeroVector; //< Used to compare against current wall normal to find a rotation angle. > 
+	//< Airborne fast path, see BallisticFlight. Whether this step can skip its scene queries, sweeping a new flight when needed. >
+	bool ShouldCoast(const FHBMovementStepInput& _StepInput, float _StepTime);
+	void SweepBallisticFlight(const FHBMovementStepInput& _StepInput);
 
-	FRotator TargetRotationDelta = FRotator::ZeroRotator; 
-	//< Remaining character rotation for the HBPhysicsCharacter to account for, smoothly rotates when turning a corner if a wall run. 
-	// This functionality will be changed when camera functionality is moved into the HBCameraController class. >
+	//< Simulated mode, decides whether this physics sub step runs the movement. _OutStepTime covers any skipped before it. >
+	bool ShouldRunSubstep(const FHBMovementStepInput& _StepInput, float _DeltaTime, float& _OutStepTime);
 
-	bool Grounded = true; // true if near ground, jumping will set to false until you make contact with ground again.
+	//< Longest step that keeps the movement precise for the current speed, mode & nearby geometry. >
+	float GetAdaptiveStepTime(const FHBMovementState& _State, const FHBMovementContact& _Contact) const;
+
+	//< MinAdaptiveStepTime, or the engine's sub step, see there. >
+	float GetMinAdaptiveStepTime() const;
+
+	//< Game thread, hands the current input to the next movement step. >
+	void PublishStepInput();
+
+	//< Turns the presses & view input between _PreviousInput & _StepInput into state changes. >
+	void ApplyStepInput(FHBMovementState& _State, const FHBMovementStepInput& _StepInput, const FHBMovementStepInput& _PreviousInput) const;
+
+	//< Packs the state against last frame's, checks it round trips & shows the size on screen. See hb.Net.ShowStateBandwidth. >
+	void MeasureStateBandwidth(float _DeltaTime);
+
+
+	FHBMovementState State; //< Live state, owned by the sub step. Velocity is applied to the body at the end of each sub step. >
+
+	//< The game thread & the sub step only talk through these, so neither locks the other's data. >
+	// This is only the data handoff: the sub steps still run inside the frame's physics tick & the game thread still waits for
+	// them at TG_EndPhysics. There is no asynchronous physics tick on this engine version to move them to.
+	TTripleBuffer<FHBMovementStepInput> StepInputBuffer;
+	TTripleBuffer<FHBMovementStepOutput> StepOutputBuffer;
+
+	FHBMovementStepInput PendingStepInput; //< Game thread. >
+	FHBMovementStepOutput StepOutput; //< Game thread, last output read back. >
+	FHBMovementStepInput AppliedStepInput; //< Sub step, the input whose presses have been applied. >
+	uint32 StepCount = 0; //< Sub step. >
+	uint32 StateHash = 0;
+
+	//< Sub step budget for the current frame, see ShouldRunSubstep. >
+	uint64 BudgetFrameNumber = 0;
+	int32 BudgetSubstepIndex = 0;
+	int32 BudgetSteps = 1;
+	float PendingStepTime = 0;
+	float SkippedGravity = 0; //< Downward speed given to the body by the sub steps skipped since the last step. >
+
+	FHBBodySnapshot Body; //< Taken at the start of each sub step. >
+
+	//< Sub step, see ShouldCoast. >
+	float BallisticTimeLeft = 0; //< Flight time known to be clear. >
+	float BallisticRetryTime = 0; //< Until a blocked flight may be swept again. >
+	float BallisticHalfHeight = 0;
+	FHBMovementStepInput BallisticInput; //< Presses the flight was swept with. >
+
+	FHBMovementSerializer StateSerializer; //< Default precision, for the state hash & the bandwidth counter. >
+	TOptional<FHBQuantizedMovementState> BandwidthBaseline;
+	float AverageStateBytes = 0;
+
+	TUniquePtr<FHBReplayWriter> Recorder;
+	FCriticalSection RecorderLock; //< Sub steps record from the physics thread. >
+
+	UHBMovementCostMapSubsystem* CostMap = nullptr; //< See hb.Movement.CostMap. >
+
+	//< Lockstep mode. State is written from LockstepState after every step & never read back. >
+	FHBLockstepState LockstepState;
+	FHBLockstepSettings LockstepSettings;
+	const FHBLockstepWorld* LockstepWorld = nullptr; //< Owned by the UHBLockstepSubsystem. >
+	float LockstepTime = 0; //< Frame time not yet stepped. >
 
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	//< HELPERS >
 private: 
 	FVector2D FindVelRelativeToLook();
-	float AngleBetweenTwoVectors(FVector _A, FVector _B);
+	static float AngleBetweenTwoVectors(FVector _A, FVector _B);
 
-	void AddTranslation(FBodyInstance* _BodyInstance, FVector _NewWorldTranslation);
-	FVector GetTranslation(FBodyInstance* _BodyInstance);
+	//< Horizontal direction along the wall, not normalized. >
+	static FVector GetWallRunDirection(const FHBMovementContact& _Contact, bool _WallRunSide);
 
-	float GetCurrentHorizontalSpeed();
+	static float GetCurrentHorizontalSpeed(const FVector& _Velocity);
 	
 
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -197,10 +456,5 @@ private:
 public:
 	FVector2D MovementInput = FVector2D::ZeroVector;
 	bool SprintPressed = false;
-	bool SprintActive = false;
 	bool CrouchPressed = false;
-
-private:
-	float JumpDelayTimer = 0;
-	bool AttemptJump = false;
 };
@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HBMovementDebugDraw.h"
+
+#if HB_WITH_MOVEMENT_DEBUG_DRAW
+
+#include "DrawDebugHelpers.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+
+static_assert((FHBMovementDebugDraw::Capacity & (FHBMovementDebugDraw::Capacity - 1)) == 0, "FHBMovementDebugDraw::Capacity must be a power of two.");
+
+static TAutoConsoleVariable<int32> CVarMovementDebugDraw(
+	TEXT("hb.Movement.DebugDraw"),
+	0,
+	TEXT("Draws the movement queries of every sub step. Bit mask:\n")
+	TEXT(" 1: ground sweep & normal\n")
+	TEXT(" 2: wall traces & normal\n")
+	TEXT(" 4: wall run direction\n")
+	TEXT(" 8: facing & pending camera rotation\n")
+	TEXT(" 16: airborne fast path sweeps"));
+
+static TAutoConsoleVariable<FString> CVarMovementDebugDrawActor(
+	TEXT("hb.Movement.DebugDrawActor"),
+	TEXT(""),
+	TEXT("Limits hb.Movement.DebugDraw to characters whose name contains this. Empty draws every character."));
+
+void FHBMovementDebugDraw::UpdateCategories(const AActor* _Owner)
+{
+	uint32 categories = (uint32)CVarMovementDebugDraw.GetValueOnGameThread();
+	if (categories != 0 && _Owner)
+	{
+		const FString filter = CVarMovementDebugDrawActor.GetValueOnGameThread();
+		if (!filter.IsEmpty() && !_Owner->GetName().Contains(filter)) categories = 0;
+	}
+	Categories = categories;
+}
+
+void FHBMovementDebugDraw::Line(FVector _Start, FVector _End, FColor _Color)
+{
+	Record({ _Start, _End, 0, _Color, EShape::Line });
+}
+
+void FHBMovementDebugDraw::Arrow(FVector _Start, FVector _End, FColor _Color)
+{
+	Record({ _Start, _End, 0, _Color, EShape::Arrow });
+}
+
+void FHBMovementDebugDraw::Sphere(FVector _Center, float _Radius, FColor _Color)
+{
+	Record({ _Center, _Center, _Radius, _Color, EShape::Sphere });
+}
+
+void FHBMovementDebugDraw::Point(FVector _Location, FColor _Color)
+{
+	Record({ _Location, _Location, 0, _Color, EShape::Point });
+}
+
+void FHBMovementDebugDraw::Record(const FShape& _Shape)
+{
+	FScopeLock lock(&Lock);
+	Shapes[WriteCount & (Capacity - 1)] = _Shape;
+	WriteCount++;
+	if (WriteCount - ReadCount > Capacity) ReadCount = WriteCount - Capacity;
+}
+
+void FHBMovementDebugDraw::Flush(UWorld* _World)
+{
+	FScopeLock lock(&Lock);
+	if (!_World)
+	{
+		ReadCount = WriteCount;
+		return;
+	}
+
+	//< Drawn for a single frame, the next flush brings the next frame's shapes. >
+	for (; ReadCount != WriteCount; ReadCount++)
+	{
+		const FShape& shape = Shapes[ReadCount & (Capacity - 1)];
+		switch (shape.Type)
+		{
+		case EShape::Line:		DrawDebugLine(_World, shape.Start, shape.End, shape.Color); break;
+		case EShape::Arrow:		DrawDebugDirectionalArrow(_World, shape.Start, shape.End, 10, shape.Color); break;
+		case EShape::Sphere:	DrawDebugSphere(_World, shape.Start, shape.Radius, 12, shape.Color); break;
+		case EShape::Point:		DrawDebugPoint(_World, shape.Start, 8, shape.Color); break;
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/StaticArray.h"
+#include "Misc/ScopeLock.h"
+
+//< Debug drawing of the movement queries. Compiled out of Shipping builds along with every HB_MOVEMENT_DEBUG_DRAW call. >
+#define HB_WITH_MOVEMENT_DEBUG_DRAW (ENABLE_DRAW_DEBUG && !UE_BUILD_SHIPPING)
+
+//< What to draw, selected by hb.Movement.DebugDraw. >
+namespace HBMovementDebugDraw
+{
+	enum ECategory : uint32
+	{
+		Ground		= 1 << 0, //< Floor sweep, impact & ground normal. >
+		Wall		= 1 << 1, //< Wall sphere & line traces, wall normal. >
+		WallRun		= 1 << 2, //< Wall run direction. >
+		Rotation	= 1 << 3, //< Facing & the TargetRotationDelta the camera has yet to take. >
+		Ballistic	= 1 << 4, //< Arc swept by the airborne fast path, up to the first possible contact. >
+	};
+}
+
+#if HB_WITH_MOVEMENT_DEBUG_DRAW
+
+class AActor;
+class UWorld;
+
+//< Shapes recorded by the movement steps of one character, drawn once per frame on the game thread. >
+// Fixed-size ring buffer that never allocates. When a frame records more than Capacity shapes the oldest are dropped.
+class HITBOX_API FHBMovementDebugDraw
+{
+public:
+	static constexpr int32 Capacity = 256; //< Must be a power of two. >
+
+	//< Picks the categories for _Owner from the console variables. Game thread, before the frame's steps. >
+	void UpdateCategories(const AActor* _Owner);
+
+	bool IsEnabled(uint32 _Category) const { return (Categories & _Category) != 0; }
+
+	void Line(FVector _Start, FVector _End, FColor _Color);
+	void Arrow(FVector _Start, FVector _End, FColor _Color);
+	void Sphere(FVector _Center, float _Radius, FColor _Color);
+	void Point(FVector _Location, FColor _Color);
+
+	//< Draws & forgets everything recorded since the last flush. >
+	void Flush(UWorld* _World);
+
+private:
+	enum class EShape : uint8 { Line, Arrow, Sphere, Point };
+
+	struct FShape
+	{
+		FVector Start;
+		FVector End;
+		float Radius;
+		FColor Color;
+		EShape Type;
+	};
+
+	void Record(const FShape& _Shape);
+
+	TStaticArray<FShape, Capacity> Shapes;
+	uint32 WriteCount = 0;
+	uint32 ReadCount = 0;
+	FCriticalSection Lock; //< Sub steps record from the physics thread. >
+
+	uint32 Categories = 0; //< Set before the physics tick starts, so the sub steps see this frame's value. >
+};
+
+//< Runs _Call on _Draw if _Category is enabled, e.g. HB_MOVEMENT_DEBUG_DRAW(DebugDraw, Ground, Point(location, FColor::Red)). >
+// Arguments are not evaluated while the category is off, & the whole statement disappears from Shipping builds.
+#define HB_MOVEMENT_DEBUG_DRAW(_Draw, _Category, _Call) \
+	do { if ((_Draw).IsEnabled(HBMovementDebugDraw::_Category)) { (_Draw)._Call; } } while (0)
+
+#else
+
+#define HB_MOVEMENT_DEBUG_DRAW(_Draw, _Category, _Call) do {} while (0)
+
+#endif
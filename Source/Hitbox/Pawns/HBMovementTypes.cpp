@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HBMovementTypes.h"
+
+FHBMovementContact FHBMovementContact::ExtrapolatedTo(FVector _Location, float _HalfHeight) const
+{
+	FHBMovementContact result = *this;
+	result.SampleLocation = _Location;
+	result.SampleHalfHeight = _HalfHeight;
+
+	FVector offset = _Location - SampleLocation;
+
+	//< Ground distance is measured vertically, so follow the slope of the ground plane under the new point. >
+	if (HasGround())
+	{
+		float slopeOffset = (GroundNormal.Z > KINDA_SMALL_NUMBER) ? (GroundNormal.X * offset.X + GroundNormal.Y * offset.Y) / GroundNormal.Z : 0;
+		result.GroundDistance = GroundDistance + offset.Z + slopeOffset - (_HalfHeight - SampleHalfHeight);
+		result.GroundImpactPoint = GroundImpactPoint + FVector(offset.X, offset.Y, -slopeOffset);
+	}
+
+	//< Wall distance is measured horizontally from the wall plane. >
+	if (HasWall())
+	{
+		FVector flatNormal = FVector(WallNormal.X, WallNormal.Y, 0).GetSafeNormal();
+		float normalOffset = FVector::DotProduct(offset, flatNormal);
+
+		result.WallDistance = WallDistance + normalOffset;
+		result.WallImpactPoint = WallImpactPoint + offset - (flatNormal * normalOffset);
+	}
+
+	//< The ledge stays put, only the capsule moves relative to it. >
+	if (HasLedge())
+	{
+		result.LedgeHeight = LedgePoint.Z - (_Location.Z - _HalfHeight);
+	}
+
+	return result;
+}
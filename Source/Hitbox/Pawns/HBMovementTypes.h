@@ -0,0 +1,297 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HBMovementTypes.generated.h"
+
+class UPhysicalMaterial;
+
+//< How the character's capsule is moved. >
+UENUM(BlueprintType)
+enum class EHBBodyMode : uint8
+{
+	Simulated,	//< Rigid body, the movement overrides its velocity every physics sub step. >
+	Kinematic,	//< The movement sweeps the capsule itself & slides along whatever it hits. >
+	Lockstep,	//< Fixed point rules against the level's static collision, bit identical on every build. See HBLockstepMovement.h. >
+};
+
+namespace HBAbility
+{
+	constexpr uint8 None = 0xFF;
+	constexpr int32 MaxAbilities = 4;
+
+	//< Presses seen by the step, see FHBAbilityState::Requests. >
+	constexpr uint8 Request_Dash			= 1 << 0;
+	constexpr uint8 Request_Grapple			= 1 << 1;
+	constexpr uint8 Request_GrappleRelease	= 1 << 2;
+}
+
+//< State of the movement abilities (dash, grapple, ledge climb, see HBMovementAbilities.h). >
+// One block shared by all of them, only one ability is active at a time.
+struct HITBOX_API FHBAbilityState
+{
+	FVector Target = FVector::ZeroVector; //< Set by the active ability on enter, e.g. dash direction or grapple point. >
+	FVector RequestedTarget = FVector::ZeroVector; //< Grapple point of the last grapple press. >
+	float Time = 0; //< Seconds the active ability has run. >
+	float Cooldowns[HBAbility::MaxAbilities] = {}; //< Indexed by the ability's place in its THBAbilitySet. >
+	uint8 Active = HBAbility::None;
+	uint8 Requests = 0; //< HBAbility::Request_ flags, cleared after every step. >
+
+	bool IsActive() const { return Active != HBAbility::None; }
+};
+
+//< Everything the movement rules read & write between sub steps. >
+// Kept as plain data so it can be copied freely, e.g. for trajectory prediction.
+USTRUCT(BlueprintType)
+struct HITBOX_API FHBMovementState
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+		FVector Location = FVector::ZeroVector;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+		float Yaw = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+		FVector Velocity = FVector::ZeroVector;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+		float CapsuleHalfHeight = 86;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+		bool Grounded = true; // true if near ground, jumping will set to false until you make contact with ground again.
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+		bool SprintActive = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+		bool AttemptJump = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+		float JumpDelayTimer = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+		bool PerformBoost = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+		float CrouchCurveTimeline = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+		bool WallRunActive = false; // If currently performing a wall run.
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+		bool WallRunSide = false; // false = left : true = right.
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+		float WallrunFalloffTimeline = 0; // Tracks how far through the WallrunFalloffCurve we are.
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+		float CurrentWallRunSpeed = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+		float WallRunDelayTimer = 0; // Min time before starting another wall run.
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+		FVector PreviousWallNormal = FVector::ZeroVector; //< Used to compare against current wall normal to find a rotation angle. >
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+		FRotator TargetRotationDelta = FRotator::ZeroRotator; //< Remaining camera rotation for the HBPhysicsCharacter to account for. >
+
+	FHBAbilityState Ability;
+
+	FQuat GetRotation() const { return FRotator(0, Yaw, 0).Quaternion(); }
+};
+
+//< Player input sampled once per sub step. >
+USTRUCT(BlueprintType)
+struct HITBOX_API FHBMovementInput
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+		FVector2D MovementInput = FVector2D::ZeroVector;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+		bool SprintPressed = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+		bool CrouchPressed = false;
+};
+
+//< Everything the game thread hands to the movement step. >
+// Button presses are counters, so a tap is never lost if several frames go by between two steps or the other way around.
+struct HITBOX_API FHBMovementStepInput
+{
+	FHBMovementInput Input;
+
+	uint32 JumpPresses = 0;
+	uint32 CrouchPresses = 0;
+	uint32 CrouchReleases = 0;
+	uint32 SprintPresses = 0;
+	uint32 DashPresses = 0;
+	uint32 GrapplePresses = 0;
+	uint32 GrappleReleases = 0;
+	FVector GrappleTarget = FVector::ZeroVector; //< Of the latest grapple press. >
+
+	FRotator ConsumedRotationDelta = FRotator::ZeroRotator; //< Total camera rotation the game thread has taken out of TargetRotationDelta. >
+	double YawInput = 0; //< Total view yaw in degrees, turned into the body by the movement step. >
+
+	uint64 FrameNumber = 0;
+	int32 FrameSubsteps = 1; //< Physics sub steps the engine runs for this frame. >
+};
+
+//< What a movement step needs from the physics body, read once at the start of the step. >
+struct HITBOX_API FHBBodySnapshot
+{
+	FTransform Transform = FTransform::Identity;
+	FVector Velocity = FVector::ZeroVector;
+	float Mass = 1.0f;
+};
+
+//< Everything the movement step hands back to the game thread. >
+struct HITBOX_API FHBMovementStepOutput
+{
+	FHBMovementState State;
+	FRotator ConsumedRotationDelta = FRotator::ZeroRotator; //< Input ConsumedRotationDelta already taken out of State.TargetRotationDelta. >
+	uint32 StepCount = 0;
+	float DeltaTime = 0;
+	uint64 FrameNumber = 0; //< Game frame whose input the step ran with. >
+	uint32 StateHash = 0; //< Rolling hash up to this step, 0 unless UHBMovementComponent::HashStates is set. >
+};
+
+//< Result of the ground & wall queries made by the HBPlayerCollisionComponent. >
+USTRUCT(BlueprintType)
+struct HITBOX_API FHBMovementContact
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement")
+		FVector SampleLocation = FVector::ZeroVector; //< Body location the queries were made from. >
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement")
+		FVector GroundNormal = FVector::UpVector;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement")
+		FVector GroundImpactPoint = FVector::ZeroVector;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement")
+		FVector WallNormal = FVector::ZeroVector;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement")
+		FVector WallImpactPoint = FVector::ZeroVector;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement")
+		float SampleHalfHeight = 86; //< Capsule half height the ground distance was measured with. >
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement")
+		float GroundDistance = 0;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement")
+		float WallDistance = 0;
+
+	//< Top of the wall in front, if the collision component probes for ledges. >
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement")
+		FVector LedgePoint = FVector::ZeroVector;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement")
+		float LedgeHeight = 9999; //< Of LedgePoint above the bottom of the capsule. >
+
+	//< Returned by the same sweeps as the normals, null if the hit had none or nothing was hit. See UHBMovementComponent::SurfaceProfiles. >
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement")
+		UPhysicalMaterial* GroundMaterial = nullptr;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement")
+		UPhysicalMaterial* WallMaterial = nullptr;
+
+	//< Thresholds copied from the owning HBPlayerCollisionComponent. >
+	float GroundNearDistance = 20;
+	float GroundContactDistance = 0.1f;
+	float WallNearDistance = 20;
+	float WallContactDistance = 5.0f;
+
+	bool IsNearGround() const		{ return (GroundDistance < GroundNearDistance);		}
+	bool IsNearWall() const			{ return (WallDistance < WallNearDistance);			}
+
+	bool ContactWithGround() const	{ return (GroundDistance < GroundContactDistance);	}
+	bool ContactWithWall() const	{ return (WallDistance < WallContactDistance);		}
+
+	bool HasGround() const			{ return GroundDistance < 9999;						}
+	bool HasWall() const			{ return WallDistance < 9999;						}
+	bool HasLedge() const			{ return LedgeHeight < 9999;						}
+
+	//< Treats the cached ground & wall hits as planes & moves the sample point to _Location. No scene queries. >
+	FHBMovementContact ExtrapolatedTo(FVector _Location, float _HalfHeight) const;
+};
+
+//< How a surface changes the movement rules, keyed on its physical material. See UHBMovementComponent::SurfaceProfiles. >
+USTRUCT(BlueprintType)
+struct HITBOX_API FHBSurfaceProfile
+{
+	GENERATED_BODY()
+
+	//< Of GroundDeceleration, e.g. low for ice. >
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Surface")
+		float DecelerationScale = 1;
+
+	//< Of SlideDeceleration, e.g. low for ramps made to slide down. >
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Surface")
+		float SlideDecelerationScale = 1;
+
+	//< Of the walk, run & crouch speeds, e.g. below 1 for sand. >
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Surface")
+		float MaxSpeedScale = 1;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Surface")
+		bool WallRunnable = true;
+};
+
+//< Options for UHBMovementComponent::PredictTrajectory. >
+USTRUCT(BlueprintType)
+struct HITBOX_API FHBPredictionSettings
+{
+	GENERATED_BODY()
+
+	//< Length of each predicted step. 0 uses the project's MaxSubstepDeltaTime. >
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Prediction")
+		float SubstepDeltaTime = 0;
+
+	//< Re-probe the floor with a single line trace every N steps. 0 never touches the scene & relies on cached contact data only. >
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Prediction")
+		int32 GroundProbeInterval = 0;
+
+	//< Only store every Nth step in the output positions. >
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Prediction")
+		int32 OutputInterval = 1;
+};
+
+USTRUCT(BlueprintType)
+struct HITBOX_API FHBPredictedTrajectory
+{
+	GENERATED_BODY()
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Prediction")
+		TArray<FVector> Positions;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Prediction")
+		float SampleInterval = 0;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Prediction")
+		FHBMovementState FinalState;
+};
+
+class UHBMovementComponent;
+
+//< A single entry for UHBMovementComponent::PredictTrajectories, see UHBMovementComponent::MakePredictionRequest. >
+struct FHBPredictionRequest
+{
+	const UHBMovementComponent* MovementComponent = nullptr;
+	FHBMovementState State;
+	FHBMovementInput Input;
+	float Horizon = 1.0f;
+
+	//< Copied on the game thread, the sub steps keep writing the originals while predictions run. >
+	FHBMovementContact Contact;
+	float BodyMass = 1.0f;
+};
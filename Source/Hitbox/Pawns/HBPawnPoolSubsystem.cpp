@@ -0,0 +1,120 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HBPawnPoolSubsystem.h"
+#include "HBPhysicsCharacter.h"
+#include "Engine/World.h"
+#include "GameFramework/Controller.h"
+#include "HAL/IConsoleManager.h"
+#include "../Hitbox.h"
+
+DECLARE_CYCLE_STAT(TEXT("Pawn Respawn"), STAT_HBPawnRespawn, STATGROUP_HBMovement);
+DECLARE_CYCLE_STAT(TEXT("Pawn Spawn"), STAT_HBPawnSpawn, STATGROUP_HBMovement);
+
+//< Where prewarmed characters wait: far below any map, yet inside the world bounds & above the default KillZ. >
+static const FVector PawnPoolParkLocation(0, 0, -HALF_WORLD_MAX / 2);
+
+static TAutoConsoleVariable<int32> CVarPawnPoolEnabled(
+	TEXT("hb.PawnPool.Enabled"),
+	1,
+	TEXT("0: characters are destroyed on release & spawned on acquire, for comparing spawn hitches against pooled respawns."));
+
+static FAutoConsoleCommandWithWorld PawnPoolStatsCommand(
+	TEXT("hb.PawnPool.Stats"),
+	TEXT("Logs how long pooled respawns & full character spawns took since the last call, then resets the counts."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* _World)
+	{
+		UHBPawnPoolSubsystem* pool = (_World) ? _World->GetSubsystem<UHBPawnPoolSubsystem>() : nullptr;
+		if (!pool) return;
+
+		const FHBPawnPoolStats& stats = pool->GetStats();
+		UE_LOG(LogTemp, Display, TEXT("Pawn pool: %d waiting. %d respawns, avg %.3f ms, max %.3f ms. %d spawns, avg %.3f ms, max %.3f ms."),
+			pool->NumPooled(),
+			stats.Respawns, (stats.Respawns > 0) ? stats.RespawnSeconds * 1000 / stats.Respawns : 0.0, stats.MaxRespawnSeconds * 1000,
+			stats.Spawns, (stats.Spawns > 0) ? stats.SpawnSeconds * 1000 / stats.Spawns : 0.0, stats.MaxSpawnSeconds * 1000);
+		pool->ResetStats();
+	}));
+
+void UHBPawnPoolSubsystem::Prewarm(TSubclassOf<AHBPhysicsCharacter> _Class, int32 _Count)
+{
+	if (!_Class) return;
+
+	int32 waiting = 0;
+	for (AHBPhysicsCharacter* character : Pooled)
+	{
+		if (character && character->GetClass() == _Class) waiting++;
+	}
+
+	for (; waiting < _Count; waiting++)
+	{
+		AHBPhysicsCharacter* character = SpawnCharacter(_Class, FTransform(PawnPoolParkLocation), true);
+		if (!character) return;
+
+		character->ReturnToPool();
+		Pooled.Add(character);
+	}
+}
+
+AHBPhysicsCharacter* UHBPawnPoolSubsystem::Acquire(TSubclassOf<AHBPhysicsCharacter> _Class, const FTransform& _Transform)
+{
+	if (!_Class) return nullptr;
+
+	int32 index = Pooled.IndexOfByPredicate([&_Class](const AHBPhysicsCharacter* _Character) { return _Character && _Character->GetClass() == _Class; });
+	if (index == INDEX_NONE || CVarPawnPoolEnabled.GetValueOnGameThread() == 0)
+	{
+		return SpawnCharacter(_Class, _Transform);
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_HBPawnRespawn);
+	double startTime = FPlatformTime::Seconds();
+
+	AHBPhysicsCharacter* character = Pooled[index];
+	Pooled.RemoveAtSwap(index);
+	character->RespawnAt(_Transform);
+
+	double seconds = FPlatformTime::Seconds() - startTime;
+	Stats.Respawns++;
+	Stats.RespawnSeconds += seconds;
+	Stats.MaxRespawnSeconds = FMath::Max(Stats.MaxRespawnSeconds, seconds);
+	return character;
+}
+
+void UHBPawnPoolSubsystem::Release(AHBPhysicsCharacter* _Character)
+{
+	if (!_Character || _Character->IsPooled()) return;
+
+	if (CVarPawnPoolEnabled.GetValueOnGameThread() == 0)
+	{
+		if (AController* controller = _Character->GetController()) controller->UnPossess();
+		_Character->Destroy();
+		return;
+	}
+
+	_Character->ReturnToPool();
+	Pooled.Add(_Character);
+}
+
+AHBPhysicsCharacter* UHBPawnPoolSubsystem::SpawnCharacter(TSubclassOf<AHBPhysicsCharacter> _Class, const FTransform& _Transform, bool _Parked)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HBPawnSpawn);
+	double startTime = FPlatformTime::Seconds();
+
+	FActorSpawnParameters spawnParams;
+	spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	spawnParams.ObjectFlags |= RF_Transient; //< Never saved into a map. >
+	spawnParams.bDeferConstruction = _Parked;
+	AHBPhysicsCharacter* character = GetWorld()->SpawnActor<AHBPhysicsCharacter>(_Class, _Transform, spawnParams);
+
+	//< Hidden & not colliding before the body is created, so prewarming never overlaps anything, including the other parked characters. >
+	if (character && _Parked)
+	{
+		character->SetActorHiddenInGame(true);
+		character->SetActorEnableCollision(false);
+		character->FinishSpawning(_Transform);
+	}
+
+	double seconds = FPlatformTime::Seconds() - startTime;
+	Stats.Spawns++;
+	Stats.SpawnSeconds += seconds;
+	Stats.MaxSpawnSeconds = FMath::Max(Stats.MaxSpawnSeconds, seconds);
+	return character;
+}
@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Templates/SubclassOf.h"
+#include "HBPawnPoolSubsystem.generated.h"
+
+class AHBPhysicsCharacter;
+
+//< Cost of handing out characters, pooled respawns against full spawns. See hb.PawnPool.Stats. >
+struct FHBPawnPoolStats
+{
+	int32 Respawns = 0;				//< Acquires served from the pool. >
+	double RespawnSeconds = 0;
+	double MaxRespawnSeconds = 0;
+
+	int32 Spawns = 0;				//< Characters created, by prewarming or because the pool ran dry. >
+	double SpawnSeconds = 0;
+	double MaxSpawnSeconds = 0;
+};
+
+//< Characters spawned up front & parked, so respawns reset them in place instead of creating UObjects & physics actors mid match. >
+// Each character's subobject chain (movement, collision & capsule, camera controller, view mount, camera) & its simulating body
+// are created once by Prewarm. hb.PawnPool.Enabled 0 falls back to destroy & spawn, to compare the two.
+UCLASS()
+class HITBOX_API UHBPawnPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	//< Spawns & parks characters of _Class until _Count of them are waiting in the pool. >
+	UFUNCTION(BlueprintCallable, Category = "Pawn Pool")
+		void Prewarm(TSubclassOf<AHBPhysicsCharacter> _Class, int32 _Count);
+
+	//< A pooled character of exactly _Class respawned at _Transform, or a newly spawned one if none is waiting. >
+	UFUNCTION(BlueprintCallable, Category = "Pawn Pool")
+		AHBPhysicsCharacter* Acquire(TSubclassOf<AHBPhysicsCharacter> _Class, const FTransform& _Transform);
+
+	//< Unpossesses & parks _Character until the next Acquire of its class. >
+	UFUNCTION(BlueprintCallable, Category = "Pawn Pool")
+		void Release(AHBPhysicsCharacter* _Character);
+
+	int32 NumPooled() const { return Pooled.Num(); }
+
+	const FHBPawnPoolStats& GetStats() const { return Stats; }
+	void ResetStats() { Stats = FHBPawnPoolStats(); }
+
+private:
+	//< _Parked spawns the character hidden & without collision, so it never touches the map before it is first acquired. >
+	AHBPhysicsCharacter* SpawnCharacter(TSubclassOf<AHBPhysicsCharacter> _Class, const FTransform& _Transform, bool _Parked = false);
+
+	UPROPERTY()
+		TArray<AHBPhysicsCharacter*> Pooled;
+
+	FHBPawnPoolStats Stats;
+};
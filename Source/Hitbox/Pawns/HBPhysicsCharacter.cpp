@@ -6,8 +6,20 @@
 #include "HBCameraController.h"
 #include "HBPlayerCollisionComponent.h"
 #include "Components/SceneComponent.h"
+#include "Camera/CameraComponent.h"
+#include "GameFramework/Controller.h"
+#include "Engine/World.h"
+#include "Engine/Engine.h"
+#include "HAL/IConsoleManager.h"
 #include "PhysicalMaterials/PhysicalMaterial.h"
+#include "../Hitbox.h"
 
+DECLARE_CYCLE_STAT(TEXT("Proxy Interpolation"), STAT_HBProxyInterpolation, STATGROUP_HBMovement);
+
+static TAutoConsoleVariable<int32> CVarShowProxyStats(
+	TEXT("hb.Net.ShowProxyStats"),
+	0,
+	TEXT("Shows the jitter buffer of every remote proxy on screen: buffered snapshots, delay, measured jitter & late snapshots."));
 
 AHBPhysicsCharacter::AHBPhysicsCharacter()
 {
@@ -20,44 +32,45 @@ AHBPhysicsCharacter::AHBPhysicsCharacter()
 
 	CameraController = CreateDefaultSubobject<UHBCameraController>(TEXT("CameraController"));
 	CameraController->SetupAttachment(RootComponent);
+	CameraComponent = CameraController->GetCameraComponent();
+	ViewMountComponent = CameraController->GetViewMountComponent();
 }
 
 void AHBPhysicsCharacter::BeginPlay()
 {
 	Super::BeginPlay();
+
+	//< After the components' BeginPlay, which set up the body for local simulation. >
+	if (RemoteProxy) SetRemoteProxy(true);
 }
 
 void AHBPhysicsCharacter::OnConstruction(const FTransform& _Transform)
 {
-	UpdateCameraHeight();
+	CameraController->SnapToTargets();
 }
 
-void AHBPhysicsCharacter::Tick(float _DeltaTime)
+void AHBPhysicsCharacter::PostLoad()
 {
-	Super::Tick(_DeltaTime);
+	Super::PostLoad();
 
-	UpdateViewingAngle(_DeltaTime);
-	UpdateCameraHeight();
+	//< Saved before the camera settings moved, the values load into the deprecated properties & are kept once the asset is saved again. >
+	if (MouseSensitivity_DEPRECATED >= 0)
+	{
+		CameraController->MouseSensitivity = MouseSensitivity_DEPRECATED;
+		MouseSensitivity_DEPRECATED = INDEX_NONE;
+	}
+	if (CameraDepth_DEPRECATED >= 0)
+	{
+		CameraController->CameraDepth = CameraDepth_DEPRECATED;
+		CameraDepth_DEPRECATED = -1;
+	}
 }
 
-void AHBPhysicsCharacter::UpdateViewingAngle(float _DeltaTime)
+void AHBPhysicsCharacter::Tick(float _DeltaTime)
 {
-	if (!CameraComponent) return;
-
-	FVector2D lastMouseDelta = ConsumeMouseInput();
-
-	//< Gather any additional rotations & account for some amount of that. >
-	FRotator additionalRot = CalculateAdditionalCameraRotation(_DeltaTime);
-
-	float horizontalDelta = (lastMouseDelta.X * 25 * MouseSensitivity) * _DeltaTime;
-	float verticalDelta = (lastMouseDelta.Y * 25 * MouseSensitivity) * _DeltaTime;
-
-	//< Rotate Camera (Vertical) >
-	float newPitch = FMath::Clamp(ViewMountComponent->GetRelativeRotation().Add(verticalDelta, 0, 0).Pitch, -85.0f, 85.0f);
-	ViewMountComponent->SetRelativeRotation(FRotator(newPitch, 0, ViewMountComponent->GetRelativeRotation().Roll + additionalRot.Roll), false, nullptr);
+	Super::Tick(_DeltaTime);
 
-	//< Rotate Actor (Horizontal) >
-	AddActorWorldRotation(FRotator(0, horizontalDelta + additionalRot.Yaw, 0), false);
+	if (RemoteProxy) ProxyTick(_DeltaTime);
 }
 
 void AHBPhysicsCharacter::SetupPlayerInputComponent(UInputComponent* _PlayerInputComponent)
@@ -72,6 +85,11 @@ void AHBPhysicsCharacter::SetupPlayerInputComponent(UInputComponent* _PlayerInpu
 	_PlayerInputComponent->BindAction(TEXT("Crouch"), EInputEvent::IE_Released, this, &AHBPhysicsCharacter::Input_CrouchUp);
 	_PlayerInputComponent->BindAction(TEXT("Crouch"), EInputEvent::IE_Pressed, this, &AHBPhysicsCharacter::Input_CrouchDown);
 
+	_PlayerInputComponent->BindAction(TEXT("Dash"), EInputEvent::IE_Pressed, this, &AHBPhysicsCharacter::Input_Dash);
+
+	_PlayerInputComponent->BindAction(TEXT("Grapple"), EInputEvent::IE_Released, this, &AHBPhysicsCharacter::Input_GrappleUp);
+	_PlayerInputComponent->BindAction(TEXT("Grapple"), EInputEvent::IE_Pressed, this, &AHBPhysicsCharacter::Input_GrappleDown);
+
 	_PlayerInputComponent->BindAxis(TEXT("MoveForward"), this, &AHBPhysicsCharacter::Input_Forward);
 	_PlayerInputComponent->BindAxis(TEXT("MoveRight"), this, &AHBPhysicsCharacter::Input_Right);
 
@@ -79,6 +97,118 @@ void AHBPhysicsCharacter::SetupPlayerInputComponent(UInputComponent* _PlayerInpu
 	_PlayerInputComponent->BindAxis(TEXT("MouseY"), this, &AHBPhysicsCharacter::Input_LookVertical);
 }
 
+//< POOLING >///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void AHBPhysicsCharacter::ReturnToPool()
+{
+	if (Controller) Controller->UnPossess();
+
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+	SetActorTickEnabled(false);
+
+	TInlineComponentArray<UActorComponent*> components(this);
+	for (UActorComponent* component : components)
+	{
+		component->SetComponentTickEnabled(false);
+	}
+
+	//< No ticks means no custom physics, so the movement stops with the body. >
+	UHBPlayerCollisionComponent* collision = MovementComponent->GetCollisionComponent();
+	collision->CapsuleComponent->SetSimulatePhysics(false);
+	collision->SetHitboxRegistered(false);
+
+	Pooled = true;
+}
+
+void AHBPhysicsCharacter::RespawnAt(const FTransform& _Transform)
+{
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+
+	//< Teleports the body & restores its physics mode. The camera follows the fresh movement state. >
+	MovementComponent->ResetForRespawn(_Transform);
+	CameraController->ResetForRespawn();
+	MovementComponent->GetCollisionComponent()->SetHitboxRegistered(true);
+
+	SetActorTickEnabled(PrimaryActorTick.bStartWithTickEnabled);
+
+	TInlineComponentArray<UActorComponent*> components(this);
+	for (UActorComponent* component : components)
+	{
+		component->SetComponentTickEnabled(component->PrimaryComponentTick.bStartWithTickEnabled);
+	}
+
+	//< Stay a proxy, with an empty buffer. >
+	if (RemoteProxy) SetRemoteProxy(true);
+
+	Pooled = false;
+}
+
+//< REMOTE PROXY >///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void AHBPhysicsCharacter::SetRemoteProxy(bool _RemoteProxy)
+{
+	UHBPlayerCollisionComponent* collision = MovementComponent->GetCollisionComponent();
+	ProxyInterpolator.Reset();
+	ProxyInterpolator.SetSettings(ProxySettings);
+
+	if (_RemoteProxy)
+	{
+		//< No movement tick means no steps, traces or custom physics. The collision component keeps ticking for the hitbox clock. >
+		MovementComponent->SetComponentTickEnabled(false);
+		CameraController->SetComponentTickEnabled(false);
+		collision->CapsuleComponent->SetSimulatePhysics(false);
+	}
+	else if (RemoteProxy)
+	{
+		MovementComponent->ResetForRespawn(GetActorTransform());
+		CameraController->ResetForRespawn();
+		MovementComponent->SetComponentTickEnabled(MovementComponent->PrimaryComponentTick.bStartWithTickEnabled);
+		CameraController->SetComponentTickEnabled(CameraController->PrimaryComponentTick.bStartWithTickEnabled);
+	}
+	RemoteProxy = _RemoteProxy;
+}
+
+void AHBPhysicsCharacter::PushProxySnapshot(const FHBProxySnapshot& _Snapshot)
+{
+	ProxyInterpolator.AddSnapshot(_Snapshot, GetWorld()->GetTimeSeconds());
+}
+
+FHBProxySnapshot AHBPhysicsCharacter::MakeProxySnapshot() const
+{
+	return FHBProxySnapshot::FromMovementState(MovementComponent->GetMovementState(), CameraController->GetViewRoll(), GetWorld()->GetTimeSeconds());
+}
+
+void AHBPhysicsCharacter::ProxyTick(float _DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HBProxyInterpolation);
+
+	FHBProxySnapshot pose;
+	if (!ProxyInterpolator.Sample(GetWorld()->GetTimeSeconds(), _DeltaTime, pose)) return;
+
+	UHBPlayerCollisionComponent* collision = MovementComponent->GetCollisionComponent();
+	UCapsuleComponent* cc = collision->CapsuleComponent;
+	if (!FMath::IsNearlyEqual(cc->GetUnscaledCapsuleHalfHeight(), pose.CapsuleHalfHeight, 0.01f))
+	{
+		cc->SetCapsuleSize(MovementComponent->PlayerRadius, pose.CapsuleHalfHeight);
+	}
+	SetActorLocationAndRotation(pose.Location, FRotator(0, pose.Yaw, 0), false, nullptr, ETeleportType::TeleportPhysics);
+	CameraController->SetProxyView(pose.CapsuleHalfHeight, pose.CameraRoll);
+
+	//< Hit tests rewind to what was drawn, at the time it is drawn. The sub step clock runs a frame behind, as sub steps start there. >
+	FHBBodySnapshot body;
+	body.Transform = cc->GetComponentTransform();
+	body.Velocity = pose.Velocity;
+	collision->RecordPose(GetWorld()->GetTimeSeconds(), body);
+
+	if (CVarShowProxyStats.GetValueOnGameThread() > 0 && GEngine)
+	{
+		GEngine->AddOnScreenDebugMessage(-1, _DeltaTime, (ProxyInterpolator.IsExtrapolating()) ? FColor::Orange : FColor::Cyan, FString::Printf(
+			TEXT("%s: %d snapshots, delay %.0f ms (target %.0f), jitter %.1f ms, %u late%s"), *GetName(),
+			ProxyInterpolator.NumSnapshots(), ProxyInterpolator.GetDelay() * 1000, ProxyInterpolator.GetTargetDelay() * 1000,
+			ProxyInterpolator.GetJitter() * 1000, ProxyInterpolator.GetLateSnapshots(), (ProxyInterpolator.IsExtrapolating()) ? TEXT(", extrapolating") : TEXT("")));
+	}
+}
+
 //< INPUT >///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 void AHBPhysicsCharacter::Input_Jump()
 {
@@ -97,25 +227,24 @@ void AHBPhysicsCharacter::Input_Right(float _Val)
  
 void AHBPhysicsCharacter::Input_LookVertical(float _Val)
 {
-	//< See @AHBPhysicsCharacter::UpdateViewingAngle. >
-	MouseDelta.Y = _Val;
+	//< See @UHBCameraController::TickComponent. >
+	CameraController->AddLookInput(FVector2D(0, _Val));
 }
 
 void AHBPhysicsCharacter::Input_LookHorizontal(float _Val)
 {
-	//< See @AHBPhysicsCharacter::UpdateViewingAngle. >
-	MouseDelta.X = _Val;
+	//< See @UHBCameraController::TickComponent. >
+	CameraController->AddLookInput(FVector2D(_Val, 0));
 }
 
 void AHBPhysicsCharacter::Input_SprintUp()
 {
-	MovementComponent->SprintPressed = false;
+	MovementComponent->Input_SprintUp();
 }
 
 void AHBPhysicsCharacter::Input_SprintDown()
 {
-	MovementComponent->SprintPressed = true;
-	MovementComponent->SprintActive = true;
+	MovementComponent->Input_SprintDown();
 }
 
 void AHBPhysicsCharacter::Input_CrouchUp()
@@ -128,41 +257,26 @@ void AHBPhysicsCharacter::Input_CrouchDown()
 	MovementComponent->Input_CrouchDown();
 }
 
-FVector2D AHBPhysicsCharacter::ConsumeMouseInput()
+void AHBPhysicsCharacter::Input_Dash()
 {
-	FVector2D LastMouseDelta = MouseDelta;
-	MouseDelta = FVector2D::ZeroVector;
-	return LastMouseDelta;
+	MovementComponent->Input_Dash();
 }
 
-FRotator AHBPhysicsCharacter::CalculateAdditionalCameraRotation(float _DeltaTime)
+void AHBPhysicsCharacter::Input_GrappleDown()
 {
-	FRotator additionalRot = MovementComponent->GetTargetRotationDelta();
+	//< Grapple to whatever the movement could stand on along the view. >
+	FVector start = CameraComponent->GetComponentLocation();
+	FVector end = start + CameraComponent->GetForwardVector() * MovementComponent->Abilities.Grapple.Range;
 
-	float pitch = additionalRot.Pitch	* FMath::Clamp((float)(_DeltaTime * CameraPitchSpeed),	0.0f, 1.0f);
-	float yaw	= additionalRot.Yaw		* FMath::Clamp((float)(_DeltaTime * CameraYawSpeed),	0.0f, 1.0f);
-	float roll	= additionalRot.Roll	* FMath::Clamp((float)(_DeltaTime * CameraRollSpeed),	0.0f, 1.0f);
-
-	additionalRot.Pitch -= pitch;
-	additionalRot.Yaw	-= yaw;
-	additionalRot.Roll	-= roll;
-
-	MovementComponent->SetTargetRotationDelta(additionalRot);
-
-	return FRotator(pitch, yaw, roll);
+	FHitResult hit;
+	FCollisionQueryParams params(SCENE_QUERY_STAT(HBGrappleTrace), false, this);
+	if (GetWorld()->LineTraceSingleByChannel(hit, start, end, ECC_HBMovement, params))
+	{
+		MovementComponent->Input_Grapple(hit.ImpactPoint);
+	}
 }
 
-void AHBPhysicsCharacter::UpdateCameraHeight()
+void AHBPhysicsCharacter::Input_GrappleUp()
 {
-	if (ViewMountComponent && MovementComponent && MovementComponent->GetCollisionComponent())
-	{
-		if (UCapsuleComponent* cc = MovementComponent->GetCollisionComponent()->CapsuleComponent)
-		{
-			float targetCameraHeight = MovementComponent->GetCollisionComponent()->CapsuleComponent->GetScaledCapsuleHalfHeight() - CameraDepth;
-			if (targetCameraHeight != ViewMountComponent->GetRelativeLocation().Z)
-			{
-				ViewMountComponent->SetRelativeLocation(FVector(0, 0, targetCameraHeight), false, nullptr, ETeleportType::TeleportPhysics);
-			}
-		}
-	}
-}
\ No newline at end of file
+	MovementComponent->Input_GrappleRelease();
+}
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Pawn.h"
+#include "../Net/HBProxyInterpolator.h"
 #include "HBPhysicsCharacter.generated.h"
 
 class UCapsuleComponent;
@@ -22,37 +23,57 @@ public:
 
 	virtual void BeginPlay() override;
 	virtual void OnConstruction(const FTransform& _Transform) override;
+	virtual void PostLoad() override;
 
 	virtual void Tick(float _DeltaTime) override;
-	void UpdateViewingAngle(float _DeltaTime);
 
 	virtual void SetupPlayerInputComponent(class UInputComponent* _PlayerInputComponent) override;
 
 
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-	//< Helpers >
+	//< POOLING >
+public:
+	//< Parks the character for UHBPawnPoolSubsystem: unpossessed, hidden, not colliding, ticking or simulating. >
+	void ReturnToPool();
+
+	//< Brings a parked character back at _Transform with fresh movement, collision & camera state. Creates no UObjects or physics actors. >
+	void RespawnAt(const FTransform& _Transform);
+
+	bool IsPooled() const { return Pooled; }
+
 private:
-	void UpdateCameraHeight();
-	FRotator CalculateAdditionalCameraRotation(float _DeltaTime);
+	bool Pooled = false;
 
 
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-	//< CONFIGURATION >
+	//< REMOTE PROXY >
 public:
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Camera")
-		float CameraDepth = 15;
+	//< Draws the character from snapshots sent by its owning peer instead of simulating it: no movement steps, scene queries or simulating body. >
+	// The capsule keeps blocking & the hitbox history records the drawn pose once a frame, so hit tests still see the character.
+	// Leaving proxy mode starts the movement afresh from the current pose, as RespawnAt does.
+	void SetRemoteProxy(bool _RemoteProxy);
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Camera")
-		float CameraPitchSpeed = 5;
+	bool IsRemoteProxy() const { return RemoteProxy; }
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Camera")
-		float CameraYawSpeed = 5;
+	//< Hands a received snapshot to the jitter buffer, see FHBProxyInterpolator. >
+	void PushProxySnapshot(const FHBProxySnapshot& _Snapshot);
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Camera")
-		float CameraRollSpeed = 5;
+	//< What the owning peer sends of this character, stamped with the current world time. >
+	FHBProxySnapshot MakeProxySnapshot() const;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Camera", meta = (ClampMin = "1.0", ClampMax = "10.0", UIMin = "1.0", UIMax = "10.0"))
-		int MouseSensitivity = 5;
+	const FHBProxyInterpolator& GetProxyInterpolator() const { return ProxyInterpolator; }
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Remote Proxy")
+		FHBProxyInterpolationSettings ProxySettings;
+
+private:
+	void ProxyTick(float _DeltaTime);
+
+	//< Read on BeginPlay, see SetRemoteProxy. >
+	UPROPERTY(EditAnywhere, Category = "Remote Proxy")
+		bool RemoteProxy = false;
+
+	FHBProxyInterpolator ProxyInterpolator;
 
 
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -71,15 +92,17 @@ private:
 	UFUNCTION() void Input_CrouchUp();
 	UFUNCTION() void Input_CrouchDown();
 
+	UFUNCTION() void Input_Dash();
 
-	FVector2D MouseDelta = FVector2D::ZeroVector;
-	FVector2D ConsumeMouseInput();
+	UFUNCTION() void Input_GrappleDown();
+	UFUNCTION() void Input_GrappleUp();
 
 
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	//< COMPONENTS >
 public:
 	UHBMovementComponent*	GetMovementComponent()	{ return MovementComponent;		}
+	UHBCameraController*	GetCameraController()	{ return CameraController;		}
 	UCameraComponent*		GetCameraComponent()	{ return CameraComponent;		}
 	USceneComponent*		GetViewMountComponent() { return ViewMountComponent;	}
 
@@ -96,4 +119,16 @@ private:
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
 		USceneComponent* ViewMountComponent;
-};
\ No newline at end of file
+
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	//< DEPRECATED >
+private:
+	//< Camera settings saved on the character before they moved to UHBCameraController, handed over in PostLoad. >
+	// Negative when the asset never saved them. The old pitch/yaw/roll speeds have no equivalent & are dropped.
+	UPROPERTY()
+		int MouseSensitivity_DEPRECATED = INDEX_NONE;
+
+	UPROPERTY()
+		float CameraDepth_DEPRECATED = -1;
+};
@@ -3,8 +3,19 @@
 #include "HBPlayerCollisionComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Engine.h"
-#include "DrawDebugHelpers.h"
 #include "../HBMathLibrary.h"
+#include "../Combat/HBHitboxRewindSubsystem.h"
+#include "../Hitbox.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Movement Queries"), STAT_HBMovementQueries, STATGROUP_HBMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Movement Candidates"), STAT_HBMovementCandidates, STATGROUP_HBMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Visibility Candidates"), STAT_HBVisibilityCandidates, STATGROUP_HBMovement);
+
+static TAutoConsoleVariable<int32> CVarMovementQueryStats(
+	TEXT("hb.Movement.QueryStats"),
+	0,
+	TEXT("Counts the primitives each ground & wall query could touch on the movement channel versus ECC_Visibility. See stat HBMovement.\n")
+	TEXT("Adds two overlap queries per trace, so only turn it on while profiling."));
 
 // Sets default values for this component's properties
 UHBPlayerCollisionComponent::UHBPlayerCollisionComponent()
@@ -12,6 +23,7 @@ UHBPlayerCollisionComponent::UHBPlayerCollisionComponent()
 	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
 	// off to improve performance if you don't need them.
 	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.TickGroup = TG_PrePhysics; //< Runs before the sub steps so the hitbox clock is in sync. >
 
 	//< Setup the Capsule Collider & set as root. >
 	CapsuleComponent = CreateDefaultSubobject<UCapsuleComponent>(TEXT("CollisionCapsule"));
@@ -39,67 +51,257 @@ UHBPlayerCollisionComponent::UHBPlayerCollisionComponent()
 void UHBPlayerCollisionComponent::BeginPlay()
 {
 	Super::BeginPlay();
+
+	RefreshQueryParams();
+	SetHitboxRegistered(true);
+}
+
+void UHBPlayerCollisionComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	SetHitboxRegistered(false);
+	Super::EndPlay(EndPlayReason);
+}
+
+void UHBPlayerCollisionComponent::SetHitboxRegistered(bool _Registered)
+{
+	if (UHBHitboxRewindSubsystem* rewindSubsystem = GetWorld()->GetSubsystem<UHBHitboxRewindSubsystem>())
+	{
+		if (_Registered)	rewindSubsystem->RegisterComponent(this);
+		else				rewindSubsystem->UnregisterComponent(this);
+	}
+}
+
+void UHBPlayerCollisionComponent::ResetForRespawn()
+{
+	Contact = FHBMovementContact();
+	HitboxHistory.Reset();
+
+	//< Poses from the previous life must not be drawn at the new one. >
+#if HB_WITH_MOVEMENT_DEBUG_DRAW
+	DebugDraw.Flush(nullptr);
+#endif
 }
 
 // Called every frame
 void UHBPlayerCollisionComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	//< This frame's sub steps simulate from the previous frame's time up to the current one. >
+	SubstepClock = GetWorld()->GetTimeSeconds() - DeltaTime;
+
+#if HB_WITH_MOVEMENT_DEBUG_DRAW
+	//< Draw what last frame's sub steps recorded, then pick what this frame's should record. >
+	DebugDraw.Flush(GetWorld());
+	DebugDraw.UpdateCategories(GetOwner());
+#endif
 }
 
-void UHBPlayerCollisionComponent::SubstepTick(float _DeltaTime, FBodyInstance* _BodyInstance)
+void UHBPlayerCollisionComponent::RefreshQueryParams()
 {
-	TraceFloor(_BodyInstance);
-	TraceWall(_BodyInstance);
+	QueryParams = FCollisionQueryParams(SCENE_QUERY_STAT(HBMovementTrace), false, GetOwner());
+	QueryParams.bReturnPhysicalMaterial = true; //< For the surface profiles, instead of a query of their own. >
+	ResponseParams = FCollisionResponseParams::DefaultResponseParam;
+	ObjectQueryParams = (MovementObjectTypes.Num() > 0) ? FCollisionObjectQueryParams(MovementObjectTypes) : FCollisionObjectQueryParams();
 }
 
-void UHBPlayerCollisionComponent::TraceFloor(FBodyInstance* _BodyInstance)
+bool UHBPlayerCollisionComponent::TraceMovement(FHitResult& _OutHit, FVector _Start, FVector _End, const FCollisionShape& _Shape) const
 {
-	FHitResult outHit;
+	INC_DWORD_STAT(STAT_HBMovementQueries);
 
-	FVector start = _BodyInstance->GetUnrealWorldTransform().GetTranslation();
-	FVector end = start + (FVector::DownVector * 9999);
+	if (ObjectQueryParams.IsValid())
+	{
+		return GetWorld()->SweepSingleByObjectType(_OutHit, _Start, _End, FQuat::Identity, ObjectQueryParams, _Shape, QueryParams);
+	}
+	return GetWorld()->SweepSingleByChannel(_OutHit, _Start, _End, FQuat::Identity, ECC_HBMovement, _Shape, QueryParams, ResponseParams);
+}
 
-	FCollisionQueryParams CollisionParams;
-	CollisionParams.AddIgnoredActor(this->GetOwner());
+void UHBPlayerCollisionComponent::CountCandidates(FVector _Start, FVector _End, float _Radius) const
+{
+	if (CVarMovementQueryStats.GetValueOnAnyThread() == 0) return;
 
-	//< Update our distance to ground & ground normal. >
-	bool hit = GetWorld()->SweepSingleByChannel(outHit, start, end, FQuat::Identity, ECC_Visibility, FCollisionShape::MakeSphere(CapsuleComponent->GetScaledCapsuleRadius() * 0.95f), CollisionParams);
+	//< Everything overlapping the swept bounds is a candidate the narrow phase may have to test. >
+	FVector center = (_Start + _End) * 0.5f;
+	FCollisionShape bounds = FCollisionShape::MakeBox((_End - _Start).GetAbs() * 0.5f + FVector(_Radius));
+
+	TArray<FOverlapResult> overlaps;
+	GetWorld()->OverlapMultiByChannel(overlaps, center, FQuat::Identity, ECC_HBMovement, bounds, QueryParams, ResponseParams);
+	INC_DWORD_STAT_BY(STAT_HBMovementCandidates, overlaps.Num());
 
-	GroundDistance	= (hit) ? start.Z - outHit.ImpactPoint.Z - CapsuleComponent->GetScaledCapsuleHalfHeight() : 9999;
-	GroundNormal	= (hit) ? outHit.ImpactNormal : FVector::UpVector;
+	overlaps.Reset();
+	GetWorld()->OverlapMultiByChannel(overlaps, center, FQuat::Identity, ECC_Visibility, bounds, QueryParams, ResponseParams);
+	INC_DWORD_STAT_BY(STAT_HBVisibilityCandidates, overlaps.Num());
 }
 
-void UHBPlayerCollisionComponent::TraceWall(FBodyInstance* _BodyInstance)
+void UHBPlayerCollisionComponent::SubstepTick(float _DeltaTime, const FHBBodySnapshot& _Body)
 {
-	FTransform bodyTransform = _BodyInstance->GetUnrealWorldTransform();
-	FVector start = bodyTransform.GetTranslation();
+	RecordHitboxSample(_DeltaTime, _Body);
+	QueryContact(_Body);
+}
+
+void UHBPlayerCollisionComponent::QueryContact(const FHBBodySnapshot& _Body)
+{
+	Contact.SampleLocation = _Body.Transform.GetTranslation();
+	Contact.SampleHalfHeight = CapsuleComponent->GetScaledCapsuleHalfHeight();
 
-	FCollisionQueryParams CollisionParams;
-	CollisionParams.AddIgnoredActor(this->GetOwner());
+	Contact.GroundNearDistance		= GroundNearDistance;
+	Contact.GroundContactDistance	= GroundContactDistance;
+	Contact.WallNearDistance		= WallNearDistance;
+	Contact.WallContactDistance		= WallContactDistance;
+
+	TraceFloor(_Body);
+	TraceWall(_Body);
+}
+
+void UHBPlayerCollisionComponent::CoastSubstep(float _DeltaTime, const FHBBodySnapshot& _Body)
+{
+	RecordHitboxSample(_DeltaTime, _Body);
+
+	Contact = Contact.ExtrapolatedTo(_Body.Transform.GetTranslation(), CapsuleComponent->GetScaledCapsuleHalfHeight());
+	Contact.GroundDistance = FMath::Max(Contact.GroundDistance, GroundNearDistance);
+	Contact.WallDistance = FMath::Max(Contact.WallDistance, WallNearDistance);
+}
+
+float UHBPlayerCollisionComponent::SweepPath(TArrayView<const FVector> _Path, TArrayView<const float> _Inflations)
+{
+	check(_Inflations.Num() >= _Path.Num() - 1);
+
+	const float reach = FMath::Max(GroundNearDistance, WallNearDistance);
+	const float radius = CapsuleComponent->GetScaledCapsuleRadius() + reach;
+	const float halfHeight = CapsuleComponent->GetScaledCapsuleHalfHeight() + reach;
+
+	//< In order, so a flight that is blocked early costs a single sweep. >
+	for (int32 i = 0; i + 1 < _Path.Num(); i++)
+	{
+		FCollisionShape shape = FCollisionShape::MakeCapsule(radius + _Inflations[i], halfHeight + _Inflations[i]);
 
+		FHitResult hit;
+		bool blocked = TraceMovement(hit, _Path[i], _Path[i + 1], shape);
+		HB_MOVEMENT_DEBUG_DRAW(DebugDraw, Ballistic, Line(_Path[i], (blocked) ? hit.Location : _Path[i + 1], (blocked) ? FColor::Red : FColor::Emerald));
+
+		if (blocked)
+		{
+			HB_MOVEMENT_DEBUG_DRAW(DebugDraw, Ballistic, Point(hit.ImpactPoint, FColor::Red));
+			return i + ((hit.bStartPenetrating) ? 0 : hit.Time);
+		}
+	}
+	return _Path.Num() - 1;
+}
+
+void UHBPlayerCollisionComponent::RecordHitboxSample(float _DeltaTime, const FHBBodySnapshot& _Body)
+{
+	FHBHitboxSample sample;
+	sample.Time			= SubstepClock;
+	sample.Location		= _Body.Transform.GetTranslation();
+	sample.Rotation		= _Body.Transform.GetRotation();
+	sample.HalfHeight	= CapsuleComponent->GetScaledCapsuleHalfHeight();
+	sample.Radius		= CapsuleComponent->GetScaledCapsuleRadius();
+
+	HitboxHistory.Record(sample);
+	SubstepClock += _DeltaTime;
+}
+
+void UHBPlayerCollisionComponent::TraceFloor(const FHBBodySnapshot& _Body)
+{
+	FHitResult outHit;
+
+	FVector start = _Body.Transform.GetTranslation();
+	FVector end = start + (FVector::DownVector * 9999);
+
+	//< Update our distance to ground & ground normal. >
+	float radius = CapsuleComponent->GetScaledCapsuleRadius() * 0.95f;
+	bool hit = TraceMovement(outHit, start, end, FCollisionShape::MakeSphere(radius));
+	CountCandidates(start, end, radius);
+
+	Contact.GroundDistance		= (hit) ? start.Z - outHit.ImpactPoint.Z - CapsuleComponent->GetScaledCapsuleHalfHeight() : 9999;
+	Contact.GroundNormal		= (hit) ? outHit.ImpactNormal : FVector::UpVector;
+	Contact.GroundImpactPoint	= (hit) ? outHit.ImpactPoint : FVector::ZeroVector;
+	Contact.GroundMaterial		= (hit) ? outHit.PhysMaterial.Get() : nullptr;
+
+#if HB_WITH_MOVEMENT_DEBUG_DRAW
+	//< Sweep down to where the sphere stopped, coloured by contact / near / airborne, & the ground normal. >
+	if (hit && DebugDraw.IsEnabled(HBMovementDebugDraw::Ground))
+	{
+		FColor color = (Contact.ContactWithGround()) ? FColor::Green : (Contact.IsNearGround()) ? FColor::Yellow : FColor::Red;
+		DebugDraw.Line(start, outHit.Location, color);
+		DebugDraw.Sphere(outHit.Location, radius, color);
+		DebugDraw.Arrow(outHit.ImpactPoint, outHit.ImpactPoint + outHit.ImpactNormal * 50, FColor::Blue);
+	}
+#endif
+}
+
+void UHBPlayerCollisionComponent::TraceWall(const FHBBodySnapshot& _Body)
+{
+	FVector start = _Body.Transform.GetTranslation();
 
 	//< Use sphere trace to find closest wall point. >
 	FHitResult outHitSphere;
 	FVector sphereEnd = start + FVector::UpVector;
+	float radius = CapsuleComponent->GetScaledCapsuleRadius() + WallNearDistance;
+	CountCandidates(start, sphereEnd, radius);
+
+	bool sphereHit = TraceMovement(outHitSphere, start, sphereEnd, FCollisionShape::MakeSphere(radius));
+	HB_MOVEMENT_DEBUG_DRAW(DebugDraw, Wall, Sphere(start, radius, (sphereHit) ? FColor::Cyan : FColor::Silver));
 
-	if (GetWorld()->SweepSingleByChannel(outHitSphere, start, sphereEnd, FQuat::Identity, ECC_Visibility, FCollisionShape::MakeSphere(CapsuleComponent->GetScaledCapsuleRadius() + WallNearDistance), CollisionParams))
+	if (sphereHit)
 	{
 
 		//< Perform line trace using sphere trace impact point. This avoids the resulting impact normal being generated along the nearest edge. >
 		FVector directionVector = (outHitSphere.ImpactPoint - start).GetSafeNormal();
 		FVector end = start + (directionVector * (FVector::Distance(start, outHitSphere.ImpactPoint) + 5));
 		FHitResult outHit;
+		HB_MOVEMENT_DEBUG_DRAW(DebugDraw, Wall, Line(start, end, FColor::Cyan));
 
-		if (GetWorld()->LineTraceSingleByChannel(outHit, start, end, ECollisionChannel::ECC_Visibility, CollisionParams))
+		if (TraceMovement(outHit, start, end, FCollisionShape::LineShape))
 		{
-			WallDistance	= FVector::Distance(UHBMathLibrary::FlattenOnAxis(start, FVector::UpVector), UHBMathLibrary::FlattenOnAxis(outHit.ImpactPoint, FVector::UpVector)) - CapsuleComponent->GetScaledCapsuleRadius();
-			WallImpactPoint = outHit.ImpactPoint;
-			WallNormal		= outHit.ImpactNormal;
+			HB_MOVEMENT_DEBUG_DRAW(DebugDraw, Wall, Arrow(outHit.ImpactPoint, outHit.ImpactPoint + outHit.ImpactNormal * 50, FColor::Blue));
+			Contact.WallDistance	= FVector::Distance(UHBMathLibrary::FlattenOnAxis(start, FVector::UpVector), UHBMathLibrary::FlattenOnAxis(outHit.ImpactPoint, FVector::UpVector)) - CapsuleComponent->GetScaledCapsuleRadius();
+			Contact.WallImpactPoint = outHit.ImpactPoint;
+			Contact.WallNormal		= outHit.ImpactNormal;
+			Contact.WallMaterial	= outHit.PhysMaterial.Get();
+			Contact.LedgeHeight		= 9999;
+
+			if (LedgeProbeHeight > 0) ProbeLedge(_Body, outHit);
 			return;
 		}
 	}
-	WallDistance	= 9999;
-	WallImpactPoint = FVector::ZeroVector;
-	WallNormal		= FVector::ZeroVector;
+	Contact.WallDistance	= 9999;
+	Contact.WallImpactPoint = FVector::ZeroVector;
+	Contact.WallNormal		= FVector::ZeroVector;
+	Contact.WallMaterial	= nullptr;
+	Contact.LedgeHeight		= 9999;
+}
+
+void UHBPlayerCollisionComponent::ProbeLedge(const FHBBodySnapshot& _Body, const FHitResult& _WallHit)
+{
+	//< From LedgeProbeHeight above the feet down to them, a capsule radius past the wall face. >
+	float feet = _Body.Transform.GetTranslation().Z - CapsuleComponent->GetScaledCapsuleHalfHeight();
+	FVector intoWall = -FVector(_WallHit.ImpactNormal.X, _WallHit.ImpactNormal.Y, 0).GetSafeNormal();
+
+	FVector start = _WallHit.ImpactPoint + intoWall * CapsuleComponent->GetScaledCapsuleRadius();
+	start.Z = feet + LedgeProbeHeight;
+	FVector end = FVector(start.X, start.Y, feet);
+
+	//< Starting inside the wall means it is taller than anything the probe is looking for. Only walkable tops count. >
+	FHitResult outHit;
+	if (!TraceMovement(outHit, start, end, FCollisionShape::LineShape) || outHit.bStartPenetrating || outHit.ImpactNormal.Z < 0.7f) return;
+
+	Contact.LedgePoint	= outHit.ImpactPoint;
+	Contact.LedgeHeight = outHit.ImpactPoint.Z - feet;
+	HB_MOVEMENT_DEBUG_DRAW(DebugDraw, Wall, Point(outHit.ImpactPoint, FColor::Orange));
+}
+
+void UHBPlayerCollisionComponent::ProbeGround(FVector _Location, float _HalfHeight, FHBMovementContact& _Contact) const
+{
+	FHitResult outHit;
+	FVector end = _Location + (FVector::DownVector * 9999);
+
+	bool hit = TraceMovement(outHit, _Location, end, FCollisionShape::LineShape);
+
+	_Contact.SampleLocation		= _Location;
+	_Contact.SampleHalfHeight	= _HalfHeight;
+	_Contact.GroundDistance		= (hit) ? _Location.Z - outHit.ImpactPoint.Z - _HalfHeight : 9999;
+	_Contact.GroundNormal		= (hit) ? outHit.ImpactNormal : FVector::UpVector;
+	_Contact.GroundImpactPoint	= (hit) ? outHit.ImpactPoint : FVector::ZeroVector;
+	_Contact.GroundMaterial		= (hit) ? outHit.PhysMaterial.Get() : nullptr;
 }
@@ -5,6 +5,9 @@
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
 #include "PhysicsEngine/BodyInstance.h"
+#include "HBMovementTypes.h"
+#include "HBMovementDebugDraw.h"
+#include "../Combat/HBHitboxHistory.h"
 #include "HBPlayerCollisionComponent.generated.h"
 
 class UCapsuleComponent;
@@ -19,21 +22,63 @@ public:
 	UHBPlayerCollisionComponent();
 
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
-	virtual void SubstepTick(float _DeltaTime, FBodyInstance* _BodyInstance);
+	virtual void SubstepTick(float _DeltaTime, const FHBBodySnapshot& _Body);
+
+	//< For sub steps the movement skips. Keeps the hitbox history at full rate without running any queries. >
+	void SkipSubstep(float _DeltaTime, const FHBBodySnapshot& _Body) { RecordHitboxSample(_DeltaTime, _Body); }
+
+	//< For poses that no sub step placed, e.g. interpolated remote characters. Stamped _Time rather than the sub step clock. >
+	void RecordPose(float _Time, const FHBBodySnapshot& _Body) { SubstepClock = _Time; RecordHitboxSample(0, _Body); }
+
+	//< The ground & wall queries of a sub step without recording a hitbox pose, for resimulation. >
+	void QueryContact(const FHBBodySnapshot& _Body);
+
+	//< For sub steps inside a flight SweepPath found clear. Records the hitbox & carries the contact along as planes, without queries. >
+	// Nothing is within reach until the flight's first possible contact, so ground & wall are kept at least their near distances away.
+	void CoastSubstep(float _DeltaTime, const FHBBodySnapshot& _Body);
+
+	//< Sweeps the capsule along the polyline _Path, grown on every side by the segment's _Inflations entry plus the near distances. >
+	// Returns where the first hit is as segment index plus fraction, or the number of segments if the path is clear.
+	float SweepPath(TArrayView<const FVector> _Path, TArrayView<const float> _Inflations);
+
+	//< For UHBMovementComponent::SaveState & RestoreState. >
+	float GetSubstepClock() const { return SubstepClock; }
+	void RestoreQueries(const FHBMovementContact& _Contact, float _SubstepClock) { Contact = _Contact; SubstepClock = _SubstepClock; }
 	
-	float GetDistanceToGround()		{ return GroundDistance;	}
-	float GetDistanceToWall()		{ return WallDistance;		}
+	float GetDistanceToGround()		{ return Contact.GroundDistance;	}
+	float GetDistanceToWall()		{ return Contact.WallDistance;		}
+
+	FVector GetGroundNormal()		{ return Contact.GroundNormal;		}
+	FVector GetWallNormal()			{ return Contact.WallNormal;		}
+	FVector GetWallImpactPoint()	{ return Contact.WallImpactPoint;	}
+
+	bool IsNearGround()				{ return Contact.IsNearGround();		}
+	bool IsNearWall()				{ return Contact.IsNearWall();			}
+
+	bool ContactWithGround()		{ return Contact.ContactWithGround();	}
+	bool ContactWithWall()			{ return Contact.ContactWithWall();		}
+
+	//< Results of the last sub step's queries. >
+	const FHBMovementContact& GetContact() const { return Contact; }
+
+	//< Single line trace straight down from _Location, refreshing the ground part of _Contact. Safe to call off the game thread. >
+	void ProbeGround(FVector _Location, float _HalfHeight, FHBMovementContact& _Contact) const;
 
-	FVector GetGroundNormal()		{ return GroundNormal;		}
-	FVector GetWallNormal()			{ return WallNormal;		}
-	FVector GetWallImpactPoint()	{ return WallImpactPoint;	}
+	//< Capsule poses recorded every sub step, used for lag compensated hit tests. See @UHBHitboxRewindSubsystem. >
+	const FHBHitboxHistory& GetHitboxHistory() const { return HitboxHistory; }
 
-	bool IsNearGround()				{ return (GroundDistance < GroundNearDistance);		}
-	bool IsNearWall()				{ return (WallDistance < WallNearDistance);			}
+	//< Whether rewound & batched hit tests see this character. Pooled characters are left out. >
+	void SetHitboxRegistered(bool _Registered);
 
-	bool ContactWithGround()		{ return (GroundDistance < GroundContactDistance);	}
-	bool ContactWithWall()			{ return (WallDistance < WallContactDistance);		}
+	//< Forgets the contact & hitbox poses of a previous life, see AHBPhysicsCharacter::RespawnAt. >
+	void ResetForRespawn();
+
+#if HB_WITH_MOVEMENT_DEBUG_DRAW
+	//< Shapes recorded by this character's sub steps, drawn on the next tick. See hb.Movement.DebugDraw. >
+	FHBMovementDebugDraw& GetDebugDraw() { return DebugDraw; }
+#endif
 
 
 	//< The CapsuleComponent being used for movement collision. >
@@ -52,14 +97,43 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 		float WallContactDistance = 5.0f;
 
+	//< If set, ground & wall queries only return these object types instead of everything blocking ECC_HBMovement. >
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Queries")
+		TArray<TEnumAsByte<EObjectTypeQuery>> MovementObjectTypes;
+
+	//< Highest ledge above the bottom of the capsule the wall query looks for. 0 skips the ledge probe. >
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Queries")
+		float LedgeProbeHeight = 0;
+
+	//< Rebuilds the cached query params, e.g. after changing MovementObjectTypes. >
+	UFUNCTION(BlueprintCallable, Category = "Queries")
+		void RefreshQueryParams();
+
 private:
-	void TraceFloor(FBodyInstance* _BodyInstance);
-	void TraceWall(FBodyInstance* _BodyInstance);
+	void TraceFloor(const FHBBodySnapshot& _Body);
+	void TraceWall(const FHBBodySnapshot& _Body);
+
+	//< Line down onto the top of the wall hit by TraceWall. >
+	void ProbeLedge(const FHBBodySnapshot& _Body, const FHitResult& _WallHit);
+
+	//< Single sweep against the movement channel, or a line trace if _Shape is a line. >
+	bool TraceMovement(FHitResult& _OutHit, FVector _Start, FVector _End, const FCollisionShape& _Shape) const;
+
+	//< See hb.Movement.QueryStats. >
+	void CountCandidates(FVector _Start, FVector _End, float _Radius) const;
+
+	void RecordHitboxSample(float _DeltaTime, const FHBBodySnapshot& _Body);
+
+	FHBMovementContact Contact;
+
+	FCollisionQueryParams QueryParams;
+	FCollisionResponseParams ResponseParams;
+	FCollisionObjectQueryParams ObjectQueryParams;
 
-	FVector GroundNormal	= FVector::UpVector;
-	FVector WallNormal		= FVector::ZeroVector;
-	FVector WallImpactPoint	= FVector::ZeroVector;
+	FHBHitboxHistory HitboxHistory;
+	float SubstepClock = 0; //< World time at the start of the current sub step. >
 
-	float GroundDistance	= 0;
-	float WallDistance		= 0;
+#if HB_WITH_MOVEMENT_DEBUG_DRAW
+	FHBMovementDebugDraw DebugDraw;
+#endif
 };
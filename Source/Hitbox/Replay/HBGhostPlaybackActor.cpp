@@ -0,0 +1,143 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HBGhostPlaybackActor.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+
+AHBGhostPlaybackActor::AHBGhostPlaybackActor()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	//< Proxies are purely visual. >
+	GhostInstances = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("GhostInstances"));
+	GhostInstances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	GhostInstances->SetGenerateOverlapEvents(false);
+	GhostInstances->SetCastShadow(false);
+	GhostInstances->SetMobility(EComponentMobility::Movable);
+	RootComponent = GhostInstances;
+}
+
+void AHBGhostPlaybackActor::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (GhostMesh)
+	{
+		GhostInstances->SetStaticMesh(GhostMesh);
+		MeshExtent = GhostMesh->GetBounds().BoxExtent.ComponentMax(FVector(1));
+	}
+
+	for (const FString& file : ReplayFiles)
+	{
+		AddGhost(file);
+	}
+}
+
+void AHBGhostPlaybackActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UpdateTask.IsValid()) UpdateTask.Wait();
+	Super::EndPlay(EndPlayReason);
+}
+
+int32 AHBGhostPlaybackActor::AddGhost(const FString& _Filename)
+{
+	WaitForUpdate();
+
+	FGhost ghost;
+	ghost.Reader = MakeUnique<FHBReplayReader>();
+	if (!ghost.Reader->Open(HBReplay::ResolveFilename(_Filename))) return INDEX_NONE;
+
+	//< Zero scale keeps the new instance hidden until its first update lands. >
+	FTransform hidden(FQuat::Identity, GetActorLocation(), FVector::ZeroVector);
+	GhostInstances->AddInstanceWorldSpace(hidden);
+	PendingTransforms.Add(hidden);
+	return Ghosts.Add(MoveTemp(ghost));
+}
+
+void AHBGhostPlaybackActor::ClearGhosts()
+{
+	WaitForUpdate();
+	Ghosts.Empty();
+	PendingTransforms.Empty();
+	GhostInstances->ClearInstances();
+}
+
+void AHBGhostPlaybackActor::Tick(float _DeltaTime)
+{
+	Super::Tick(_DeltaTime);
+
+	//< Hand last frame's results to the renderer in one batch. >
+	WaitForUpdate();
+	if (Ghosts.Num() == 0) return;
+
+	PlaybackTime += _DeltaTime * PlaybackRate;
+
+	//< Next frame's transforms are worked out while the rest of this frame runs. >
+	double time = PlaybackTime;
+	UpdateTask = Async(EAsyncExecution::TaskGraph, [this, time]()
+	{
+		ParallelFor(Ghosts.Num(), [this, time](int32 _Index)
+		{
+			UpdateGhost(Ghosts[_Index], time, PendingTransforms[_Index]);
+		});
+	});
+}
+
+void AHBGhostPlaybackActor::WaitForUpdate()
+{
+	if (!UpdateTask.IsValid()) return;
+
+	UpdateTask.Wait();
+	UpdateTask = TFuture<void>();
+
+	if (PendingTransforms.Num() > 0 && GhostInstances->GetInstanceCount() == PendingTransforms.Num())
+	{
+		GhostInstances->BatchUpdateInstancesTransforms(0, PendingTransforms, true, true, true);
+	}
+}
+
+void AHBGhostPlaybackActor::UpdateGhost(FGhost& _Ghost, double _Time, FTransform& _OutTransform) const
+{
+	const FHBReplayReader& reader = *_Ghost.Reader;
+	double duration = reader.GetDuration();
+	double time = (Loop && duration > 0) ? FMath::Fmod(_Time, duration) : FMath::Min(_Time, duration);
+
+	//< Looped, scrubbed or skipped far ahead, start again from the nearest keyframe. >
+	if (!_Ghost.Cursor.Valid || time < _Ghost.PreviousTime || time > _Ghost.Cursor.Time + 1.0)
+	{
+		FHBReplayCursor cursor;
+		if (!reader.Seek(time, cursor)) return;
+
+		_Ghost.Cursor = cursor;
+		_Ghost.PreviousTime = cursor.Time;
+		_Ghost.Previous = reader.GetState(cursor);
+		_Ghost.Current = _Ghost.Previous;
+	}
+
+	//< Stream forward until the cursor brackets the sample time. >
+	while (_Ghost.Cursor.Time < time)
+	{
+		FHBReplayCursor next = _Ghost.Cursor;
+		if (!reader.Next(next)) break;
+
+		_Ghost.PreviousTime = _Ghost.Cursor.Time;
+		_Ghost.Previous = _Ghost.Current;
+		_Ghost.Cursor = next;
+		_Ghost.Current = reader.GetState(next);
+	}
+
+	double span = _Ghost.Cursor.Time - _Ghost.PreviousTime;
+	float alpha = (span > 0) ? (float)FMath::Clamp((time - _Ghost.PreviousTime) / span, 0.0, 1.0) : 1.0f;
+
+	const FHBMovementState& a = _Ghost.Previous;
+	const FHBMovementState& b = _Ghost.Current;
+	FVector location = FMath::Lerp(a.Location, b.Location, alpha);
+	float yaw = a.Yaw + FMath::FindDeltaAngleDegrees(a.Yaw, b.Yaw) * alpha;
+	float halfHeight = FMath::Lerp(a.CapsuleHalfHeight, b.CapsuleHalfHeight, alpha);
+
+	FVector scale(GhostRadius / MeshExtent.X, GhostRadius / MeshExtent.Y, halfHeight / MeshExtent.Z);
+	_OutTransform = FTransform(FRotator(0, yaw, 0), location, scale);
+}
@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Async/Future.h"
+#include "HBReplayFile.h"
+#include "HBGhostPlaybackActor.generated.h"
+
+class UInstancedStaticMeshComponent;
+class UStaticMesh;
+
+//< Plays back any number of recorded runs as physics free instanced proxies. >
+// Replays are streamed through their memory mapping & interpolated on worker threads. The game thread only hands the finished
+// transforms of the previous frame to the instanced mesh in one batch, so the ghosts trail the playback clock by a frame.
+UCLASS()
+class HITBOX_API AHBGhostPlaybackActor : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AHBGhostPlaybackActor();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void Tick(float _DeltaTime) override;
+
+	//< Relative names are looked up in Saved/Replays. Returns the ghost index or INDEX_NONE. >
+	UFUNCTION(BlueprintCallable, Category = "Ghosts")
+		int32 AddGhost(const FString& _Filename);
+
+	UFUNCTION(BlueprintCallable, Category = "Ghosts")
+		void ClearGhosts();
+
+	UFUNCTION(BlueprintCallable, Category = "Ghosts")
+		void SetPlaybackTime(float _Time) { PlaybackTime = _Time; }
+
+	UFUNCTION(BlueprintPure, Category = "Ghosts")
+		int32 NumGhosts() const { return Ghosts.Num(); }
+
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	//< CONFIGURATION >
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ghosts")
+		TArray<FString> ReplayFiles; //< Loaded on BeginPlay. >
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ghosts")
+		UStaticMesh* GhostMesh;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ghosts")
+		float GhostRadius = 26;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ghosts")
+		float PlaybackRate = 1;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ghosts")
+		bool Loop = true;
+
+private:
+	struct FGhost
+	{
+		TUniquePtr<FHBReplayReader> Reader;
+		FHBReplayCursor Cursor; //< Sub step at or after the sample time. >
+		FHBMovementState Previous;
+		FHBMovementState Current;
+		double PreviousTime = 0;
+	};
+
+	//< Moves the ghost's cursor to _Time & writes its interpolated transform. Runs on worker threads. >
+	void UpdateGhost(FGhost& _Ghost, double _Time, FTransform& _OutTransform) const;
+
+	void WaitForUpdate();
+
+	TArray<FGhost> Ghosts;
+	TArray<FTransform> PendingTransforms; //< Written by the update task, read once it has finished. >
+	TFuture<void> UpdateTask;
+
+	double PlaybackTime = 0;
+	FVector MeshExtent = FVector(50);
+
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	//< COMPONENTS >
+private:
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
+		UInstancedStaticMeshComponent* GhostInstances;
+};
@@ -0,0 +1,570 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HBReplayFile.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/Event.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Async/MappedFileHandle.h"
+#include "Serialization/BitReader.h"
+#include "Misc/Paths.h"
+#include "HAL/IConsoleManager.h"
+
+namespace
+{
+	//< Fixed size fields are stored in native (little endian) order. Mapped data has no alignment guarantees, so go through memcpy. >
+	template<typename T>
+	T ReadRaw(const uint8* _Data)
+	{
+		T value;
+		FMemory::Memcpy(&value, _Data, sizeof(T));
+		return value;
+	}
+
+	template<typename T>
+	uint8* WriteRaw(uint8* _Data, T _Value)
+	{
+		FMemory::Memcpy(_Data, &_Value, sizeof(T));
+		return _Data + sizeof(T);
+	}
+
+	template<typename T>
+	void AppendRaw(TArray<uint8>& _Data, T _Value)
+	{
+		_Data.Append(reinterpret_cast<const uint8*>(&_Value), sizeof(T));
+	}
+
+	//< One line per step input field that differs, e.g. a missed jump shows up as its press counter. >
+	FString DescribeInputDifferences(const FHBMovementStepInput& _A, const FHBMovementStepInput& _B)
+	{
+		FString report;
+		auto describeCount = [&report](const TCHAR* _Name, uint32 _ValueA, uint32 _ValueB)
+		{
+			if (_ValueA != _ValueB) report += FString::Printf(TEXT("  %s: %u vs %u\n"), _Name, _ValueA, _ValueB);
+		};
+
+		if (_A.Input.MovementInput != _B.Input.MovementInput)
+		{
+			report += FString::Printf(TEXT("  MovementInput: %s vs %s\n"), *_A.Input.MovementInput.ToString(), *_B.Input.MovementInput.ToString());
+		}
+		if (_A.Input.SprintPressed != _B.Input.SprintPressed) report += FString::Printf(TEXT("  SprintPressed: %d vs %d\n"), _A.Input.SprintPressed, _B.Input.SprintPressed);
+		if (_A.Input.CrouchPressed != _B.Input.CrouchPressed) report += FString::Printf(TEXT("  CrouchPressed: %d vs %d\n"), _A.Input.CrouchPressed, _B.Input.CrouchPressed);
+		describeCount(TEXT("JumpPresses"), _A.JumpPresses, _B.JumpPresses);
+		describeCount(TEXT("CrouchPresses"), _A.CrouchPresses, _B.CrouchPresses);
+		describeCount(TEXT("CrouchReleases"), _A.CrouchReleases, _B.CrouchReleases);
+		describeCount(TEXT("SprintPresses"), _A.SprintPresses, _B.SprintPresses);
+		describeCount(TEXT("DashPresses"), _A.DashPresses, _B.DashPresses);
+		describeCount(TEXT("GrapplePresses"), _A.GrapplePresses, _B.GrapplePresses);
+		describeCount(TEXT("GrappleReleases"), _A.GrappleReleases, _B.GrappleReleases);
+		describeCount(TEXT("FrameSubsteps"), _A.FrameSubsteps, _B.FrameSubsteps);
+		if (_A.GrappleTarget != _B.GrappleTarget)
+		{
+			report += FString::Printf(TEXT("  GrappleTarget: %s vs %s\n"), *_A.GrappleTarget.ToString(), *_B.GrappleTarget.ToString());
+		}
+		if (_A.ConsumedRotationDelta != _B.ConsumedRotationDelta)
+		{
+			report += FString::Printf(TEXT("  ConsumedRotationDelta: %s vs %s\n"), *_A.ConsumedRotationDelta.ToString(), *_B.ConsumedRotationDelta.ToString());
+		}
+		if (_A.YawInput != _B.YawInput) report += FString::Printf(TEXT("  YawInput: %.6f vs %.6f\n"), _A.YawInput, _B.YawInput);
+		return report;
+	}
+}
+
+void HBReplay::WriteInput(uint8* _Data, const FHBMovementStepInput& _StepInput)
+{
+	uint8* cursor = _Data;
+	cursor = WriteRaw<float>(cursor, _StepInput.Input.MovementInput.X);
+	cursor = WriteRaw<float>(cursor, _StepInput.Input.MovementInput.Y);
+	cursor = WriteRaw<uint8>(cursor, (_StepInput.Input.SprintPressed ? 1 : 0) | (_StepInput.Input.CrouchPressed ? 2 : 0));
+	cursor = WriteRaw<uint8>(cursor, (uint8)FMath::Clamp(_StepInput.FrameSubsteps, 0, (int32)MAX_uint8));
+	cursor = WriteRaw<uint32>(cursor, _StepInput.JumpPresses);
+	cursor = WriteRaw<uint32>(cursor, _StepInput.CrouchPresses);
+	cursor = WriteRaw<uint32>(cursor, _StepInput.CrouchReleases);
+	cursor = WriteRaw<uint32>(cursor, _StepInput.SprintPresses);
+	cursor = WriteRaw<uint32>(cursor, _StepInput.DashPresses);
+	cursor = WriteRaw<uint32>(cursor, _StepInput.GrapplePresses);
+	cursor = WriteRaw<uint32>(cursor, _StepInput.GrappleReleases);
+	cursor = WriteRaw<float>(cursor, _StepInput.GrappleTarget.X);
+	cursor = WriteRaw<float>(cursor, _StepInput.GrappleTarget.Y);
+	cursor = WriteRaw<float>(cursor, _StepInput.GrappleTarget.Z);
+	cursor = WriteRaw<float>(cursor, _StepInput.ConsumedRotationDelta.Pitch);
+	cursor = WriteRaw<float>(cursor, _StepInput.ConsumedRotationDelta.Yaw);
+	cursor = WriteRaw<float>(cursor, _StepInput.ConsumedRotationDelta.Roll);
+	cursor = WriteRaw<double>(cursor, _StepInput.YawInput);
+	check(cursor - _Data == InputBytes);
+}
+
+FHBMovementStepInput HBReplay::ReadInput(const uint8* _Data)
+{
+	FHBMovementStepInput stepInput;
+	stepInput.Input.MovementInput.X = ReadRaw<float>(_Data);
+	stepInput.Input.MovementInput.Y = ReadRaw<float>(_Data + 4);
+	stepInput.Input.SprintPressed = (_Data[8] & 1) != 0;
+	stepInput.Input.CrouchPressed = (_Data[8] & 2) != 0;
+	stepInput.FrameSubsteps = _Data[9];
+	stepInput.JumpPresses = ReadRaw<uint32>(_Data + 10);
+	stepInput.CrouchPresses = ReadRaw<uint32>(_Data + 14);
+	stepInput.CrouchReleases = ReadRaw<uint32>(_Data + 18);
+	stepInput.SprintPresses = ReadRaw<uint32>(_Data + 22);
+	stepInput.DashPresses = ReadRaw<uint32>(_Data + 26);
+	stepInput.GrapplePresses = ReadRaw<uint32>(_Data + 30);
+	stepInput.GrappleReleases = ReadRaw<uint32>(_Data + 34);
+	stepInput.GrappleTarget = FVector(ReadRaw<float>(_Data + 38), ReadRaw<float>(_Data + 42), ReadRaw<float>(_Data + 46));
+	stepInput.ConsumedRotationDelta = FRotator(ReadRaw<float>(_Data + 50), ReadRaw<float>(_Data + 54), ReadRaw<float>(_Data + 58));
+	stepInput.YawInput = ReadRaw<double>(_Data + 62);
+	return stepInput;
+}
+
+FString HBReplay::ResolveFilename(const FString& _Filename)
+{
+	FString filename = _Filename;
+	if (FPaths::IsRelative(filename))
+	{
+		filename = FPaths::ProjectSavedDir() / TEXT("Replays") / filename;
+	}
+	if (FPaths::GetExtension(filename).IsEmpty())
+	{
+		filename += TEXT(".hbreplay");
+	}
+	return filename;
+}
+
+int32 HBReplay::Compare(const FString& _FilenameA, const FString& _FilenameB, FString& _OutReport)
+{
+	FHBReplayReader a;
+	FHBReplayReader b;
+	if (!a.Open(ResolveFilename(_FilenameA)) || !b.Open(ResolveFilename(_FilenameB)))
+	{
+		_OutReport = TEXT("Could not open both replays.");
+		return INDEX_NONE;
+	}
+
+	const FHBQuantizationSettings& settings = a.GetSerializer().GetSettings();
+	const FHBQuantizationSettings& settingsB = b.GetSerializer().GetSettings();
+	_OutReport.Reset();
+	if (settings.PositionPrecision != settingsB.PositionPrecision || settings.VelocityPrecision != settingsB.VelocityPrecision
+		|| settings.AnglePrecision != settingsB.AnglePrecision || settings.TimePrecision != settingsB.TimePrecision || settings.NormalBits != settingsB.NormalBits)
+	{
+		_OutReport = TEXT("Warning: the replays were quantized differently, their hashes can not match.\n");
+	}
+
+	FHBReplayCursor cursorA;
+	FHBReplayCursor cursorB;
+	uint32 substeps = 0;
+	for (;;)
+	{
+		bool nextA = a.Next(cursorA);
+		bool nextB = b.Next(cursorB);
+		if (!nextA || !nextB)
+		{
+			_OutReport += FString::Printf(TEXT("No divergence in %u sub steps."), substeps);
+			if (nextA != nextB) _OutReport += FString::Printf(TEXT(" Replay %s is longer."), (nextA) ? TEXT("A") : TEXT("B"));
+			return INDEX_NONE;
+		}
+
+		if (cursorA.Hash == cursorB.Hash)
+		{
+			substeps++;
+			continue;
+		}
+
+		//< The hash chains agreed up to the previous sub step, so this one's input or state differs. >
+		_OutReport += FString::Printf(TEXT("First divergent sub step %u (time %.4f vs %.4f, frame %llu vs %llu).\n"),
+			cursorA.SubstepIndex, cursorA.Time, cursorB.Time, cursorA.FrameNumber, cursorB.FrameNumber);
+
+		_OutReport += DescribeInputDifferences(cursorA.Input, cursorB.Input);
+		if (cursorA.DeltaTime != cursorB.DeltaTime)
+		{
+			_OutReport += FString::Printf(TEXT("  DeltaTime: %.6f vs %.6f\n"), cursorA.DeltaTime, cursorB.DeltaTime);
+		}
+		_OutReport += cursorA.State.DescribeDifferences(cursorB.State, settings);
+		return (int32)cursorA.SubstepIndex;
+	}
+}
+
+static FAutoConsoleCommand CompareReplaysCommand(
+	TEXT("hb.Replay.Compare"),
+	TEXT("hb.Replay.Compare <ReplayA> <ReplayB>: Reports the first sub step where two movement replays diverge & how their states differ."),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& _Args)
+	{
+		if (_Args.Num() < 2)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Usage: hb.Replay.Compare <ReplayA> <ReplayB>"));
+			return;
+		}
+
+		FString report;
+		HBReplay::Compare(_Args[0], _Args[1], report);
+		UE_LOG(LogTemp, Display, TEXT("%s"), *report);
+	}));
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//< WRITER >
+
+FHBReplayWriter::FHBReplayWriter(const FString& _Filename, const FHBQuantizationSettings& _Settings, int32 _KeyframeInterval)
+	: Bits(256 * 8, true)
+	, Serializer(_Settings)
+	, KeyframeInterval(FMath::Max(_KeyframeInterval, 1))
+{
+	FileWriter.Reset(IFileManager::Get().CreateFileWriter(*_Filename));
+	if (!FileWriter)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Could not open replay file %s for writing."), *_Filename);
+		return;
+	}
+
+	CurrentBlock.Reserve(HBReplay::BlockBytes);
+
+	//< Header. >
+	const FHBQuantizationSettings& settings = Serializer.GetSettings();
+	AppendRaw<uint32>(CurrentBlock, HBReplay::Magic);
+	AppendRaw<uint32>(CurrentBlock, HBReplay::Version);
+	AppendRaw<float>(CurrentBlock, settings.PositionPrecision);
+	AppendRaw<float>(CurrentBlock, settings.VelocityPrecision);
+	AppendRaw<float>(CurrentBlock, settings.AnglePrecision);
+	AppendRaw<float>(CurrentBlock, settings.TimePrecision);
+	AppendRaw<int32>(CurrentBlock, settings.NormalBits);
+	AppendRaw<int32>(CurrentBlock, KeyframeInterval);
+	check(CurrentBlock.Num() == HBReplay::HeaderBytes);
+	FileOffset = CurrentBlock.Num();
+
+	WorkEvent = FPlatformProcess::GetSynchEventFromPool();
+	Thread = FRunnableThread::Create(this, TEXT("HBReplayWriter"), 0, TPri_BelowNormal);
+}
+
+FHBReplayWriter::~FHBReplayWriter()
+{
+	Close();
+}
+
+void FHBReplayWriter::RecordSubstep(float _DeltaTime, const FHBMovementStepInput& _StepInput, const FHBMovementState& _State)
+{
+	if (!IsOpen()) return;
+
+	Time += _DeltaTime;
+	bool keyframe = (SubstepIndex % KeyframeInterval) == 0;
+
+	//< Keyframes repeat the input so that a seek never has to look further back. >
+	if (keyframe)
+	{
+		Index.Add({ Time, SubstepIndex, FileOffset });
+	}
+
+	uint8 input[HBReplay::InputBytes];
+	HBReplay::WriteInput(input, _StepInput);
+	if (keyframe || !HasInput || FMemory::Memcmp(input, PreviousInput, sizeof(input)) != 0)
+	{
+		AppendRecord(HBReplay::Record_Input, input, sizeof(input));
+		FMemory::Memcpy(PreviousInput, input, sizeof(input));
+		HasInput = true;
+	}
+
+	FHBQuantizedMovementState quantized = Serializer.Quantize(_State);
+	Hash = quantized.Hash(Hash);
+	{
+		uint8 prefix[12];
+		WriteRaw<uint64>(WriteRaw<uint32>(prefix, Hash), _StepInput.FrameNumber);
+		AppendRecord(HBReplay::Record_Hash, prefix, sizeof(prefix));
+	}
+
+	Bits.Reset();
+	Serializer.Write(Bits, quantized, (keyframe) ? nullptr : &PreviousState);
+
+	uint8 prefix[16];
+	uint8* cursor = prefix;
+	if (keyframe)
+	{
+		cursor = WriteRaw<double>(cursor, Time);
+		cursor = WriteRaw<uint32>(cursor, SubstepIndex);
+	}
+	cursor = WriteRaw<float>(cursor, _DeltaTime);
+	AppendRecord((keyframe) ? HBReplay::Record_Keyframe : HBReplay::Record_Substep, prefix, cursor - prefix, &Bits);
+
+	PreviousState = quantized;
+	SubstepIndex++;
+}
+
+void FHBReplayWriter::AppendRecord(uint8 _Type, const uint8* _Prefix, int32 _PrefixBytes, const FBitWriter* _Bits)
+{
+	int32 bitsBytes = (_Bits) ? (int32)_Bits->GetNumBytes() : 0;
+	int32 payloadBytes = _PrefixBytes + bitsBytes;
+	check(payloadBytes <= MAX_uint16);
+
+	CurrentBlock.Add(_Type);
+	AppendRaw<uint16>(CurrentBlock, (uint16)payloadBytes);
+	CurrentBlock.Append(_Prefix, _PrefixBytes);
+	if (bitsBytes > 0)
+	{
+		CurrentBlock.Append(_Bits->GetData(), bitsBytes);
+	}
+
+	FileOffset += HBReplay::RecordHeaderBytes + payloadBytes;
+
+	if (CurrentBlock.Num() >= HBReplay::BlockBytes)
+	{
+		FlushBlock();
+	}
+}
+
+void FHBReplayWriter::FlushBlock()
+{
+	if (CurrentBlock.Num() == 0) return;
+
+	PendingBlocks.Enqueue(MoveTemp(CurrentBlock));
+	CurrentBlock.Reset();
+	CurrentBlock.Reserve(HBReplay::BlockBytes);
+	WorkEvent->Trigger();
+}
+
+void FHBReplayWriter::Close()
+{
+	if (!IsOpen()) return;
+
+	//< Index & footer. >
+	uint64 indexOffset = FileOffset;
+	for (const FHBReplayIndexEntry& entry : Index)
+	{
+		AppendRaw<double>(CurrentBlock, entry.Time);
+		AppendRaw<uint32>(CurrentBlock, entry.SubstepIndex);
+		AppendRaw<uint64>(CurrentBlock, entry.Offset);
+	}
+	AppendRaw<uint64>(CurrentBlock, indexOffset);
+	AppendRaw<uint32>(CurrentBlock, (uint32)Index.Num());
+	AppendRaw<uint32>(CurrentBlock, HBReplay::Magic);
+	FlushBlock();
+
+	//< Let the writer thread drain the queue. >
+	Stop();
+	if (Thread)
+	{
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+	}
+	FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+	WorkEvent = nullptr;
+
+	FileWriter->Close();
+	FileWriter.Reset();
+	Index.Empty();
+}
+
+uint32 FHBReplayWriter::Run()
+{
+	TArray<uint8> block;
+	for (;;)
+	{
+		//< Read the flag before draining, anything queued before Stop() is then guaranteed to be written. >
+		bool stopping = StopRequested;
+
+		while (PendingBlocks.Dequeue(block))
+		{
+			FileWriter->Serialize(block.GetData(), block.Num());
+		}
+
+		if (stopping) break;
+		WorkEvent->Wait(100);
+	}
+	return 0;
+}
+
+void FHBReplayWriter::Stop()
+{
+	StopRequested = true;
+	if (WorkEvent) WorkEvent->Trigger();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//< READER >
+
+FHBReplayReader::FHBReplayReader()
+{
+}
+
+FHBReplayReader::~FHBReplayReader()
+{
+	Close();
+}
+
+bool FHBReplayReader::Open(const FString& _Filename)
+{
+	Close();
+
+	IPlatformFile& platformFile = FPlatformFileManager::Get().GetPlatformFile();
+	MappedFile.Reset(platformFile.OpenMapped(*_Filename));
+	if (!MappedFile)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Could not map replay file %s."), *_Filename);
+		return false;
+	}
+
+	Size = MappedFile->GetFileSize();
+	if (Size < HBReplay::HeaderBytes + HBReplay::FooterBytes)
+	{
+		Close();
+		return false;
+	}
+
+	MappedRegion.Reset(MappedFile->MapRegion(0, Size));
+	if (!MappedRegion)
+	{
+		Close();
+		return false;
+	}
+	Data = MappedRegion->GetMappedPtr();
+
+	//< Header. >
+	if (ReadRaw<uint32>(Data) != HBReplay::Magic || ReadRaw<uint32>(Data + 4) != HBReplay::Version)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s is not a replay file or was written by a different version."), *_Filename);
+		Close();
+		return false;
+	}
+
+	FHBQuantizationSettings settings;
+	settings.PositionPrecision = ReadRaw<float>(Data + 8);
+	settings.VelocityPrecision = ReadRaw<float>(Data + 12);
+	settings.AnglePrecision = ReadRaw<float>(Data + 16);
+	settings.TimePrecision = ReadRaw<float>(Data + 20);
+	settings.NormalBits = ReadRaw<int32>(Data + 24);
+	Serializer = FHBMovementSerializer(settings);
+	RecordsOffset = HBReplay::HeaderBytes;
+
+	//< Footer & index. A recording that was never closed has no footer & is rejected. >
+	const uint8* footer = Data + Size - HBReplay::FooterBytes;
+	IndexOffset = (int64)ReadRaw<uint64>(footer);
+	IndexCount = (int32)ReadRaw<uint32>(footer + 8);
+	if (ReadRaw<uint32>(footer + 12) != HBReplay::Magic
+		|| IndexOffset < RecordsOffset
+		|| IndexOffset + (int64)IndexCount * HBReplay::IndexEntryBytes != Size - HBReplay::FooterBytes)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Replay file %s has no valid index, it was probably not closed."), *_Filename);
+		Close();
+		return false;
+	}
+
+	FHBReplayCursor last;
+	Duration = (Seek(TNumericLimits<double>::Max(), last)) ? last.Time : 0;
+	return true;
+}
+
+void FHBReplayReader::Close()
+{
+	//< The region has to go before the file handle. >
+	MappedRegion.Reset();
+	MappedFile.Reset();
+	Data = nullptr;
+	Size = 0;
+	IndexOffset = 0;
+	IndexCount = 0;
+	Duration = 0;
+}
+
+FHBReplayIndexEntry FHBReplayReader::GetIndexEntry(int32 _Index) const
+{
+	const uint8* entry = Data + IndexOffset + (int64)_Index * HBReplay::IndexEntryBytes;
+
+	FHBReplayIndexEntry result;
+	result.Time = ReadRaw<double>(entry);
+	result.SubstepIndex = ReadRaw<uint32>(entry + 8);
+	result.Offset = ReadRaw<uint64>(entry + 12);
+	return result;
+}
+
+bool FHBReplayReader::Seek(double _Time, FHBReplayCursor& _OutCursor) const
+{
+	if (!IsOpen() || IndexCount == 0) return false;
+
+	//< Last keyframe at or before _Time, or the first one if _Time is before the recording. >
+	int32 low = 0;
+	int32 high = IndexCount - 1;
+	while (low < high)
+	{
+		int32 mid = (low + high + 1) / 2;
+		if (GetIndexEntry(mid).Time <= _Time) low = mid;
+		else high = mid - 1;
+	}
+
+	FHBReplayCursor cursor;
+	cursor.Offset = (int64)GetIndexEntry(low).Offset;
+	if (!Next(cursor)) return false;
+
+	//< Walk the deltas up to _Time. >
+	FHBReplayCursor peek = cursor;
+	while (Next(peek) && peek.Time <= _Time)
+	{
+		cursor = peek;
+	}
+
+	_OutCursor = cursor;
+	return true;
+}
+
+bool FHBReplayReader::Next(FHBReplayCursor& _Cursor) const
+{
+	if (!IsOpen()) return false;
+
+	int64 offset = FMath::Max(_Cursor.Offset, RecordsOffset);
+	while (offset + HBReplay::RecordHeaderBytes <= IndexOffset)
+	{
+		uint8 type = Data[offset];
+		int32 payloadBytes = ReadRaw<uint16>(Data + offset + 1);
+		const uint8* payload = Data + offset + HBReplay::RecordHeaderBytes;
+
+		offset += HBReplay::RecordHeaderBytes + payloadBytes;
+		if (offset > IndexOffset) return false;
+
+		switch (type)
+		{
+		case HBReplay::Record_Input:
+		{
+			if (payloadBytes < HBReplay::InputBytes) return false;
+			_Cursor.Input = HBReplay::ReadInput(payload);
+			break;
+		}
+		case HBReplay::Record_Hash:
+		{
+			if (payloadBytes < 12) return false;
+			_Cursor.Hash = ReadRaw<uint32>(payload);
+			_Cursor.FrameNumber = ReadRaw<uint64>(payload + 4);
+			break;
+		}
+		case HBReplay::Record_Keyframe:
+		case HBReplay::Record_Substep:
+		{
+			bool keyframe = (type == HBReplay::Record_Keyframe);
+			int32 prefixBytes = (keyframe) ? 16 : 4;
+			if (payloadBytes < prefixBytes) return false;
+
+			//< Deltas need the previous sub step as their baseline. >
+			if (!keyframe && !_Cursor.Valid) return false;
+
+			FBitReader reader(const_cast<uint8*>(payload + prefixBytes), (int64)(payloadBytes - prefixBytes) * 8);
+			FHBQuantizedMovementState decoded;
+			if (!Serializer.Read(reader, decoded, (keyframe) ? nullptr : &_Cursor.State) || reader.IsError()) return false;
+
+			if (keyframe)
+			{
+				_Cursor.Time = ReadRaw<double>(payload);
+				_Cursor.SubstepIndex = ReadRaw<uint32>(payload + 8);
+				_Cursor.DeltaTime = ReadRaw<float>(payload + 12);
+			}
+			else
+			{
+				_Cursor.DeltaTime = ReadRaw<float>(payload);
+				_Cursor.Time += _Cursor.DeltaTime;
+				_Cursor.SubstepIndex++;
+			}
+
+			_Cursor.State = decoded;
+			_Cursor.Offset = offset;
+			_Cursor.Valid = true;
+			return true;
+		}
+		default:
+			return false;
+		}
+	}
+	return false;
+}
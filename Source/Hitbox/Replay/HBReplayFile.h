@@ -0,0 +1,158 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "Containers/Queue.h"
+#include "Serialization/BitWriter.h"
+#include "../Pawns/HBMovementTypes.h"
+#include "../Net/HBMovementSerializer.h"
+
+class FRunnableThread;
+class FEvent;
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+//< On disk layout of a movement replay: >
+//  Header | Records... | Index | Footer
+//  Records are [uint8 Type][uint16 PayloadBytes][Payload]. Every sub step writes either a Keyframe (full state) or a Substep
+//  (state delta against the previous sub step). Input records hold the whole step input & are only written when it changes. A Hash record,
+//  holding the rolling state hash & the game frame, comes right before every state record.
+//  The index lists every keyframe, & the fixed-size footer at the very end of the file points at the index.
+namespace HBReplay
+{
+	static constexpr uint32 Magic = 0x50524248; // "HBRP"
+	static constexpr uint32 Version = 4; //< 3 added the ability state, 4 the whole step input. >
+
+	enum ERecordType : uint8
+	{
+		Record_Keyframe	= 1,
+		Record_Substep	= 2,
+		Record_Input	= 3,
+		Record_Hash		= 4,
+	};
+
+	static constexpr int32 HeaderBytes = 32;
+	static constexpr int32 RecordHeaderBytes = 3;
+	static constexpr int32 BlockBytes = 16 * 1024;
+	static constexpr int32 IndexEntryBytes = 20;
+	static constexpr int32 FooterBytes = 16;
+	static constexpr int32 InputBytes = 70;
+
+	//< Step input as stored in a Record_Input, exact so a replay can be resimulated from any keyframe: >
+	// stick X & Y, button flags, sub steps, the press & release counters, grapple target, consumed rotation & view yaw. FrameNumber is in the Hash record.
+	HITBOX_API void WriteInput(uint8* _Data, const FHBMovementStepInput& _StepInput);
+	HITBOX_API FHBMovementStepInput ReadInput(const uint8* _Data);
+
+	//< Relative names go to Saved/Replays & a missing extension becomes .hbreplay. >
+	HITBOX_API FString ResolveFilename(const FString& _Filename);
+
+	//< Walks two replays side by side & reports the first sub step whose state hashes differ, with a diff of the two states. >
+	// Returns that sub step's index, or INDEX_NONE if the replays agree for as long as both run. Also hb.Replay.Compare.
+	HITBOX_API int32 Compare(const FString& _FilenameA, const FString& _FilenameB, FString& _OutReport);
+}
+
+struct FHBReplayIndexEntry
+{
+	double Time = 0;
+	uint32 SubstepIndex = 0;
+	uint64 Offset = 0; //< File offset of the keyframe record. >
+};
+
+//< Position in a replay while reading. Advancing is cheap, so it doubles as a playback cursor. >
+struct FHBReplayCursor
+{
+	int64 Offset = 0; //< Next record to read. >
+	double Time = 0; //< Time at the end of the current sub step. >
+	float DeltaTime = 0;
+	uint32 SubstepIndex = 0;
+	FHBQuantizedMovementState State;
+	FHBMovementStepInput Input;
+	uint32 Hash = 0; //< Rolling hash up to & including this sub step, see FHBQuantizedMovementState::Hash. >
+	uint64 FrameNumber = 0; //< Game frame whose input the sub step ran with. >
+	bool Valid = false;
+};
+
+//< Streams a movement recording to disk. Records are encoded by the caller & written by a background thread. >
+// Recording is single producer, so all RecordSubstep calls must come from the same thread.
+class HITBOX_API FHBReplayWriter : public FRunnable
+{
+public:
+	FHBReplayWriter(const FString& _Filename, const FHBQuantizationSettings& _Settings = FHBQuantizationSettings(), int32 _KeyframeInterval = 120);
+	virtual ~FHBReplayWriter();
+
+	bool IsOpen() const { return FileWriter.IsValid(); }
+
+	void RecordSubstep(float _DeltaTime, const FHBMovementStepInput& _StepInput, const FHBMovementState& _State);
+
+	//< Writes the index & footer, then waits for the background thread to finish. >
+	void Close();
+
+	//< FRunnable >
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	void AppendRecord(uint8 _Type, const uint8* _Prefix, int32 _PrefixBytes, const FBitWriter* _Bits = nullptr);
+	void FlushBlock();
+
+	TUniquePtr<FArchive> FileWriter;
+	FRunnableThread* Thread = nullptr;
+	FEvent* WorkEvent = nullptr;
+	FThreadSafeBool StopRequested = false;
+
+	TQueue<TArray<uint8>, EQueueMode::Spsc> PendingBlocks;
+	TArray<uint8> CurrentBlock; //< Records are batched into blocks before being handed to the writer thread. >
+
+	FHBMovementSerializer Serializer;
+	FBitWriter Bits;
+	FHBQuantizedMovementState PreviousState;
+	uint8 PreviousInput[HBReplay::InputBytes] = {}; //< See HBReplay::WriteInput. >
+	uint32 Hash = 0;
+	bool HasInput = false;
+
+	TArray<FHBReplayIndexEntry> Index;
+	int32 KeyframeInterval = 120;
+	uint32 SubstepIndex = 0;
+	double Time = 0;
+	uint64 FileOffset = 0; //< Offset the next record will land at, tracked here so the index never waits on the writer. >
+};
+
+//< Reads a replay through a memory mapping, so only the pages being looked at are ever loaded. >
+class HITBOX_API FHBReplayReader
+{
+public:
+	FHBReplayReader();
+	~FHBReplayReader();
+
+	bool Open(const FString& _Filename);
+	void Close();
+	bool IsOpen() const { return Data != nullptr; }
+
+	double GetDuration() const { return Duration; }
+	int32 NumKeyframes() const { return IndexCount; }
+	const FHBMovementSerializer& GetSerializer() const { return Serializer; }
+
+	//< Positions the cursor on the last sub step at or before _Time. Costs one keyframe decode plus the deltas after it. >
+	bool Seek(double _Time, FHBReplayCursor& _OutCursor) const;
+
+	//< Advances the cursor by one sub step. Returns false at the end of the recording. >
+	bool Next(FHBReplayCursor& _Cursor) const;
+
+	FHBMovementState GetState(const FHBReplayCursor& _Cursor) const { return Serializer.Dequantize(_Cursor.State); }
+
+private:
+	FHBReplayIndexEntry GetIndexEntry(int32 _Index) const;
+
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	const uint8* Data = nullptr;
+	int64 Size = 0;
+
+	FHBMovementSerializer Serializer;
+	int64 RecordsOffset = 0;
+	int64 IndexOffset = 0;
+	int32 IndexCount = 0;
+	double Duration = 0;
+};
@@ -0,0 +1,175 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "../Lockstep/HBFixedMath.h"
+#include "../Lockstep/HBLockstepMovement.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace HBLockstepTests
+{
+	//< Fixed numbers rather than a component's, so the golden hashes don't move when the character is tuned. >
+	static FHBLockstepSettings MakeReferenceSettings()
+	{
+		FHBLockstepSettings settings;
+		settings.DeltaTime = FHBFixed::FromInt(1) / 60;
+		settings.Gravity = FHBFixed::FromInt(980);
+		settings.GroundAcceleration = FHBFixed::FromInt(4500);
+		settings.GroundDeceleration = FHBFixed::FromInt(4500);
+		settings.StickToGroundForce = FHBFixed::FromInt(15);
+		settings.CosMaxSlopeAngle = HBFixedMath::CosDeg(FHBFixed::FromInt(40));
+		settings.WalkSpeed = FHBFixed::FromInt(575);
+		settings.RunSpeed = FHBFixed::FromInt(800);
+		settings.CrouchSpeed = FHBFixed::FromInt(250);
+		settings.SlideForce = FHBFixed::FromInt(900);
+		settings.SlideDeceleration = FHBFixed::FromInt(500);
+		settings.AirSpeed = FHBFixed::FromInt(250);
+		settings.AirAcceleration = FHBFixed::FromInt(2000);
+		settings.AirDeceleration = FHBFixed::FromInt(100);
+		settings.JumpForce = FHBFixed::FromInt(700);
+		settings.SlideHopWindow = FHBFixed::FromInt(15) / 100;
+		settings.WallRunSpeed = FHBFixed::FromInt(900);
+		settings.WallRunAcceleration = FHBFixed::FromInt(1000);
+		settings.WallJumpForce = FHBFixed::FromInt(1000);
+		settings.WallRunDelay = FHBFixed::FromInt(3) / 10;
+		settings.StickToWallForce = FHBFixed::FromInt(35);
+		settings.CosMaxApproachVertical = HBFixedMath::CosDeg(FHBFixed::FromInt(15));
+		settings.CosMaxApproachHorizontal = HBFixedMath::CosDeg(FHBFixed::FromInt(120));
+		settings.WallRunDuration = FHBFixed::FromInt(2);
+		settings.StandingHalfHeight = FHBFixed::FromInt(86);
+		settings.CrouchedHalfHeight = FHBFixed::FromInt(43);
+		settings.CrouchTime = FHBFixed::FromInt(1) / 4;
+		settings.Radius = FHBFixed::FromInt(26);
+		settings.GroundNearDistance = FHBFixed::FromInt(20);
+		settings.GroundContactDistance = FHBFixed::FromInt(1) / 10;
+		settings.WallNearDistance = FHBFixed::FromInt(20);
+		settings.WallContactDistance = FHBFixed::FromInt(5);
+		return settings;
+	}
+
+	static FHBFixed Degrees(double _Degrees) { return FHBFixed::FromRaw(int64(_Degrees * FHBFixed::One)); }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHBLockstepDeterminismGoldenTest, "Hitbox.Lockstep.Determinism.Golden", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FHBLockstepDeterminismGoldenTest::RunTest(const FString& Parameters)
+{
+	using namespace HBLockstepTests;
+
+	//< The settings hash & the running hash after every 60th step of the 1800 step script, with MakeReferenceSettings. >
+	// A build that disagrees would desync against the others. Record them from a build of this tree: while they are empty the test
+	// warns with the values to paste here. Only change them again for a deliberate change to the simulation or the script.
+	const uint32 GoldenSettingsHash = 0;
+	static const TArray<uint32> GoldenHashes =
+	{
+	};
+	const int32 interval = 60;
+	const int32 steps = 30 * interval;
+
+	FHBLockstepSettings settings = MakeReferenceSettings();
+	TArray<uint32> hashes;
+	FHBLockstepMovement::RunDeterminismScript(settings, steps, hashes);
+	if (!TestEqual(TEXT("Hash count"), hashes.Num(), steps)) return false;
+
+	//< Holds even before anything is recorded: the same build has to agree with itself. >
+	TArray<uint32> repeatHashes;
+	FHBLockstepMovement::RunDeterminismScript(settings, steps, repeatHashes);
+	TestTrue(TEXT("Repeats within a build"), repeatHashes == hashes);
+
+	if (GoldenHashes.Num() == 0)
+	{
+		FString recorded;
+		for (int32 step = interval - 1; step < steps; step += interval) recorded += FString::Printf(TEXT("0x%08x, "), hashes[step]);
+		AddWarning(FString::Printf(TEXT("No golden hashes recorded yet. This build's settings hash is 0x%08x & its hashes are: %s"), settings.Hash(), *recorded));
+		return true;
+	}
+
+	TestTrue(TEXT("Settings hash"), settings.Hash() == GoldenSettingsHash);
+	if (!TestEqual(TEXT("Golden hash count"), GoldenHashes.Num() * interval, steps)) return false;
+	for (int32 i = 0; i < GoldenHashes.Num(); i++)
+	{
+		int32 step = (i + 1) * interval - 1;
+		if (hashes[step] != GoldenHashes[i])
+		{
+			//< Only the first, every later hash chains from it. >
+			AddError(FString::Printf(TEXT("Step %d hashes to %08x, the golden list has %08x."), step, hashes[step], GoldenHashes[i]));
+			break;
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHBFixedMathSqrtTest, "Hitbox.Lockstep.FixedMath.Sqrt", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FHBFixedMathSqrtTest::RunTest(const FString& Parameters)
+{
+	TestTrue(TEXT("Sqrt(0)"), HBFixedMath::Sqrt(FHBFixed()).Raw == 0);
+	TestTrue(TEXT("Sqrt(4)"), HBFixedMath::Sqrt(FHBFixed::FromInt(4)).Raw == FHBFixed::FromInt(2).Raw);
+	TestTrue(TEXT("Sqrt(0.25)"), HBFixedMath::Sqrt(FHBFixed::FromInt(1) / 4).Raw == FHBFixed::One / 2);
+	TestTrue(TEXT("Sqrt(1000000)"), HBFixedMath::Sqrt(FHBFixed::FromInt(1000000)).Raw == FHBFixed::FromInt(1000).Raw);
+	TestTrue(TEXT("Sqrt(2)"), HBFixedMath::Sqrt(FHBFixed::FromInt(2)).Raw == 92681);
+
+	//< Rounds down to the grid: the result squared never passes the input, one more step always does. >
+	FRandomStream random(47);
+	for (int32 i = 0; i < 1000; i++)
+	{
+		int64 raw = int64(random.RandRange(0, MAX_int32)) * random.RandRange(1, 64);
+		int64 root = HBFixedMath::Sqrt(FHBFixed::FromRaw(raw)).Raw;
+		if (root * root > raw * FHBFixed::One || (root + 1) * (root + 1) <= raw * FHBFixed::One)
+		{
+			AddError(FString::Printf(TEXT("Sqrt of raw %lld is raw %lld."), raw, root));
+			break;
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHBFixedMathTrigTest, "Hitbox.Lockstep.FixedMath.Trig", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FHBFixedMathTrigTest::RunTest(const FString& Parameters)
+{
+	using namespace HBLockstepTests;
+
+	TestTrue(TEXT("Sin(90)"), HBFixedMath::SinDeg(FHBFixed::FromInt(90)).Raw == FHBFixed::One);
+	TestTrue(TEXT("Sin(30)"), HBFixedMath::SinDeg(FHBFixed::FromInt(30)).Raw == FHBFixed::One / 2);
+	TestTrue(TEXT("Sin(-90)"), HBFixedMath::SinDeg(FHBFixed::FromInt(-90)).Raw == -FHBFixed::One);
+	TestTrue(TEXT("Cos(60)"), HBFixedMath::CosDeg(FHBFixed::FromInt(60)).Raw == FHBFixed::One / 2);
+	TestTrue(TEXT("Cos(180)"), HBFixedMath::CosDeg(FHBFixed::FromInt(180)).Raw == -FHBFixed::One);
+	TestTrue(TEXT("Sin(45)"), HBFixedMath::SinDeg(FHBFixed::FromInt(45)).Raw == 46341);
+
+	//< Within two steps of the grid everywhere, including outside one turn. >
+	double maxError = 0;
+	for (int32 tenths = -7200; tenths <= 7200; tenths += 7)
+	{
+		double degrees = tenths / 10.0;
+		double sinError = FMath::Abs(HBFixedMath::SinDeg(Degrees(degrees)).Raw - FMath::Sin(FMath::DegreesToRadians(degrees)) * FHBFixed::One);
+		double cosError = FMath::Abs(HBFixedMath::CosDeg(Degrees(degrees)).Raw - FMath::Cos(FMath::DegreesToRadians(degrees)) * FHBFixed::One);
+		maxError = FMath::Max(maxError, FMath::Max(sinError, cosError));
+	}
+	AddInfo(FString::Printf(TEXT("Largest sine & cosine error: %.2f steps."), maxError));
+	TestTrue(TEXT("Sine & cosine error below two steps"), maxError < 2);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHBFixedMathAsinTest, "Hitbox.Lockstep.FixedMath.Asin", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FHBFixedMathAsinTest::RunTest(const FString& Parameters)
+{
+	TestTrue(TEXT("Asin(1)"), HBFixedMath::AsinDeg(FHBFixed::FromInt(1)).Raw == FHBFixed::FromInt(90).Raw);
+	TestTrue(TEXT("Asin(0.5)"), HBFixedMath::AsinDeg(FHBFixed::FromInt(1) / 2).Raw == FHBFixed::FromInt(30).Raw);
+	TestTrue(TEXT("Asin(-1)"), HBFixedMath::AsinDeg(FHBFixed::FromInt(-1)).Raw == FHBFixed::FromInt(-90).Raw);
+	TestTrue(TEXT("Asin(2) clamps"), HBFixedMath::AsinDeg(FHBFixed::FromInt(2)).Raw == FHBFixed::FromInt(90).Raw);
+
+	//< Interpolated between table entries, so within a fiftieth of a degree. >
+	double maxError = 0;
+	for (int64 raw = -FHBFixed::One; raw <= FHBFixed::One; raw += 97)
+	{
+		double degrees = HBFixedMath::AsinDeg(FHBFixed::FromRaw(raw)).Raw / double(FHBFixed::One);
+		maxError = FMath::Max(maxError, FMath::Abs(degrees - FMath::RadiansToDegrees(FMath::Asin(raw / double(FHBFixed::One)))));
+	}
+	AddInfo(FString::Printf(TEXT("Largest arcsine error: %.4f degrees."), maxError));
+	TestTrue(TEXT("Arcsine error below 0.02 degrees"), maxError < 0.02);
+	return true;
+}
+
+#endif
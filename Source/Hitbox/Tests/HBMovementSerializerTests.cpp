@@ -0,0 +1,229 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "Serialization/BitWriter.h"
+#include "Serialization/BitReader.h"
+#include "../Net/HBMovementSerializer.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace HBMovementSerializerTests
+{
+	//< Writes _State against _Baseline, reads it back & checks it matches & used up exactly the bits written. Returns the bits. >
+	static int64 RoundTrip(FAutomationTestBase& _Test, const FString& _What, const FHBMovementSerializer& _Serializer, const FHBQuantizedMovementState& _State, const FHBQuantizedMovementState* _Baseline)
+	{
+		FBitWriter writer(0, true);
+		_Serializer.Write(writer, _State, _Baseline);
+
+		FBitReader reader(writer.GetData(), writer.GetNumBits());
+		FHBQuantizedMovementState decoded;
+		bool read = _Serializer.Read(reader, decoded, _Baseline);
+
+		_Test.TestTrue(_What + TEXT(" reads back"), read);
+		_Test.TestTrue(_What + TEXT(" round trips"), decoded == _State);
+		_Test.TestEqual(_What + TEXT(" bits read"), (int32)reader.GetPosBits(), (int32)writer.GetNumBits());
+
+		if (decoded != _State) _Test.AddInfo(decoded.DescribeDifferences(_State, _Serializer.GetSettings()));
+		return writer.GetNumBits();
+	}
+
+	static FHBMovementState MakeRandomState(FRandomStream& _Random)
+	{
+		FHBMovementState state;
+		state.Location = FVector(_Random.FRandRange(-50000, 50000), _Random.FRandRange(-50000, 50000), _Random.FRandRange(-5000, 5000));
+		state.Velocity = _Random.GetUnitVector() * _Random.FRandRange(0, 2500);
+		state.Yaw = _Random.FRandRange(-180, 180);
+		state.CapsuleHalfHeight = _Random.FRandRange(40, 86);
+		state.Grounded = _Random.RandRange(0, 1) != 0;
+		state.SprintActive = _Random.RandRange(0, 1) != 0;
+		state.AttemptJump = _Random.RandRange(0, 1) != 0;
+		state.WallRunActive = _Random.RandRange(0, 1) != 0;
+		state.WallRunSide = _Random.RandRange(0, 1) != 0;
+		state.JumpDelayTimer = _Random.FRandRange(0, 0.15f);
+		state.CrouchCurveTimeline = _Random.FRandRange(0, 0.3f);
+		state.WallrunFalloffTimeline = _Random.FRandRange(0, 2);
+		state.WallRunDelayTimer = _Random.FRandRange(0, 1);
+		state.CurrentWallRunSpeed = _Random.FRandRange(0, 1200);
+		state.PreviousWallNormal = (_Random.RandRange(0, 3) == 0) ? FVector::ZeroVector : _Random.GetUnitVector();
+		state.TargetRotationDelta = FRotator(_Random.FRandRange(-10, 10), _Random.FRandRange(-90, 90), _Random.FRandRange(-10, 10));
+
+		int32 active = _Random.RandRange(-1, HBAbility::MaxAbilities - 1);
+		state.Ability.Active = (active < 0) ? HBAbility::None : (uint8)active;
+		state.Ability.Time = (state.Ability.IsActive()) ? _Random.FRandRange(0, 2) : 0;
+		state.Ability.Target = (_Random.RandRange(0, 1) != 0) ? _Random.GetUnitVector() : state.Location + _Random.GetUnitVector() * 3000;
+		for (float& cooldown : state.Ability.Cooldowns) cooldown = (_Random.RandRange(0, 1) != 0) ? _Random.FRandRange(0, 5) : 0;
+		return state;
+	}
+
+	//< Running diagonally at 800 units/s, as the bandwidth counter sees it. >
+	static FHBQuantizedMovementState MakeRunState()
+	{
+		FHBQuantizedMovementState state;
+		state.Location[0] = 123456;
+		state.Location[1] = -78901;
+		state.Location[2] = 10000;
+		state.Velocity[0] = 5657;
+		state.Velocity[1] = 5657;
+		state.Yaw = 4500;
+		state.CapsuleHalfHeight = 8600;
+		state.Flags = FHBQuantizedMovementState::Flag_Grounded | FHBQuantizedMovementState::Flag_SprintActive;
+		return state;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHBMovementSerializerRoundTripTest, "Hitbox.Net.MovementSerializer.RoundTrip", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FHBMovementSerializerRoundTripTest::RunTest(const FString& Parameters)
+{
+	using namespace HBMovementSerializerTests;
+
+	FHBMovementSerializer serializer;
+	FRandomStream random(2931);
+
+	FHBQuantizedMovementState previous = serializer.Quantize(MakeRandomState(random));
+	for (int32 i = 0; i < 256; i++)
+	{
+		FHBMovementState state = MakeRandomState(random);
+		FHBQuantizedMovementState quantized = serializer.Quantize(state);
+
+		RoundTrip(*this, TEXT("Null baseline"), serializer, quantized, nullptr);
+		RoundTrip(*this, TEXT("Unrelated baseline"), serializer, quantized, &previous);
+		RoundTrip(*this, TEXT("Same baseline"), serializer, quantized, &quantized);
+
+		//< Dequantizing lands within a step, float rounding of large coordinates included. >
+		FHBMovementState dequantized = serializer.Dequantize(quantized);
+		TestTrue(TEXT("Location within precision"), dequantized.Location.Equals(state.Location, serializer.GetSettings().PositionPrecision));
+		TestTrue(TEXT("Velocity within precision"), dequantized.Velocity.Equals(state.Velocity, serializer.GetSettings().VelocityPrecision));
+		TestTrue(TEXT("Flags survive"), dequantized.WallRunActive == state.WallRunActive && dequantized.Grounded == state.Grounded);
+		TestTrue(TEXT("Active ability survives"), dequantized.Ability.Active == state.Ability.Active);
+		TestTrue(TEXT("Ability target within precision"), dequantized.Ability.Target.Equals(state.Ability.Target, serializer.GetSettings().PositionPrecision));
+		TestTrue(TEXT("Ability time within precision"), FMath::IsNearlyEqual(dequantized.Ability.Time, state.Ability.Time, serializer.GetSettings().TimePrecision));
+		TestTrue(TEXT("Cooldown within precision"), FMath::IsNearlyEqual(dequantized.Ability.Cooldowns[1], state.Ability.Cooldowns[1], serializer.GetSettings().TimePrecision));
+
+		previous = quantized;
+	}
+
+	//< Reading back into the baseline itself, which Read allows. >
+	FHBQuantizedMovementState baseline = serializer.Quantize(MakeRandomState(random));
+	FHBQuantizedMovementState state = serializer.Quantize(MakeRandomState(random));
+	FBitWriter writer(0, true);
+	serializer.Write(writer, state, &baseline);
+	FBitReader reader(writer.GetData(), writer.GetNumBits());
+	TestTrue(TEXT("Aliased read"), serializer.Read(reader, baseline, &baseline) && baseline == state);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHBMovementSerializerExtremesTest, "Hitbox.Net.MovementSerializer.Extremes", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FHBMovementSerializerExtremesTest::RunTest(const FString& Parameters)
+{
+	using namespace HBMovementSerializerTests;
+
+	FHBMovementSerializer serializer;
+
+	//< Deltas across the whole int32 range wrap & still decode, in both directions. >
+	FHBQuantizedMovementState low;
+	FHBQuantizedMovementState high;
+	for (int32 i = 0; i < 3; i++)
+	{
+		low.Location[i] = MIN_int32;
+		high.Location[i] = MAX_int32;
+		low.Velocity[i] = -1;
+		high.Velocity[i] = MAX_int32 - i;
+	}
+	low.Yaw = MIN_int32;
+	high.Yaw = MAX_int32;
+	high.PreviousWallNormal = 1u << (serializer.GetSettings().NormalBits * 2); //< Largest packed normal. >
+	high.Flags = (1 << FHBQuantizedMovementState::Flag_Count) - 1;
+	high.AbilityActive = HBAbility::MaxAbilities - 1;
+	high.AbilityTime = MAX_int32;
+	for (int32 i = 0; i < 3; i++) high.AbilityTarget[i] = (i == 1) ? MIN_int32 : MAX_int32;
+	for (int32 i = 0; i < HBAbility::MaxAbilities; i++) high.AbilityCooldowns[i] = (i % 2) ? MIN_int32 : MAX_int32;
+
+	RoundTrip(*this, TEXT("Low to high"), serializer, high, &low);
+	RoundTrip(*this, TEXT("High to low"), serializer, low, &high);
+	RoundTrip(*this, TEXT("High, null baseline"), serializer, high, nullptr);
+	RoundTrip(*this, TEXT("Low, null baseline"), serializer, low, nullptr);
+
+	//< Out of range & non finite floats saturate or become 0 rather than overflowing, & the result still round trips. >
+	FHBMovementState wild;
+	wild.Location = FVector(1e30f, -1e30f, NAN);
+	wild.Velocity = FVector(INFINITY, -INFINITY, 3e9f);
+	wild.CapsuleHalfHeight = NAN;
+	wild.JumpDelayTimer = 1e20f;
+	wild.PreviousWallNormal = FVector(NAN, 0, 1);
+	wild.Ability.Active = 200;
+	wild.Ability.Time = NAN;
+	wild.Ability.Cooldowns[0] = INFINITY;
+
+	FHBQuantizedMovementState quantized = serializer.Quantize(wild);
+	TestEqual(TEXT("Huge positive saturates"), quantized.Location[0], MAX_int32 - 127);
+	TestEqual(TEXT("Huge negative saturates"), quantized.Location[1], MIN_int32);
+	TestEqual(TEXT("NaN quantizes to 0"), quantized.Location[2], 0);
+	TestEqual(TEXT("Infinity saturates"), quantized.Velocity[0], MAX_int32 - 127);
+	TestEqual(TEXT("NaN half height quantizes to 0"), quantized.CapsuleHalfHeight, 0);
+	TestTrue(TEXT("NaN normal packs as none"), quantized.PreviousWallNormal == 0);
+	TestTrue(TEXT("Unknown ability packs as none"), quantized.AbilityActive == HBAbility::None);
+	TestEqual(TEXT("NaN ability time quantizes to 0"), quantized.AbilityTime, 0);
+	TestEqual(TEXT("Infinite cooldown saturates"), quantized.AbilityCooldowns[0], MAX_int32 - 127);
+
+	FHBQuantizedMovementState run = MakeRunState();
+	RoundTrip(*this, TEXT("Saturated"), serializer, quantized, nullptr);
+	RoundTrip(*this, TEXT("Saturated against run"), serializer, quantized, &run);
+
+	//< A truncated packet fails the read instead of returning garbage. >
+	FBitWriter writer(0, true);
+	serializer.Write(writer, high, &low);
+	FBitReader reader(writer.GetData(), writer.GetNumBits() / 2);
+	FHBQuantizedMovementState decoded;
+	TestFalse(TEXT("Truncated read fails"), serializer.Read(reader, decoded, &low));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHBMovementSerializerSizeTest, "Hitbox.Net.MovementSerializer.Size", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FHBMovementSerializerSizeTest::RunTest(const FString& Parameters)
+{
+	using namespace HBMovementSerializerTests;
+
+	FHBMovementSerializer serializer;
+	FHBQuantizedMovementState run = MakeRunState();
+
+	//< 9.43 units along X & Y, one 60 Hz frame of the run. >
+	FHBQuantizedMovementState nextFrame = run;
+	nextFrame.Location[0] += 943;
+	nextFrame.Location[1] += 943;
+
+	//< Same, airborne & turning: height, fall speed & yaw change too. >
+	FHBQuantizedMovementState airborne = nextFrame;
+	airborne.Location[2] += 500;
+	airborne.Velocity[2] -= 250;
+	airborne.Yaw += 30;
+	airborne.Flags &= ~FHBQuantizedMovementState::Flag_Grounded;
+
+	//< The run, starting a diagonal dash one step in with its 1 s cooldown. >
+	FHBQuantizedMovementState dash = nextFrame;
+	dash.AbilityActive = 0;
+	dash.AbilityTime = 16;
+	dash.AbilityTarget[0] = 71;
+	dash.AbilityTarget[1] = 71;
+	dash.AbilityCooldowns[0] = 1000;
+
+	int64 fullBits = RoundTrip(*this, TEXT("Full"), serializer, run, nullptr);
+	int64 unchangedBits = RoundTrip(*this, TEXT("Unchanged"), serializer, run, &run);
+	int64 runBits = RoundTrip(*this, TEXT("Run"), serializer, nextFrame, &run);
+	int64 airborneBits = RoundTrip(*this, TEXT("Airborne"), serializer, airborne, &run);
+	int64 dashBits = RoundTrip(*this, TEXT("Dash"), serializer, dash, &run);
+
+	AddInfo(FString::Printf(TEXT("Bytes per update: full %.1f, unchanged %.1f, running %.1f, airborne & turning %.1f, starting a dash %.1f."), fullBits / 8.0f, unchangedBits / 8.0f, runBits / 8.0f, airborneBits / 8.0f, dashBits / 8.0f));
+
+	//< The layout's own numbers, so a change to the format shows up here. >
+	TestEqual(TEXT("Full state bits"), (int32)fullBits, 182);
+	TestEqual(TEXT("Unchanged state bits"), (int32)unchangedBits, 18);
+	TestEqual(TEXT("Running update bits"), (int32)runBits, 57);
+	TestEqual(TEXT("Airborne update bits"), (int32)airborneBits, 106);
+	TestEqual(TEXT("Dash start bits"), (int32)dashBits, 117);
+	return true;
+}
+
+#endif
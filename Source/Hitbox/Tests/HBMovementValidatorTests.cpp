@@ -0,0 +1,263 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "../Net/HBMovementValidator.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace HBMovementValidatorTests
+{
+	constexpr float TickTime = 1.0f / 30;
+	constexpr uint8 Dash = 2; //< Its id in FHBMovementAbilities. >
+
+	//< Close to the default character's, but fixed so tuning doesn't move the tests. >
+	static FHBMovementLimits MakeLimits()
+	{
+		FHBMovementLimits limits;
+		limits.HorizontalSpeed[HBMovementMode::Ground] = 900;
+		limits.HorizontalSpeed[HBMovementMode::Air] = 1000;
+		limits.HorizontalSpeed[HBMovementMode::WallRun] = 900;
+		limits.HorizontalSpeed[HBMovementMode::Ability] = 2200;
+		for (float& upSpeed : limits.UpSpeed) upSpeed = 700;
+		limits.UpSpeed[HBMovementMode::Ability] = 2200;
+		limits.FallAcceleration = 3000;
+
+		limits.CarryDeceleration[HBMovementMode::Ground] = 500;
+		limits.CarryDeceleration[HBMovementMode::Air] = 100;
+		limits.CarryDeceleration[HBMovementMode::WallRun] = 100;
+		limits.CarryDeceleration[HBMovementMode::Ability] = 100;
+
+		limits.AbilityDurations[Dash] = 0.15f;
+		limits.AbilityCooldowns[Dash] = 0.8f;
+		return limits;
+	}
+
+	static FHBMovementContact MakeContact(float _GroundDistance, float _WallDistance)
+	{
+		FHBMovementContact contact;
+		contact.GroundDistance = _GroundDistance;
+		contact.WallDistance = _WallDistance;
+		return contact;
+	}
+
+	static FHBMovementState MakeGroundState(FVector _Velocity)
+	{
+		FHBMovementState state;
+		state.Velocity = _Velocity;
+		state.Grounded = true;
+		return state;
+	}
+
+	//< One tick of a lone player. Returns whether it was escalated. >
+	static bool ValidateTick(FHBMovementValidator& _Validator, const FHBMovementReport& _Report, const FHBMovementContact& _Contact)
+	{
+		TArray<int32> suspicious;
+		_Validator.Validate(MakeArrayView(&_Report, 1), MakeArrayView(&_Contact, 1), TickTime, suspicious);
+		return suspicious.Num() > 0;
+	}
+
+	//< Moves _Report on by _Velocity over one tick. >
+	static void Advance(FHBMovementReport& _Report, FVector _Velocity, uint8 _Mode, uint8 _Ability = HBAbility::None)
+	{
+		_Report.Velocity = _Velocity;
+		_Report.Location += _Velocity * TickTime;
+		_Report.Mode = _Mode;
+		_Report.Ability = _Ability;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHBMovementValidatorCarriedSpeedTest, "Hitbox.Net.MovementValidator.CarriedSpeed", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FHBMovementValidatorCarriedSpeedTest::RunTest(const FString& Parameters)
+{
+	using namespace HBMovementValidatorTests;
+	const FHBMovementContact ground = MakeContact(0, 9999);
+	const FHBMovementState start = MakeGroundState(FVector(2000, 0, 0));
+
+	//< Slowing down at the ground's least deceleration until the limit is honest all the way. >
+	{
+		FHBMovementValidator validator(MakeLimits());
+		validator.AddPlayer(start);
+		FHBMovementReport report = FHBMovementReport::FromState(start);
+
+		bool escalated = false;
+		for (int32 tick = 1; tick <= 90 && !escalated; tick++)
+		{
+			Advance(report, FVector(FMath::Max(2000 - 500 * tick * TickTime, 900.0f), 0, 0), HBMovementMode::Ground);
+			escalated = ValidateTick(validator, report, ground);
+		}
+		TestFalse(TEXT("Decaying speed is never escalated"), escalated);
+		TestTrue(TEXT("Decaying speed builds no suspicion"), validator.GetSuspicion(0) < 0.05f);
+	}
+
+	//< Holding the speed carried in: the allowance runs out from under it. >
+	{
+		FHBMovementValidator validator(MakeLimits());
+		validator.AddPlayer(start);
+		FHBMovementReport report = FHBMovementReport::FromState(start);
+
+		int32 escalatedTick = INDEX_NONE;
+		for (int32 tick = 1; tick <= 90 && escalatedTick == INDEX_NONE; tick++)
+		{
+			Advance(report, start.Velocity, HBMovementMode::Ground);
+			if (ValidateTick(validator, report, ground)) escalatedTick = tick;
+		}
+		AddInfo(FString::Printf(TEXT("Holding 2000 units/s on the ground is escalated on tick %d."), escalatedTick));
+		TestTrue(TEXT("Sustained carried speed is escalated"), escalatedTick != INDEX_NONE && escalatedTick <= 10);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHBMovementValidatorTeleportTest, "Hitbox.Net.MovementValidator.Teleport", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FHBMovementValidatorTeleportTest::RunTest(const FString& Parameters)
+{
+	using namespace HBMovementValidatorTests;
+	const FHBMovementContact ground = MakeContact(0, 9999);
+	const FVector velocity(600, 0, 0);
+
+	FHBMovementValidator validator(MakeLimits());
+	validator.AddPlayer(MakeGroundState(velocity));
+	FHBMovementReport report = FHBMovementReport::FromState(MakeGroundState(velocity));
+
+	bool escalated = false;
+	for (int32 tick = 0; tick < 30; tick++)
+	{
+		Advance(report, velocity, HBMovementMode::Ground);
+		escalated |= ValidateTick(validator, report, ground);
+	}
+	TestFalse(TEXT("Running is not escalated"), escalated);
+
+	//< Same reported speed, but 10 m further on. >
+	Advance(report, velocity, HBMovementMode::Ground);
+	report.Location.X += 1000;
+	TestTrue(TEXT("Teleport is escalated on the tick"), ValidateTick(validator, report, ground));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHBMovementValidatorSpoofedModeTest, "Hitbox.Net.MovementValidator.SpoofedMode", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FHBMovementValidatorSpoofedModeTest::RunTest(const FString& Parameters)
+{
+	using namespace HBMovementValidatorTests;
+	const FHBMovementContact ground = MakeContact(0, 9999);
+	const FHBMovementState start = MakeGroundState(FVector(600, 0, 0));
+
+	//< A real dash: five ticks at dash speed, then out at a speed the ground allows. >
+	{
+		FHBMovementValidator validator(MakeLimits());
+		validator.AddPlayer(start);
+		FHBMovementReport report = FHBMovementReport::FromState(start);
+
+		bool escalated = false;
+		for (int32 tick = 0; tick < 5; tick++)
+		{
+			Advance(report, FVector(2200, 0, 0), HBMovementMode::Ability, Dash);
+			escalated |= ValidateTick(validator, report, ground);
+		}
+		Advance(report, FVector(900, 0, 0), HBMovementMode::Ground);
+		escalated |= ValidateTick(validator, report, ground);
+		TestFalse(TEXT("A dash is not escalated"), escalated);
+
+		//< The dash is still cooling down. >
+		Advance(report, FVector(900, 0, 0), HBMovementMode::Ability, Dash);
+		TestTrue(TEXT("A dash during its cooldown is escalated"), ValidateTick(validator, report, ground));
+	}
+
+	//< Claiming a dash for longer than dashes last. >
+	{
+		FHBMovementValidator validator(MakeLimits());
+		validator.AddPlayer(start);
+		FHBMovementReport report = FHBMovementReport::FromState(start);
+
+		int32 escalatedTick = INDEX_NONE;
+		for (int32 tick = 1; tick <= 30 && escalatedTick == INDEX_NONE; tick++)
+		{
+			Advance(report, FVector(2200, 0, 0), HBMovementMode::Ability, Dash);
+			if (ValidateTick(validator, report, ground)) escalatedTick = tick;
+		}
+		TestTrue(TEXT("An endless dash is escalated once it overruns"), escalatedTick != INDEX_NONE && escalatedTick <= 10);
+	}
+
+	//< Abilities that can't be running, even at harmless speeds. >
+	{
+		FHBMovementState coolingDown = start;
+		coolingDown.Ability.Cooldowns[Dash] = 0.5f;
+
+		FHBMovementValidator validator(MakeLimits());
+		validator.AddPlayer(coolingDown);
+		FHBMovementReport report = FHBMovementReport::FromState(coolingDown);
+		Advance(report, start.Velocity, HBMovementMode::Ability, Dash);
+		TestTrue(TEXT("Ability still cooling down is escalated"), ValidateTick(validator, report, ground));
+
+		validator.ResetPlayer(0, start);
+		report = FHBMovementReport::FromState(start);
+		Advance(report, start.Velocity, HBMovementMode::Ability, 3);
+		TestTrue(TEXT("Ability the set doesn't run is escalated"), ValidateTick(validator, report, ground));
+
+		validator.ResetPlayer(0, start);
+		report = FHBMovementReport::FromState(start);
+		Advance(report, start.Velocity, HBMovementMode::Ability, HBAbility::None);
+		TestTrue(TEXT("Ability mode without an ability is escalated"), ValidateTick(validator, report, ground));
+	}
+
+	//< Wall runs need a wall in the server's contact. >
+	{
+		FHBMovementValidator validator(MakeLimits());
+		validator.AddPlayer(start);
+		FHBMovementReport report = FHBMovementReport::FromState(start);
+		Advance(report, FVector(800, 0, 0), HBMovementMode::WallRun);
+		TestFalse(TEXT("Wall run next to a wall is not escalated"), ValidateTick(validator, report, MakeContact(50, 5)));
+
+		validator.ResetPlayer(0, start);
+		report = FHBMovementReport::FromState(start);
+		Advance(report, FVector(800, 0, 0), HBMovementMode::WallRun);
+		TestTrue(TEXT("Wall run without a wall is escalated"), ValidateTick(validator, report, MakeContact(50, 9999)));
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHBMovementValidatorMalformedTest, "Hitbox.Net.MovementValidator.Malformed", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FHBMovementValidatorMalformedTest::RunTest(const FString& Parameters)
+{
+	using namespace HBMovementValidatorTests;
+	const FHBMovementState start = MakeGroundState(FVector(600, 0, 0));
+	const FHBMovementContact contacts[] = { MakeContact(0, 9999), MakeContact(0, 9999) };
+
+	//< Player 0 sends garbage, player 1 shares its packet & runs normally. >
+	FHBMovementReport malformed[4];
+	for (FHBMovementReport& report : malformed) report = FHBMovementReport::FromState(start);
+	malformed[0].Location.X = NAN;
+	malformed[1].Velocity.Y = NAN;
+	malformed[2].Velocity.X = INFINITY;
+	malformed[3].Mode = HBMovementMode::Count + 5;
+
+	for (int32 i = 0; i < UE_ARRAY_COUNT(malformed); i++)
+	{
+		FHBMovementValidator validator(MakeLimits());
+		validator.AddPlayer(start);
+		validator.AddPlayer(start);
+
+		FHBMovementReport honest = FHBMovementReport::FromState(start);
+		Advance(honest, start.Velocity, HBMovementMode::Ground);
+
+		const FHBMovementReport reports[] = { malformed[i], honest };
+		TArray<int32> suspicious;
+		validator.Validate(MakeArrayView(reports, 2), MakeArrayView(contacts, 2), TickTime, suspicious);
+
+		FString what = FString::Printf(TEXT("Malformed report %d"), i);
+		TestTrue(what + TEXT(" escalates its player only"), suspicious.Num() == 1 && suspicious[0] == 0);
+		TestTrue(what + TEXT(" leaves no NaN behind"), FMath::IsFinite(validator.GetSuspicion(0)) && validator.GetSuspicion(1) < 0.05f);
+
+		//< Its baseline stayed put, so a reset & an honest report go through. >
+		validator.ResetPlayer(0, start);
+		suspicious.Reset();
+		const FHBMovementReport honestReports[] = { honest, honest };
+		validator.Validate(MakeArrayView(honestReports, 2), MakeArrayView(contacts, 2), TickTime, suspicious);
+		TestEqual(what + TEXT(", then honest"), suspicious.Num(), 0);
+	}
+	return true;
+}
+
+#endif
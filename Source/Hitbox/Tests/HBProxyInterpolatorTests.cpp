@@ -0,0 +1,176 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+#include "../Net/HBProxyInterpolator.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace HBProxyInterpolatorTests
+{
+	constexpr double SendInterval = 1.0 / 30;
+	constexpr float FrameTime = 1.0f / 120;
+
+	//< Running along X at 600 units/s, so every pose has a known answer. >
+	static FHBProxySnapshot MakeRunSnapshot(double _Time)
+	{
+		FHBProxySnapshot snapshot;
+		snapshot.Time = _Time;
+		snapshot.Location = FVector(600 * _Time, 0, 0);
+		snapshot.Velocity = FVector(600, 0, 0);
+		return snapshot;
+	}
+
+	//< Pins the delay, so playback runs at local time minus the transit minus _Delay. >
+	static FHBProxyInterpolationSettings MakeFixedDelaySettings(float _Delay)
+	{
+		FHBProxyInterpolationSettings settings;
+		settings.MinDelay = _Delay;
+		settings.MaxDelay = _Delay;
+		return settings;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHBProxyInterpolatorReorderTest, "Hitbox.Net.ProxyInterpolator.Reorder", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FHBProxyInterpolatorReorderTest::RunTest(const FString& Parameters)
+{
+	using namespace HBProxyInterpolatorTests;
+	FHBProxyInterpolator interpolator(MakeFixedDelaySettings(0.1f));
+
+	//< The middle one is off to the side & arrives last, so a pose between the first two only bends towards it if it was put in place. >
+	FHBProxySnapshot first, middle, last;
+	first.Time = 0;
+	middle.Time = SendInterval;
+	middle.Location = FVector(0, 100, 0);
+	last.Time = 2 * SendInterval;
+
+	interpolator.AddSnapshot(first, 0.05);
+	interpolator.AddSnapshot(last, last.Time + 0.05);
+	interpolator.AddSnapshot(middle, middle.Time + 0.09);
+	TestEqual(TEXT("Snapshots kept"), interpolator.NumSnapshots(), 3);
+	TestEqual(TEXT("Late snapshots"), (int32)interpolator.GetLateSnapshots(), 0);
+
+	FHBProxySnapshot pose;
+	if (!TestTrue(TEXT("Samples"), interpolator.Sample(SendInterval / 2 + 0.05 + 0.1, FrameTime, pose))) return false;
+	if (!TestTrue(TEXT("Plays back between the first two"), pose.Time > 0 && pose.Time < SendInterval)) return false;
+
+	//< No velocities, so the cubic eases in & out: 3a^2 - 2a^3 of the way. >
+	float alpha = float(pose.Time / SendInterval);
+	TestTrue(TEXT("Bends towards the reordered snapshot"), FMath::IsNearlyEqual(pose.Location.Y, 100 * alpha * alpha * (3 - 2 * alpha), 0.01f));
+	TestFalse(TEXT("Not extrapolating"), interpolator.IsExtrapolating());
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHBProxyInterpolatorLateTest, "Hitbox.Net.ProxyInterpolator.DuplicatesAndLate", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FHBProxyInterpolatorLateTest::RunTest(const FString& Parameters)
+{
+	using namespace HBProxyInterpolatorTests;
+	FHBProxyInterpolator interpolator(MakeFixedDelaySettings(0.05f));
+
+	interpolator.AddSnapshot(MakeRunSnapshot(0), 0.05);
+	interpolator.AddSnapshot(MakeRunSnapshot(SendInterval), SendInterval + 0.05);
+	interpolator.AddSnapshot(MakeRunSnapshot(SendInterval), SendInterval + 0.06);
+	TestEqual(TEXT("Duplicate dropped"), interpolator.NumSnapshots(), 2);
+	TestEqual(TEXT("Duplicate counted"), (int32)interpolator.GetLateSnapshots(), 1);
+
+	//< Play past both, then anything at or before the playback time is too late, new or not. >
+	FHBProxySnapshot pose;
+	interpolator.Sample(0.5 + 0.05 + 0.05, FrameTime, pose);
+	interpolator.AddSnapshot(MakeRunSnapshot(0), 0.61);
+	interpolator.AddSnapshot(MakeRunSnapshot(0.4), 0.62);
+	TestEqual(TEXT("Late snapshots dropped"), interpolator.NumSnapshots(), 1);
+	TestEqual(TEXT("Late snapshots counted"), (int32)interpolator.GetLateSnapshots(), 3);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHBProxyInterpolatorExtrapolationTest, "Hitbox.Net.ProxyInterpolator.Extrapolation", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FHBProxyInterpolatorExtrapolationTest::RunTest(const FString& Parameters)
+{
+	using namespace HBProxyInterpolatorTests;
+	FHBProxyInterpolationSettings settings = MakeFixedDelaySettings(0.05f);
+	FHBProxyInterpolator interpolator(settings);
+
+	//< 50 ms transit & 50 ms delay, so playback is local time minus 0.1 s. >
+	interpolator.AddSnapshot(MakeRunSnapshot(0), 0.05);
+	interpolator.AddSnapshot(MakeRunSnapshot(SendInterval), SendInterval + 0.05);
+
+	FHBProxySnapshot pose;
+	interpolator.Sample(SendInterval + 0.1 + 0.1, FrameTime, pose);
+	TestTrue(TEXT("Extrapolates once dry"), interpolator.IsExtrapolating());
+	TestTrue(TEXT("Carried on by the velocity"), FMath::IsNearlyEqual(pose.Location.X, float(600 * (SendInterval + 0.1)), 0.01f));
+
+	interpolator.Sample(SendInterval + 0.1 + 1, FrameTime, pose);
+	TestTrue(TEXT("Still extrapolating"), interpolator.IsExtrapolating());
+	TestTrue(TEXT("Holds after MaxExtrapolationTime"), FMath::IsNearlyEqual(pose.Location.X, float(600 * (SendInterval + settings.MaxExtrapolationTime)), 0.01f));
+
+	//< Interpolation takes over again from the last snapshot towards the next, without playback going backwards. >
+	interpolator.AddSnapshot(MakeRunSnapshot(2), 2.05);
+	interpolator.Sample(2.05, FrameTime, pose);
+	TestFalse(TEXT("Interpolates with the next snapshot"), interpolator.IsExtrapolating());
+	TestTrue(TEXT("Playback moves on"), pose.Time > SendInterval + 0.9 && pose.Time < 2);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHBProxyInterpolatorDelayTest, "Hitbox.Net.ProxyInterpolator.DelayConvergence", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FHBProxyInterpolatorDelayTest::RunTest(const FString& Parameters)
+{
+	using namespace HBProxyInterpolatorTests;
+	FHBProxyInterpolationSettings settings;
+	FHBProxyInterpolator interpolator(settings);
+
+	//< 5 s of steady 50 ms transit, then 5 s with up to 60 ms extra, sampled at 120 Hz. >
+	struct FArrival { double Time; double SendTime; };
+	TArray<FArrival> arrivals;
+	FRandomStream random(48);
+	for (int32 i = 0; i < 300; i++)
+	{
+		double sendTime = i * SendInterval;
+		arrivals.Add({ sendTime + 0.05 + ((sendTime >= 5) ? random.FRandRange(0, 0.06f) : 0), sendTime });
+	}
+	arrivals.Sort([](const FArrival& _A, const FArrival& _B) { return _A.Time < _B.Time; });
+
+	int32 next = 0;
+	float calmDelay = 0;
+	float previousDelay = -1;
+	float largestChange = 0;
+	float largestError = 0;
+	for (int32 frame = 1; frame <= 1200; frame++)
+	{
+		double now = frame * double(FrameTime);
+		while (next < arrivals.Num() && arrivals[next].Time <= now)
+		{
+			interpolator.AddSnapshot(MakeRunSnapshot(arrivals[next].SendTime), arrivals[next].Time);
+			next++;
+		}
+
+		FHBProxySnapshot pose;
+		if (!interpolator.Sample(now, FrameTime, pose)) continue;
+
+		if (previousDelay >= 0) largestChange = FMath::Max(largestChange, FMath::Abs(interpolator.GetDelay() - previousDelay));
+		previousDelay = interpolator.GetDelay();
+		if (!interpolator.IsExtrapolating()) largestError = FMath::Max(largestError, FMath::Abs(pose.Location.X - float(600 * pose.Time)));
+		if (frame == 600) calmDelay = interpolator.GetDelay();
+	}
+
+	AddInfo(FString::Printf(TEXT("Delay %.1f ms steady, %.1f ms jittery (target %.1f ms), %u late."), calmDelay * 1000, interpolator.GetDelay() * 1000,
+		interpolator.GetTargetDelay() * 1000, interpolator.GetLateSnapshots()));
+
+	//< Without jitter only the send interval is buffered. >
+	TestTrue(TEXT("Steady delay is the send interval"), FMath::IsNearlyEqual(calmDelay, float(SendInterval), 0.002f));
+
+	//< With it the delay grows, only as fast as DelayAdjustRate allows, & ends up on the target. >
+	TestTrue(TEXT("Jitter grows the delay"), interpolator.GetDelay() > calmDelay + 0.04f);
+	TestTrue(TEXT("Delay reaches the target"), FMath::IsNearlyEqual(interpolator.GetDelay(), interpolator.GetTargetDelay(), 0.005f));
+	TestTrue(TEXT("Delay changes gently"), largestChange <= settings.DelayAdjustRate * FrameTime + 1e-5f);
+
+	//< Only while the delay catches up with the jump in jitter. >
+	TestTrue(TEXT("Few late snapshots"), interpolator.GetLateSnapshots() <= 10);
+	TestTrue(TEXT("Poses stay on the path"), largestError < 1);
+	return true;
+}
+
+#endif
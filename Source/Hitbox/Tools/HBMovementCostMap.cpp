@@ -0,0 +1,151 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HBMovementCostMap.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+static TAutoConsoleVariable<int32> CVarMovementCostMap(
+	TEXT("hb.Movement.CostMap"),
+	0,
+	TEXT("Accumulates the measured cost of every movement step into a world space grid around the character's position.\n")
+	TEXT("See hb.Movement.CostMap.Export. Written out automatically when the world ends while this is on."));
+
+static TAutoConsoleVariable<float> CVarMovementCostMapCellSize(
+	TEXT("hb.Movement.CostMapCellSize"),
+	250.0f,
+	TEXT("Edge length of a cost map cell in cm. Takes effect after hb.Movement.CostMap.Reset."));
+
+static FAutoConsoleCommandWithWorldAndArgs ExportCostMapCommand(
+	TEXT("hb.Movement.CostMap.Export"),
+	TEXT("hb.Movement.CostMap.Export [Name]: Writes the movement cost map to Saved/CostMaps as a CSV & a heat map bitmap. Name defaults to the map's."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& _Args, UWorld* _World)
+	{
+		UHBMovementCostMapSubsystem* costMap = (_World) ? _World->GetSubsystem<UHBMovementCostMapSubsystem>() : nullptr;
+		if (!costMap) return;
+
+		FString report;
+		costMap->Export((_Args.Num() > 0) ? _Args[0] : _World->GetMapName(), report);
+		UE_LOG(LogTemp, Display, TEXT("%s"), *report);
+	}));
+
+static FAutoConsoleCommandWithWorld ResetCostMapCommand(
+	TEXT("hb.Movement.CostMap.Reset"),
+	TEXT("Clears the movement cost map."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* _World)
+	{
+		if (UHBMovementCostMapSubsystem* costMap = (_World) ? _World->GetSubsystem<UHBMovementCostMapSubsystem>() : nullptr)
+		{
+			costMap->Reset();
+		}
+	}));
+
+void UHBMovementCostMapSubsystem::Deinitialize()
+{
+	//< Keep what an automated run recorded. >
+	if (IsRecording() && Cells.Num() > 0)
+	{
+		FString report;
+		Export(GetWorld()->GetMapName() + FDateTime::Now().ToString(TEXT("_%Y%m%d_%H%M%S")), report);
+		UE_LOG(LogTemp, Display, TEXT("%s"), *report);
+	}
+
+	Super::Deinitialize();
+}
+
+bool UHBMovementCostMapSubsystem::IsRecording() const
+{
+	return CVarMovementCostMap.GetValueOnAnyThread() != 0;
+}
+
+void UHBMovementCostMapSubsystem::Record(FVector _Location, uint64 _QueryCycles, uint64 _StepCycles)
+{
+	FScopeLock lock(&Lock);
+	if (CellSize <= 0) CellSize = FMath::Max(CVarMovementCostMapCellSize.GetValueOnAnyThread(), 10.0f);
+
+	FCell& cell = Cells.FindOrAdd(FIntPoint(FMath::FloorToInt(_Location.X / CellSize), FMath::FloorToInt(_Location.Y / CellSize)));
+	cell.Steps++;
+	cell.QueryCycles += _QueryCycles;
+	cell.StepCycles += _StepCycles;
+	cell.MaxCycles = FMath::Max(cell.MaxCycles, _QueryCycles + _StepCycles);
+}
+
+void UHBMovementCostMapSubsystem::Reset()
+{
+	FScopeLock lock(&Lock);
+	Cells.Reset();
+	CellSize = 0;
+}
+
+bool UHBMovementCostMapSubsystem::Export(const FString& _BaseName, FString& _OutReport)
+{
+	FScopeLock lock(&Lock);
+	if (Cells.Num() == 0)
+	{
+		_OutReport = TEXT("Movement cost map is empty, is hb.Movement.CostMap on?");
+		return false;
+	}
+
+	const double microsecondsPerCycle = FPlatformTime::GetSecondsPerCycle64() * 1000000.0;
+	const FString basePath = FPaths::ProjectSavedDir() / TEXT("CostMaps") / _BaseName;
+
+	//< Table, most expensive cells first. >
+	TArray<TPair<FIntPoint, FCell>> sorted;
+	sorted.Reserve(Cells.Num());
+	for (const TPair<FIntPoint, FCell>& cell : Cells) sorted.Add(cell);
+	sorted.Sort([](const TPair<FIntPoint, FCell>& _A, const TPair<FIntPoint, FCell>& _B)
+	{
+		return double(_A.Value.QueryCycles + _A.Value.StepCycles) / _A.Value.Steps > double(_B.Value.QueryCycles + _B.Value.StepCycles) / _B.Value.Steps;
+	});
+
+	FString csv = TEXT("CellX,CellY,CenterX,CenterY,Steps,QueryUs,StepUs,TotalUs,MaxUs,TotalMs\n");
+	for (const TPair<FIntPoint, FCell>& cell : sorted)
+	{
+		const FCell& value = cell.Value;
+		double queryUs = value.QueryCycles * microsecondsPerCycle / value.Steps;
+		double stepUs = value.StepCycles * microsecondsPerCycle / value.Steps;
+		csv += FString::Printf(TEXT("%d,%d,%.0f,%.0f,%u,%.2f,%.2f,%.2f,%.2f,%.3f\n"),
+			cell.Key.X, cell.Key.Y, (cell.Key.X + 0.5f) * CellSize, (cell.Key.Y + 0.5f) * CellSize, value.Steps,
+			queryUs, stepUs, queryUs + stepUs, value.MaxCycles * microsecondsPerCycle, (value.QueryCycles + value.StepCycles) * microsecondsPerCycle / 1000.0);
+	}
+
+	if (!FFileHelper::SaveStringToFile(csv, *(basePath + TEXT(".csv"))))
+	{
+		_OutReport = FString::Printf(TEXT("Could not write %s.csv."), *basePath);
+		return false;
+	}
+
+	//< Heat map of the average step cost, one pixel per cell. Pixel (0, 0) is the cell with the lowest X & Y, X runs right & Y down. >
+	FIntPoint minCell(MAX_int32, MAX_int32), maxCell(MIN_int32, MIN_int32);
+	TArray<double> averages;
+	for (const TPair<FIntPoint, FCell>& cell : Cells)
+	{
+		minCell = minCell.ComponentMin(cell.Key);
+		maxCell = maxCell.ComponentMax(cell.Key);
+		averages.Add(double(cell.Value.QueryCycles + cell.Value.StepCycles) / cell.Value.Steps);
+	}
+
+	//< Scale to the 95th percentile so a few outliers don't wash out the rest. >
+	averages.Sort();
+	double scale = averages[FMath::Min(FMath::FloorToInt(averages.Num() * 0.95f), averages.Num() - 1)];
+
+	FIntPoint size = (maxCell - minCell) + FIntPoint(1, 1);
+	FString bitmapName;
+	if (size.X <= 8192 && size.Y <= 8192)
+	{
+		TArray<FColor> pixels;
+		pixels.Init(FColor::Black, size.X * size.Y);
+		for (const TPair<FIntPoint, FCell>& cell : Cells)
+		{
+			float heat = FMath::Clamp(float(double(cell.Value.QueryCycles + cell.Value.StepCycles) / cell.Value.Steps / FMath::Max(scale, 1.0)), 0.0f, 1.0f);
+			FIntPoint pixel = cell.Key - minCell;
+			pixels[pixel.Y * size.X + pixel.X] = FLinearColor::MakeFromHSV8((uint8)((1 - heat) * 160), 255, 255).ToFColor(true); //< Blue is cheap, red expensive. >
+		}
+		FFileHelper::CreateBitmap(*basePath, size.X, size.Y, pixels.GetData(), nullptr, &IFileManager::Get(), &bitmapName);
+	}
+
+	_OutReport = FString::Printf(TEXT("Movement cost map: %d cells of %.0f cm, red at %.2f us per step. Wrote %s.csv %s"),
+		Cells.Num(), CellSize, scale * microsecondsPerCycle, *basePath, *bitmapName);
+	return true;
+}
@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HBMovementCostMap.generated.h"
+
+//< Movement cost profiling. Compiled out of Shipping builds along with every FHBMovementCostSample. >
+#define HB_WITH_MOVEMENT_COST_MAP (!UE_BUILD_SHIPPING)
+
+//< Measured cost of the movement steps taken in each cell of a world space grid, keyed on the character's position. >
+// Turned on by hb.Movement.CostMap. Shows where a level's collision makes the ground & wall queries expensive.
+// Exported with hb.Movement.CostMap.Export, & automatically when the world is torn down, e.g. at the end of an automated run.
+UCLASS()
+class HITBOX_API UHBMovementCostMapSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	bool IsRecording() const;
+
+	//< Adds one step at _Location. Any thread. >
+	void Record(FVector _Location, uint64 _QueryCycles, uint64 _StepCycles);
+
+	void Reset();
+
+	//< Writes Saved/CostMaps/<_BaseName>.csv & a heat map bitmap next to it. Returns false if nothing was recorded. >
+	bool Export(const FString& _BaseName, FString& _OutReport);
+
+private:
+	struct FCell
+	{
+		uint32 Steps = 0;
+		uint64 QueryCycles = 0;
+		uint64 StepCycles = 0; //< Everything else in the step: rules, sweeps & the body write. >
+		uint64 MaxCycles = 0; //< Most expensive single step, queries included. >
+	};
+
+	TMap<FIntPoint, FCell> Cells;
+	float CellSize = 0; //< Picked up from hb.Movement.CostMapCellSize on the first record after a reset. >
+	FCriticalSection Lock; //< Sub steps record from the physics thread. >
+};
+
+//< Times one movement step for the cost map. Construct before the queries, call QueriesDone after them, records when it goes out of scope. >
+struct FHBMovementCostSample
+{
+#if HB_WITH_MOVEMENT_COST_MAP
+	FHBMovementCostSample(UHBMovementCostMapSubsystem* _CostMap, FVector _Location)
+		: CostMap((_CostMap && _CostMap->IsRecording()) ? _CostMap : nullptr)
+		, Location(_Location)
+		, StartCycles((CostMap) ? FPlatformTime::Cycles64() : 0)
+	{
+	}
+
+	void QueriesDone() { if (CostMap) QueryEndCycles = FPlatformTime::Cycles64(); }
+
+	~FHBMovementCostSample()
+	{
+		if (!CostMap) return;
+		uint64 endCycles = FPlatformTime::Cycles64();
+		uint64 queryEnd = (QueryEndCycles) ? QueryEndCycles : StartCycles;
+		CostMap->Record(Location, queryEnd - StartCycles, endCycles - queryEnd);
+	}
+
+private:
+	UHBMovementCostMapSubsystem* CostMap;
+	FVector Location;
+	uint64 StartCycles;
+	uint64 QueryEndCycles = 0;
+#else
+	FHBMovementCostSample(UHBMovementCostMapSubsystem*, FVector) {}
+	void QueriesDone() {}
+#endif
+};
@@ -0,0 +1,501 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HBMovementSweepCommandlet.h"
+#include "HBStaticCollisionWorld.h"
+#include "../Pawns/HBPhysicsCharacter.h"
+#include "../Pawns/HBMovementComponent.h"
+#include "../Pawns/HBPlayerCollisionComponent.h"
+#include "Async/ParallelFor.h"
+#include "Dom/JsonObject.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "PhysicsEngine/PhysicsSettings.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "UObject/Package.h"
+
+namespace
+{
+	//< Swept property & the values it takes. >
+	struct FSweepParameter
+	{
+		FString Path;
+		float Min = 0;
+		float Max = 0;
+		int32 Count = 1;
+
+		float GetValue(int32 _Index) const { return (Count > 1) ? FMath::Lerp(Min, Max, (float)_Index / (Count - 1)) : Min; }
+	};
+
+	//< Held input from Time on, plus the presses made at Time. >
+	struct FScenarioKey
+	{
+		float Time = 0;
+		FVector2D Stick = FVector2D::ZeroVector;
+		bool Sprint = false;
+		bool Crouch = false;
+		bool Jump = false;
+		bool Dash = false;
+		float Turn = 0; //< Degrees of view yaw added at Time. >
+	};
+
+	struct FScenario
+	{
+		FString Name;
+		float Duration = 5;
+		FVector Start = FVector(0, 0, 86);
+		float Yaw = 0;
+		TArray<FScenarioKey> Keys; //< Sorted by time. >
+	};
+
+	struct FRunMetrics
+	{
+		float MaxSpeed = 0;
+		float FinalSpeed = 0;
+		float Distance = 0;
+		float WallRunDistance = 0;
+		float WallRunTime = 0;
+		int32 Hops = 0;
+		float HopSpeedMean = 0;
+		float HopConsistency = 0; //< 1 when every hop leaves at the same horizontal speed. >
+	};
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	//< PARAMETERS >
+
+	//< Follows a dotted path of struct properties down to a number. >
+	FNumericProperty* FindNumericProperty(UObject* _Object, const FString& _Path, void*& _OutValue)
+	{
+		TArray<FString> names;
+		_Path.ParseIntoArray(names, TEXT("."));
+
+		const UStruct* type = _Object->GetClass();
+		void* container = _Object;
+
+		for (int32 i = 0; i < names.Num(); i++)
+		{
+			FProperty* property = FindFProperty<FProperty>(type, *names[i]);
+			if (!property) return nullptr;
+
+			if (i == names.Num() - 1)
+			{
+				FNumericProperty* numeric = CastField<FNumericProperty>(property);
+				_OutValue = (numeric) ? numeric->ContainerPtrToValuePtr<void>(container) : nullptr;
+				return numeric;
+			}
+
+			FStructProperty* structProperty = CastField<FStructProperty>(property);
+			if (!structProperty) return nullptr;
+
+			container = structProperty->ContainerPtrToValuePtr<void>(container);
+			type = structProperty->Struct;
+		}
+		return nullptr;
+	}
+
+	bool SetParameter(UObject* _Object, const FString& _Path, float _Value)
+	{
+		void* value = nullptr;
+		FNumericProperty* property = FindNumericProperty(_Object, _Path, value);
+		if (!property) return false;
+
+		if (property->IsFloatingPoint())	property->SetFloatingPointPropertyValue(value, (double)_Value);
+		else								property->SetIntPropertyValue(value, (int64)FMath::RoundToInt(_Value));
+		return true;
+	}
+
+	//< Name:Min:Max:Count, comma separated. >
+	bool ParseParameters(const FString& _Text, TArray<FSweepParameter>& _OutParameters)
+	{
+		TArray<FString> entries;
+		_Text.ParseIntoArray(entries, TEXT(","));
+
+		for (const FString& entry : entries)
+		{
+			TArray<FString> fields;
+			entry.ParseIntoArray(fields, TEXT(":"));
+			if (fields.Num() != 4 && fields.Num() != 2)
+			{
+				UE_LOG(LogTemp, Error, TEXT("Bad sweep parameter '%s', expected Name:Min:Max:Count or Name:Value."), *entry);
+				return false;
+			}
+
+			FSweepParameter& parameter = _OutParameters.AddDefaulted_GetRef();
+			parameter.Path = fields[0];
+			parameter.Min = FCString::Atof(*fields[1]);
+			parameter.Max = (fields.Num() == 4) ? FCString::Atof(*fields[2]) : parameter.Min;
+			parameter.Count = (fields.Num() == 4) ? FMath::Max(FCString::Atoi(*fields[3]), 1) : 1;
+		}
+		return true;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	//< SCENARIOS >
+
+	void AddBuiltInScenarios(TArray<FScenario>& _OutScenarios)
+	{
+		//< Flat out along the floor. >
+		FScenario& sprint = _OutScenarios.AddDefaulted_GetRef();
+		sprint.Name = TEXT("Sprint");
+		sprint.Duration = 4;
+		sprint.Keys.Add({ 0, FVector2D(1, 0), true });
+
+		//< Sprint, jump & drift right onto the long wall of the test course. >
+		FScenario& wallRun = _OutScenarios.AddDefaulted_GetRef();
+		wallRun.Name = TEXT("WallRun");
+		wallRun.Duration = 6;
+		wallRun.Start = FVector(0, 150, 86);
+		wallRun.Keys.Add({ 0, FVector2D(1, 0), true });
+		wallRun.Keys.Add({ 1.5f, FVector2D(1, 0.5f), true, false, true });
+		wallRun.Keys.Add({ 2.0f, FVector2D(1, 0), true });
+
+		//< Slide & hop down the floor, jumping out of every slide. >
+		FScenario& slideHop = _OutScenarios.AddDefaulted_GetRef();
+		slideHop.Name = TEXT("SlideHop");
+		slideHop.Duration = 8;
+		slideHop.Start = FVector(0, -1000, 86);
+		slideHop.Keys.Add({ 0, FVector2D(1, 0), true });
+		for (int32 i = 0; i < 6; i++)
+		{
+			float time = 1.0f + i * 0.9f;
+			slideHop.Keys.Add({ time, FVector2D(1, 0), true, true });
+			slideHop.Keys.Add({ time + 0.25f, FVector2D(1, 0), true, false, true });
+		}
+	}
+
+	FVector ReadVector(const TSharedPtr<FJsonObject>& _Object, const FString& _Field, FVector _Default)
+	{
+		const TArray<TSharedPtr<FJsonValue>>* values;
+		if (!_Object->TryGetArrayField(_Field, values)) return _Default;
+
+		FVector result = _Default;
+		for (int32 i = 0; i < FMath::Min(values->Num(), 3); i++) result[i] = (*values)[i]->AsNumber();
+		return result;
+	}
+
+	void ReadNumber(const TSharedPtr<FJsonObject>& _Object, const FString& _Field, float& _OutValue)
+	{
+		double value;
+		if (_Object->TryGetNumberField(_Field, value)) _OutValue = (float)value;
+	}
+
+	//< { "Scenarios": [ { "Name", "Duration", "Start": [x, y, z], "Yaw", "Keys": [ { "Time", "Stick": [x, y], "Sprint", "Crouch", "Jump", "Dash", "Turn" } ] } ] } >
+	bool LoadScenarios(const FString& _Filename, TArray<FScenario>& _OutScenarios)
+	{
+		FString text;
+		if (!FFileHelper::LoadFileToString(text, *_Filename))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Could not read scenario file %s."), *_Filename);
+			return false;
+		}
+
+		TSharedPtr<FJsonObject> root;
+		const TArray<TSharedPtr<FJsonValue>>* scenarios;
+		if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(text), root) || !root.IsValid() || !root->TryGetArrayField(TEXT("Scenarios"), scenarios))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Scenario file %s is not an object with a Scenarios array."), *_Filename);
+			return false;
+		}
+
+		for (const TSharedPtr<FJsonValue>& value : *scenarios)
+		{
+			const TSharedPtr<FJsonObject>* object;
+			if (!value->TryGetObject(object)) continue;
+
+			FScenario& scenario = _OutScenarios.AddDefaulted_GetRef();
+			scenario.Name = (*object)->GetStringField(TEXT("Name"));
+			scenario.Start = ReadVector(*object, TEXT("Start"), scenario.Start);
+			ReadNumber(*object, TEXT("Duration"), scenario.Duration);
+			ReadNumber(*object, TEXT("Yaw"), scenario.Yaw);
+
+			const TArray<TSharedPtr<FJsonValue>>* keys;
+			if (!(*object)->TryGetArrayField(TEXT("Keys"), keys)) continue;
+
+			for (const TSharedPtr<FJsonValue>& keyValue : *keys)
+			{
+				const TSharedPtr<FJsonObject>* keyObject;
+				if (!keyValue->TryGetObject(keyObject)) continue;
+
+				FScenarioKey& key = scenario.Keys.AddDefaulted_GetRef();
+				FVector stick = ReadVector(*keyObject, TEXT("Stick"), FVector::ZeroVector);
+				key.Stick = FVector2D(stick.X, stick.Y);
+				ReadNumber(*keyObject, TEXT("Time"), key.Time);
+				ReadNumber(*keyObject, TEXT("Turn"), key.Turn);
+				(*keyObject)->TryGetBoolField(TEXT("Sprint"), key.Sprint);
+				(*keyObject)->TryGetBoolField(TEXT("Crouch"), key.Crouch);
+				(*keyObject)->TryGetBoolField(TEXT("Jump"), key.Jump);
+				(*keyObject)->TryGetBoolField(TEXT("Dash"), key.Dash);
+			}
+			scenario.Keys.StableSort([](const FScenarioKey& _A, const FScenarioKey& _B) { return _A.Time < _B.Time; });
+		}
+		return _OutScenarios.Num() > 0;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	//< RUN >
+
+	//< One scenario with one set of parameters. Only reads the component & world, so runs can share both across threads. >
+	FRunMetrics RunScenario(const UHBMovementComponent& _Component, const FHBStaticCollisionWorld::FQuerySettings& _QuerySettings, const FHBStaticCollisionWorld& _World, const FScenario& _Scenario, float _DeltaTime)
+	{
+		FRunMetrics metrics;
+
+		FHBMovementState state;
+		state.Location = _Scenario.Start;
+		state.Yaw = _Scenario.Yaw;
+		state.CapsuleHalfHeight = _Component.PlayerHeight / 2;
+
+		FHBMovementStepInput input;
+		FHBMovementStepInput previousInput;
+		FHBMovementContact contact;
+
+		TArray<float, TInlineAllocator<32>> hopSpeeds;
+		int32 nextKey = 0;
+		int32 stepCount = FMath::CeilToInt(_Scenario.Duration / _DeltaTime);
+
+		for (int32 step = 0; step < stepCount; step++)
+		{
+			float time = step * _DeltaTime;
+
+			//< Turn the keys reached this step into held input & press counters, as the character's input bindings would. >
+			for (; nextKey < _Scenario.Keys.Num() && _Scenario.Keys[nextKey].Time <= time; nextKey++)
+			{
+				const FScenarioKey& key = _Scenario.Keys[nextKey];
+				if (key.Sprint && !input.Input.SprintPressed) input.SprintPresses++;
+				if (key.Crouch && !input.Input.CrouchPressed) input.CrouchPresses++;
+				if (!key.Crouch && input.Input.CrouchPressed) input.CrouchReleases++;
+				if (key.Jump) input.JumpPresses++;
+				if (key.Dash) input.DashPresses++;
+
+				input.Input.MovementInput = key.Stick;
+				input.Input.SprintPressed = key.Sprint;
+				input.Input.CrouchPressed = key.Crouch;
+				input.YawInput += key.Turn;
+			}
+
+			//< The camera takes any rotation the rules ask for straight away. >
+			input.ConsumedRotationDelta += state.TargetRotationDelta;
+			input.YawInput += state.TargetRotationDelta.Yaw;
+
+			_World.QueryContact(state.Location, state.CapsuleHalfHeight, _QuerySettings, contact);
+
+			bool wasGrounded = state.Grounded;
+			FVector previousLocation = state.Location;
+
+			_Component.SimulateStep(state, input, previousInput, contact, _DeltaTime);
+			previousInput = input;
+
+			float speed = FVector(state.Velocity.X, state.Velocity.Y, 0).Size();
+			metrics.MaxSpeed = FMath::Max(metrics.MaxSpeed, speed);
+
+			if (state.WallRunActive)
+			{
+				metrics.WallRunDistance += FVector::DistXY(previousLocation, state.Location);
+				metrics.WallRunTime += _DeltaTime;
+			}
+
+			//< A hop is leaving the ground upwards. >
+			if (wasGrounded && !state.Grounded && state.Velocity.Z > 0)
+			{
+				hopSpeeds.Add(speed);
+			}
+		}
+
+		metrics.FinalSpeed = FVector(state.Velocity.X, state.Velocity.Y, 0).Size();
+		metrics.Distance = FVector::DistXY(_Scenario.Start, state.Location);
+		metrics.Hops = hopSpeeds.Num();
+
+		if (hopSpeeds.Num() > 0)
+		{
+			float sum = 0;
+			for (float hopSpeed : hopSpeeds) sum += hopSpeed;
+			metrics.HopSpeedMean = sum / hopSpeeds.Num();
+
+			float variance = 0;
+			for (float hopSpeed : hopSpeeds) variance += FMath::Square(hopSpeed - metrics.HopSpeedMean);
+			variance /= hopSpeeds.Num();
+
+			metrics.HopConsistency = (metrics.HopSpeedMean > KINDA_SMALL_NUMBER) ? FMath::Clamp(1 - FMath::Sqrt(variance) / metrics.HopSpeedMean, 0.0f, 1.0f) : 1;
+		}
+
+		return metrics;
+	}
+
+	FHBStaticCollisionWorld::FQuerySettings GetQuerySettings(UHBMovementComponent& _Component)
+	{
+		FHBStaticCollisionWorld::FQuerySettings settings;
+		settings.Radius = _Component.PlayerRadius;
+
+		if (UHBPlayerCollisionComponent* collision = _Component.GetCollisionComponent())
+		{
+			settings.GroundNearDistance		= collision->GroundNearDistance;
+			settings.GroundContactDistance	= collision->GroundContactDistance;
+			settings.WallNearDistance		= collision->WallNearDistance;
+			settings.WallContactDistance	= collision->WallContactDistance;
+			settings.LedgeProbeHeight		= collision->LedgeProbeHeight;
+		}
+
+		//< As UHBMovementComponent::BeginPlay does. >
+		if (_Component.Abilities.LedgeClimb.Enabled)
+		{
+			settings.LedgeProbeHeight = FMath::Max(settings.LedgeProbeHeight, _Component.Abilities.LedgeClimb.MaxHeight);
+		}
+		return settings;
+	}
+}
+
+UHBMovementSweepCommandlet::UHBMovementSweepCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UHBMovementSweepCommandlet::Main(const FString& _Params)
+{
+	FString parameterText, pawnPath, mapPath, scenarioPath;
+	FString outPath = FPaths::ProjectSavedDir() / TEXT("MovementSweep.csv");
+	float deltaTime = UPhysicsSettings::Get()->MaxSubstepDeltaTime;
+	int32 batchSize = 256;
+
+	FParse::Value(*_Params, TEXT("params="), parameterText, false);
+	FParse::Value(*_Params, TEXT("pawn="), pawnPath);
+	FParse::Value(*_Params, TEXT("map="), mapPath);
+	FParse::Value(*_Params, TEXT("scenarios="), scenarioPath);
+	FParse::Value(*_Params, TEXT("out="), outPath);
+	FParse::Value(*_Params, TEXT("dt="), deltaTime);
+	FParse::Value(*_Params, TEXT("batch="), batchSize);
+	batchSize = FMath::Max(batchSize, 1);
+
+	if (deltaTime <= 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("-dt must be positive."));
+		return 1;
+	}
+
+	//< The movement component to start from, with whatever the pawn's defaults set. >
+	UClass* pawnClass = (pawnPath.IsEmpty()) ? AHBPhysicsCharacter::StaticClass() : LoadClass<AHBPhysicsCharacter>(nullptr, *pawnPath);
+	UHBMovementComponent* movementTemplate = (pawnClass) ? pawnClass->GetDefaultObject<AHBPhysicsCharacter>()->GetMovementComponent() : nullptr;
+	if (!movementTemplate)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not find a HBMovementComponent on pawn class '%s'."), *pawnPath);
+		return 1;
+	}
+
+	TArray<FSweepParameter> parameters;
+	if (!ParseParameters(parameterText, parameters)) return 1;
+
+	for (const FSweepParameter& parameter : parameters)
+	{
+		void* value = nullptr;
+		if (!FindNumericProperty(movementTemplate, parameter.Path, value))
+		{
+			UE_LOG(LogTemp, Error, TEXT("HBMovementComponent has no numeric property '%s'."), *parameter.Path);
+			return 1;
+		}
+	}
+
+	TArray<FScenario> scenarios;
+	if (scenarioPath.IsEmpty())					AddBuiltInScenarios(scenarios);
+	else if (!LoadScenarios(scenarioPath, scenarios))	return 1;
+
+	//< Static collision. >
+	FHBStaticCollisionWorld world;
+	if (mapPath.IsEmpty())
+	{
+		world.AddTestCourse();
+	}
+	else
+	{
+		UPackage* package = LoadPackage(nullptr, *mapPath, LOAD_None);
+		UWorld* mapWorld = (package) ? UWorld::FindWorldInPackage(package) : nullptr;
+		if (!mapWorld)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Could not load map %s."), *mapPath);
+			return 1;
+		}
+		world.AddFromWorld(mapWorld);
+	}
+	world.Build();
+
+	int32 comboCount = 1;
+	for (const FSweepParameter& parameter : parameters) comboCount *= parameter.Count;
+
+	UE_LOG(LogTemp, Display, TEXT("Sweeping %d combinations x %d scenarios against %d boxes, %.4f s steps."), comboCount, scenarios.Num(), world.NumBoxes(), deltaTime);
+
+	//< Table header. >
+	FString csv;
+	for (const FSweepParameter& parameter : parameters) csv += parameter.Path + TEXT(",");
+	csv += TEXT("Scenario,MaxSpeed,FinalSpeed,Distance,WallRunDistance,WallRunTime,Hops,HopSpeedMean,HopConsistency\n");
+
+	TArray<UHBMovementComponent*> components;
+	TArray<FHBStaticCollisionWorld::FQuerySettings> querySettings;
+	TArray<FRunMetrics> results;
+	int64 totalSteps = 0;
+	double runSeconds = 0;
+
+	for (int32 batchStart = 0; batchStart < comboCount; batchStart += batchSize)
+	{
+		int32 batchCount = FMath::Min(batchSize, comboCount - batchStart);
+
+		//< UObjects are made on this thread, the runs only read them. >
+		components.Reset();
+		querySettings.Reset();
+		for (int32 combo = batchStart; combo < batchStart + batchCount; combo++)
+		{
+			UHBMovementComponent* component = NewObject<UHBMovementComponent>(GetTransientPackage(), movementTemplate->GetClass(), NAME_None, RF_Transient, movementTemplate);
+
+			int32 digits = combo;
+			for (const FSweepParameter& parameter : parameters)
+			{
+				SetParameter(component, parameter.Path, parameter.GetValue(digits % parameter.Count));
+				digits /= parameter.Count;
+			}
+
+			component->InitBodyFromSettings();
+			components.Add(component);
+			querySettings.Add(GetQuerySettings(*component));
+		}
+
+		results.SetNum(batchCount * scenarios.Num());
+
+		double startTime = FPlatformTime::Seconds();
+		ParallelFor(results.Num(), [&](int32 _Index)
+		{
+			int32 combo = _Index / scenarios.Num();
+			results[_Index] = RunScenario(*components[combo], querySettings[combo], world, scenarios[_Index % scenarios.Num()], deltaTime);
+		});
+		runSeconds += FPlatformTime::Seconds() - startTime;
+
+		for (const FScenario& scenario : scenarios) totalSteps += (int64)batchCount * FMath::CeilToInt(scenario.Duration / deltaTime);
+
+		for (int32 index = 0; index < results.Num(); index++)
+		{
+			int32 digits = batchStart + index / scenarios.Num();
+			for (const FSweepParameter& parameter : parameters)
+			{
+				csv += FString::Printf(TEXT("%g,"), parameter.GetValue(digits % parameter.Count));
+				digits /= parameter.Count;
+			}
+
+			const FRunMetrics& metrics = results[index];
+			csv += FString::Printf(TEXT("%s,%.1f,%.1f,%.1f,%.1f,%.3f,%d,%.1f,%.3f\n"), *scenarios[index % scenarios.Num()].Name,
+				metrics.MaxSpeed, metrics.FinalSpeed, metrics.Distance, metrics.WallRunDistance, metrics.WallRunTime, metrics.Hops, metrics.HopSpeedMean, metrics.HopConsistency);
+		}
+
+		for (UHBMovementComponent* component : components) component->MarkPendingKill();
+		CollectGarbage(RF_NoFlags);
+	}
+
+	if (!FFileHelper::SaveStringToFile(csv, *outPath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Could not write %s."), *outPath);
+		return 1;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Ran %lld sub steps in %.2f s (%.2f million per second). Results in %s."),
+		totalSteps, runSeconds, (runSeconds > 0) ? totalSteps / runSeconds / 1000000.0 : 0.0, *outPath);
+	return 0;
+}
@@ -0,0 +1,27 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "HBMovementSweepCommandlet.generated.h"
+
+//< Headless sweep of movement parameters against scripted input, for tuning. >
+// Runs every combination of the given parameter ranges through every scenario on all cores, against a box copy of a level's
+// static collision, & writes a table of max speed, wall run distance & hop consistency per run.
+//
+// UE4Editor-Cmd Hitbox -run=HBMovementSweep -params=WallRunSpeed:700:1100:5,JumpForce:600:800:3
+//		[-pawn=/Game/Path/BP_Pawn.BP_Pawn_C] [-map=/Game/Maps/Level] [-scenarios=Scenarios.json] [-out=Sweep.csv] [-dt=0.00833] [-batch=256]
+//
+// Parameters are numeric properties of the pawn's UHBMovementComponent, dotted paths reach into structs, e.g. Abilities.Dash.Speed.
+// Without -map the runs use FHBStaticCollisionWorld::AddTestCourse, without -scenarios the built in sprint, wall run & hop ones.
+UCLASS()
+class HITBOX_API UHBMovementSweepCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UHBMovementSweepCommandlet();
+
+	virtual int32 Main(const FString& _Params) override;
+};
@@ -0,0 +1,150 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HBStaticCollisionWorld.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "../Hitbox.h"
+
+void FHBStaticCollisionWorld::AddFromWorld(UWorld* _World)
+{
+	if (!_World) return;
+
+	for (TActorIterator<AActor> it(_World); it; ++it)
+	{
+		TInlineComponentArray<UPrimitiveComponent*> primitives(*it);
+		for (UPrimitiveComponent* primitive : primitives)
+		{
+			if (primitive->Mobility != EComponentMobility::Static || !primitive->IsCollisionEnabled()) continue;
+			if (primitive->GetCollisionResponseToChannel(ECC_HBMovement) != ECR_Block) continue;
+
+			//< The world is never ticked, so transforms & bounds are only as fresh as we make them. >
+			primitive->UpdateComponentToWorld();
+			FBox box = primitive->CalcBounds(primitive->GetComponentTransform()).GetBox();
+			if (box.IsValid) AddBox(box);
+		}
+	}
+}
+
+void FHBStaticCollisionWorld::AddTestCourse()
+{
+	//< Floor. >
+	AddBox(FBox(FVector(-2000, -2000, -100), FVector(20000, 2000, 0)));
+
+	//< A long wall to the right of the +X run, then a gap & a second wall on the left to chain wall runs. >
+	AddBox(FBox(FVector(1500, 300, 0), FVector(4500, 400, 600)));
+	AddBox(FBox(FVector(5500, -400, 0), FVector(8500, -300, 600)));
+
+	//< Steps of rising height, for ledge climbs & jumps. >
+	for (int32 i = 0; i < 4; i++)
+	{
+		float start = 10000 + i * 800;
+		AddBox(FBox(FVector(start, -500, 0), FVector(start + 400, 500, 40 + i * 40)));
+	}
+}
+
+void FHBStaticCollisionWorld::Build()
+{
+	Cells.Reset();
+
+	for (int32 index = 0; index < Boxes.Num(); index++)
+	{
+		const FBox& box = Boxes[index];
+		FIntPoint minCell = GetCell(box.Min - FVector(CellMargin));
+		FIntPoint maxCell = GetCell(box.Max + FVector(CellMargin));
+
+		for (int32 x = minCell.X; x <= maxCell.X; x++)
+		{
+			for (int32 y = minCell.Y; y <= maxCell.Y; y++)
+			{
+				Cells.FindOrAdd(FIntPoint(x, y)).Add(index);
+			}
+		}
+	}
+}
+
+void FHBStaticCollisionWorld::QueryContact(FVector _Location, float _HalfHeight, const FQuerySettings& _Settings, FHBMovementContact& _OutContact) const
+{
+	checkSlow(_Settings.Radius + _Settings.WallNearDistance <= CellMargin);
+
+	_OutContact.SampleLocation			= _Location;
+	_OutContact.SampleHalfHeight		= _HalfHeight;
+	_OutContact.GroundNearDistance		= _Settings.GroundNearDistance;
+	_OutContact.GroundContactDistance	= _Settings.GroundContactDistance;
+	_OutContact.WallNearDistance		= _Settings.WallNearDistance;
+	_OutContact.WallContactDistance		= _Settings.WallContactDistance;
+
+	_OutContact.GroundDistance		= 9999;
+	_OutContact.GroundNormal		= FVector::UpVector;
+	_OutContact.GroundImpactPoint	= FVector::ZeroVector;
+	_OutContact.WallDistance		= 9999;
+	_OutContact.WallNormal			= FVector::ZeroVector;
+	_OutContact.WallImpactPoint		= FVector::ZeroVector;
+	_OutContact.LedgeHeight			= 9999;
+
+	const TArray<int32>* candidates = Cells.Find(GetCell(_Location));
+	if (!candidates) return;
+
+	float groundRadius = _Settings.Radius * 0.95f;
+	float wallReach = _Settings.Radius + _Settings.WallNearDistance;
+	float feet = _Location.Z - _HalfHeight;
+	const FBox* wallBox = nullptr;
+	FVector2D wallPoint;
+	float wallDistance = wallReach;
+
+	for (int32 index : *candidates)
+	{
+		const FBox& box = Boxes[index];
+		FVector2D closest(FMath::Clamp(_Location.X, box.Min.X, box.Max.X), FMath::Clamp(_Location.Y, box.Min.Y, box.Max.Y));
+		float flatDistance = FVector2D::Distance(closest, FVector2D(_Location));
+
+		//< Ground: the highest top below the centre that the downward sphere sweep would land on. Tops are flat. >
+		if (box.Max.Z <= _Location.Z)
+		{
+			float distance = _Location.Z - box.Max.Z - _HalfHeight;
+			if (flatDistance < groundRadius && distance < _OutContact.GroundDistance)
+			{
+				_OutContact.GroundDistance		= distance;
+				_OutContact.GroundImpactPoint	= FVector(closest, box.Max.Z);
+			}
+			continue;
+		}
+
+		//< Wall: the nearest side at the height of the centre, as the sphere & line traces would find it. >
+		if (box.Min.Z <= _Location.Z && flatDistance < wallDistance)
+		{
+			wallBox = &box;
+			wallPoint = closest;
+			wallDistance = flatDistance;
+		}
+	}
+
+	if (!wallBox) return;
+
+	FVector2D normal = FVector2D(_Location) - wallPoint;
+	if (wallDistance < KINDA_SMALL_NUMBER)
+	{
+		//< Centre inside the box, push out through the nearest side. >
+		float toMinX = _Location.X - wallBox->Min.X, toMaxX = wallBox->Max.X - _Location.X;
+		float toMinY = _Location.Y - wallBox->Min.Y, toMaxY = wallBox->Max.Y - _Location.Y;
+		float nearest = FMath::Min(FMath::Min(toMinX, toMaxX), FMath::Min(toMinY, toMaxY));
+		normal = (nearest == toMinX) ? FVector2D(-1, 0) : (nearest == toMaxX) ? FVector2D(1, 0) : (nearest == toMinY) ? FVector2D(0, -1) : FVector2D(0, 1);
+		wallDistance = -nearest;
+	}
+	else
+	{
+		normal /= wallDistance;
+	}
+
+	_OutContact.WallDistance	= wallDistance - _Settings.Radius;
+	_OutContact.WallNormal		= FVector(normal, 0);
+	_OutContact.WallImpactPoint = FVector(wallPoint, _Location.Z);
+
+	//< Ledge: the top of the wall, if it is low enough for the probe to start above it. >
+	if (_Settings.LedgeProbeHeight > 0 && wallBox->Max.Z < feet + _Settings.LedgeProbeHeight)
+	{
+		FVector2D ledge = wallPoint - normal * _Settings.Radius;
+		_OutContact.LedgePoint	= FVector(ledge, wallBox->Max.Z);
+		_OutContact.LedgeHeight = wallBox->Max.Z - feet;
+	}
+}
@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "../Pawns/HBMovementTypes.h"
+
+class UWorld;
+
+//< Static level collision reduced to axis aligned boxes, for running the movement rules without a physics scene. >
+// Answers the same ground, wall & ledge questions as the HBPlayerCollisionComponent, analytically. Immutable once built, so
+// any number of threads can query it at the same time.
+class HITBOX_API FHBStaticCollisionWorld
+{
+public:
+	//< Thresholds & probe sizes, copied from a HBPlayerCollisionComponent. >
+	struct FQuerySettings
+	{
+		float Radius = 26;
+		float GroundNearDistance = 20;
+		float GroundContactDistance = 0.1f;
+		float WallNearDistance = 20;
+		float WallContactDistance = 5.0f;
+		float LedgeProbeHeight = 0;
+	};
+
+	void AddBox(const FBox& _Box) { Boxes.Add(_Box); }
+
+	//< Bounds of every static primitive blocking ECC_HBMovement in the world's persistent level. >
+	void AddFromWorld(UWorld* _World);
+
+	//< A floor with a run of walls & steps, for when no level is given. >
+	void AddTestCourse();
+
+	//< Must be called after the last box is added & before querying. >
+	void Build();
+
+	int32 NumBoxes() const { return Boxes.Num(); }
+	const TArray<FBox>& GetBoxes() const { return Boxes; }
+
+	//< Fills the ground, wall & ledge part of _OutContact for a capsule at _Location. >
+	void QueryContact(FVector _Location, float _HalfHeight, const FQuerySettings& _Settings, FHBMovementContact& _OutContact) const;
+
+private:
+	static constexpr float CellSize = 1024;
+	static constexpr float CellMargin = 256; //< Widest horizontal reach of a query. >
+
+	FIntPoint GetCell(FVector _Location) const { return FIntPoint(FMath::FloorToInt(_Location.X / CellSize), FMath::FloorToInt(_Location.Y / CellSize)); }
+
+	TArray<FBox> Boxes;
+	TMap<FIntPoint, TArray<int32>> Cells; //< Boxes within CellMargin of each cell. >
+};